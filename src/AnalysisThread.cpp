@@ -0,0 +1,74 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "AnalysisThread.h"
+
+
+AnalysisThread::AnalysisThread(MonoAudioBuffer& buffer, std::function<int64_t()> analyze)
+	: QThread(0)
+	, m_buffer(buffer)
+	, m_analyze(analyze)
+	, m_hopSemaphore()
+{
+	setObjectName("Analysis");
+}
+
+AnalysisThread::~AnalysisThread()
+{
+	stopAnalysis();
+}
+
+void AnalysisThread::startAnalysis()
+{
+	if (isRunning()) return;
+	m_buffer.setHopListener(this);
+	start(QThread::HighPriority);
+}
+
+void AnalysisThread::stopAnalysis()
+{
+	requestInterruption();
+	wait();
+	m_buffer.setHopListener(nullptr);
+}
+
+bool AnalysisThread::acquireOrInterrupt(QSemaphore& semaphore)
+{
+	while (!semaphore.tryAcquire(1, ANALYSIS_WAIT_TIMEOUT)) {
+		if (QThread::currentThread()->isInterruptionRequested()) return false;
+	}
+	return true;
+}
+
+void AnalysisThread::run()
+{
+	while (!isInterruptionRequested()) {
+		const int64_t nextHopEnd = m_analyze();
+
+		// the request is made before the number of put samples is checked,
+		// so that no notification is lost:
+		m_buffer.requestHopNotification(nextHopEnd);
+		if (m_buffer.getNumPutSamples() >= nextHopEnd) continue;
+
+		// (a notification of a previous request may wake up the thread once more than necessary,
+		// the analysis function just finds no new hop then)
+		m_hopSemaphore.tryAcquire(1, ANALYSIS_WAIT_TIMEOUT);
+	}
+}
@@ -0,0 +1,76 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef ANALYSISTHREAD_H
+#define ANALYSISTHREAD_H
+
+#include "MonoAudioBuffer.h"
+
+#include <QThread>
+#include <QSemaphore>
+
+#include <functional>
+
+
+// time the analysis thread waits for a notification before it checks if it should stop
+static const int ANALYSIS_WAIT_TIMEOUT = 100;  // ms
+
+
+// A thread that runs the analysis of a MonoAudioBuffer as soon as the producer has put a new hop
+// into the buffer, instead of polling the buffer with a timer.
+//
+// The analysis function is called in this thread, it returns the number of put samples of the buffer
+// at which its next hop is complete. The buffer notifies this thread (see MonoAudioBuffer::HopListener)
+// when they have been put, the producer only releases a semaphore for that.
+class AnalysisThread : public QThread, protected MonoAudioBuffer::HopListener
+{
+
+public:
+	// analyze is called whenever new samples are available and returns the number of put samples
+	// of buffer (an absolute sample number) at which it should be called again
+	explicit AnalysisThread(MonoAudioBuffer& buffer, std::function<int64_t()> analyze);
+	~AnalysisThread() override;
+
+	// starts the thread and registers it as the HopListener of the buffer
+	void startAnalysis();
+
+	// stops the thread and removes the HopListener of the buffer
+	// (the analysis function is not called anymore when this returns)
+	void stopAnalysis();
+
+	// waits until semaphore can be acquired or an interruption of the calling thread is requested,
+	// returns false if it was interrupted
+	// - i.e. for the analysis function to wait for the results of another thread
+	static bool acquireOrInterrupt(QSemaphore& semaphore);
+
+protected:
+	// calls the analysis function after each notification until an interruption is requested
+	void run() override;
+
+	// wakes up the thread
+	// - called by the producer of the buffer
+	void hopReady() override { m_hopSemaphore.release(); }
+
+	MonoAudioBuffer&		m_buffer;  // the buffer whose producer wakes up this thread
+	std::function<int64_t()> m_analyze;  // the analysis function
+	QSemaphore				m_hopSemaphore;  // released by the producer when the requested samples have been put
+};
+
+#endif // ANALYSISTHREAD_H
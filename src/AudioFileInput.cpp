@@ -0,0 +1,203 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "AudioFileInput.h"
+
+#include "utils.h"
+
+#include <QtEndian>
+#include <QDebug>
+
+#include <cstring>
+
+// maximum time to process hops without returning to the event loop when not in realtime mode
+static const int FILE_INPUT_SLICE_DURATION = 20;  // ms
+
+AudioFileInput::AudioFileInput(MonoAudioBuffer* buffer, const QString& fileName, int hopsPerSecond, bool realtime)
+	: QObject(0)
+	, AudioInputInterface(buffer)
+	, m_fileName(fileName)
+	, m_hopsPerSecond(hopsPerSecond)
+	, m_realtime(realtime)
+	, m_dataEnd(0)
+	, m_hopFrames(0)
+	, m_numHops(0)
+	, m_volume(1.0)
+{
+	// files without a WAV header are interpreted as 16bit stereo by default:
+	PcmDecoder::parseFormat("s16le:2:44100", m_rawFormat);
+
+	// in realtime mode the timer checks twice per hop if a new hop is due,
+	// otherwise it processes the file whenever the event loop is idle:
+	m_timer.setTimerType(Qt::PreciseTimer);
+	m_timer.setInterval(m_realtime ? qMax(1, 1000 / m_hopsPerSecond / 2) : 0);
+	connect(&m_timer, SIGNAL(timeout()), this, SLOT(processHops()));
+}
+
+AudioFileInput::~AudioFileInput()
+{
+	closeFile();
+}
+
+void AudioFileInput::setInputByName(const QString& name)
+{
+	closeFile();
+
+	m_file.setFileName(name);
+	if (!m_file.open(QIODevice::ReadOnly)) {
+		qWarning() << "Could not open audio file" << name << ":" << m_file.errorString();
+		return;
+	}
+
+	// use the format of the WAV header or the raw format if there is no header:
+	if (!readWavHeader()) {
+		m_file.seek(0);
+		m_format = m_rawFormat;
+		m_dataEnd = m_file.size();
+	}
+
+	// 8bit unsigned, 16, 24 and 32bit signed and 32bit float samples are supported:
+	if (!m_decoder.setFormat(m_format)) {
+		qWarning() << "Unsupported sample format in audio file" << name;
+		closeFile();
+		return;
+	}
+	m_buffer->setInputSampleRate(m_format.sampleRate(), m_realtime);
+
+	m_activeInputName = name;
+	m_hopFrames = qMax(1, m_format.sampleRate() / m_hopsPerSecond);
+	m_decoder.setGain(m_volume);
+	m_readBuffer.resize(m_hopFrames * m_decoder.getBytesPerFrame());
+	m_numHops = 0;
+	m_elapsedTimer.start();
+	m_timer.start();
+}
+
+void AudioFileInput::setVolume(const qreal& value)
+{
+	m_volume = limit(0, value, 1);
+	m_decoder.setGain(m_volume);
+}
+
+bool AudioFileInput::setRawFormat(const QString& description)
+{
+	return PcmDecoder::parseFormat(description, m_rawFormat);
+}
+
+void AudioFileInput::processHops()
+{
+	if (m_realtime) {
+		// process all hops that are due according to the wall-clock time:
+		const qint64 framesDue = m_elapsedTimer.elapsed() * m_format.sampleRate() / 1000;
+		while (m_numHops * m_hopFrames < framesDue) {
+			if (!processNextHop()) break;
+		}
+	} else {
+		// process as many hops as possible, but return to the event loop regularly:
+		QElapsedTimer sliceTimer;
+		sliceTimer.start();
+		while (sliceTimer.elapsed() < FILE_INPUT_SLICE_DURATION) {
+			if (!processNextHop()) break;
+		}
+	}
+
+	if (m_timer.isActive()) return;
+
+	// the end of the file has been reached:
+	const qreal audioDuration = qreal(m_numHops * m_hopFrames) / m_format.sampleRate();
+	const qreal wallDuration = m_elapsedTimer.elapsed() / 1000.0;
+	qDebug() << "Processed" << audioDuration << "s of audio from" << m_activeInputName << "in" << wallDuration << "s"
+			 << "(" << (wallDuration > 0 ? audioDuration / wallDuration : 0.0) << "x realtime )";
+	emit finished();
+}
+
+bool AudioFileInput::processNextHop()
+{
+	const int bytesPerFrame = m_decoder.getBytesPerFrame();
+	const qint64 bytesLeft = m_dataEnd - m_file.pos();
+	const qint64 bytesToRead = qMin(qint64(m_readBuffer.size()), bytesLeft - bytesLeft % bytesPerFrame);
+	const qint64 bytesRead = bytesToRead > 0 ? m_file.read(m_readBuffer.data(), bytesToRead) : 0;
+	if (bytesRead < bytesPerFrame) {
+		m_timer.stop();
+		return false;
+	}
+
+	// Call MonoAudioBuffer as next element in processing chain:
+	m_buffer->putSamples(m_readBuffer.constData(), int(bytesRead / bytesPerFrame), m_decoder);
+	++m_numHops;
+	emit hopReady();
+	return true;
+}
+
+bool AudioFileInput::readWavHeader()
+{
+	char riffHeader[12];
+	if (m_file.read(riffHeader, 12) != 12) return false;
+	if (std::memcmp(riffHeader, "RIFF", 4) != 0 || std::memcmp(riffHeader + 8, "WAVE", 4) != 0) return false;
+
+	bool formatFound = false;
+	char chunkHeader[8];
+	while (m_file.read(chunkHeader, 8) == 8) {
+		const qint64 chunkStart = m_file.pos();
+		const quint32 chunkSize = qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(chunkHeader + 4));
+
+		if (std::memcmp(chunkHeader, "fmt ", 4) == 0) {
+			QByteArray fmt = m_file.read(qMin(chunkSize, quint32(40)));
+			if (fmt.size() < 16) return false;
+			const uchar* p = reinterpret_cast<const uchar*>(fmt.constData());
+			quint16 formatTag = qFromLittleEndian<quint16>(p);
+			// WAVE_FORMAT_EXTENSIBLE stores the actual format in the first bytes of the sub format GUID:
+			if (formatTag == 0xFFFE && fmt.size() >= 26) formatTag = qFromLittleEndian<quint16>(p + 24);
+			if (formatTag != 1 && formatTag != 3) return false;  // only PCM and IEEE float
+
+			const int bitsPerSample = qFromLittleEndian<quint16>(p + 14);
+			m_format.setCodec("audio/pcm");
+			m_format.setChannelCount(qFromLittleEndian<quint16>(p + 2));
+			m_format.setSampleRate(qFromLittleEndian<quint32>(p + 4));
+			m_format.setSampleSize(bitsPerSample);
+			m_format.setByteOrder(QAudioFormat::LittleEndian);
+			if (formatTag == 3) {
+				m_format.setSampleType(QAudioFormat::Float);
+			} else {
+				// 8bit WAV files are unsigned, all others are signed:
+				m_format.setSampleType(bitsPerSample == 8 ? QAudioFormat::UnSignedInt : QAudioFormat::SignedInt);
+			}
+			formatFound = true;
+		} else if (std::memcmp(chunkHeader, "data", 4) == 0) {
+			if (!formatFound) return false;
+			// streamed WAV files may have an invalid data size:
+			m_dataEnd = (chunkSize == 0 || chunkSize == 0xFFFFFFFF) ? m_file.size() : qMin(m_file.size(), chunkStart + chunkSize);
+			return true;
+		}
+
+		// go to the next chunk (chunks are padded to an even size):
+		if (!m_file.seek(chunkStart + chunkSize + (chunkSize & 1))) return false;
+	}
+	return false;
+}
+
+void AudioFileInput::closeFile()
+{
+	m_timer.stop();
+	if (m_file.isOpen()) {
+		m_file.close();
+	}
+	m_activeInputName.clear();
+}
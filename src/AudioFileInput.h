@@ -0,0 +1,121 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef AUDIOFILEINPUT_H
+#define AUDIOFILEINPUT_H
+
+#include "AudioInputInterface.h"
+#include "MonoAudioBuffer.h"
+#include "PcmDecoder.h"
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QFile>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QByteArray>
+#include <QtMultimedia/QAudioFormat>
+
+
+// An AudioInputInterface implementation that streams a WAV or raw PCM file
+// into the MonoAudioBuffer instead of recording from a sound card.
+// see AudioInputInterface.h for documentation of overridden functions
+//
+// The file is either played at wall-clock speed or as fast as the CPU allows.
+// After the samples of each hop have been put into the buffer, hopReady() is emitted,
+// so that the analysis can be driven once per hop by the file instead of by QTimers.
+// This is used to pre-analyze show tracks and to benchmark the processing chain
+// on machines without a sound card.
+class AudioFileInput : public QObject, public AudioInputInterface
+{
+	Q_OBJECT
+
+public:
+	// Creates a file input for the file fileName.
+	// hopsPerSecond is the rate (in realtime) at which hopReady() is emitted.
+	// If realtime is false, the file is processed as fast as possible.
+	explicit AudioFileInput(MonoAudioBuffer* buffer, const QString& fileName, int hopsPerSecond, bool realtime = true);
+	~AudioFileInput() override;
+
+	// returns a list with the file name as the only entry
+	QStringList getAvailableInputs() const override { return QStringList(m_fileName); }
+
+	// returns the file name
+	QString getDefaultInputName() const override { return m_fileName; }
+
+	QString getActiveInputName() const override { return m_activeInputName; }
+	// opens the file with the given name and starts streaming it
+	void setInputByName(const QString& name) override;
+
+	qreal getVolume() const override { return m_volume; }
+	void setVolume(const qreal& value) override;
+
+	// sets the format used for files without a WAV header (raw PCM),
+	// see PcmDecoder::parseFormat() for the format of the description
+	// returns false if the description is not valid
+	bool setRawFormat(const QString& description);
+
+	// returns the format of the opened file
+	const QAudioFormat& getFormat() const { return m_format; }
+
+signals:
+	// emitted after the samples of one hop have been put into the buffer
+	void hopReady();
+
+	// emitted when the end of the file has been reached
+	void finished();
+
+private slots:
+	// reads and processes as many hops as are due
+	// - called periodically by m_timer
+	void processHops();
+
+protected:
+	// reads the header of a RIFF WAVE file, sets m_format and
+	// moves the file position to the beginning of the sample data
+	// returns false if the file is not a supported WAV file
+	bool readWavHeader();
+
+	// reads the next hop from the file and puts it into the MonoAudioBuffer
+	// returns false if the end of the file has been reached
+	bool processNextHop();
+
+	// stops streaming and closes the file
+	void closeFile();
+
+	const QString	m_fileName;  // the name of the file to stream
+	const int		m_hopsPerSecond;  // number of hops per second of audio
+	const bool		m_realtime;  // true if the file is played at wall-clock speed
+	QString			m_activeInputName;  // name of the opened file
+	QFile			m_file;  // the opened file
+	QAudioFormat	m_format;  // the format of the sample data in the file
+	QAudioFormat	m_rawFormat;  // the format to use for files without a WAV header
+	qint64			m_dataEnd;  // file position of the end of the sample data
+	int				m_hopFrames;  // number of frames in one hop
+	qint64			m_numHops;  // number of hops processed since the file was opened
+	qreal			m_volume;  // gain applied to the samples [0...1]
+	PcmDecoder		m_decoder;  // converts the PCM data of the file to mono float samples
+	QByteArray		m_readBuffer;  // buffer for the raw data of one hop
+	QTimer			m_timer;  // timer used to process the file
+	QElapsedTimer	m_elapsedTimer;  // wall-clock time since the file was opened
+};
+
+#endif // AUDIOFILEINPUT_H
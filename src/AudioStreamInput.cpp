@@ -0,0 +1,178 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "AudioStreamInput.h"
+
+#include "utils.h"
+
+#include <QDebug>
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#include <poll.h>
+#endif
+
+
+AudioStreamInput::AudioStreamInput(MonoAudioBuffer* buffer, const QString& sourceName, const QAudioFormat& format)
+	: QThread(0)
+	, AudioInputInterface(buffer)
+	, m_sourceName(sourceName == "-" ? QString(STREAM_STDIN_NAME) : sourceName)
+	, m_activeInputName("")
+	, m_decoder()
+	, m_readBuffer()
+	, m_pendingBytes(0)
+	, m_fd(-1)
+	, m_isStdin(false)
+	, m_volume(1.0f)
+{
+	if (!m_decoder.setFormat(format)) {
+		qWarning() << "Unsupported sample format for stream input, using s16le mono.";
+	}
+	setObjectName("AudioStream");
+}
+
+AudioStreamInput::~AudioStreamInput()
+{
+	requestInterruption();
+	wait();
+	closeSource();
+}
+
+void AudioStreamInput::setInputByName(const QString& name)
+{
+	// stop the reading thread of the previous source:
+	requestInterruption();
+	wait();
+	closeSource();
+
+	m_activeInputName = (name == "-") ? QString(STREAM_STDIN_NAME) : name;
+	m_isStdin = (m_activeInputName == STREAM_STDIN_NAME);
+	m_readBuffer.resize(STREAM_READ_BLOCK_FRAMES * m_decoder.getBytesPerFrame());
+	m_pendingBytes = 0;
+	m_buffer->setInputSampleRate(m_decoder.getFormat().sampleRate());
+
+	start(QThread::TimeCriticalPriority);
+}
+
+void AudioStreamInput::setVolume(const qreal& value)
+{
+	m_volume.store(limit(0, value, 1));
+}
+
+void AudioStreamInput::run()
+{
+	if (!openSource()) return;
+
+	while (!isInterruptionRequested()) {
+		const int bytesRead = readBlock();
+		if (bytesRead < 0) {
+			qWarning() << "Error reading audio stream" << m_activeInputName;
+			break;
+		}
+		if (bytesRead == 0) {
+			if (m_isStdin) {
+				// end of the standard input:
+				emit streamFinished();
+				break;
+			}
+			// the writer closed the FIFO, wait for the next one:
+			closeSource();
+			if (!openSource()) break;
+		}
+	}
+}
+
+bool AudioStreamInput::openSource()
+{
+	if (m_isStdin) {
+		m_fd = 0;
+#ifdef Q_OS_WIN
+		_setmode(m_fd, _O_BINARY);
+#endif
+		return true;
+	}
+
+	// open the FIFO without waiting for a writer (the data is waited for in readBlock()):
+	const QByteArray path = m_activeInputName.toLocal8Bit();
+#ifdef Q_OS_WIN
+	m_fd = _open(path.constData(), _O_RDONLY | _O_BINARY);
+#else
+	m_fd = open(path.constData(), O_RDONLY | O_NONBLOCK);
+#endif
+	if (m_fd < 0) {
+		qWarning() << "Could not open audio stream" << m_activeInputName << ":" << std::strerror(errno);
+		return false;
+	}
+	return true;
+}
+
+int AudioStreamInput::readBlock()
+{
+#ifdef Q_OS_WIN
+	// (no poll() available, the read blocks until data arrives)
+	const int bytesRead = _read(m_fd, m_readBuffer.data() + m_pendingBytes, m_readBuffer.size() - m_pendingBytes);
+#else
+	// wait for data, but check regularly if the thread should stop:
+	pollfd pfd;
+	pfd.fd = m_fd;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	const int ready = poll(&pfd, 1, STREAM_POLL_TIMEOUT);
+	if (ready < 0) return (errno == EINTR) ? 1 : -1;
+	// no data yet (a FIFO without writer also returns here):
+	if (ready == 0) return 1;
+
+	const int bytesRead = int(read(m_fd, m_readBuffer.data() + m_pendingBytes, m_readBuffer.size() - m_pendingBytes));
+	if (bytesRead < 0 && (errno == EAGAIN || errno == EINTR)) return 1;
+#endif
+	if (bytesRead <= 0) return bytesRead;
+
+	// Call MonoAudioBuffer as next element in processing chain:
+	const int bytesPerFrame = m_decoder.getBytesPerFrame();
+	const int availableBytes = m_pendingBytes + bytesRead;
+	const int numFrames = availableBytes / bytesPerFrame;
+	m_decoder.setGain(m_volume.load(std::memory_order_relaxed));
+	m_buffer->putSamples(m_readBuffer.constData(), numFrames, m_decoder);
+
+	// keep an incomplete frame for the next read:
+	m_pendingBytes = availableBytes - numFrames * bytesPerFrame;
+	if (m_pendingBytes > 0) {
+		std::memmove(m_readBuffer.data(), m_readBuffer.constData() + numFrames * bytesPerFrame, m_pendingBytes);
+	}
+	return bytesRead;
+}
+
+void AudioStreamInput::closeSource()
+{
+	if (m_fd > 0) {
+#ifdef Q_OS_WIN
+		_close(m_fd);
+#else
+		close(m_fd);
+#endif
+	}
+	m_fd = -1;
+}
@@ -0,0 +1,111 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef AUDIOSTREAMINPUT_H
+#define AUDIOSTREAMINPUT_H
+
+#include "AudioInputInterface.h"
+#include "MonoAudioBuffer.h"
+#include "PcmDecoder.h"
+
+#include <QThread>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QtMultimedia/QAudioFormat>
+
+#include <atomic>
+
+
+// number of frames that are read from the stream at once
+static const int STREAM_READ_BLOCK_FRAMES = 512;
+
+// time to wait for new data before checking if the reading thread should stop
+static const int STREAM_POLL_TIMEOUT = 100;  // ms
+
+// input name that selects the standard input
+static const char* const STREAM_STDIN_NAME = "stdin";
+
+
+// An AudioInputInterface implementation that reads raw interleaved PCM data
+// from the standard input or a named pipe (FIFO), i.e. from ffmpeg, arecord or a network receiver:
+//   arecord -f S16_LE -c 2 -r 48000 | s2l --input-stream - --raw-format s16le:2:48000
+//   mkfifo /tmp/s2l.pcm && s2l --input-stream /tmp/s2l.pcm --raw-format f32le:1:48000
+// see AudioInputInterface.h for documentation of overridden functions
+//
+// The stream is read block by block in a dedicated thread (the single producer of the buffer)
+// and the samples are put into the MonoAudioBuffer as they arrive, so the source has to deliver
+// the data in realtime (i.e. ffmpeg -re). The read buffer is allocated once per input.
+// When the writer of a FIFO closes it, the FIFO is opened again for the next writer,
+// the end of the standard input stops the input and emits streamFinished().
+class AudioStreamInput : public QThread, public AudioInputInterface
+{
+	Q_OBJECT
+
+public:
+	// Creates a stream input for the source name ("stdin", "-" or the path of a FIFO).
+	// format is the format of the PCM data, see PcmDecoder::parseFormat().
+	explicit AudioStreamInput(MonoAudioBuffer* buffer, const QString& sourceName, const QAudioFormat& format);
+	~AudioStreamInput() override;
+
+	// returns a list with the source name as the only entry
+	QStringList getAvailableInputs() const override { return QStringList(m_sourceName); }
+
+	// returns the source name
+	QString getDefaultInputName() const override { return m_sourceName; }
+
+	QString getActiveInputName() const override { return m_activeInputName; }
+	// stops reading from the active source and starts reading from the given one
+	void setInputByName(const QString& name) override;
+
+	qreal getVolume() const override { return m_volume.load(); }
+	void setVolume(const qreal& value) override;
+
+signals:
+	// emitted when the end of the standard input has been reached
+	// (not named finished(), which is the signal of QThread that is emitted when run() returns)
+	void streamFinished();
+
+protected:
+	// reads the stream until the end of stdin or until an interruption is requested
+	// - runs in the reading thread
+	void run() override;
+
+	// opens m_activeInputName, returns false on error
+	bool openSource();
+
+	// waits up to STREAM_POLL_TIMEOUT for data, reads it and puts the complete frames into the buffer
+	// returns the number of bytes read, 0 at the end of the stream, -1 on error
+	int readBlock();
+
+	// closes the file descriptor (but not the standard input)
+	void closeSource();
+
+	const QString		m_sourceName;  // the name of the source given at construction
+	QString				m_activeInputName;  // name of the source that is read
+	PcmDecoder			m_decoder;  // converts the PCM data to mono float samples
+	QByteArray			m_readBuffer;  // preallocated buffer for one block of raw data
+	int					m_pendingBytes;  // number of bytes of an incomplete frame at the beginning of m_readBuffer
+	int					m_fd;  // file descriptor of the source or -1
+	bool				m_isStdin;  // true if the source is the standard input
+	std::atomic<float>	m_volume;  // gain applied to the samples [0...1]
+};
+
+#endif // AUDIOSTREAMINPUT_H
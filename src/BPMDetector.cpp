@@ -20,7 +20,6 @@
 
 #include "BPMDetector.h"
 
-#include "FFTRealWrapper.h"
 #include "QCircularBuffer.h"
 
 #include <QTime>
@@ -87,7 +86,13 @@
  * This creates an overlap of 87%, which is fine because it ensures a high resolution
  * (172 fps at 44100 kHz) while still including frequencies even under 50Hz. The 256
  * Samples were chosen because we wanted at least 100 fps of prescision, and the 2048
- * were then determined by experiment.
+ * were then determined by experiment. At other sample rates the hop size is scaled
+ * (i.e. 278.6 samples at 48 kHz), so that the frame rate and all timing stay the same.
+ * Optionally the input is decimated by BPM_DECIMATION_FACTOR first (with the same
+ * polyphase filter used to resample the input). Then the FFT and the hop are smaller by
+ * the same factor, so the frequency resolution and the frame rate stay the same while
+ * the energy above a quarter of the sample rate, which contributes little to the onsets,
+ * is discarded. This reduces the cost of the detection on slow machines.
  *
  * 2. Onset Detection `updateOnsets()`
  * -----------------------------------
@@ -150,19 +155,30 @@ static const int NUM_BPM_SAMPLES_EXPONENT = 8;
 static const int NUM_BPM_SAMPLES = qPow(2, NUM_BPM_SAMPLES_EXPONENT);
 
 // the number of samples fft-ed for each sample (more to allow overlap) as an exponent of 2
+// (at REFERENCE_SAMPLE_RATE, the size is scaled with the analyzed sample rate)
 static const int NUM_BPM_FFT_SAMPLES_EXPONENT = 11;
 
 // the number of samples fft-ed for each sample (more to allow overlap
 static const int NUM_BPM_FFT_SAMPLES = qPow(2, NUM_BPM_FFT_SAMPLES_EXPONENT);
 
-// Sampling Rate
-static const int SAMPLE_RATE = 44100;
+// the input is decimated by 2^BPM_DECIMATION_EXPONENT if decimation is enabled
+static const int BPM_DECIMATION_EXPONENT = 2;
+
+static const int BPM_DECIMATION_FACTOR = 1 << BPM_DECIMATION_EXPONENT;
+
+// number of input samples decimated at once
+static const int BPM_DECIMATION_BLOCK_SIZE = 1024;
+
+// Sampling Rate the frame duration is based on
+// (at other sample rates the hop size is scaled, so that all frames have the duration
+// of NUM_BPM_SAMPLES samples at this rate and the timing stays the same)
+static const int REFERENCE_SAMPLE_RATE = 44100;
 
 // the number of seconds to be cached for detection
 static const int SECONDS_TO_CACHE = 5;
 
 // the number of frames to be cached, based on the seconds
-static const int FRAMES_TO_CACHE = (SAMPLE_RATE / NUM_BPM_SAMPLES) * SECONDS_TO_CACHE;
+static const int FRAMES_TO_CACHE = (REFERENCE_SAMPLE_RATE / NUM_BPM_SAMPLES) * SECONDS_TO_CACHE;
 
 // the number of refresh calls to wait before calculating the bpm
 static const int CALLS_TO_WAIT = 5;
@@ -184,16 +200,16 @@ inline float msToBPM(const float ms) {
     return 60000.0 / ms;
 }
 
-inline int frequencyToIndex(const int frequency) {
-    return NUM_BPM_FFT_SAMPLES*frequency / SAMPLE_RATE;
+inline int frequencyToIndex(const int frequency, const int sampleRate, const int fftSize) {
+    return fftSize*frequency / sampleRate;
 }
 
 inline int framesToMs(const int frames) {
-    return frames * NUM_BPM_SAMPLES * 1000 / SAMPLE_RATE;
+    return frames * NUM_BPM_SAMPLES * 1000 / REFERENCE_SAMPLE_RATE;
 }
 
 inline int msToFrames(const int ms) {
-    return ms * SAMPLE_RATE / NUM_BPM_SAMPLES / 1000;
+    return ms * REFERENCE_SAMPLE_RATE / NUM_BPM_SAMPLES / 1000;
 }
 
 constexpr int GLOBAL_MIN_BPM = 50;
@@ -225,33 +241,39 @@ inline float bpmInRange(float bpm, const int minBPM) {
 
 BPMDetector::BPMDetector(const MonoAudioBuffer &buffer, BPMOscControler *osc) :
     m_inputBuffer(buffer)
-  , m_lastInputBufferNumSamples(0)
+  , m_sampleRate(0)
+  , m_analysisSampleRate(REFERENCE_SAMPLE_RATE)
+  , m_numOverruns(0)
   , m_refreshesSinceCalculation(0)
   , m_bpm(0)
   , m_framesSinceLastBPMDetection(0)
   , m_minBPM(75)
-  , m_fft()
-  , m_window(NUM_BPM_FFT_SAMPLES)
+  , m_decimationEnabled(false)
+  , m_decimating(false)
+  , m_decimator()
+  , m_decimatedBuffer(buffer.getCapacity() / BPM_DECIMATION_FACTOR)
+  , m_decimatorOutput()
+  , m_lastDecimatedSampleNumber(0)
+  , m_stft(NUM_BPM_FFT_SAMPLES_EXPONENT, NUM_BPM_SAMPLES)
   , m_onsetBuffer(FRAMES_TO_CACHE)
   , m_spectralFluxBuffer(FRAMES_TO_CACHE)
   , m_spectralFluxNormalized(FRAMES_TO_CACHE)
   , m_waveColors(FRAMES_TO_CACHE)
-  , m_buffer(NUM_BPM_FFT_SAMPLES)
-  , m_fftOutput(NUM_BPM_FFT_SAMPLES)
-  , m_currentSpectrum(NUM_BPM_FFT_SAMPLES)
-  , m_lastSpectrum(NUM_BPM_FFT_SAMPLES)
+  , m_lastSpectrum(NUM_BPM_FFT_SAMPLES / 2)
   , m_beatStrings()
   , m_lastIntervals(INTERVALS_TO_STORE)
   , m_transmitBpm(false)
   , m_oscController(osc)
 {
-    m_fft = static_cast<BasicFFTInterface*>(new FFTRealWrapper<NUM_BPM_FFT_SAMPLES_EXPONENT>());
-    calculateWindow();
+    // the decimated samples are already filtered and resampled by the input buffer:
+    m_decimatedBuffer.setDcBlockerEnabled(false);
+    m_decimatedBuffer.setResamplingEnabled(false);
+    m_stft.addConsumer(this);
+    configure(m_inputBuffer.getSampleRate());
 }
 
 BPMDetector::~BPMDetector()
 {
-    delete m_fft;
 }
 
 void BPMDetector::resetCache()
@@ -260,15 +282,66 @@ void BPMDetector::resetCache()
     m_onsetBuffer.fill(false);
     m_spectralFluxBuffer.clear();
     m_waveColors.clear();
-    m_lastInputBufferNumSamples = m_inputBuffer.getNumPutSamples();
+    m_lastDecimatedSampleNumber = m_inputBuffer.getNumPutSamples();
+    m_stft.reset(analysisBuffer().getNumPutSamples());
 }
 
-void BPMDetector::calculateWindow()
+void BPMDetector::configure(int sampleRate)
 {
-    // Hann Window function
-    // used to prepare the PCM data for FFT
-    for (int i=0; i<NUM_BPM_FFT_SAMPLES; ++i) {
-        m_window[i] = 0.5f * (1 - qCos((2 * M_PI * i) / (NUM_BPM_FFT_SAMPLES - 1)));
+    m_sampleRate = sampleRate;
+
+    // decimate only if the rate can be divided exactly (the ratio is 1 / BPM_DECIMATION_FACTOR then):
+    m_decimating = m_decimationEnabled && sampleRate % BPM_DECIMATION_FACTOR == 0
+            && m_decimator.setRates(sampleRate, sampleRate / BPM_DECIMATION_FACTOR)
+            && !m_decimator.isBypassed();
+    if (m_decimating) {
+        m_analysisSampleRate = sampleRate / BPM_DECIMATION_FACTOR;
+        m_decimatedBuffer.setInputSampleRate(m_analysisSampleRate, false);
+        m_decimatorOutput.resize(m_decimator.maxOutputSamples(BPM_DECIMATION_BLOCK_SIZE));
+    } else {
+        m_analysisSampleRate = sampleRate;
+    }
+
+    // the frame size is scaled with the analyzed sample rate (to the nearest power of two),
+    // so that a frame covers about the same time and frequency resolution at every rate
+    // (i.e. 4096 samples at 96kHz without resampling instead of a 21ms window):
+    const int rateExponent = qRound(qLn(double(m_analysisSampleRate) / REFERENCE_SAMPLE_RATE) / M_LN2);
+    m_stft.setSizeExponent(NUM_BPM_FFT_SAMPLES_EXPONENT + rateExponent);
+    m_lastSpectrum = QVector<float>(m_stft.getSize() / 2, 0.0f);
+
+    // the hop is scaled with the analyzed sample rate, so that the frame rate stays the same:
+    m_stft.setHopSize(double(NUM_BPM_SAMPLES) * m_analysisSampleRate / REFERENCE_SAMPLE_RATE);
+    resetCache();
+}
+
+void BPMDetector::setDecimationEnabled(bool value)
+{
+    if (value == m_decimationEnabled) return;
+    m_decimationEnabled = value;
+    configure(m_inputBuffer.getSampleRate());
+}
+
+void BPMDetector::updateDecimatedBuffer()
+{
+    // skip the samples that are no longer in the input buffer (i.e. after a pause)
+    // or could be overwritten by the next block of the producer while they are decimated:
+    const int64_t numPutSamples = m_inputBuffer.getNumPutSamples();
+    const int64_t oldestSampleNumber = m_inputBuffer.getOldestIntactSampleNumber() + AUDIO_BUFFER_READ_MARGIN;
+    m_lastDecimatedSampleNumber = qMax(m_lastDecimatedSampleNumber, qMin(oldestSampleNumber, numPutSamples));
+
+    // decimate the new samples block by block, directly from the ring of the input buffer:
+    while (m_lastDecimatedSampleNumber < numPutSamples) {
+        const int count = int(qMin(numPutSamples - m_lastDecimatedSampleNumber, int64_t(BPM_DECIMATION_BLOCK_SIZE)));
+        const AudioSpans spans = m_inputBuffer.getSpans(m_lastDecimatedSampleNumber, count);
+        int numOutputSamples = m_decimator.process(spans.first, spans.firstSize, m_decimatorOutput.data());
+        numOutputSamples += m_decimator.process(spans.second, spans.secondSize, m_decimatorOutput.data() + numOutputSamples);
+        if (m_lastDecimatedSampleNumber < m_inputBuffer.getOldestIntactSampleNumber()) {
+            // the block was overwritten while it was decimated, continue with newer samples in the next call:
+            m_decimator.reset();
+            return;
+        }
+        m_decimatedBuffer.putSamples(m_decimatorOutput.constData(), numOutputSamples);
+        m_lastDecimatedSampleNumber += count;
     }
 }
 
@@ -299,11 +372,30 @@ void BPMDetector::setMinBPM(int value) {
 // 3. evaluate these and smooth the output
 void BPMDetector::detectBPM()
 {
-    // add as many new samples to the spectral flux history as available
-    int64_t currentNumPutSamples = m_inputBuffer.getNumPutSamples();
-    while (currentNumPutSamples - m_lastInputBufferNumSamples > NUM_BPM_FFT_SAMPLES) {
-        updateSpectralFluxes(m_inputBuffer.getCapacity() - (currentNumPutSamples - m_lastInputBufferNumSamples));
-        m_lastInputBufferNumSamples += NUM_BPM_SAMPLES;
+    // restart the detection if the sample rate of the input changed
+    const int sampleRate = m_inputBuffer.getSampleRate();
+    if (sampleRate != m_sampleRate) {
+        configure(sampleRate);
+    }
+
+    // restart the detection if samples of the input were lost,
+    // otherwise the gap would be interpreted as part of the rhythm
+    const int numOverruns = m_inputBuffer.getCaptureClock().getNumOverruns();
+    if (numOverruns != m_numOverruns) {
+        m_numOverruns = numOverruns;
+        resetCache();
+    }
+
+    if (m_decimating) {
+        updateDecimatedBuffer();
+    }
+
+    // add as many new frames to the spectral flux history as available
+    // (the STFT calls processFrame() for each of them, the hop is chosen so that
+    // the frames have exactly the duration of NUM_BPM_SAMPLES at REFERENCE_SAMPLE_RATE):
+    const MonoAudioBuffer& buffer = analysisBuffer();
+    while (m_stft.isFrameAvailable(buffer)) {
+        m_stft.processNextFrame(buffer);
     }
 
     // if the buffer isn't full yet, don't continue
@@ -330,42 +422,29 @@ void BPMDetector::detectBPM()
 }
 
 
-// Calculates the spectral flux for the samples from the given index
+// Calculates the spectral flux of a new frame of the STFT
 // Spectral flux is the sum of only the *increases* in frequency.
 // See "Evaluation of the Audio Beat Tracking System BeatRoot" by Simon Dixon
 // (in Journal of New Music Research, 36, 2007/8) for further detail
-void BPMDetector::updateSpectralFluxes(const int fromIndex)
+void BPMDetector::processFrame(const QVector<float>& magnitudes, int sampleRate)
 {
-    // Stop if the index to go forward from is out of the buffers bound
-    if (fromIndex+NUM_BPM_FFT_SAMPLES >= m_inputBuffer.getCapacity() || fromIndex < 0) {
-        return;
-    }
-
-    // apply hann window to new data to prepare it for the FFT
-    for (int i=0; i < NUM_BPM_FFT_SAMPLES; ++i) {
-        m_buffer[i] = m_inputBuffer.at(fromIndex+i) * m_window[i];
-    }
-
-    // apply FFT:
-    m_fft->doFft(m_fftOutput.data(), m_buffer.constData());
+    const int fftSize = magnitudes.size() * 2;
 
     // calculate spectral flux by adding all increases in energy in each band
     float flux = 0.0;
 
-    for (int i = 0; i < NUM_BPM_FFT_SAMPLES / 2; ++i) {
-        if (m_fftOutput[i] > m_lastSpectrum[i]) {
-            flux += (m_fftOutput[i] - m_lastSpectrum[i]);
-        }
-        if (m_fftOutput[i + NUM_BPM_FFT_SAMPLES / 2] > m_lastSpectrum[i + NUM_BPM_FFT_SAMPLES / 2]) {
-            flux += (m_fftOutput[i + NUM_BPM_FFT_SAMPLES / 2] - m_lastSpectrum[i + NUM_BPM_FFT_SAMPLES / 2]);
+    for (int i = 0; i < magnitudes.size(); ++i) {
+        if (magnitudes[i] > m_lastSpectrum[i]) {
+            flux += (magnitudes[i] - m_lastSpectrum[i]);
         }
     }
 
     // Store the new spectral flux value
-    m_spectralFluxBuffer.push_back(flux);
+    // (scaled to the values of the full size FFT, so that the waveform display stays the same)
+    m_spectralFluxBuffer.push_back(flux * NUM_BPM_FFT_SAMPLES / fftSize);
 
     // Store the spectrum for comparison in the next iteration
-    m_lastSpectrum = m_fftOutput;
+    m_lastSpectrum = magnitudes;
 
 
     // Calculate a color for the gui that represents the spectral content of this sample
@@ -374,16 +453,16 @@ void BPMDetector::updateSpectralFluxes(const int fromIndex)
     int col[] = {0,0,0}; // r,g and b values in 0..255
 
     // Sum up low, mid an high frequencies
-    for (int i = 0; i < frequencyToIndex(200); i++) {
-        col[0] += qAbs(m_fftOutput[i])*1000;
+    for (int i = 0; i < frequencyToIndex(200, sampleRate, fftSize); i++) {
+        col[0] += magnitudes[i]*1000;
     }
 
-    for (int i = frequencyToIndex(200); i < frequencyToIndex(2000); i+=10) {
-        col[1] += qAbs(m_fftOutput[i])*5000;
+    for (int i = frequencyToIndex(200, sampleRate, fftSize); i < frequencyToIndex(2000, sampleRate, fftSize); i+=10) {
+        col[1] += magnitudes[i]*5000;
     }
 
-    for (int i = frequencyToIndex(2000); i < NUM_BPM_FFT_SAMPLES / 2; i+=20) {
-        col[2] += qAbs(m_fftOutput[i])*10000;
+    for (int i = frequencyToIndex(2000, sampleRate, fftSize); i < fftSize / 2; i+=20) {
+        col[2] += magnitudes[i]*10000;
     }
 
     // Normalize so that at least one value is 255
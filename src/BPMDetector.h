@@ -21,9 +21,10 @@
 #ifndef BPMDETECTOR_H
 #define BPMDETECTOR_H
 
-#include "BasicFFTInterface.h"
+#include "STFT.h"
 #include "ScaledSpectrum.h"
 #include "MonoAudioBuffer.h"
+#include "Resampler.h"
 #include "BPMOscControler.h"
 
 #include "QCircularBuffer.h"
@@ -41,11 +42,12 @@ class BeatString;
 
 
 // A class to process the contents of an audio buffer to detect its BPM
-class BPMDetector
+// (the spectral flux and the waveform colors are calculated from the frames of a STFT)
+class BPMDetector : public STFTConsumer
 {
 public:
     explicit BPMDetector(const MonoAudioBuffer& buffer, BPMOscControler* osc);
-    ~BPMDetector();
+    ~BPMDetector() override;
 
     void resetCache(); // to be called when the bpm detection is restarted after a pause, to remove old data from the buffer
 
@@ -61,17 +63,30 @@ public:
 
     void setTransmitBpm(bool value) { m_transmitBpm = value; }
 
+    // returns if the input is decimated before the analysis (see BPM_DECIMATION_FACTOR)
+    bool getDecimationEnabled() const { return m_decimationEnabled; }
+
+    // enables or disables the decimation of the input (restarts the detection)
+    void setDecimationEnabled(bool value);
+
     // Helper functions to display a nice GUI
     const QVector<bool>& getOnsets() { return m_onsetBuffer; }
     const Qt3DCore::QCircularBuffer<float>& getWaveDisplay() { return m_spectralFluxBuffer; }
     const Qt3DCore::QCircularBuffer<QColor>& getWaveColors() { return m_waveColors; }
 
+    // updates the spectral flux and the waveform colors with a new frame of the STFT
+    void processFrame(const QVector<float>& magnitudes, int sampleRate) override;
+
 protected:
-    // calculates a Hann Window for FFT and saves it to m_window
-    void calculateWindow();
+    // configures the FFT, the decimation and the hop size for the sample rate of the input
+    // and restarts the detection
+    void configure(int sampleRate);
+
+    // decimates the samples of the input since the last call into m_decimatedBuffer
+    void updateDecimatedBuffer();
 
-    // updates the arrays of spectral flux values
-    void updateSpectralFluxes(int from);
+    // returns the buffer that is analyzed (the input or the decimated input)
+    const MonoAudioBuffer& analysisBuffer() const { return m_decimating ? m_decimatedBuffer : m_inputBuffer; }
 
     // performs onset recognition
     void updateOnsets();
@@ -86,20 +101,24 @@ protected:
     void evaluateStrings();
 
     const MonoAudioBuffer&              m_inputBuffer; // buffer that stores the audio samples
-    int64_t                             m_lastInputBufferNumSamples; // the number of samples ever put into the buffer when last getting data from there
+    int                                 m_sampleRate; // the sample rate of the input the detection is configured for
+    int                                 m_analysisSampleRate; // the sample rate of the analyzed samples (lower than m_sampleRate if decimating)
+    int                                 m_numOverruns; // the number of overruns of the input when the detection was last restarted
     int                                 m_refreshesSinceCalculation; // used to calculate the bpm every n-th call
     float                               m_bpm; // the detected bpm
     int                                 m_framesSinceLastBPMDetection; // time since the bpm has last changed in frames
     int                                 m_minBPM; // the minimum bpm that sets the range of possible bpms as min to 2*min. That solves the 60 vs 120 BPM debate
-    BasicFFTInterface*                  m_fft; // FFT implementation
-    QVector<float>                      m_window; // array with window data
+    bool                                m_decimationEnabled; // true if the input should be decimated before the analysis
+    bool                                m_decimating; // true if the input is decimated (enabled and the sample rate can be divided)
+    Resampler                           m_decimator; // anti-aliased polyphase decimation of the input
+    MonoAudioBuffer                     m_decimatedBuffer; // the decimated input (only used by this object)
+    QVector<float>                      m_decimatorOutput; // intermediate buffer for the output of m_decimator
+    int64_t                             m_lastDecimatedSampleNumber; // the number of input samples that have been decimated
+    STFT                                m_stft; // calculates the frames of the analyzed buffer (smaller if decimating)
     QVector<bool>                       m_onsetBuffer; // a boolen buffer indicating wether there was a onset i frames ago
     Qt3DCore::QCircularBuffer<float>    m_spectralFluxBuffer; // a float buffer caching the spectral flux of the bands of the last frames
     QVector<float>                      m_spectralFluxNormalized; // a vector to copy the normalized spectral flux data into
     Qt3DCore::QCircularBuffer<QColor>   m_waveColors; // the color for each sample to give spectral information in the GUI
-    QVector<float>                      m_buffer;  // buffer for prepared data (intermediate result)
-    QVector<float>                      m_fftOutput; // buffer for FFT Data
-    QVector<float>                      m_currentSpectrum; // the spectrum currently being calculated
     QVector<float>                      m_lastSpectrum; // the spectrum calculated in the last frame for calculating the spectral flux, which is a difference
     QLinkedList<BeatString>             m_beatStrings; // the IOI Clusters identified from the intervalls
     Qt3DCore::QCircularBuffer<float>    m_lastIntervals; // the last bpm values stored as their interval, to achieve smoothing
@@ -0,0 +1,119 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "BandFilterBank.h"
+
+#include "ScaledSpectrum.h"
+
+#include <QtMath>
+
+BandFilterBank::BandFilterBank()
+	: m_numBands(0)
+	, m_x1(0.0f)
+	, m_x2(0.0f)
+{
+	setup(0, nullptr, nullptr, 0);
+}
+
+void BandFilterBank::setup(int sampleRate, const int* midFreqs, const float* widths, int numBands)
+{
+	m_numBands = sampleRate > 0 ? qMin(numBands, BAND_FILTER_MAX_BANDS) : 0;
+
+	// the ScaledSpectrum spans about 10 octaves:
+	const double octavesOfSpectrum = qLn(double(SCALED_SPECTRUM_MAX_FREQ) / SCALED_SPECTRUM_BASE_FREQ) / M_LN2;
+
+	for (int band=0; band<BAND_FILTER_MAX_BANDS; ++band) {
+		m_b0[band] = m_a1[band] = m_a2[band] = 0.0f;
+		m_release[band] = 0.0f;
+		if (band >= m_numBands) continue;
+
+		// the middle frequency has to be below the nyquist frequency:
+		const double midFreq = qMin(double(midFreqs[band]), 0.45 * sampleRate);
+		const double bandwidth = qMax(0.01, widths[band] * octavesOfSpectrum);  // octaves
+
+		// band-pass with a peak gain of 1 (constant 0dB peak gain, see the Audio EQ Cookbook):
+		const double w0 = 2 * M_PI * midFreq / sampleRate;
+		const double alpha = qSin(w0) * std::sinh(M_LN2 / 2 * bandwidth * w0 / qSin(w0));
+		const double a0 = 1 + alpha;
+		m_b0[band] = alpha / a0;
+		m_a1[band] = -2 * qCos(w0) / a0;
+		m_a2[band] = (1 - alpha) / a0;
+
+		const double releaseTime = qMax(double(BAND_FILTER_MIN_RELEASE_TIME), BAND_FILTER_RELEASE_PERIODS / midFreq);
+		m_release[band] = qExp(-1.0 / (releaseTime * sampleRate));
+	}
+	reset();
+}
+
+void BandFilterBank::reset()
+{
+	for (int band=0; band<BAND_FILTER_MAX_BANDS; ++band) {
+		m_y1[band] = m_y2[band] = m_envelope[band] = 0.0f;
+	}
+	m_x1 = m_x2 = 0.0f;
+}
+
+void BandFilterBank::process(const float* samples, int numSamples, float* maxEnvelopes)
+{
+	if (m_numBands <= 0) return;
+
+	// (local copies of the state, so that the compiler keeps it in registers)
+	float y1[BAND_FILTER_MAX_BANDS];
+	float y2[BAND_FILTER_MAX_BANDS];
+	float envelope[BAND_FILTER_MAX_BANDS];
+	float maxEnvelope[BAND_FILTER_MAX_BANDS];
+	for (int band=0; band<BAND_FILTER_MAX_BANDS; ++band) {
+		y1[band] = m_y1[band];
+		y2[band] = m_y2[band];
+		envelope[band] = m_envelope[band];
+		maxEnvelope[band] = 0.0f;
+	}
+	float x1 = m_x1;
+	float x2 = m_x2;
+
+	for (int i=0; i<numSamples; ++i) {
+		// the input difference of the band-pass is the same for all bands:
+		const float x = samples[i];
+		const float difference = x - x2;
+		x2 = x1;
+		x1 = x;
+
+		// y[n] = b0 * (x[n] - x[n-2]) - a1 * y[n-1] - a2 * y[n-2] for all bands at once:
+		for (int band=0; band<BAND_FILTER_MAX_BANDS; ++band) {
+			const float y = m_b0[band] * difference - m_a1[band] * y1[band] - m_a2[band] * y2[band];
+			y2[band] = y1[band];
+			y1[band] = y;
+			// the envelope follows peaks immediately and decays exponentially:
+			envelope[band] = qMax(qAbs(y), envelope[band] * m_release[band]);
+			maxEnvelope[band] = qMax(maxEnvelope[band], envelope[band]);
+		}
+	}
+
+	for (int band=0; band<BAND_FILTER_MAX_BANDS; ++band) {
+		m_y1[band] = y1[band];
+		m_y2[band] = y2[band];
+		m_envelope[band] = envelope[band];
+	}
+	m_x1 = x1;
+	m_x2 = x2;
+	for (int band=0; band<m_numBands; ++band) {
+		maxEnvelopes[band] = maxEnvelope[band];
+	}
+}
@@ -0,0 +1,83 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef BANDFILTERBANK_H
+#define BANDFILTERBANK_H
+
+
+// maximum number of bands of a BandFilterBank
+// (all bands are calculated at once, 8 floats fill one AVX or two SSE registers)
+static const int BAND_FILTER_MAX_BANDS = 8;
+
+// release time of the envelope followers in periods of the middle frequency of the band
+// (long enough to bridge the gaps between the peaks of a single tone)
+static const float BAND_FILTER_RELEASE_PERIODS = 4.0f;
+
+// minimum release time of the envelope followers
+static const float BAND_FILTER_MIN_RELEASE_TIME = 0.005f;  // s
+
+
+// A bank of band-pass biquads with envelope followers for mono float samples,
+// i.e. to check bandpass triggers directly on the incoming samples without the latency of a FFT window.
+//
+// Each band is a band-pass with a peak gain of 1 designed from the middle frequency
+// and the width of the band, followed by a peak envelope follower.
+// The state of all bands is stored in arrays of BAND_FILTER_MAX_BANDS values,
+// so that each sample is filtered in all bands at once in a loop the compiler can vectorize
+// (unused bands have coefficients of 0).
+class BandFilterBank
+{
+
+public:
+	explicit BandFilterBank();
+
+	// configures numBands bands for sampleRate and resets the filter history
+	// - midFreqs are the middle frequencies in Hz
+	// - widths are the widths of the bands in the scale of a ScaledSpectrum [0...1]
+	//   (the band reaches width/2 of the logarithmic frequency axis below and above the middle frequency)
+	void setup(int sampleRate, const int* midFreqs, const float* widths, int numBands);
+
+	// returns the number of configured bands
+	int getNumBands() const { return m_numBands; }
+
+	// clears the filter history and the envelopes
+	void reset();
+
+	// filters numSamples samples and writes the max envelope of each band during the samples to maxEnvelopes
+	// (getNumBands() values, 1.0 is the peak of a full scale sine in the middle of the band)
+	void process(const float* samples, int numSamples, float* maxEnvelopes);
+
+	// returns the envelope of the band after the last processed sample
+	float getEnvelope(int band) const { return m_envelope[band]; }
+
+protected:
+	int		m_numBands;  // number of configured bands
+	float	m_b0[BAND_FILTER_MAX_BANDS];  // feed-forward coefficient of each band (b1 = 0, b2 = -b0)
+	float	m_a1[BAND_FILTER_MAX_BANDS];  // first feedback coefficient of each band
+	float	m_a2[BAND_FILTER_MAX_BANDS];  // second feedback coefficient of each band
+	float	m_release[BAND_FILTER_MAX_BANDS];  // factor of the envelope per sample while it decays
+	float	m_y1[BAND_FILTER_MAX_BANDS];  // last output sample of each band
+	float	m_y2[BAND_FILTER_MAX_BANDS];  // second to last output sample of each band
+	float	m_envelope[BAND_FILTER_MAX_BANDS];  // envelope of each band
+	float	m_x1;  // last input sample (the same for all bands)
+	float	m_x2;  // second to last input sample
+};
+
+#endif // BANDFILTERBANK_H
@@ -0,0 +1,110 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "BandFilterMeter.h"
+
+#include <QtMath>
+
+
+namespace {
+
+// sets target to value if value is greater
+void storeMax(std::atomic<float>& target, float value)
+{
+	float current = target.load(std::memory_order_relaxed);
+	while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+}  // namespace
+
+
+BandFilterMeter::BandFilterMeter()
+	: m_numBands(0)
+	, m_revision(0)
+	, m_revisionApplied(0)
+	, m_sampleRateApplied(0)
+	, m_filters()
+{
+	for (int band=0; band<BAND_FILTER_MAX_BANDS; ++band) {
+		m_midFreqs[band].store(0);
+		m_widths[band].store(0.0f);
+		m_heldLevels[band].store(0.0f);
+		m_levels[band].store(0.0f);
+	}
+}
+
+void BandFilterMeter::setBands(const int* midFreqs, const float* widths, int numBands)
+{
+	numBands = limit(0, numBands, BAND_FILTER_MAX_BANDS);
+	bool changed = numBands != m_numBands.load(std::memory_order_relaxed);
+	for (int band=0; band<numBands && !changed; ++band) {
+		changed = midFreqs[band] != m_midFreqs[band].load(std::memory_order_relaxed)
+				|| widths[band] != m_widths[band].load(std::memory_order_relaxed);
+	}
+	if (!changed) return;
+
+	for (int band=0; band<numBands; ++band) {
+		m_midFreqs[band].store(midFreqs[band], std::memory_order_relaxed);
+		m_widths[band].store(widths[band], std::memory_order_relaxed);
+	}
+	m_numBands.store(numBands, std::memory_order_relaxed);
+	m_revision.fetch_add(1, std::memory_order_release);
+}
+
+void BandFilterMeter::takeLevels(float* levels, int numBands)
+{
+	for (int band=0; band<qMin(numBands, BAND_FILTER_MAX_BANDS); ++band) {
+		levels[band] = qMax(m_heldLevels[band].exchange(0.0f, std::memory_order_relaxed),
+							m_levels[band].load(std::memory_order_relaxed));
+	}
+}
+
+void BandFilterMeter::samplesWritten(const float* samples, int numSamples, int sampleRate)
+{
+	if (m_revision.load(std::memory_order_acquire) != m_revisionApplied || sampleRate != m_sampleRateApplied) {
+		updateFilters(sampleRate);
+	}
+
+	const int numBands = m_filters.getNumBands();
+	if (numBands <= 0) return;
+	float maxEnvelopes[BAND_FILTER_MAX_BANDS];
+	m_filters.process(samples, numSamples, maxEnvelopes);
+	for (int band=0; band<numBands; ++band) {
+		storeMax(m_heldLevels[band], maxEnvelopes[band]);
+		m_levels[band].store(m_filters.getEnvelope(band), std::memory_order_relaxed);
+	}
+}
+
+void BandFilterMeter::updateFilters(int sampleRate)
+{
+	m_revisionApplied = m_revision.load(std::memory_order_acquire);
+	m_sampleRateApplied = sampleRate;
+	int midFreqs[BAND_FILTER_MAX_BANDS];
+	float widths[BAND_FILTER_MAX_BANDS];
+	const int numBands = m_numBands.load(std::memory_order_relaxed);
+	for (int band=0; band<numBands; ++band) {
+		midFreqs[band] = m_midFreqs[band].load(std::memory_order_relaxed);
+		widths[band] = m_widths[band].load(std::memory_order_relaxed);
+	}
+	m_filters.setup(sampleRate, midFreqs, widths, numBands);
+	for (int band=0; band<BAND_FILTER_MAX_BANDS; ++band) {
+		m_levels[band].store(0.0f, std::memory_order_relaxed);
+	}
+}
@@ -0,0 +1,73 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef BANDFILTERMETER_H
+#define BANDFILTERMETER_H
+
+#include "BandFilterBank.h"
+#include "MonoAudioBuffer.h"
+
+#include <atomic>
+
+
+// Measures the envelopes of up to BAND_FILTER_MAX_BANDS frequency bands with a BandFilterBank
+// while the samples are written to a MonoAudioBuffer (set it with MonoAudioBuffer::setBlockListener()).
+// The bands are requested and the envelopes are taken by the thread of the triggers,
+// the filters run in the producer thread of the buffer.
+// Both sides only exchange atomic values, so the producer never waits or allocates memory.
+class BandFilterMeter : public MonoAudioBuffer::BlockListener
+{
+
+public:
+	explicit BandFilterMeter();
+
+	// sets the bands whose envelopes are measured
+	// (numBands bands up to BAND_FILTER_MAX_BANDS, 0 to disable the filters, see BandFilterBank::setup())
+	// - can be called from any thread, applied with the next samples written to the buffer
+	//   (the filters are only reset if the bands have changed)
+	void setBands(const int* midFreqs, const float* widths, int numBands);
+
+	// writes the max envelope of each band since the last call to levels (numBands values)
+	// (at least the current envelope, even if no samples have been written since the last call)
+	// - can be called from any thread, but only one reader should take the levels
+	void takeLevels(float* levels, int numBands);
+
+	// filters the samples in all requested bands (called by the producer of the buffer)
+	void samplesWritten(const float* samples, int numSamples, int sampleRate) override;
+
+protected:
+	// configures the filters for sampleRate and the requested bands
+	// - called in the producer thread
+	void updateFilters(int sampleRate);
+
+	std::atomic<int>		m_midFreqs[BAND_FILTER_MAX_BANDS];  // middle frequencies of the requested bands
+	std::atomic<float>		m_widths[BAND_FILTER_MAX_BANDS];  // widths of the requested bands
+	std::atomic<int>		m_numBands;  // number of requested bands
+	std::atomic<unsigned>	m_revision;  // incremented when the requested bands change
+	std::atomic<float>		m_heldLevels[BAND_FILTER_MAX_BANDS];  // max envelopes since the last takeLevels()
+	std::atomic<float>		m_levels[BAND_FILTER_MAX_BANDS];  // envelopes after the latest samples
+
+	// only used by the producer thread:
+	unsigned				m_revisionApplied;  // the value of m_revision the filters are configured for
+	int						m_sampleRateApplied;  // the sample rate the filters are configured for
+	BandFilterBank			m_filters;  // measures the envelopes of the requested bands
+};
+
+#endif // BANDFILTERMETER_H
@@ -0,0 +1,107 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "CaptureClock.h"
+
+#include <QtGlobal>
+
+
+CaptureClock::CaptureClock()
+	: m_sampleRate(0)
+	, m_enabled(false)
+	, m_started(false)
+	, m_referenceTime()
+	, m_receivedDuration(0)
+	, m_averageBlockDuration(0)
+	, m_deficitPending(false)
+	, m_minPendingDeficit(0)
+	, m_blocksWithoutCatchUp(0)
+	, m_numOverruns(0)
+	, m_numUnderruns(0)
+	, m_numLostSamples(0)
+{
+}
+
+void CaptureClock::start(int sampleRate, bool realtime)
+{
+	m_sampleRate = sampleRate;
+	m_enabled = realtime && sampleRate > 0;
+	m_started = false;
+	m_deficitPending = false;
+}
+
+void CaptureClock::addBlock(int numFrames, HighResTime::monotonic_time_point_t arrivalTime)
+{
+	if (!m_enabled) return;
+
+	const double blockDuration = double(numFrames) / m_sampleRate;
+
+	if (!m_started) {
+		// the samples of the first block were captured before it arrived:
+		m_referenceTime = arrivalTime;
+		moveReference(-blockDuration);
+		m_receivedDuration = blockDuration;
+		m_averageBlockDuration = blockDuration;
+		m_started = true;
+		return;
+	}
+
+	m_receivedDuration += blockDuration;
+	m_averageBlockDuration += (blockDuration - m_averageBlockDuration) * CAPTURE_CLOCK_BLOCK_AVERAGING;
+	const double tolerance = getTolerance();
+
+	// deficit > 0 means that less samples arrived than the elapsed time requires:
+	const double deficit = HighResTime::diff(arrivalTime, m_referenceTime) - m_receivedDuration;
+
+	if (m_deficitPending) {
+		if (deficit <= tolerance) {
+			// the samples only arrived late:
+			m_numUnderruns.fetch_add(1, std::memory_order_relaxed);
+			m_deficitPending = false;
+		} else if (deficit < m_minPendingDeficit - blockDuration / 2) {
+			// the late samples are still being caught up:
+			m_minPendingDeficit = deficit;
+			m_blocksWithoutCatchUp = 0;
+		} else if (++m_blocksWithoutCatchUp >= XRUN_CONFIRMATION_BLOCKS) {
+			// the input is back at its normal pace, the rest of the deficit is lost:
+			const double lostDuration = qMin(deficit, m_minPendingDeficit);
+			m_numOverruns.fetch_add(1, std::memory_order_relaxed);
+			m_numLostSamples.fetch_add(qRound64(lostDuration * m_sampleRate), std::memory_order_relaxed);
+			moveReference(lostDuration);
+			m_deficitPending = false;
+		}
+	} else if (deficit > tolerance) {
+		m_deficitPending = true;
+		m_minPendingDeficit = deficit;
+		m_blocksWithoutCatchUp = 0;
+	} else if (deficit < 0) {
+		// the block arrived earlier than any block before (the clock of the input is faster
+		// or the first blocks were delayed), the reference follows the earliest arrival:
+		moveReference(deficit);
+	} else {
+		// follow a slower clock of the input, but not faster than CAPTURE_CLOCK_MAX_DRIFT:
+		moveReference(qMin(deficit, blockDuration * CAPTURE_CLOCK_MAX_DRIFT));
+	}
+}
+
+void CaptureClock::moveReference(double seconds)
+{
+	m_referenceTime += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+}
@@ -0,0 +1,113 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef CAPTURECLOCK_H
+#define CAPTURECLOCK_H
+
+#include "utils.h"
+
+#include <atomic>
+#include <cstdint>
+
+
+// allowed deviation between the duration of the received samples and the elapsed time
+// in blocks of the input (a driver may deliver a block up to about one block late)
+static const double XRUN_TOLERANCE_BLOCKS = 1.5;
+
+// allowed deviation in addition to XRUN_TOLERANCE_BLOCKS for the jitter of the scheduler
+static const double XRUN_MIN_TOLERANCE = 0.002;  // s
+
+// number of blocks a deficit of samples has to persist without being caught up
+// to be counted as lost samples (late blocks are usually delivered in a burst)
+static const int XRUN_CONFIRMATION_BLOCKS = 4;
+
+// max relative drift between the audio clock and the system clock that is followed
+// (the reference time moves at most by this fraction of each block)
+static const double CAPTURE_CLOCK_MAX_DRIFT = 0.001;
+
+// weight of a new block in the average block duration the tolerance is derived from
+static const double CAPTURE_CLOCK_BLOCK_AVERAGING = 0.1;
+
+
+// Compares the number of samples delivered by an input with the elapsed monotonic time
+// to detect dropouts of the audio stream.
+//
+// The reference time is the estimated capture time of the first sample. It follows the earliest
+// arrivals of the blocks and moves forward by at most CAPTURE_CLOCK_MAX_DRIFT, so that the drift of
+// the clocks is followed, but a dropout is not absorbed before it is classified.
+// A deficit of samples larger than the tolerance (XRUN_TOLERANCE_BLOCKS average blocks plus
+// XRUN_MIN_TOLERANCE, i.e. 11ms for blocks of 256 samples at 44.1kHz) starts an event
+// that is counted exactly once, either as overrun or as underrun:
+//
+// Overrun: the deficit persisted for XRUN_CONFIRMATION_BLOCKS blocks without being caught up,
+//          i.e. the buffer of the device overflowed and samples were lost.
+//          The signal in the MonoAudioBuffer is discontinuous at this point.
+// Underrun: the missing samples arrived late and the deficit was caught up,
+//          the analysis had no new data in the meantime.
+//
+// addBlock() is called by the producer thread, the counters can be read from any thread.
+class CaptureClock
+{
+
+public:
+	explicit CaptureClock();
+
+	// restarts the measurement for an input with the given sample rate
+	// realtime is false if the input is not bound to the wall clock (i.e. fast file processing),
+	// the detection is disabled then
+	void start(int sampleRate, bool realtime);
+
+	// checks the timing of a block of numFrames input frames that arrived at the given time
+	void addBlock(int numFrames, HighResTime::monotonic_time_point_t arrivalTime);
+
+	// returns the current tolerance of the detection in seconds
+	// - only valid in the producer thread
+	double getTolerance() const { return XRUN_TOLERANCE_BLOCKS * m_averageBlockDuration + XRUN_MIN_TOLERANCE; }
+
+	// returns the number of detected overruns since the start of the application
+	int getNumOverruns() const { return m_numOverruns.load(std::memory_order_relaxed); }
+
+	// returns the number of detected underruns since the start of the application
+	int getNumUnderruns() const { return m_numUnderruns.load(std::memory_order_relaxed); }
+
+	// returns the estimated number of input samples lost by all overruns
+	int64_t getNumLostSamples() const { return m_numLostSamples.load(std::memory_order_relaxed); }
+
+protected:
+	// moves the reference time by the given number of seconds
+	void moveReference(double seconds);
+
+	// only used by the producer thread:
+	int										m_sampleRate;  // sample rate of the input
+	bool									m_enabled;  // false if the input is not a realtime input
+	bool									m_started;  // true if the first block has arrived
+	HighResTime::monotonic_time_point_t		m_referenceTime;  // the time the received samples are counted from
+	double									m_receivedDuration;  // duration of the samples received since m_referenceTime in seconds
+	double									m_averageBlockDuration;  // average duration of the received blocks in seconds
+	bool									m_deficitPending;  // true if there is a deficit of samples that is not yet classified
+	double									m_minPendingDeficit;  // smallest deficit since the pending deficit was detected in seconds
+	int										m_blocksWithoutCatchUp;  // number of blocks since the pending deficit last decreased
+
+	std::atomic<int>						m_numOverruns;  // number of detected overruns
+	std::atomic<int>						m_numUnderruns;  // number of detected underruns
+	std::atomic<int64_t>					m_numLostSamples;  // estimated number of lost samples
+};
+
+#endif // CAPTURECLOCK_H
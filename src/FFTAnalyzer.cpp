@@ -20,69 +20,370 @@
 
 #include "FFTAnalyzer.h"
 
-#include "FFTRealWrapper.h"
-
-FFTAnalyzer::FFTAnalyzer(const MonoAudioBuffer& buffer,QVector<TriggerGeneratorInterface*>& triggerContainer)
+FFTAnalyzer::FFTAnalyzer(MonoAudioBuffer& buffer,QVector<TriggerGeneratorInterface*>& triggerContainer, int channel)
 	: m_inputBuffer(buffer)
 	, m_triggerContainer(triggerContainer)
-	, m_fft(0)
-	, m_buffer(NUM_SAMPLES)
-	, m_window(NUM_SAMPLES)
-	, m_fftOutput(NUM_SAMPLES)
-	, m_linearSpectrum(NUM_SAMPLES / 2)
+	, m_channel(channel)
+	, m_levels()
+	, m_sizeExponent(NUM_SAMPLES_EXPONENT)
+	, m_stft(NUM_SAMPLES_EXPONENT, double(buffer.getSampleRate()) / FFT_HOP_RATE)
+	, m_multiResolution(false)
+	, m_shortStfts()
+	, m_linearSpectrum()
 	, m_scaledSpectrum(SCALED_SPECTRUM_BASE_FREQ, SCALED_SPECTRUM_LENGTH)
+	, m_bandpassEngine(FFTBandpassEngine)
+	, m_slidingDfts()
+	, m_bandPosition(0)
+	, m_bandRanges()
+	, m_triggerRanges()
+	, m_bandLinearSpectrum()
+	, m_bandSpectrum(SCALED_SPECTRUM_BASE_FREQ, SCALED_SPECTRUM_LENGTH)
+	, m_bandFilterMeter()
+	, m_filterPosition(0)
 {
-	m_fft = (BasicFFTInterface*) new FFTRealWrapper<NUM_SAMPLES_EXPONENT>();
-	calculateWindow();
+	m_stft.reset(buffer.getNumPutSamples());
+	m_stft.addConsumer(this);
+	updateResolutions();
+	// (the gain is taken from m_scaledSpectrum, whose AGC sees the whole spectrum)
+	m_bandSpectrum.setAgcEnabled(false);
 }
 
 FFTAnalyzer::~FFTAnalyzer()
 {
-	delete m_fft;
+	if (m_bandpassEngine == FilterBankBandpassEngine) {
+		m_inputBuffer.setBlockListener(nullptr);
+	}
+	qDeleteAll(m_shortStfts);
+	qDeleteAll(m_slidingDfts);
+}
+
+void FFTAnalyzer::setSizeExponent(int value)
+{
+	value = limit(MIN_NUM_SAMPLES_EXPONENT, value, MAX_NUM_SAMPLES_EXPONENT);
+	if (value == m_sizeExponent) return;
+	m_sizeExponent = value;
+
+	// the next frame ends at the same sample, so the analysis continues without a gap:
+	m_stft.setSizeExponent(value);
+	m_scaledSpectrum.setFftSize(m_stft.getSize());
+	updateResolutions();
 }
 
-void FFTAnalyzer::calculateWindow()
+void FFTAnalyzer::setMultiResolution(bool value)
 {
-	// Hann Window function
-	// used to prepare the PCM data for FFT
-	for (int i=0; i<NUM_SAMPLES; ++i) {
-		m_window[i] = 0.5f * (1 - qCos((2 * M_PI * i) / (NUM_SAMPLES - 1)));
+	if (value == m_multiResolution) return;
+	m_multiResolution = value;
+	updateResolutions();
+}
+
+void FFTAnalyzer::setBandpassEngine(BandpassEngine value)
+{
+	if (value == m_bandpassEngine) return;
+	m_bandpassEngine = value;
+	updateSlidingDfts();
+	// the filters only run in the producer thread of the buffer while they are used:
+	if (value == FilterBankBandpassEngine) {
+		m_inputBuffer.setBlockListener(&m_bandFilterMeter);
+	} else {
+		m_inputBuffer.setBlockListener(nullptr);
+		m_bandFilterMeter.setBands(nullptr, nullptr, 0);
+	}
+}
+
+void FFTAnalyzer::setPowerDomain(bool value)
+{
+	m_stft.setSpectrumType(value ? PowerSpectrum : MagnitudeSpectrum);
+	for (STFT* stft: m_shortStfts) {
+		stft->setSpectrumType(m_stft.getSpectrumType());
+	}
+	m_scaledSpectrum.setPowerDomain(value);
+}
+
+void FFTAnalyzer::updateResolutions()
+{
+	qDeleteAll(m_shortStfts);
+	m_shortStfts.clear();
+
+	QVector<int> lengths;
+	lengths.append(m_stft.getSize() / 2);
+	int sizeExponent = m_sizeExponent;
+	for (int i=1; m_multiResolution && i < MULTI_RESOLUTION_NUM_FFTS; ++i) {
+		const int shortExponent = qMax(MIN_NUM_SAMPLES_EXPONENT, sizeExponent - MULTI_RESOLUTION_STEP_EXPONENT);
+		if (shortExponent == sizeExponent) break;
+		sizeExponent = shortExponent;
+
+		// (the hop size is not used, the frames are aligned with those of m_stft)
+		STFT* stft = new STFT(shortExponent, m_stft.getHopSize());
+		stft->setSpectrumType(m_stft.getSpectrumType());
+		m_shortStfts.append(stft);
+		lengths.append(stft->getSize() / 2);
+	}
+
+	int totalLength = 0;
+	for (int length: lengths) totalLength += length;
+	m_linearSpectrum = QVector<float>(totalLength, 0.0f);
+	m_bandLinearSpectrum = QVector<float>(totalLength, 0.0f);
+	m_scaledSpectrum.setResolutions(lengths);
+	updateSlidingDfts();
+}
+
+void FFTAnalyzer::updateSlidingDfts()
+{
+	qDeleteAll(m_slidingDfts);
+	m_slidingDfts.clear();
+	// (the bins are set with the next call of updateBandBins())
+	m_bandRanges.clear();
+	m_bandPosition = 0;
+	if (m_bandpassEngine != SlidingDFTBandpassEngine) return;
+
+	m_slidingDfts.append(new SlidingDFT(m_stft.getSize()));
+	for (STFT* stft: m_shortStfts) {
+		m_slidingDfts.append(new SlidingDFT(stft->getSize()));
+	}
+}
+
+void FFTAnalyzer::updateBandBins()
+{
+	m_triggerRanges.clear();
+	for (TriggerGeneratorInterface* trigger: m_triggerContainer) {
+		if (trigger->getChannel() != m_channel || !trigger->isBandpass()) continue;
+		int startIndex;
+		int endIndex;
+		m_bandSpectrum.getIndexRange(trigger->getMidFreq(), trigger->getWidth(), startIndex, endIndex);
+		m_triggerRanges.append(startIndex);
+		m_triggerRanges.append(endIndex);
+	}
+	if (m_triggerRanges == m_bandRanges) return;
+	m_bandRanges = m_triggerRanges;
+
+	// find the bins of each FFT size that are used for the scaled bins of the bands
+	// (the linear spectrum is the concatenation of the spectra of all sizes, see updateResolutions()):
+	m_bandLinearSpectrum.fill(0.0f);
+	int offset = 0;
+	for (SlidingDFT* dft: m_slidingDfts) {
+		const int length = dft->getWindowSize() / 2;
+		QVector<int> bins;
+		for (int range=0; range < m_bandRanges.size(); range += 2) {
+			for (int i=m_bandRanges[range]; i <= m_bandRanges[range+1]; ++i) {
+				int firstIndex;
+				int numBins;
+				m_bandSpectrum.getLinearBins(i, firstIndex, numBins);
+				for (int j=firstIndex; j < firstIndex + numBins; ++j) {
+					const int bin = j - offset;
+					if (bin >= 0 && bin < length && !bins.contains(bin)) bins.append(bin);
+				}
+			}
+		}
+		dft->setBins(bins);
+		offset += length;
 	}
 }
 
 void FFTAnalyzer::calculateFFT(bool lowSoloMode)
 {
-	// apply window:
-	int bufferOffset = m_inputBuffer.getCapacity() - NUM_SAMPLES;
-	for (int i=0; i < NUM_SAMPLES; ++i) {
-		m_buffer[i] = m_inputBuffer.at(i + bufferOffset) * m_window[i];
+	bool newLevels = true;
+	while (isHopAvailable()) {
+		analyze();
+		checkTriggers(lowSoloMode, newLevels);
+		newLevels = false;
 	}
+}
+
+bool FFTAnalyzer::isHopAvailable() const
+{
+	return m_stft.isFrameAvailable(m_inputBuffer);
+}
+
+int FFTAnalyzer::getSamplesUntilNextHop() const
+{
+	return int(qMax(int64_t(0), m_stft.getNextFrameEnd() - m_inputBuffer.getNumPutSamples()));
+}
+
+void FFTAnalyzer::analyze()
+{
+	// the hop is scaled with the sample rate of the input, so that the frame rate stays FFT_HOP_RATE:
+	m_stft.setHopSize(double(m_inputBuffer.getSampleRate()) / FFT_HOP_RATE);
+
+	// calculates the next frame and calls processFrame():
+	m_stft.processNextFrame(m_inputBuffer);
+}
 
-	// apply FFT:
-	m_fft->doFft(m_fftOutput.data(), m_buffer.constData());
+void FFTAnalyzer::processFrame(const QVector<float>& spectrum, int sampleRate)
+{
+	// adapt the frequency mapping to the sample rate of the input:
+	if (sampleRate != m_scaledSpectrum.getSampleRate()) {
+		m_scaledSpectrum.setSampleRate(sampleRate);
+	}
 
-	// convert complex output of FFT to real numbers:
-	for (int i=0; i < NUM_SAMPLES / 2; ++i) {
-		const float real = m_fftOutput[i];
-		const float img = m_fftOutput[NUM_SAMPLES / 2 + i];
-		const float energy = qSqrt(real*real + img*img) / 10;
-		m_linearSpectrum[i] = energy;
+	// the magnitudes are scaled by 1/10, the powers by 1/100:
+	const bool powerDomain = m_scaledSpectrum.getPowerDomain();
+	const float scale = powerDomain ? 0.01f : 0.1f;
+	float* linear = m_linearSpectrum.data();
+	for (int i=0; i < spectrum.size(); ++i) {
+		linear[i] = spectrum[i] * scale;
 	}
 	// first value is 0Hz / DC value and is not usefull:
-	m_linearSpectrum[0] = 0.0;
+	linear[0] = 0.0;
+
+	// append the spectra of the shorter FFTs that end at the same sample:
+	int offset = spectrum.size();
+	for (STFT* stft: m_shortStfts) {
+		if (!stft->processFrameAt(m_inputBuffer, m_stft.getLastFrameEnd())) {
+			// (the shorter frame was overwritten while it was read, the ScaledSpectrum keeps the last frame)
+			return;
+		}
+		const QVector<float>& shortSpectrum = stft->getSpectrum();
+
+		// the magnitude of a sine grows linearly with the number of samples,
+		// so the values are scaled to the energies of the main FFT
+		// (broadband signals like noise grow with the square root of the number of samples,
+		// their magnitudes are too low by the square root of sizeRatio, see setMultiResolution()):
+		const float sizeRatio = float(m_stft.getSize()) / stft->getSize();
+		const float shortScale = scale * (powerDomain ? sizeRatio * sizeRatio : sizeRatio);
+		for (int i=0; i < shortSpectrum.size(); ++i) {
+			linear[offset + i] = shortSpectrum[i] * shortScale;
+		}
+		linear[offset] = 0.0;
+		offset += shortSpectrum.size();
+	}
 
 	// give linear spectrum to ScaledSpectrum object to be scalled:
 	m_scaledSpectrum.updateWithLinearSpectrum(m_linearSpectrum);
+}
+
+void FFTAnalyzer::checkTriggers(bool lowSoloMode, bool newLevels)
+{
+	// the levels of the blocks since the last check (measured by the buffer while writing the samples):
+	if (newLevels) {
+		m_levels = m_inputBuffer.takeLevels();
+	}
+	const AudioLevels& levels = m_levels;
 
     // next element in processing chain: TriggerGenerators
     bool triggered = false;
     for (int i=0; i<m_triggerContainer.size(); ++i) {
         TriggerGeneratorInterface* trigger = m_triggerContainer[i];
+        if (trigger->getChannel() != m_channel) continue;
         if (trigger->isBandpass()) {
-            bool active = trigger->checkForTrigger(m_scaledSpectrum, lowSoloMode && triggered);
+            // (checked by checkBandTriggers() with the other engines)
+            if (m_bandpassEngine != FFTBandpassEngine) continue;
+            bool active = trigger->checkForTrigger(m_scaledSpectrum, levels, lowSoloMode && triggered);
             triggered = triggered || active;
         } else {
-            trigger->checkForTrigger(m_scaledSpectrum, false);
+            trigger->checkForTrigger(m_scaledSpectrum, levels, false);
         }
     }
 }
+
+void FFTAnalyzer::checkBandTriggers(bool lowSoloMode)
+{
+	switch (m_bandpassEngine) {
+	case SlidingDFTBandpassEngine:
+		checkSlidingDftTriggers(lowSoloMode);
+		break;
+	case FilterBankBandpassEngine:
+		checkFilterBankTriggers(lowSoloMode);
+		break;
+	default:
+		break;
+	}
+}
+
+void FFTAnalyzer::checkSlidingDftTriggers(bool lowSoloMode)
+{
+	// the bands use the same frequency mapping, gain and scale as the ScaledSpectrum:
+	if (m_scaledSpectrum.getSampleRate() != m_bandSpectrum.getSampleRate()) {
+		// (the bins of the bands have other frequencies)
+		m_bandRanges.clear();
+	}
+	m_bandSpectrum.copyParameters(m_scaledSpectrum);
+	m_bandSpectrum.prepareFilterbank(m_bandLinearSpectrum.size());
+	updateBandBins();
+	if (m_bandRanges.isEmpty()) return;
+
+	// the windows of the sliding DFTs have to be completely in the buffer:
+	const int64_t numPutSamples = m_inputBuffer.getNumPutSamples();
+	const int maxWindowSize = m_stft.getSize();
+	if (numPutSamples < maxWindowSize + BAND_ENERGY_BLOCK_SIZE) return;
+
+	// continue with the newest block if the analysis has just started or was paused
+	// or if the windows could be overwritten by the next block of the producer while they are read:
+	if (m_bandPosition == 0
+			|| m_bandPosition - maxWindowSize < m_inputBuffer.getOldestIntactSampleNumber() + AUDIO_BUFFER_READ_MARGIN) {
+		m_bandPosition = numPutSamples - BAND_ENERGY_BLOCK_SIZE;
+	}
+
+	// the values are scaled like the spectra of the STFTs in processFrame():
+	const bool powerDomain = m_scaledSpectrum.getPowerDomain();
+	const float scale = powerDomain ? 0.01f : 0.1f;
+	while (m_bandPosition + BAND_ENERGY_BLOCK_SIZE <= numPutSamples) {
+		m_bandPosition += BAND_ENERGY_BLOCK_SIZE;
+
+		int offset = 0;
+		for (SlidingDFT* dft: m_slidingDfts) {
+			dft->advance(m_inputBuffer, m_bandPosition);
+			const float sizeRatio = float(m_stft.getSize()) / dft->getWindowSize();
+			const float dftScale = scale * (powerDomain ? sizeRatio * sizeRatio : sizeRatio);
+			for (int bin: dft->getBins()) {
+				m_bandLinearSpectrum[offset + bin] = dftScale * (powerDomain ? dft->getPower(bin) : dft->getMagnitude(bin));
+			}
+			offset += dft->getWindowSize() / 2;
+		}
+		if (m_bandPosition - BAND_ENERGY_BLOCK_SIZE - maxWindowSize < m_inputBuffer.getOldestIntactSampleNumber()) {
+			// the samples were overwritten while they were read, continue with the newest block in the next call:
+			for (SlidingDFT* dft: m_slidingDfts) {
+				dft->invalidate();
+			}
+			m_bandPosition = 0;
+			return;
+		}
+		for (int range=0; range < m_bandRanges.size(); range += 2) {
+			m_bandSpectrum.updateBins(m_bandLinearSpectrum, m_bandRanges[range], m_bandRanges[range+1]);
+		}
+
+		// same order and low solo mode as in checkTriggers():
+		bool triggered = false;
+		for (TriggerGeneratorInterface* trigger: m_triggerContainer) {
+			if (trigger->getChannel() != m_channel || !trigger->isBandpass()) continue;
+			bool active = trigger->checkForTrigger(m_bandSpectrum, m_levels, lowSoloMode && triggered);
+			triggered = triggered || active;
+		}
+	}
+}
+
+void FFTAnalyzer::checkFilterBankTriggers(bool lowSoloMode)
+{
+	// the bands of the bandpass triggers (in the order they are checked):
+	int midFreqs[BAND_FILTER_MAX_BANDS];
+	float widths[BAND_FILTER_MAX_BANDS];
+	int numBands = 0;
+	for (TriggerGeneratorInterface* trigger: m_triggerContainer) {
+		if (trigger->getChannel() != m_channel || !trigger->isBandpass()) continue;
+		if (numBands == BAND_FILTER_MAX_BANDS) break;
+		midFreqs[numBands] = trigger->getMidFreq();
+		widths[numBands] = trigger->getWidth();
+		++numBands;
+	}
+	// (the filters are only reset if the bands have changed)
+	m_bandFilterMeter.setBands(midFreqs, widths, numBands);
+
+	// the envelopes are only checked when new samples have been filtered:
+	const int64_t numPutSamples = m_inputBuffer.getNumPutSamples();
+	if (numPutSamples == m_filterPosition) return;
+	m_filterPosition = numPutSamples;
+
+	float bandLevels[BAND_FILTER_MAX_BANDS];
+	m_bandFilterMeter.takeLevels(bandLevels, numBands);
+
+	// same order and low solo mode as in checkTriggers():
+	bool triggered = false;
+	int band = 0;
+	for (TriggerGeneratorInterface* trigger: m_triggerContainer) {
+		if (trigger->getChannel() != m_channel || !trigger->isBandpass()) continue;
+		if (band == numBands) break;
+		// (the envelope of a sine is its amplitude like the level of a single tone in the spectrum)
+		const float value = m_scaledSpectrum.normalizeLevel(bandLevels[band++]);
+		bool active = trigger->checkLevel(value, lowSoloMode && triggered);
+		triggered = triggered || active;
+	}
+}
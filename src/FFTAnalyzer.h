@@ -21,8 +21,10 @@
 #ifndef FFTWRAPPER_H
 #define FFTWRAPPER_H
 
-#include "BasicFFTInterface.h"
+#include "STFT.h"
+#include "SlidingDFT.h"
 #include "ScaledSpectrum.h"
+#include "BandFilterMeter.h"
 #include "TriggerGeneratorInterface.h"
 #include "MonoAudioBuffer.h"
 
@@ -31,13 +33,26 @@
 #include <QVector>
 #include <QDebug>
 
-// the number of samples used for FFT expressed as an exponent of 2
+// the default number of samples used for FFT expressed as an exponent of 2
 static const int NUM_SAMPLES_EXPONENT = 12;
 
 // the real number of samples calculated from NUM_SAMPLES_EXPONENT
 static const int NUM_SAMPLES = qPow(2, NUM_SAMPLES_EXPONENT);
 
-// maximum absolute value in the result of the FFT
+// the range of the number of samples that can be selected at runtime (as exponents of 2)
+static const int MIN_NUM_SAMPLES_EXPONENT = 9;
+static const int MAX_NUM_SAMPLES_EXPONENT = 14;
+
+// the largest number of samples that can be selected at runtime
+static const int MAX_NUM_SAMPLES = qPow(2, MAX_NUM_SAMPLES_EXPONENT);
+
+// the number of samples of the latency profiles (as exponents of 2)
+static const int FFT_LOW_LATENCY_EXPONENT = 11;  // 2048 samples, 46ms at 44.1kHz
+static const int FFT_BALANCED_EXPONENT = NUM_SAMPLES_EXPONENT;  // 4096 samples, 93ms
+static const int FFT_HIGH_RESOLUTION_EXPONENT = 13;  // 8192 samples, 186ms
+
+// maximum absolute value in the result of the FFT with NUM_SAMPLES samples
+// (scaled linearly for other sizes, see ScaledSpectrum::setFftSize())
 // estimated from previous tests (exponent/samples: max value):
 // 11/2048: 51, 12/4096: 96, 13/8192: 195, 14/16384: 350
 static const int MAX_FFT_VALUE = 96;
@@ -45,23 +60,120 @@ static const int MAX_FFT_VALUE = 96;
 // number of frequency bins in the resulting ScaledSpectrum
 static const int SCALED_SPECTRUM_LENGTH = 200;
 
-// base frequency of the ScaledSpectrum in Hz
-static const int SCALED_SPECTRUM_BASE_FREQ = 20;  // ms
+// number of FFTs with different sizes used for the multi-resolution analysis
+// (the main FFT for the bass and shorter FFTs with a lower latency for the higher bands)
+static const int MULTI_RESOLUTION_NUM_FFTS = 3;
+
+// the size of each further FFT of the multi-resolution analysis expressed as a negative exponent of 2
+// (i.e. 4096 samples -> 1024 -> 512, limited to MIN_NUM_SAMPLES_EXPONENT)
+static const int MULTI_RESOLUTION_STEP_EXPONENT = 2;
+
+// number of samples of a block analyzed by the sliding DFTs of the bandpass triggers
+// (the triggers are checked after each block)
+static const int BAND_ENERGY_BLOCK_SIZE = 256;  // 5.8ms at 44.1kHz
+
+// number of FFT frames per second of audio (the hop size in samples is sample rate / FFT_HOP_RATE)
+static const int FFT_HOP_RATE = 44; // Hz
+
+// the ways the levels of the bandpass triggers can be measured
+enum BandpassEngine {
+	FFTBandpassEngine,  // max level of the band in the ScaledSpectrum, checked after each hop of the STFT
+	SlidingDFTBandpassEngine,  // the bins of the band in sliding DFTs, checked after each block of BAND_ENERGY_BLOCK_SIZE samples
+	FilterBankBandpassEngine  // envelope of a band-pass filter applied while the samples are written to the buffer (see BandFilterMeter)
+};
 
-// A class to prepare the content of an audio buffer for FFT,
-// calculate the FFT and create a ScaledSpectrum of the results.
+// A class to calculate the STFT of the content of an audio buffer
+// and create a ScaledSpectrum of the results.
 // Calls checkForTrigger() of a TriggerGeneratorContainer object when a new FFT is done.
-class FFTAnalyzer
+// Further consumers can be added to the STFT to use the same frames.
+// With the multi-resolution analysis, shorter FFTs that end at the same sample
+// are calculated for each frame and used for the higher bands of the ScaledSpectrum.
+// The bandpass triggers can be checked with faster engines than the STFT (see BandpassEngine):
+// sliding DFTs that keep the bins of the trigger bands up to date after every block
+// of BAND_ENERGY_BLOCK_SIZE samples, or band-pass filters that listen to the blocks written
+// to the input buffer (see BandFilterMeter).
+class FFTAnalyzer : public STFTConsumer
 {
 
 public:
-	explicit FFTAnalyzer(const MonoAudioBuffer& buffer, QVector<TriggerGeneratorInterface*>& m_triggerContainer);
+	// the analyzer checks the triggers of m_triggerContainer that are bound to channel
+	// (-1 for the downmix, buffer should be the matching channel buffer)
+	explicit FFTAnalyzer(MonoAudioBuffer& buffer, QVector<TriggerGeneratorInterface*>& m_triggerContainer, int channel = -1);
 	~FFTAnalyzer();
 
-	// calculates the FFT based on the data in the inputBuffer and updates the ScaledSpectrum
-	// - usually called periodically 44 times per second
+	// analyzes all hops of new samples in the inputBuffer and checks the triggers after each of them
+	// (same as analyze() followed by checkTriggers() while isHopAvailable())
+	// - can be called at any rate, each hop of audio is analyzed exactly once
     void calculateFFT(bool lowSoloMode);
 
+	// returns the number of samples of the FFT expressed as an exponent of 2
+	int getSizeExponent() const { return m_sizeExponent; }
+
+	// changes the number of samples of the FFT (within MIN_NUM_SAMPLES_EXPONENT...MAX_NUM_SAMPLES_EXPONENT),
+	// the frequency mapping and the normalization of the ScaledSpectrum follow the new size
+	// - has to be called in the thread of the triggers (not while analyze() runs)
+	void setSizeExponent(int value);
+
+	// returns if the higher bands are calculated with shorter FFTs
+	bool getMultiResolution() const { return m_multiResolution; }
+
+	// sets if the higher bands are calculated with shorter FFTs (see MULTI_RESOLUTION_NUM_FFTS),
+	// which lowers their latency and time smearing without losing the frequency resolution of the bass
+	// - disabled by default: the shorter spectra are scaled so that a sine keeps its level,
+	//   in the magnitude domain broadband signals (noise, cymbals) are lower by the square root
+	//   of the size ratio in the higher bands (i.e. -6dB at a ratio of 4, -12dB at 16),
+	//   in the power domain they keep about their level as well (see ScaledSpectrum::setPowerDomain())
+	// - has to be called in the thread of the triggers (not while analyze() runs)
+	void setMultiResolution(bool value);
+
+	// returns the way the levels of the bandpass triggers are measured
+	BandpassEngine getBandpassEngine() const { return m_bandpassEngine; }
+
+	// sets the way the levels of the bandpass triggers are measured
+	// (the engines other than FFTBandpassEngine are checked by checkBandTriggers())
+	// - has to be called in the thread of the triggers (not while analyze() runs)
+	void setBandpassEngine(BandpassEngine value);
+
+	// returns if the ScaledSpectrum is calculated from the powers instead of the magnitudes of the bins
+	bool getPowerDomain() const { return m_scaledSpectrum.getPowerDomain(); }
+
+	// sets if the ScaledSpectrum is calculated from the powers of the bins
+	// (saves the square roots of the bins, one is left per scaled bin, see ScaledSpectrum::setPowerDomain())
+	void setPowerDomain(bool value);
+
+	// returns true if the inputBuffer contains enough new samples for the next hop
+	bool isHopAvailable() const;
+
+	// returns the number of samples that are missing in the inputBuffer for the next hop (0 if it is available)
+	int getSamplesUntilNextHop() const;
+
+	// calculates the FFT of the window that ends with the next hop and updates the ScaledSpectrum
+	// (the newest samples if no complete hop is available,
+	// hops that have already been overwritten in the inputBuffer are skipped)
+	// - only uses members of this object, so the analyzers of different channels can run in parallel
+	void analyze();
+
+	// checks the triggers bound to the channel of this analyzer with the last FFT results
+	// - newLevels: take the levels measured since the last check from the buffer,
+	//   otherwise the previous levels are used again (i.e. for further hops analyzed at once)
+	// - has to be called in the thread of the triggers (they send OSC messages and use timers)
+	void checkTriggers(bool lowSoloMode, bool newLevels = true);
+
+	// checks the bandpass triggers bound to the channel of this analyzer with the levels
+	// of the BandpassEngine for all new samples (does nothing with FFTBandpassEngine)
+	// - has to be called in the thread of the triggers
+	void checkBandTriggers(bool lowSoloMode);
+
+	// returns the STFT that calculates the frames of the main FFT (i.e. to add further consumers)
+	STFT& getSTFT() { return m_stft; }
+
+	// updates the ScaledSpectrum with a new frame of the STFT
+	// (and the frames of the shorter FFTs that end at the same sample)
+	void processFrame(const QVector<float>& spectrum, int sampleRate) override;
+
+	// returns the input channel that is analyzed (-1 for the downmix)
+	int getChannel() const { return m_channel; }
+
 	// returns the normalized spectrum of the ScaledSpectrum
 	const QVector<float>& getNormalizedSpectrum() const { return m_scaledSpectrum.getNormalizedSpectrum(); }
 
@@ -72,17 +184,44 @@ public:
 	ScaledSpectrum& getScaledSpectrum() { return m_scaledSpectrum; }
 
 protected:
-	// calculates a Hann Window for FFT and saves it to m_window
-	void calculateWindow();
+	// creates the STFTs of the shorter FFTs for the actual size and mode
+	// and sets the resulting layout of the linear spectrum
+	void updateResolutions();
+
+	// creates the sliding DFTs with the sizes of the FFTs if the SlidingDFTBandpassEngine is used
+	void updateSlidingDfts();
+
+	// sets the bins of the sliding DFTs to the bands of the bandpass triggers if they have changed
+	void updateBandBins();
+
+	// analyzes all new blocks of the inputBuffer with the sliding DFTs and checks the bandpass triggers after each of them
+	// (the bands have the same frequency resolution and level scale as in the ScaledSpectrum)
+	void checkSlidingDftTriggers(bool lowSoloMode);
+
+	// sets the bands of the band filter meter to the bands of the bandpass triggers
+	// and checks the triggers with the envelopes measured since the last check
+	// (the envelopes are normalized like the levels of the ScaledSpectrum)
+	void checkFilterBankTriggers(bool lowSoloMode);
 
-	const MonoAudioBuffer&	m_inputBuffer;  // buffer that stores the audio samples
+	MonoAudioBuffer&		m_inputBuffer;  // buffer that stores the audio samples
 	QVector<TriggerGeneratorInterface*>& m_triggerContainer;  // list of all controlled triggerGenerators
-	BasicFFTInterface*		m_fft;  // FFT implementation
-	QVector<float>			m_buffer;  // buffer for prepared data (intermediate result)
-	QVector<float>			m_window;  // array with window data
-	QVector<float>			m_fftOutput;  // buffer containing the FFT output (intermediate result)
-	QVector<float>			m_linearSpectrum;  // buffer containing the non-scaled spectrum data (intermediate result)
+	const int				m_channel;  // the analyzed input channel (-1 for the downmix)
+	AudioLevels				m_levels;  // the levels used for the last trigger check
+	int						m_sizeExponent;  // the number of samples of the FFT expressed as an exponent of 2
+	STFT					m_stft;  // calculates the frames of 2^m_sizeExponent samples
+	bool					m_multiResolution;  // true if the higher bands are calculated with shorter FFTs
+	QVector<STFT*>			m_shortStfts;  // STFTs of the shorter FFTs (from the longest to the shortest, empty if not used)
+	QVector<float>			m_linearSpectrum;  // buffer containing the concatenated non-scaled spectra of all FFTs (intermediate result)
 	ScaledSpectrum			m_scaledSpectrum;  // stores the scaled data of the spectrum
+	BandpassEngine			m_bandpassEngine;  // the way the levels of the bandpass triggers are measured
+	QVector<SlidingDFT*>	m_slidingDfts;  // sliding DFTs with the sizes of m_stft and m_shortStfts (empty if not used)
+	int64_t					m_bandPosition;  // the absolute sample number after the last block analyzed by the sliding DFTs
+	QVector<int>			m_bandRanges;  // ranges of scaled bins (start and end) the sliding DFTs are set up for
+	QVector<int>			m_triggerRanges;  // ranges of scaled bins of the bandpass triggers (intermediate result)
+	QVector<float>			m_bandLinearSpectrum;  // linear spectrum with only the bins of the trigger bands (intermediate result)
+	ScaledSpectrum			m_bandSpectrum;  // scaled spectrum of the trigger bands updated at block rate
+	BandFilterMeter			m_bandFilterMeter;  // band-pass filters of the bandpass triggers (the block listener of the inputBuffer while used)
+	int64_t					m_filterPosition;  // the number of put samples of the inputBuffer at the last check of the band filters
 };
 
 #endif // FFTWRAPPER_H
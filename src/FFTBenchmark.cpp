@@ -0,0 +1,217 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "FFTBenchmark.h"
+
+#include "FFTRealWrapper.h"
+#include "FixedPointFFT.h"
+#include "MonoAudioBuffer.h"
+#include "STFT.h"
+#include "SimdFFT.h"
+
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QVector>
+#include <QtMath>
+
+// returns the time of one FFT of fft in microseconds
+static double measureFft(BasicFFTInterface& fft, const QVector<float>& input, QVector<float>& output)
+{
+	// warm up the caches:
+	fft.doFft(output.data(), input.constData());
+
+	QElapsedTimer timer;
+	timer.start();
+	for (int i=0; i<FFT_BENCHMARK_ITERATIONS; ++i) {
+		fft.doFft(output.data(), input.constData());
+	}
+	return timer.nsecsElapsed() / 1000.0 / FFT_BENCHMARK_ITERATIONS;
+}
+
+template<int SIZE_EXPONENT>
+static void benchmarkSize(QTextStream& out)
+{
+	const int size = 1 << SIZE_EXPONENT;
+
+	// a few sines and some noise, similar to music:
+	QVector<float> input(size);
+	for (int i=0; i<size; ++i) {
+		input[i] = 0.5f * qSin(2 * M_PI * 110 * i / 44100) + 0.2f * qSin(2 * M_PI * 1234 * i / 44100)
+				+ 0.1f * (float(qrand()) / RAND_MAX - 0.5f);
+	}
+
+	QVector<float> reference(size);
+	FFTRealWrapper<SIZE_EXPONENT> fftReal;
+	const double fftRealTime = measureFft(fftReal, input, reference);
+	out << "FFT size " << size << ":" << endl;
+	out << "  FFTReal: " << QString::number(fftRealTime, 'f', 2) << " us" << endl;
+
+	const SimdFFT::Backend backends[] = { SimdFFT::Sse2Backend, SimdFFT::Avx2Backend, SimdFFT::NeonBackend };
+	for (SimdFFT::Backend backend: backends) {
+		if (!SimdFFT::isBackendAvailable(backend)) continue;
+		SimdFFT fft(SIZE_EXPONENT, backend);
+		QVector<float> output(size);
+		const double time = measureFft(fft, input, output);
+		float maxDeviation = 0.0f;
+		for (int i=0; i<size; ++i) {
+			maxDeviation = qMax(maxDeviation, qAbs(output[i] - reference[i]));
+		}
+		out << "  " << SimdFFT::getBackendName(backend) << ": " << QString::number(time, 'f', 2) << " us"
+			<< " (" << QString::number(fftRealTime / time, 'f', 2) << "x, max deviation " << maxDeviation << ")" << endl;
+	}
+
+	FixedPointFFT fixedPointFft(SIZE_EXPONENT);
+	QVector<float> output(size);
+	const double time = measureFft(fixedPointFft, input, output);
+	float maxDeviation = 0.0f;
+	for (int i=0; i<size; ++i) {
+		maxDeviation = qMax(maxDeviation, qAbs(output[i] - reference[i]));
+	}
+	out << "  Fixed point: " << QString::number(time, 'f', 2) << " us"
+		<< " (" << QString::number(fftRealTime / time, 'f', 2) << "x, max deviation " << maxDeviation << ")" << endl;
+}
+
+// returns the time of one frame of stft in microseconds (window, FFT and spectrum through STFT::processFrameAt())
+// - the frames are at different positions of buffer, some of them wrap around the end of the ring
+static double measureFrames(STFT& stft, const MonoAudioBuffer& buffer)
+{
+	const int64_t firstFrameEnd = buffer.getNumPutSamples() - buffer.getCapacity() + stft.getSize();
+	const int numFrameEnds = buffer.getCapacity() - stft.getSize() + 1;
+
+	// warm up the caches:
+	stft.processFrameAt(buffer, firstFrameEnd);
+
+	QElapsedTimer timer;
+	timer.start();
+	for (int i=0; i<FFT_BENCHMARK_ITERATIONS; ++i) {
+		stft.processFrameAt(buffer, firstFrameEnd + (int64_t(i) * STFT_BENCHMARK_HOP_SIZE) % numFrameEnds);
+	}
+	return timer.nsecsElapsed() / 1000.0 / FFT_BENCHMARK_ITERATIONS;
+}
+
+// prints the time of a whole STFT frame of 2^STFT_BENCHMARK_FRAME_SIZE_EXPONENT samples
+// with FFTReal, the best SimdFFT backend and the fixed point FFT
+static void benchmarkFrames(QTextStream& out)
+{
+	const int size = 1 << STFT_BENCHMARK_FRAME_SIZE_EXPONENT;
+
+	// noise as the source of the frames, the ring is filled more than once so that frames wrap around its end:
+	MonoAudioBuffer buffer(size * 4);
+	QVector<float> samples(buffer.getCapacity());
+	for (int i=0; i<samples.size(); ++i) {
+		samples[i] = float(qrand()) / RAND_MAX - 0.5f;
+	}
+	buffer.putSamples(samples.constData(), samples.size());
+	buffer.putSamples(samples.constData(), STFT_BENCHMARK_HOP_SIZE);
+
+	// (the FFT and the type of arithmetic are chosen when the STFT is created)
+	const bool simdFftEnabled = STFT::getSimdFftEnabled();
+	const bool fixedPointEnabled = STFT::getFixedPointEnabled();
+	STFT::setFixedPointEnabled(false);
+
+	out << "STFT frame of " << size << " samples (window, FFT and magnitudes):" << endl;
+	STFT::setSimdFftEnabled(false);
+	STFT fftRealStft(STFT_BENCHMARK_FRAME_SIZE_EXPONENT, STFT_BENCHMARK_HOP_SIZE);
+	const double fftRealTime = measureFrames(fftRealStft, buffer);
+	out << "  FFTReal: " << QString::number(fftRealTime, 'f', 2) << " us" << endl;
+
+	if (SimdFFT::getBestBackend() != SimdFFT::NoBackend) {
+		STFT::setSimdFftEnabled(true);
+		STFT simdStft(STFT_BENCHMARK_FRAME_SIZE_EXPONENT, STFT_BENCHMARK_HOP_SIZE);
+		const double time = measureFrames(simdStft, buffer);
+		out << "  " << SimdFFT::getBackendName(SimdFFT::getBestBackend()) << ": " << QString::number(time, 'f', 2) << " us"
+			<< " (" << QString::number(fftRealTime / time, 'f', 2) << "x)" << endl;
+	}
+
+	STFT::setFixedPointEnabled(true);
+	STFT fixedPointStft(STFT_BENCHMARK_FRAME_SIZE_EXPONENT, STFT_BENCHMARK_HOP_SIZE);
+	const double time = measureFrames(fixedPointStft, buffer);
+	out << "  Fixed point: " << QString::number(time, 'f', 2) << " us"
+		<< " (" << QString::number(fftRealTime / time, 'f', 2) << "x)" << endl;
+
+	STFT::setSimdFftEnabled(simdFftEnabled);
+	STFT::setFixedPointEnabled(fixedPointEnabled);
+}
+
+// compares the spectra of frames of 2^sizeExponent samples calculated by a STFT with integer arithmetic
+// with those of the float STFT and prints if they are within FIXED_POINT_FFT_TOLERANCE
+// (for full scale and quiet sines with noise, the magnitudes and the powers of the bins)
+// - returns false if the deviation exceeds the tolerance
+static bool compareFixedPoint(QTextStream& out, int sizeExponent)
+{
+	const int size = 1 << sizeExponent;
+	MonoAudioBuffer buffer(size * 4);
+	// (the type of arithmetic is chosen when the STFT is created)
+	const bool fixedPointEnabled = STFT::getFixedPointEnabled();
+	STFT::setFixedPointEnabled(false);
+	STFT floatStft(sizeExponent, STFT_BENCHMARK_HOP_SIZE);
+	STFT::setFixedPointEnabled(true);
+	STFT fixedPointStft(sizeExponent, STFT_BENCHMARK_HOP_SIZE);
+	STFT::setFixedPointEnabled(fixedPointEnabled);
+	QVector<float> samples(buffer.getCapacity());
+
+	// the magnitude and the power of a bin of a full scale sine in a frame with Hann window:
+	const float fullScaleMagnitude = size / 4.0f;
+	const float fullScalePower = fullScaleMagnitude * fullScaleMagnitude;
+
+	float maxDeviation = 0.0f;
+	const float amplitudes[] = { 0.95f, 0.5f, 0.01f, 0.0001f };
+	for (float amplitude: amplitudes) {
+		for (int i=0; i<samples.size(); ++i) {
+			samples[i] = amplitude * (0.9f * qSin(2 * M_PI * 110 * i / 44100) + 0.1f * (float(qrand()) / RAND_MAX - 0.5f));
+		}
+		buffer.putSamples(samples.constData(), samples.size());
+		const int64_t firstFrameEnd = buffer.getNumPutSamples() - buffer.getCapacity() + size;
+		for (int64_t frameEnd=firstFrameEnd; frameEnd<=buffer.getNumPutSamples(); frameEnd+=STFT_BENCHMARK_HOP_SIZE) {
+			const SpectrumType types[] = { MagnitudeSpectrum, PowerSpectrum };
+			for (SpectrumType type: types) {
+				floatStft.setSpectrumType(type);
+				fixedPointStft.setSpectrumType(type);
+				floatStft.processFrameAt(buffer, frameEnd);
+				fixedPointStft.processFrameAt(buffer, frameEnd);
+				const float fullScale = type == MagnitudeSpectrum ? fullScaleMagnitude : fullScalePower;
+				for (int i=0; i<size/2; ++i) {
+					maxDeviation = qMax(maxDeviation, qAbs(fixedPointStft.getSpectrum()[i] - floatStft.getSpectrum()[i]) / fullScale);
+				}
+			}
+		}
+	}
+
+	const bool passed = maxDeviation <= FIXED_POINT_FFT_TOLERANCE;
+	out << "  " << size << " samples: max deviation " << maxDeviation << " of full scale"
+		<< (passed ? " (within tolerance)" : " (EXCEEDS TOLERANCE)") << endl;
+	return passed;
+}
+
+bool runFFTBenchmark()
+{
+	QTextStream out(stdout);
+	out << "Selected FFT backend: " << SimdFFT::getBackendName(SimdFFT::getBestBackend()) << endl;
+	// the sizes of BPMDetector and FFTAnalyzer:
+	benchmarkSize<11>(out);
+	benchmarkSize<12>(out);
+	benchmarkFrames(out);
+
+	out << "Fixed point analysis compared with the float analysis (tolerance " << FIXED_POINT_FFT_TOLERANCE << "):" << endl;
+	bool passed = compareFixedPoint(out, STFT_MIN_SIZE_EXPONENT);
+	passed = compareFixedPoint(out, STFT_BENCHMARK_FRAME_SIZE_EXPONENT) && passed;
+	passed = compareFixedPoint(out, STFT_MAX_SIZE_EXPONENT) && passed;
+	return passed;
+}
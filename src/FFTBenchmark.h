@@ -0,0 +1,43 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef FFTBENCHMARK_H
+#define FFTBENCHMARK_H
+
+// number of FFTs calculated per implementation and size in the benchmark
+static const int FFT_BENCHMARK_ITERATIONS = 20000;
+
+// size of the STFT frames that are timed and compared between the float and the fixed point analysis
+// (the default size of FFTAnalyzer, the comparison also uses the smallest and the largest size)
+static const int STFT_BENCHMARK_FRAME_SIZE_EXPONENT = 12;
+
+// distance of the timed and compared STFT frames in samples (not a divisor of the buffer capacity)
+static const int STFT_BENCHMARK_HOP_SIZE = 1002;
+
+// Measures the FFT implementations (FFTReal and the SimdFFT backends available on this CPU)
+// for the sizes used by FFTAnalyzer and BPMDetector and prints the results to stdout.
+// Also prints the maximum deviation of each backend from the result of FFTReal
+// and the time of a whole STFT frame (window, FFT and spectrum) with each FFT.
+// Finally checks that the spectra of the fixed point analysis are within FIXED_POINT_FFT_TOLERANCE
+// of the float analysis.
+// - returns false if they are not (i.e. to use it as a test)
+bool runFFTBenchmark();
+
+#endif // FFTBENCHMARK_H
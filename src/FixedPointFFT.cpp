@@ -0,0 +1,225 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "FixedPointFFT.h"
+
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// The roots of the values 0...2^FIXED_POINT_ROOT_TABLE_BITS-1 (rounded up, times 16),
+// the first estimate of FixedPointFFT::squareRoot() for large values.
+struct RootTable
+{
+	uint16_t values[1 << FIXED_POINT_ROOT_TABLE_BITS];
+
+	RootTable() {
+		uint32_t root = 0;
+		for (uint32_t i=0; i < (1u << FIXED_POINT_ROOT_TABLE_BITS); ++i) {
+			// the smallest root with root^2 >= (i+1) * 16^2:
+			while (root * root < (i + 1) * 256) ++root;
+			values[i] = uint16_t(root);
+		}
+	}
+};
+
+const RootTable s_rootTable;
+
+}  // namespace
+
+FixedPointFFT::FixedPointFFT(int sizeExponent)
+	: m_size(1 << qMax(sizeExponent, FIXED_POINT_FFT_MIN_SIZE_EXPONENT))
+	, m_complexSize(m_size / 2)
+	, m_twiddleRe()
+	, m_twiddleIm()
+	, m_realTwiddleCos()
+	, m_realTwiddleSin()
+	, m_work(4 * m_complexSize)
+	, m_input()
+	, m_output()
+{
+	const int half = m_complexSize / 2;
+	m_twiddleRe.resize(half);
+	m_twiddleIm.resize(half);
+	for (int k=0; k<half; ++k) {
+		m_twiddleRe[k] = toQ31(qCos(2 * M_PI * k / m_complexSize));
+		m_twiddleIm[k] = toQ31(-qSin(2 * M_PI * k / m_complexSize));
+	}
+	m_realTwiddleCos.resize(m_complexSize);
+	m_realTwiddleSin.resize(m_complexSize);
+	for (int k=0; k<m_complexSize; ++k) {
+		m_realTwiddleCos[k] = toQ31(qCos(2 * M_PI * k / m_size));
+		m_realTwiddleSin[k] = toQ31(qSin(2 * M_PI * k / m_size));
+	}
+}
+
+int32_t FixedPointFFT::toQ31(double value)
+{
+	const double scaled = qRound64(value * 2147483648.0);
+	return int32_t(qBound(-2147483648.0, scaled, 2147483647.0));
+}
+
+void FixedPointFFT::applyWindow(const float* input, const int32_t* window, int32_t* output, int numSamples)
+{
+	for (int i=0; i<numSamples; ++i) {
+		output[i] = multiply(halfToQ31(input[i]), window[i]);
+	}
+}
+
+void FixedPointFFT::doFft(float* output, const float* input)
+{
+	// (the buffers are only needed for the float interface)
+	if (m_input.size() != m_size) {
+		m_input.resize(m_size);
+		m_output.resize(m_size);
+	}
+	for (int i=0; i<m_size; ++i) {
+		m_input[i] = halfToQ31(input[i]);
+	}
+	doFixedPointFft(m_output.data(), m_input.constData());
+
+	// the output is the FFT of the halved input divided by the size:
+	const float scale = 2.0f * m_size / 2147483648.0f;
+	for (int i=0; i<m_size; ++i) {
+		output[i] = m_output[i] * scale;
+	}
+}
+
+void FixedPointFFT::doFixedPointFft(int32_t* output, const int32_t* input)
+{
+	const int n = m_complexSize;
+	const int half = n / 2;
+	int32_t* xRe = m_work.data();
+	int32_t* xIm = xRe + n;
+	int32_t* yRe = xRe + 2 * n;
+	int32_t* yIm = xRe + 3 * n;
+
+	// split the even and odd samples into the real and imaginary parts of z:
+	for (int k=0; k<n; ++k) {
+		xRe[k] = input[2 * k];
+		xIm[k] = input[2 * k + 1];
+	}
+
+	// complex FFT of z (radix-2 Stockham, the sums and the differences are halved in each pass,
+	// so that the magnitudes never exceed the max magnitude of the input):
+	for (int stride=1; stride<n; stride*=2) {
+		for (int p=0; p * stride < half; ++p) {
+			const int32_t wRe = m_twiddleRe[p * stride];
+			const int32_t wIm = m_twiddleIm[p * stride];
+			const int x0 = p * stride;
+			const int y0 = 2 * p * stride;
+			for (int q=0; q<stride; ++q) {
+				const int32_t aRe = xRe[x0 + q] >> 1;
+				const int32_t aIm = xIm[x0 + q] >> 1;
+				const int32_t bRe = xRe[x0 + q + half] >> 1;
+				const int32_t bIm = xIm[x0 + q + half] >> 1;
+				const int32_t dRe = aRe - bRe;
+				const int32_t dIm = aIm - bIm;
+				yRe[y0 + q] = aRe + bRe;
+				yIm[y0 + q] = aIm + bIm;
+				yRe[y0 + stride + q] = multiply(dRe, wRe) - multiply(dIm, wIm);
+				yIm[y0 + stride + q] = multiply(dRe, wIm) + multiply(dIm, wRe);
+			}
+		}
+		std::swap(xRe, yRe);
+		std::swap(xIm, yIm);
+	}
+
+	// separate the spectra of the even and odd samples (see simdRealFft()),
+	// the result is halved once more because a bin can be twice as large as the values of z:
+	output[0] = (xRe[0] >> 1) + (xIm[0] >> 1);
+	output[n] = (xRe[0] >> 1) - (xIm[0] >> 1);
+	for (int k=1; k<n; ++k) {
+		// (twice the values of E and O, the sums need 33 bits)
+		const int64_t eRe = int64_t(xRe[k]) + xRe[n - k];
+		const int64_t eIm = int64_t(xIm[k]) - xIm[n - k];
+		const int64_t oRe = int64_t(xIm[k]) + xIm[n - k];
+		const int64_t oIm = int64_t(xRe[n - k]) - xRe[k];
+		const int64_t c = m_realTwiddleCos[k];
+		const int64_t s = m_realTwiddleSin[k];
+		const int64_t re = eRe + ((oRe * c + oIm * s) >> 31);
+		// FFTReal stores the negated imaginary parts:
+		const int64_t im = ((oRe * s - oIm * c) >> 31) - eIm;
+		output[k] = int32_t((re + 2) >> 2);
+		output[n + k] = int32_t((im + 2) >> 2);
+	}
+}
+
+void FixedPointFFT::calculateSpectrum(SpectrumType type, const int32_t* fftOutput, int size, float scale, float* spectrum)
+{
+	const int half = size / 2;
+	const float powerScale = scale * scale;
+	for (int i=0; i<half; ++i) {
+		const int64_t real = fftOutput[i];
+		// (bin 0 is real, the Nyquist bin is omitted)
+		const int64_t img = i > 0 ? fftOutput[half + i] : 0;
+		// (each square of a Q31 value has up to 62 bits, so the sum fits into 64 unsigned bits)
+		const uint64_t power = uint64_t(real * real) + uint64_t(img * img);
+		if (type == MagnitudeSpectrum) {
+			spectrum[i] = squareRoot(power) * scale;
+		} else if (type == PowerSpectrum) {
+			spectrum[i] = power * powerScale;
+		} else {
+			spectrum[i] = 10 * std::log10(qMax(power * powerScale, SIMD_FFT_MIN_POWER));
+		}
+	}
+}
+
+uint32_t FixedPointFFT::squareRoot(uint64_t value)
+{
+	// the position of the highest bit of value, rounded down to an even number (binary search):
+	int shift = 0;
+	for (int step = 32; step >= 2; step >>= 1) {
+		if (value >> (shift + step)) shift += step;
+	}
+
+	uint64_t root;
+	if (shift < FIXED_POINT_ROOT_TABLE_BITS) {
+		// small values: one bit of the root per iteration, starting with the highest power of 4 in value
+		// (without branches, because the bits of the root can't be predicted)
+		root = 0;
+		uint64_t bit = uint64_t(1) << shift;
+		while (bit != 0) {
+			const uint64_t trial = root + bit;
+			const uint64_t mask = uint64_t(0) - uint64_t(value >= trial);  // all bits set if the bit belongs to the root
+			value -= trial & mask;
+			root = (root >> 1) + (bit & mask);
+			bit >>= 2;
+		}
+		// value is now the remainder value - root^2, round up if it is beyond (root + 0.5)^2:
+		if (value > root) ++root;
+		return uint32_t(root);
+	}
+
+	// the estimate from the root of the highest bits is exact to about 1/128,
+	// two Newton iterations make it exact to +-1:
+	const int tableShift = shift - (FIXED_POINT_ROOT_TABLE_BITS - 2);
+	root = (uint64_t(s_rootTable.values[value >> tableShift]) << (tableShift / 2)) >> 4;
+	root = (root + value / root) >> 1;
+	root = (root + value / root) >> 1;
+	while (root * root > value) --root;
+	while ((root + 1) * (root + 1) <= value) ++root;
+
+	// round up if the remainder is beyond (root + 0.5)^2:
+	if (value - root * root > root) ++root;
+	return uint32_t(root);
+}
@@ -0,0 +1,119 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef FIXEDPOINTFFT_H
+#define FIXEDPOINTFFT_H
+
+#include "BasicFFTInterface.h"
+#include "SimdFFT.h"
+
+#include <QVector>
+
+#include <cstdint>
+
+// smallest number of samples supported by FixedPointFFT expressed as an exponent of 2
+static const int FIXED_POINT_FFT_MIN_SIZE_EXPONENT = 2;
+
+// number of the highest bits of a value whose roots are tabulated as the first estimate of FixedPointFFT::squareRoot()
+// (values below 2^FIXED_POINT_ROOT_TABLE_BITS are calculated bit by bit)
+static const int FIXED_POINT_ROOT_TABLE_BITS = 8;
+
+// max deviation of the magnitudes of the bins of a frame calculated with FixedPointFFT
+// from those of the float FFTs, relative to the magnitude of a full scale sine in the frame (-100dB)
+// - this is an absolute error: quiet bins deviate by much more than 1e-5 of their own value
+// - only valid for samples within -1...1 (larger samples are clipped, the float analysis doesn't clip them)
+static const float FIXED_POINT_FFT_TOLERANCE = 1e-5f;
+
+// max deviation of the trigger levels [0...1] of the fixed-point analysis from those of the float analysis
+// per gain of the ScaledSpectrum, in all spectrum modes with a compression of at most 1
+// - a trigger decision can only differ from the one of the float analysis if the level is this close to the threshold
+// - a compression c above 1 raises the levels to the power of 1/c, which magnifies the deviation of quiet bands
+//   up to (gain * FIXED_POINT_FFT_TOLERANCE)^(1/c), i.e. 0.003 with c = 2 and 0.3 with c = 10
+// (verified with synthetic material in tst_fixedpointanalysis)
+static const float FIXED_POINT_LEVEL_TOLERANCE = 1e-4f;
+
+
+// An implementation of the BasicFFTInterface with integer arithmetic.
+// The samples and the twiddle factors are Q31 values (a 32 bit integer i is the value i / 2^31).
+// The passes of the FFT and the powers and magnitudes of the bins are calculated with integers,
+// the conversions from and to floats at both ends are not:
+// - the samples of the MonoAudioBuffer are floats, so applyWindow() converts each sample to Q31
+// - calculateSpectrum() converts each bin to a float for the ScaledSpectrum (and takes the log10 for dB)
+// It has only been measured on x86-64, where it is slower than FFTReal and SimdFFT (see --benchmark-fft).
+// Each pass of the FFT halves its results, so that they can't overflow.
+// The real FFT of N samples is calculated like in SimdFFT (a complex FFT of N/2 points
+// in Stockham order followed by a post-processing step) and has the format of FFTReal:
+// - output[0...N/2] are the real parts of the bins 0...N/2
+// - output[N/2+1...N-1] are the negated imaginary parts of the bins 1...N/2-1
+class FixedPointFFT : public BasicFFTInterface
+{
+
+public:
+	// sizeExponent is the number of samples expressed as an exponent of 2
+	// (at least FIXED_POINT_FFT_MIN_SIZE_EXPONENT)
+	explicit FixedPointFFT(int sizeExponent);
+
+	// converts the float input to Q31, calculates the FFT and converts the result back
+	// (the same scale as the float FFTs, input is limited to -1...1)
+	void doFft(float* output, const float* input) override;
+
+	// returns the number of samples
+	int getSize() const { return m_size; }
+
+	// calculates the FFT of the Q31 samples in input and writes it to output, divided by the size
+	// - the samples have to be within -0.5...0.5, so that the complex values of the passes can't overflow
+	void doFixedPointFft(int32_t* output, const int32_t* input);
+
+	// calculates the spectrum of the given type from the output of doFixedPointFft() for size samples
+	// (the Q31 values are multiplied by scale, see SimdFFT::calculateSpectrum())
+	// - the powers and the magnitudes are calculated with integers and converted to floats
+	static void calculateSpectrum(SpectrumType type, const int32_t* fftOutput, int size, float scale, float* spectrum);
+
+	// returns the square root of value rounded to the nearest integer (with integer arithmetic,
+	// a table lookup and two Newton iterations, value has to be at most 2^63,
+	// i.e. the largest power of a bin of doFixedPointFft())
+	static uint32_t squareRoot(uint64_t value);
+
+	// returns the Q31 value of the product of two Q31 values (rounded)
+	static int32_t multiply(int32_t a, int32_t b) { return int32_t((int64_t(a) * b + (int64_t(1) << 30)) >> 31); }
+
+	// returns the Q31 value of half of a float value (value is limited to -1...1)
+	static int32_t halfToQ31(float value) { return int32_t((value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value)) * 1073741824.0f); }
+
+	// converts half of numSamples samples to Q31 and multiplies them with the Q31 window
+	// (the samples are halved to be within the range of the input of doFixedPointFft())
+	static void applyWindow(const float* input, const int32_t* window, int32_t* output, int numSamples);
+
+	// returns the Q31 value of a float value within -1...1 (1 is saturated)
+	static int32_t toQ31(double value);
+
+protected:
+	int					m_size;  // number of real samples
+	int					m_complexSize;  // number of points of the complex FFT (m_size / 2)
+	QVector<int32_t>	m_twiddleRe;  // cos(2*pi*k / complexSize) for k < complexSize / 2
+	QVector<int32_t>	m_twiddleIm;  // -sin(2*pi*k / complexSize) for k < complexSize / 2
+	QVector<int32_t>	m_realTwiddleCos;  // cos(2*pi*k / size) for k < complexSize
+	QVector<int32_t>	m_realTwiddleSin;  // sin(2*pi*k / size) for k < complexSize
+	QVector<int32_t>	m_work;  // the arrays of the complex FFT (intermediate result)
+	QVector<int32_t>	m_input;  // the converted input of doFft() (intermediate result)
+	QVector<int32_t>	m_output;  // the output of doFixedPointFft() for doFft() (intermediate result)
+};
+
+#endif // FIXEDPOINTFFT_H
@@ -0,0 +1,227 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "JackAudioInput.h"
+
+#include "utils.h"
+
+#include <QDebug>
+
+
+JackAudioInput::JackAudioInput(MonoAudioBuffer* buffer)
+	: AudioInputInterface(buffer)
+	, m_client(nullptr)
+	, m_numPorts(0)
+	, m_activeInputName("")
+	, m_numActivePorts(0)
+	, m_sampleRate(0)
+	, m_appliedSampleRate(0)
+	, m_bufferSize(0)
+	, m_volume(1.0f)
+	, m_shutdown(false)
+{
+	for (int i=0; i<JACK_MAX_INPUT_PORTS; ++i) {
+		m_ports[i] = nullptr;
+	}
+
+	// connect to a running server (the server is not started automatically):
+	jack_status_t status;
+	m_client = jack_client_open(JACK_CLIENT_NAME, JackNoStartServer, &status);
+	if (!m_client) {
+		qWarning() << "Could not connect to JACK server, status:" << int(status);
+		return;
+	}
+
+	// only the ports up to the first failed registration are used:
+	for (int i=0; i<JACK_MAX_INPUT_PORTS; ++i) {
+		const QByteArray portName = QString("in_%1").arg(i + 1).toLatin1();
+		m_ports[i] = jack_port_register(m_client, portName.constData(), JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
+		if (!m_ports[i]) {
+			qWarning() << "Could not register JACK port" << portName << ", using" << i << "input ports.";
+			break;
+		}
+		++m_numPorts;
+	}
+
+	// prepare the buffer for the current sample rate before the processing starts:
+	m_sampleRate.store(int(jack_get_sample_rate(m_client)));
+	m_appliedSampleRate = m_sampleRate.load();
+	m_bufferSize.store(int(jack_get_buffer_size(m_client)));
+	m_buffer->setInputSampleRate(m_appliedSampleRate);
+
+	jack_set_process_callback(m_client, &JackAudioInput::processCallback, this);
+	jack_set_sample_rate_callback(m_client, &JackAudioInput::sampleRateCallback, this);
+	jack_set_buffer_size_callback(m_client, &JackAudioInput::bufferSizeCallback, this);
+	jack_on_shutdown(m_client, &JackAudioInput::shutdownCallback, this);
+
+	if (jack_activate(m_client) != 0) {
+		qWarning() << "Could not activate JACK client.";
+		jack_client_close(m_client);
+		m_client = nullptr;
+		return;
+	}
+	qDebug() << "JACK client active at" << m_sampleRate.load() << "Hz with"
+			 << m_bufferSize.load() << "frames per period.";
+}
+
+JackAudioInput::~JackAudioInput()
+{
+	if (!m_client) return;
+	// stops the processing thread before the client is closed:
+	if (!m_shutdown.load()) jack_deactivate(m_client);
+	jack_client_close(m_client);
+}
+
+QStringList JackAudioInput::getAvailableInputs() const
+{
+	QStringList inputs;
+	if (!isConnected()) return inputs;
+
+	// all audio output ports of other clients can be used as input:
+	const char** ports = jack_get_ports(m_client, nullptr, JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput);
+	if (!ports) return inputs;
+	QStringList portNames;
+	for (int i=0; ports[i]; ++i) {
+		portNames.append(QString::fromUtf8(ports[i]));
+	}
+	jack_free(ports);
+
+	// add stereo pairs of the ports of the same client (1+2, 3+4, ...):
+	for (int i=0; i<portNames.size(); ++i) {
+		inputs.append(portNames[i]);
+		if (i % 2 == 1) {
+			const QString previous = portNames[i - 1];
+			if (previous.section(':', 0, 0) == portNames[i].section(':', 0, 0)) {
+				inputs.append(previous + JACK_PORT_SEPARATOR + portNames[i]);
+			}
+		}
+	}
+
+	// add the first JACK_MAX_INPUT_PORTS ports of clients with more than two ports
+	// (to analyze the channels of a multichannel interface separately):
+	int first = 0;
+	while (first < portNames.size()) {
+		const QString client = portNames[first].section(':', 0, 0);
+		int end = first + 1;
+		while (end < portNames.size() && portNames[end].section(':', 0, 0) == client) ++end;
+		if (end - first > 2) {
+			inputs.append(QStringList(portNames.mid(first, qMin(end - first, JACK_MAX_INPUT_PORTS))).join(JACK_PORT_SEPARATOR));
+		}
+		first = end;
+	}
+	return inputs;
+}
+
+QString JackAudioInput::getDefaultInputName() const
+{
+	if (!isConnected()) return "";
+
+	// use the first physical capture ports (i.e. "system:capture_1+system:capture_2"):
+	const char** ports = jack_get_ports(m_client, nullptr, JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput | JackPortIsPhysical);
+	if (!ports) return "";
+	QStringList names;
+	for (int i=0; ports[i] && i < JACK_DEFAULT_INPUT_PORTS; ++i) {
+		names.append(QString::fromUtf8(ports[i]));
+	}
+	jack_free(ports);
+	return names.join(JACK_PORT_SEPARATOR);
+}
+
+void JackAudioInput::setInputByName(const QString& name)
+{
+	if (!isConnected()) return;
+
+	disconnectInputs();
+
+	// connect each source port to one of the input ports of this client:
+	const QStringList sources = name.split(JACK_PORT_SEPARATOR, QString::SkipEmptyParts);
+	int numConnected = 0;
+	for (int i=0; i<sources.size() && numConnected < m_numPorts; ++i) {
+		const QByteArray source = sources[i].toUtf8();
+		if (jack_connect(m_client, source.constData(), jack_port_name(m_ports[numConnected])) != 0) {
+			qWarning() << "Could not connect JACK port" << sources[i];
+			continue;
+		}
+		++numConnected;
+	}
+	m_numActivePorts.store(numConnected);
+	m_activeInputName = name;
+}
+
+void JackAudioInput::setVolume(const qreal& value)
+{
+	m_volume.store(limit(0, value, 1));
+}
+
+void JackAudioInput::disconnectInputs()
+{
+	m_numActivePorts.store(0);
+	for (int i=0; i<m_numPorts; ++i) {
+		jack_port_disconnect(m_client, m_ports[i]);
+	}
+}
+
+int JackAudioInput::processCallback(jack_nframes_t numFrames, void* arg)
+{
+	JackAudioInput* input = static_cast<JackAudioInput*>(arg);
+
+	// apply a new sample rate in this thread, so that the buffer keeps a single producer:
+	const int sampleRate = input->m_sampleRate.load(std::memory_order_acquire);
+	if (sampleRate != input->m_appliedSampleRate) {
+		input->m_appliedSampleRate = sampleRate;
+		input->m_buffer->setInputSampleRate(sampleRate);
+	}
+
+	const int numPorts = input->m_numActivePorts.load(std::memory_order_relaxed);
+	if (numPorts <= 0) return 0;
+
+	const float* channels[JACK_MAX_INPUT_PORTS];
+	for (int port=0; port<numPorts; ++port) {
+		channels[port] = static_cast<const float*>(jack_port_get_buffer(input->m_ports[port], numFrames));
+	}
+
+	// next element in processing chain (mixes the ports to mono and keeps them as separate channels):
+	input->m_buffer->putSamples(channels, numPorts, int(numFrames), input->m_volume.load(std::memory_order_relaxed));
+	return 0;
+}
+
+int JackAudioInput::sampleRateCallback(jack_nframes_t sampleRate, void* arg)
+{
+	// (may be called in another thread than processCallback, which applies the new rate)
+	JackAudioInput* input = static_cast<JackAudioInput*>(arg);
+	input->m_sampleRate.store(int(sampleRate), std::memory_order_release);
+	return 0;
+}
+
+int JackAudioInput::bufferSizeCallback(jack_nframes_t numFrames, void* arg)
+{
+	// the MonoAudioBuffer processes periods of any size in blocks of a fixed size,
+	// so nothing has to be reallocated:
+	JackAudioInput* input = static_cast<JackAudioInput*>(arg);
+	input->m_bufferSize.store(int(numFrames));
+	return 0;
+}
+
+void JackAudioInput::shutdownCallback(void* arg)
+{
+	JackAudioInput* input = static_cast<JackAudioInput*>(arg);
+	input->m_shutdown.store(true);
+	qWarning() << "JACK server has shut down the Sound2Light client.";
+}
@@ -0,0 +1,125 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef JACKAUDIOINPUT_H
+#define JACKAUDIOINPUT_H
+
+#include "AudioInputInterface.h"
+#include "MonoAudioBuffer.h"
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <jack/jack.h>
+
+#include <atomic>
+
+
+// name of the JACK client
+static const char* const JACK_CLIENT_NAME = "Sound2Light";
+
+// maximum number of input ports, the signals of all connected ports are mixed to mono
+// (and are available as separate channels for the per-channel analysis)
+static const int JACK_MAX_INPUT_PORTS = MAX_ANALYSIS_CHANNELS;
+
+// number of physical capture ports used as default input (a stereo pair)
+static const int JACK_DEFAULT_INPUT_PORTS = 2;
+
+// separator of port names when more than one source port is used as input,
+// i.e. "system:capture_1+system:capture_2"
+static const char JACK_PORT_SEPARATOR = '+';
+
+
+// An AudioInputInterface implementation that registers as a JACK client.
+// see AudioInputInterface.h for documentation of overridden functions
+//
+// The JACK server calls processCallback() in its realtime thread once per period
+// (usually 64...256 frames), the samples are put into the MonoAudioBuffer directly
+// from there without any further buffering. This thread is the single producer of the buffer.
+// The sample rate and buffer size callbacks may run in another thread (i.e. with JACK2),
+// so they only store the new values, a new sample rate is applied to the buffer by the next
+// processCallback() (MonoAudioBuffer::setInputSampleRate() doesn't allocate).
+// The buffer accepts periods of any size, so a new buffer size needs no reconfiguration.
+//
+// The available inputs are the audio output ports of the JACK graph, stereo pairs of them
+// and all ports of a client with more than two ports (i.e. all channels of a multitrack interface).
+// An input name is one port or up to JACK_MAX_INPUT_PORTS ports separated by JACK_PORT_SEPARATOR,
+// each of them is connected to one of the input ports of this client.
+// The client registers JACK_MAX_INPUT_PORTS (MAX_ANALYSIS_CHANNELS) input ports,
+// so that every channel a trigger can be bound to can be connected
+// (the ports up to the first one that can't be registered are used).
+//
+// The backend is only compiled with "qmake CONFIG+=jack" (defines S2L_WITH_JACK).
+// It can be tested on a headless machine with the dummy driver of jackd:
+//   jackd -d dummy -r 48000 -p 64 &
+//   jack_metro -b 120 &
+//   QT_QPA_PLATFORM=offscreen s2l --jack
+// and selecting "metro:120_bpm" as input.
+class JackAudioInput : public AudioInputInterface
+{
+
+public:
+	explicit JackAudioInput(MonoAudioBuffer* buffer);
+	~JackAudioInput() override;
+
+	// returns the number of frames per period of the JACK server
+	int getBufferSize() const { return m_bufferSize.load(); }
+
+	// returns true if the connection to the JACK server was established
+	bool isConnected() const { return m_client && !m_shutdown.load(); }
+
+	// returns all audio output ports, stereo pairs of the ports of each client
+	// and all ports of each client with more than two ports
+	QStringList getAvailableInputs() const override;
+
+	// returns the first JACK_DEFAULT_INPUT_PORTS physical capture ports
+	QString getDefaultInputName() const override;
+
+	QString getActiveInputName() const override { return m_activeInputName; }
+	void setInputByName(const QString& name) override;
+
+	qreal getVolume() const override { return m_volume.load(); }
+	void setVolume(const qreal& value) override;
+
+protected:
+	// JACK callbacks, arg is a pointer to this object
+	// - processCallback is called in the realtime thread of JACK and must not block or allocate
+	static int processCallback(jack_nframes_t numFrames, void* arg);
+	static int sampleRateCallback(jack_nframes_t sampleRate, void* arg);
+	static int bufferSizeCallback(jack_nframes_t numFrames, void* arg);
+	static void shutdownCallback(void* arg);
+
+	// disconnects all input ports from their sources
+	void disconnectInputs();
+
+	jack_client_t*		m_client;  // the JACK client or nullptr if there is no server
+	jack_port_t*		m_ports[JACK_MAX_INPUT_PORTS];  // the input ports of this client
+	int					m_numPorts;  // number of registered input ports (the first ones of m_ports, the others are nullptr)
+	QString				m_activeInputName;  // the name of the active input (source ports)
+	std::atomic<int>	m_numActivePorts;  // number of input ports that are connected to a source
+	std::atomic<int>	m_sampleRate;  // the sample rate of the JACK server
+	int					m_appliedSampleRate;  // the sample rate the buffer is configured for (only used by processCallback())
+	std::atomic<int>	m_bufferSize;  // number of frames per period of the JACK server
+	std::atomic<float>	m_volume;  // gain applied to the samples [0...1]
+	std::atomic<bool>	m_shutdown;  // true if the JACK server has shut down the client
+};
+
+#endif // JACKAUDIOINPUT_H
@@ -21,6 +21,12 @@
 #include "MainController.h"
 
 #include "QAudioInputWrapper.h"
+#include "AudioFileInput.h"
+#include "AudioStreamInput.h"
+#include "NetworkAudioInput.h"
+#ifdef S2L_WITH_JACK
+#include "JackAudioInput.h"
+#endif
 #include "TriggerGenerator.h"
 #include "TriggerGuiController.h"
 #include "OSCNetworkManager.h"
@@ -34,14 +40,22 @@
 #include <QDateTime>
 #include <QScreen>
 #include <QFileDialog>
+#include <QtConcurrent>
 
 
 MainController::MainController(QQmlApplicationEngine* qmlEngine, QObject *parent)
 	: QObject(parent)
 	, m_qmlEngine(qmlEngine)
-    , m_buffer(NUM_SAMPLES*4) // more buffer so the bpm detector can get overlaping data
+    , m_buffer(MAX_NUM_SAMPLES*2, MAX_ANALYSIS_CHANNELS) // more buffer so the bpm detector can get overlaping data
     , m_audioInput(nullptr)
 	, m_fft(m_buffer, m_triggerContainer)
+	, m_channelFfts()
+	, m_activeFfts()
+	, m_hopFfts()
+	, m_levelOnlyFfts()
+	, m_analysisMutex(QMutex::Recursive)
+	, m_hopTriggersChecked()
+	, m_analysisThread(m_buffer, [this]() { return analyzeNewHops(); })
 	, m_osc()
 	, m_consoleType("Eos")
 	, m_oscMapping(this)
@@ -52,9 +66,19 @@ MainController::MainController(QQmlApplicationEngine* qmlEngine, QObject *parent
     , m_bpmActive(false)
     , m_waveformVisible(true)
     , m_autoBpm(false)
+    , m_analysisDrivenByInput(false)
+	, m_reportedAudioOverruns(0)
+	, m_reportedAudioUnderruns(0)
 {
 	m_audioInput = new QAudioInputWrapper(&m_buffer);
 
+	for (int channel=0; channel<m_buffer.getMaxChannelBuffers(); ++channel) {
+		m_channelFfts.append(new FFTAnalyzer(m_buffer.getChannelBuffer(channel), m_triggerContainer, channel));
+	}
+	m_activeFfts.reserve(m_channelFfts.size() + 1);
+	m_hopFfts.reserve(m_channelFfts.size() + 1);
+	m_levelOnlyFfts.reserve(m_channelFfts.size());
+
 	initializeGenerators();
 	connectGeneratorsWithGui();
 }
@@ -63,6 +87,9 @@ MainController::~MainController()
 {
 	// delete all objects created on Heap:
     delete m_audioInput; m_audioInput = nullptr;
+	// (the analysis thread uses the analyzers and the triggers)
+	m_analysisThread.stopAnalysis();
+    qDeleteAll(m_channelFfts); m_channelFfts.clear();
 
     delete m_bass; m_bass = nullptr;
     delete m_loMid; m_loMid = nullptr;
@@ -111,6 +138,67 @@ void MainController::initAfterQmlIsLoaded()
 	connect(getMainWindow(), SIGNAL(visibilityChanged(QWindow::Visibility)), this, SLOT(onVisibilityChanged()));
 }
 
+void MainController::useAudioFileInput(const QString& fileName, const QString& rawFormat, bool realtime)
+{
+	AudioFileInput* fileInput = new AudioFileInput(&m_buffer, fileName, FFT_UPDATE_RATE, realtime);
+	if (!rawFormat.isEmpty() && !fileInput->setRawFormat(rawFormat)) {
+		qWarning() << "Invalid raw PCM format:" << rawFormat;
+	}
+	connect(fileInput, SIGNAL(hopReady()), this, SLOT(onInputHopReady()));
+	connect(fileInput, SIGNAL(finished()), this, SIGNAL(inputFinished()));
+
+	delete m_audioInput;
+	m_audioInput = fileInput;
+	m_analysisDrivenByInput = true;
+}
+
+void MainController::useAudioStreamInput(const QString& sourceName, const QString& format)
+{
+	QAudioFormat streamFormat;
+	if (!PcmDecoder::parseFormat(format.isEmpty() ? QString("s16le:2:44100") : format, streamFormat)) {
+		qWarning() << "Invalid raw PCM format:" << format;
+		PcmDecoder::parseFormat("s16le:2:44100", streamFormat);
+	}
+	// the old input has to be stopped first, because the buffer accepts only one producer:
+	delete m_audioInput;
+	AudioStreamInput* streamInput = new AudioStreamInput(&m_buffer, sourceName, streamFormat);
+	connect(streamInput, SIGNAL(streamFinished()), this, SIGNAL(inputFinished()));
+	m_audioInput = streamInput;
+}
+
+void MainController::useNetworkInput(const QString& sourceName, const QString& format)
+{
+	// L16 stereo is the most common RTP payload:
+	QAudioFormat networkFormat;
+	if (!PcmDecoder::parseFormat(format.isEmpty() ? QString("s16be:2:48000") : format, networkFormat)) {
+		qWarning() << "Invalid raw PCM format:" << format;
+		PcmDecoder::parseFormat("s16be:2:48000", networkFormat);
+	}
+	// the old input has to be stopped first, because the buffer accepts only one producer:
+	delete m_audioInput;
+	m_audioInput = new NetworkAudioInput(&m_buffer, sourceName, networkFormat);
+}
+
+bool MainController::useJackInput()
+{
+#ifdef S2L_WITH_JACK
+	// the old input has to be stopped first, because the buffer accepts only one producer:
+	delete m_audioInput;
+	JackAudioInput* jackInput = new JackAudioInput(&m_buffer);
+	m_audioInput = jackInput;
+	if (!jackInput->isConnected()) {
+		// fall back to the sound card:
+		delete m_audioInput;
+		m_audioInput = new QAudioInputWrapper(&m_buffer);
+		return false;
+	}
+	return true;
+#else
+	qWarning() << "Sound2Light was built without JACK support (qmake CONFIG+=jack).";
+	return false;
+#endif
+}
+
 void MainController::initializeGenerators()
 {
 	// create TriggerGenerator objects:
@@ -200,8 +288,8 @@ void MainController::initAudioInput()
 	if (settingsFormatIsValid(settings)) {
 		inputDeviceName = settings.value("inputDeviceName").toString();
 	}
-	// if it is empty, set it to default input:
-	if (inputDeviceName.isEmpty()) {
+	// if it is empty or not available, set it to default input:
+	if (inputDeviceName.isEmpty() || !m_audioInput->getAvailableInputs().contains(inputDeviceName)) {
 		inputDeviceName = m_audioInput->getDefaultInputName();
 	}
 	if (inputDeviceName.isEmpty()) {
@@ -213,13 +301,27 @@ void MainController::initAudioInput()
 		emit inputChanged();
 	}
 
-	// start FFT update timer:
-	connect(&m_fftUpdateTimer, SIGNAL(timeout()), this, SLOT(updateFFT()));
-	m_fftUpdateTimer.start(1000.0 / FFT_UPDATE_RATE);
+	// start the analysis thread, it analyzes each hop as soon as the input has put it into the buffer
+	// (if the input doesn't drive the analysis itself):
+	connect(&m_bandTriggerTimer, SIGNAL(timeout()), this, SLOT(checkBandTriggers()));
+	if (!m_analysisDrivenByInput) {
+		{
+			QMutexLocker locker(&m_analysisMutex);
+			updateActiveAnalyzers();
+		}
+		m_analysisThread.startAnalysis();
+		if (m_fft.getBandpassEngine() != FFTBandpassEngine) {
+			m_bandTriggerTimer.start(1000.0 / BAND_ENERGY_POLL_RATE);
+		}
+	}
 
     // set up the BPM timer and start it
     connect(&m_bpmUpdatetimer, SIGNAL(timeout()), this, SLOT(updateBPM()));
     setBPMActive(m_bpmActive);
+
+	// check the input for dropouts regularly:
+	connect(&m_audioStatusTimer, SIGNAL(timeout()), this, SLOT(checkAudioStatus()));
+	m_audioStatusTimer.start(1000 / AUDIO_STATUS_CHECK_RATE);
 }
 
 void MainController::triggerBeat()
@@ -238,7 +340,9 @@ void MainController::activateBPM()
 {
     m_bpm.resetCache();
     m_bpmTap.reset();
-    m_bpmUpdatetimer.start(1000.0 / BPM_UPDATE_RATE);
+    if (!m_analysisDrivenByInput) {
+        m_bpmUpdatetimer.start(1000.0 / BPM_UPDATE_RATE);
+    }
 }
 
 void MainController::deactivateBPM()
@@ -246,6 +350,166 @@ void MainController::deactivateBPM()
     m_bpmUpdatetimer.stop();
 }
 
+void MainController::updateFFT()
+{
+	QMutexLocker locker(&m_analysisMutex);
+	updateActiveAnalyzers();
+
+	// all new hops are analyzed, the triggers are checked after each of them:
+	while (analyzeNextHops()) {
+		checkTriggersOfHops();
+	}
+
+	// the bandpass triggers are checked with the new samples if they don't use the FFT:
+	for (FFTAnalyzer* fft: m_activeFfts) {
+		fft->checkBandTriggers(m_lowSoloMode);
+	}
+}
+
+void MainController::checkHopTriggers()
+{
+	{
+		QMutexLocker locker(&m_analysisMutex);
+		checkTriggersOfHops();
+		// (changes of the channels of the triggers are applied from the next hop on)
+		updateActiveAnalyzers();
+	}
+	m_hopTriggersChecked.release();
+}
+
+void MainController::checkBandTriggers()
+{
+	QMutexLocker locker(&m_analysisMutex);
+	for (FFTAnalyzer* fft: m_activeFfts) {
+		fft->checkBandTriggers(m_lowSoloMode);
+	}
+}
+
+void MainController::updateActiveAnalyzers()
+{
+	// find the channels the triggers are bound to
+	// (the level triggers use the block levels of the buffer, so usually only bandpass triggers need a spectrum):
+	bool channelUsed[MAX_ANALYSIS_CHANNELS] = {};
+	bool spectrumUsed[MAX_ANALYSIS_CHANNELS] = {};
+	int numChannelBuffers = 0;
+	for (int i=0; i<m_triggerContainer.size(); ++i) {
+		const TriggerGeneratorInterface* trigger = m_triggerContainer[i];
+		const int channel = trigger->getChannel();
+		if (channel < 0) continue;
+		channelUsed[channel] = true;
+		spectrumUsed[channel] = spectrumUsed[channel] || trigger->usesSpectrum();
+		numChannelBuffers = qMax(numChannelBuffers, channel + 1);
+	}
+	// (the buffer fills the channel buffers from the next block of the input on)
+	m_buffer.setNumChannelBuffers(numChannelBuffers);
+
+	// the spectrum of the downmix is always needed for the GUI:
+	m_activeFfts.clear();
+	m_activeFfts.append(&m_fft);
+	m_levelOnlyFfts.clear();
+	for (int channel=0; channel<numChannelBuffers; ++channel) {
+		if (spectrumUsed[channel]) {
+			m_activeFfts.append(m_channelFfts[channel]);
+		} else if (channelUsed[channel]) {
+			// the channels with only level triggers don't need a FFT:
+			m_levelOnlyFfts.append(m_channelFfts[channel]);
+		}
+	}
+	syncChannelSpectrumParameters();
+}
+
+bool MainController::analyzeNextHops()
+{
+	m_hopFfts.clear();
+	for (FFTAnalyzer* fft: m_activeFfts) {
+		if (fft->isHopAvailable()) m_hopFfts.append(fft);
+	}
+	if (m_hopFfts.isEmpty()) return false;
+
+	if (m_hopFfts.size() == 1) {
+		m_hopFfts.first()->analyze();
+	} else {
+		QtConcurrent::blockingMap(m_hopFfts, [](FFTAnalyzer* fft) { fft->analyze(); });
+	}
+	return true;
+}
+
+void MainController::checkTriggersOfHops()
+{
+	for (FFTAnalyzer* fft: m_hopFfts) {
+		fft->checkTriggers(m_lowSoloMode);
+	}
+	for (FFTAnalyzer* fft: m_levelOnlyFfts) {
+		fft->checkTriggers(m_lowSoloMode);
+	}
+	m_hopFfts.clear();
+}
+
+int64_t MainController::analyzeNewHops()
+{
+	forever {
+		{
+			QMutexLocker locker(&m_analysisMutex);
+			if (!analyzeNextHops()) {
+				// the next hop is the one whose samples are missing first
+				// (the channel buffers get the same number of samples as the downmix with each block):
+				int missingSamples = m_fft.getSamplesUntilNextHop();
+				for (FFTAnalyzer* fft: m_activeFfts) {
+					missingSamples = qMin(missingSamples, fft->getSamplesUntilNextHop());
+				}
+				return m_buffer.getNumPutSamples() + missingSamples;
+			}
+		}
+
+		// the triggers send OSC messages and use timers, so they are checked in the GUI thread,
+		// the next hop is analyzed when they are done:
+		QMetaObject::invokeMethod(this, "checkHopTriggers", Qt::QueuedConnection);
+		if (!AnalysisThread::acquireOrInterrupt(m_hopTriggersChecked)) return m_buffer.getNumPutSamples();
+	}
+}
+
+void MainController::syncChannelSpectrumParameters()
+{
+	const ScaledSpectrum& source = m_fft.getScaledSpectrum();
+	for (FFTAnalyzer* fft: m_channelFfts) {
+		ScaledSpectrum& spectrum = fft->getScaledSpectrum();
+		// the gain is adapted for each analyzed channel separately if AGC is enabled
+		// (channels without a spectrum use the gain of the downmix for their levels):
+		if (!source.getAgcEnabled() || !m_activeFfts.contains(fft)) spectrum.setGain(source.getGain());
+		spectrum.setCompression(source.getCompression());
+		spectrum.setDecibelConversion(source.getDecibelConversion());
+		fft->setPowerDomain(source.getPowerDomain());
+		spectrum.setAgcEnabled(source.getAgcEnabled());
+	}
+}
+
+void MainController::onInputHopReady()
+{
+    updateFFT();
+    if (m_bpmActive) {
+        updateBPM();
+    }
+}
+
+void MainController::checkAudioStatus()
+{
+	const int numOverruns = getNumAudioOverruns();
+	const int numUnderruns = getNumAudioUnderruns();
+	if (numOverruns == m_reportedAudioOverruns && numUnderruns == m_reportedAudioUnderruns) return;
+
+	if (numOverruns != m_reportedAudioOverruns) {
+		qWarning() << QDateTime::currentDateTime().toString(Qt::ISODate) << "Audio input overrun:"
+				   << numOverruns << "overruns," << getNumLostAudioSamples() << "samples lost in total";
+	}
+	if (numUnderruns != m_reportedAudioUnderruns) {
+		qWarning() << QDateTime::currentDateTime().toString(Qt::ISODate) << "Audio input underrun:"
+				   << numUnderruns << "times the samples arrived late";
+	}
+	m_reportedAudioOverruns = numOverruns;
+	m_reportedAudioUnderruns = numUnderruns;
+	m_oscMapping.sendAudioStatus();
+}
+
 void MainController::setConsoleType(QString value)
 {
 	if (value.isEmpty()) return;
@@ -256,10 +520,94 @@ void MainController::setConsoleType(QString value)
 	emit presetChanged();
 }
 
+void MainController::setFftSizeExponent(int value)
+{
+	{
+		// (the analyzers are not changed while the analysis thread uses them)
+		QMutexLocker locker(&m_analysisMutex);
+		m_fft.setSizeExponent(value);
+		for (FFTAnalyzer* fft: m_channelFfts) {
+			fft->setSizeExponent(value);
+		}
+	}
+	emit fftSizeChanged();
+}
+
+void MainController::setMultiResolutionEnabled(bool value)
+{
+	// (the analyzers are not changed while the analysis thread uses them)
+	QMutexLocker locker(&m_analysisMutex);
+	m_fft.setMultiResolution(value);
+	for (FFTAnalyzer* fft: m_channelFfts) {
+		fft->setMultiResolution(value);
+	}
+}
+
+QString MainController::getBandpassEngine() const
+{
+	switch (m_fft.getBandpassEngine()) {
+	case SlidingDFTBandpassEngine: return "Sliding DFT";
+	case FilterBankBandpassEngine: return "Filter Bank";
+	default: return "FFT";
+	}
+}
+
+void MainController::setBandpassEngine(const QString& value)
+{
+	const QString name = value.toLower().replace('_', ' ');
+	BandpassEngine engine;
+	if (name == "fft") {
+		engine = FFTBandpassEngine;
+	} else if (name == "sliding dft") {
+		engine = SlidingDFTBandpassEngine;
+	} else if (name == "filter bank") {
+		engine = FilterBankBandpassEngine;
+	} else {
+		return;
+	}
+
+	{
+		QMutexLocker locker(&m_analysisMutex);
+		m_fft.setBandpassEngine(engine);
+		for (FFTAnalyzer* fft: m_channelFfts) {
+			fft->setBandpassEngine(engine);
+		}
+	}
+	// the other engines are checked regularly between the hops of the FFT:
+	if (engine == FFTBandpassEngine) {
+		m_bandTriggerTimer.stop();
+	} else if (m_analysisThread.isRunning()) {
+		m_bandTriggerTimer.start(1000.0 / BAND_ENERGY_POLL_RATE);
+	}
+}
+
+QString MainController::getFftProfile() const
+{
+	switch (getFftSizeExponent()) {
+	case FFT_LOW_LATENCY_EXPONENT: return "Low Latency";
+	case FFT_BALANCED_EXPONENT: return "Balanced";
+	case FFT_HIGH_RESOLUTION_EXPONENT: return "High Resolution";
+	default: return "Custom";
+	}
+}
+
+void MainController::setFftProfile(const QString& value)
+{
+	const QString profile = value.toLower().replace('_', ' ');
+	if (profile == "low latency") {
+		setFftSizeExponent(FFT_LOW_LATENCY_EXPONENT);
+	} else if (profile == "balanced") {
+		setFftSizeExponent(FFT_BALANCED_EXPONENT);
+	} else if (profile == "high resolution") {
+		setFftSizeExponent(FFT_HIGH_RESOLUTION_EXPONENT);
+	}
+}
+
 QList<qreal> MainController::getSpectrumPoints()
 {
 	// convert const QVector<float>& to QList<qreal> to be used in GUI:
 	QList<qreal> points;
+	QMutexLocker locker(&m_analysisMutex);
 	const QVector<float>& spectrum = m_fft.getNormalizedSpectrum();
 	for (int i=0; i<spectrum.size(); ++i) {
 		points.append(spectrum[i]);
@@ -403,6 +751,14 @@ void MainController::savePresetIndependentSettings() const
 	bool maximized = (getMainWindow()->width() == QGuiApplication::primaryScreen()->availableSize().width());
 	independentSettings.setValue("maximized", maximized);
 	independentSettings.setValue("inputDeviceName", getActiveInputName());
+	independentSettings.setValue("resamplingEnabled", getResamplingEnabled());
+	independentSettings.setValue("dcBlockerEnabled", getDcBlockerEnabled());
+	independentSettings.setValue("highPassFrequency", getHighPassFrequency());
+	independentSettings.setValue("highPassOrder", getHighPassOrder());
+	independentSettings.setValue("bpmDecimationEnabled", getBPMDecimationEnabled());
+	independentSettings.setValue("fftSizeExponent", getFftSizeExponent());
+	independentSettings.setValue("multiResolutionEnabled", getMultiResolutionEnabled());
+	independentSettings.setValue("bandpassEngine", getBandpassEngine());
 	independentSettings.setValue("presetFileName", m_currentPresetFilename);
 	independentSettings.setValue("presetChangedButNotSaved", m_presetChangedButNotSaved);
 	independentSettings.setValue("oscLogSettingsValid", true);
@@ -426,6 +782,13 @@ void MainController::loadPresetIndependentSettings()
 	setOscEnabled(independentSettings.value("oscIsEnabled").toBool());
 	setUseTcp(independentSettings.value("oscUseTcp").toBool());
 	setUseOsc_1_1(independentSettings.value("oscUse_1_1").toBool());
+	setResamplingEnabled(independentSettings.value("resamplingEnabled", true).toBool());
+	setDcBlockerEnabled(independentSettings.value("dcBlockerEnabled", true).toBool());
+	setHighPass(independentSettings.value("highPassFrequency", 0).toInt(), independentSettings.value("highPassOrder", 2).toInt());
+	setBPMDecimationEnabled(independentSettings.value("bpmDecimationEnabled", false).toBool());
+	setFftSizeExponent(independentSettings.value("fftSizeExponent", NUM_SAMPLES_EXPONENT).toInt());
+	setMultiResolutionEnabled(independentSettings.value("multiResolutionEnabled", false).toBool());
+	setBandpassEngine(independentSettings.value("bandpassEngine", "FFT").toString());
 	if (independentSettings.value("oscLogSettingsValid").toBool()) {
 		enableOscLogging(independentSettings.value("oscLogIncomingIsEnabled").toBool(), independentSettings.value("oscLogOutgoingIsEnabled").toBool());
 	} else {
@@ -479,6 +842,7 @@ void MainController::loadPreset(const QString &constFileName, bool createIfNotEx
 
 	// restore all general, not independent settings from the preset file:
 	setDecibelConversion(settings.value("dbConversion").toBool());
+	setPowerDomain(settings.value("powerDomain", false).toBool());
 	setFftGain(settings.value("fftGain").toReal());
 	setFftCompression(settings.value("fftCompression").toReal());
 	setAgcEnabled(settings.value("agcEnabled").toBool());
@@ -515,6 +879,7 @@ void MainController::loadPreset(const QString &constFileName, bool createIfNotEx
 
 	// notify the GUI of the changes:
 	emit decibelConversionChanged();
+	emit powerDomainChanged();
 	emit agcEnabledChanged();
 	emit gainChanged();
 	emit compressionChanged();
@@ -566,6 +931,7 @@ void MainController::savePresetAs(const QString &constFileName, bool isAutosave)
 	settings.setValue("formatVersion", SETTINGS_FORMAT_VERSION);
 	settings.setValue("changedAt", QDateTime::currentDateTime().toString());
 	settings.setValue("dbConversion", getDecibelConversion());
+	settings.setValue("powerDomain", getPowerDomain());
 	settings.setValue("fftGain", getFftGain());
 	settings.setValue("fftCompression", getFftCompression());
 	settings.setValue("agcEnabled", getAgcEnabled());
@@ -646,6 +1012,7 @@ void MainController::resetPreset()
 	setFftCompression(1.0);
 	setAgcEnabled(true);
 	setDecibelConversion(false);
+	setPowerDomain(false);
     setLowSoloMode(false);
     setBPMActive(false);
     setMinBPM(75);
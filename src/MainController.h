@@ -22,6 +22,7 @@
 #define MAINCONTROLLER_H
 
 #include "FFTAnalyzer.h"
+#include "AnalysisThread.h"
 #include "BPMDetector.h"
 #include "BPMTapDetector.h"
 #include "MonoAudioBuffer.h"
@@ -40,15 +41,24 @@
 #include <QUrl>
 #include <QGuiApplication>
 #include <QQuickItem>
+#include <QMutex>
+#include <QSemaphore>
 
 #include <iostream>
 
 // Rate to calculate the FFT (and Trigger signals) in Hz / FPS
-static const int FFT_UPDATE_RATE = 44; // Hz
+static const int FFT_UPDATE_RATE = FFT_HOP_RATE; // Hz
+
+// Rate to check the bandpass triggers if they are not checked with the FFT
+// (see FFTAnalyzer::checkBandTriggers() and BandpassEngine, the FFT is driven by the input, see AnalysisThread)
+static const int BAND_ENERGY_POLL_RATE = 400; // Hz
 
 // Rate to send OSC Level Feedback (if activated) in Hz / FPS
 static const int OSC_LEVEL_FEEDBACK_RATE = 15; // Hz
 
+// Rate to check the audio input for dropouts in Hz
+static const int AUDIO_STATUS_CHECK_RATE = 1; // Hz
+
 
 // Forward declarations:
 class TriggerGenerator;
@@ -58,8 +68,12 @@ class EnvelopeTriggerGuiController;
 
 
 // Processing chains in this software:
-// 1. Chain:  AudioInput (async) -> MonoAudioBuffer
-// 2. Chain:  QTimer(44Hz) -> FFTAnalyzer -> TriggerGenerator -> TriggerFilter -> OSCNetworkManager
+// 1. Chain:  AudioInput (capture thread) -> MonoAudioBuffer (lock-free, read by the analysis chains)
+// 2. Chain:  MonoAudioBuffer::HopListener (capture thread, when a hop of new samples is complete)
+//            -> AnalysisThread -> FFTAnalyzer (analysis thread, FFT_HOP_RATE frames per second)
+//            -> checkHopTriggers() (GUI thread, the analysis thread waits for it)
+//            -> TriggerGenerator -> TriggerFilter -> OSCNetworkManager
+//            (one FFTAnalyzer for the downmix and one per channel a trigger is bound to, calculated in parallel)
 
 
 // This class coordinates the communication of Model and GUI,
@@ -72,6 +86,10 @@ class MainController : public QObject
 	Q_PROPERTY(bool decibelConversion READ getDecibelConversion NOTIFY decibelConversionChanged)
 	// this property is used by the AGC checkbox:
 	Q_PROPERTY(bool agcEnabled READ getAgcEnabled NOTIFY agcEnabledChanged)
+
+	Q_PROPERTY(bool powerDomain READ getPowerDomain NOTIFY powerDomainChanged)
+
+	Q_PROPERTY(QString fftProfile READ getFftProfile NOTIFY fftSizeChanged)
 	// the base name of the preset file to be displayed in GUI:
 	Q_PROPERTY(QString presetName READ getPresetName NOTIFY presetNameChanged)
 	// this property indicates if the current preset has been changed but not stored yet:
@@ -92,10 +110,34 @@ public:
 	// initializes everything that has to be done after QML is loaded
 	void initAfterQmlIsLoaded();
 
+	// replaces the sound card input by a WAV or raw PCM file input
+	// rawFormat is used for files without a WAV header (see PcmDecoder::parseFormat())
+	// the analysis is then driven once per hop by the file instead of by the update timers
+	// - has to be called before initAfterQmlIsLoaded()
+	void useAudioFileInput(const QString& fileName, const QString& rawFormat, bool realtime);
+
+	// replaces the sound card input by raw PCM data from the standard input ("-") or a FIFO
+	// format is the format of the data (see PcmDecoder::parseFormat())
+	// - has to be called before initAfterQmlIsLoaded()
+	void useAudioStreamInput(const QString& sourceName, const QString& format);
+
+	// replaces the sound card input by RTP or plain UDP packets (see NetworkAudioInput.h)
+	// format is the format of the payload (see PcmDecoder::parseFormat())
+	// - has to be called before initAfterQmlIsLoaded()
+	void useNetworkInput(const QString& sourceName, const QString& format);
+
+	// replaces the sound card input by a JACK client (only available if built with CONFIG+=jack)
+	// returns false if there is no JACK support or no running JACK server
+	// - has to be called before initAfterQmlIsLoaded()
+	bool useJackInput();
+
 signals:
 	// emitted when the input device was changed
 	void inputChanged();
 
+	// emitted when an input file has been processed completely
+	void inputFinished();
+
 	// emitted when settings were changed
 	void settingsChanged();
 
@@ -105,6 +147,12 @@ signals:
 	// emitted when the AGC state is changed
 	void agcEnabledChanged();
 
+	// emitted when the power domain mode of the spectrum is changed
+	void powerDomainChanged();
+
+	// emitted when the FFT size (and with it the latency profile) is changed
+	void fftSizeChanged();
+
 	// emitted when presetChangedButNotSaved state changed
 	void presetChangedButNotSavedChanged();
 
@@ -169,12 +217,27 @@ public slots:
 	// restores the window size and position
 	void restoreWindowGeometry();
 
-    // update function passed to the FFTAnalyzer
-    void updateFFT() { m_fft.calculateFFT(m_lowSoloMode); }
+    // analyzes all new hops of the downmix and the channels the triggers are bound to
+    // and checks the triggers in this thread
+    // (used by inputs that drive the analysis themselves, see onInputHopReady())
+    void updateFFT();
+
+	// checks the triggers with the hop that has just been analyzed by the analysis thread
+	// - queued to the GUI thread by analyzeNewHops() (the triggers send OSC messages and use timers)
+	void checkHopTriggers();
+
+	// checks the bandpass triggers with the BandpassEngine if it is not the FFT
+	void checkBandTriggers();
 
     // update function passed to the BPMDetector
     void updateBPM() { m_bpm.detectBPM(); }
 
+    // called by an input that drives the analysis after each hop of new samples
+    void onInputHopReady();
+
+	// logs and sends the dropout counters of the input via OSC if they changed
+	void checkAudioStatus();
+
 	// ------------------- Presets --------------------------------
 
 	// load a preset file, creates a new file if it does not exist
@@ -256,6 +319,9 @@ public slots:
     void setMinBPM(int value);
     // gets the minium bpm of the range
     int getMinBPM() { return m_bpm.getMinBPM(); }
+    // set/get if the input of the bpm detection is decimated to reduce the CPU load
+    bool getBPMDecimationEnabled() const { return m_bpm.getDecimationEnabled(); }
+    void setBPMDecimationEnabled(bool value) { m_bpm.setDecimationEnabled(value); }
 
     // set/get bpm mute
     bool getBPMMute() { return m_bpmOSC.getBPMMute(); }
@@ -284,16 +350,61 @@ public slots:
 	qreal getVolume() const { return m_audioInput->getVolume(); }
 	void setVolume(const qreal& value) { m_audioInput->setVolume(value); emit presetChanged(); }
 
+	// returns the sample rate of the analyzed samples
+	int getAnalysisSampleRate() const { return m_buffer.getSampleRate(); }
+	// returns the number of input channels the triggers can be bound to
+	int getMaxAnalysisChannels() const { return m_buffer.getMaxChannelBuffers(); }
+	// returns if inputs with a higher sample rate are resampled to ANALYSIS_SAMPLE_RATE
+	bool getResamplingEnabled() const { return m_buffer.getResamplingEnabled(); }
+	// enables or disables the resampling of inputs with a higher sample rate
+	void setResamplingEnabled(bool value) { m_buffer.setResamplingEnabled(value); }
+
+	// forward calls to the pre-filter of MonoAudioBuffer
+	// see MonoAudioBuffer.h for documentation
+	bool getDcBlockerEnabled() const { return m_buffer.getDcBlockerEnabled(); }
+	void setDcBlockerEnabled(bool value) { m_buffer.setDcBlockerEnabled(value); }
+	int getHighPassFrequency() const { return m_buffer.getHighPassFrequency(); }
+	int getHighPassOrder() const { return m_buffer.getHighPassOrder(); }
+	void setHighPass(int frequency, int order) { m_buffer.setHighPass(frequency, order); }
+
+	// return the dropout counters of the input (see CaptureClock)
+	int getNumAudioOverruns() const { return m_buffer.getCaptureClock().getNumOverruns(); }
+	int getNumAudioUnderruns() const { return m_buffer.getCaptureClock().getNumUnderruns(); }
+	qint64 getNumLostAudioSamples() const { return m_buffer.getCaptureClock().getNumLostSamples(); }
+
 	// forward calls to ScaledSpectrum of FFTAnalyzer
 	// see ScaledSpectrum.h for documentation
+	// (the setters wait until the analysis thread has finished the current hop)
 	qreal getFftGain() const { return m_fft.getScaledSpectrum().getGain(); }
-	void setFftGain(const qreal& value) { m_fft.getScaledSpectrum().setGain(value); emit gainChanged(); emit presetChanged(); }
+	void setFftGain(const qreal& value) { { QMutexLocker locker(&m_analysisMutex); m_fft.getScaledSpectrum().setGain(value); } emit gainChanged(); emit presetChanged(); }
 	qreal getFftCompression() const { return m_fft.getScaledSpectrum().getCompression(); }
-	void setFftCompression(const qreal& value) { m_fft.getScaledSpectrum().setCompression(value); emit compressionChanged(); emit presetChanged(); }
+	void setFftCompression(const qreal& value) { { QMutexLocker locker(&m_analysisMutex); m_fft.getScaledSpectrum().setCompression(value); } emit compressionChanged(); emit presetChanged(); }
 	bool getDecibelConversion() const { return m_fft.getScaledSpectrum().getDecibelConversion(); }
-	void setDecibelConversion(bool value) { m_fft.getScaledSpectrum().setDecibelConversion(value); emit decibelConversionChanged(); emit presetChanged(); }
+	void setDecibelConversion(bool value) { { QMutexLocker locker(&m_analysisMutex); m_fft.getScaledSpectrum().setDecibelConversion(value); } emit decibelConversionChanged(); emit presetChanged(); }
 	bool getAgcEnabled() const { return m_fft.getScaledSpectrum().getAgcEnabled(); }
-	void setAgcEnabled(bool value) { m_fft.getScaledSpectrum().setAgcEnabled(value); emit agcEnabledChanged(); emit presetChanged(); }
+	void setAgcEnabled(bool value) { { QMutexLocker locker(&m_analysisMutex); m_fft.getScaledSpectrum().setAgcEnabled(value); } emit agcEnabledChanged(); emit presetChanged(); }
+
+	// returns / sets if the spectrum is calculated from the powers instead of the magnitudes of the FFT bins
+	bool getPowerDomain() const { return m_fft.getPowerDomain(); }
+	void setPowerDomain(bool value) { { QMutexLocker locker(&m_analysisMutex); m_fft.setPowerDomain(value); } emit powerDomainChanged(); emit presetChanged(); }
+
+	// returns the number of samples of the FFTs of the trigger analysis expressed as an exponent of 2
+	int getFftSizeExponent() const { return m_fft.getSizeExponent(); }
+	// sets the number of samples of the FFTs of the downmix and all channels
+	// (within MIN_NUM_SAMPLES_EXPONENT...MAX_NUM_SAMPLES_EXPONENT, applied from the next frame on)
+	void setFftSizeExponent(int value);
+	// returns the latency profile of the FFT size ("Low Latency", "Balanced", "High Resolution" or "Custom")
+	QString getFftProfile() const;
+	// sets the FFT size of a latency profile (see FFT_LOW_LATENCY_EXPONENT etc.)
+	void setFftProfile(const QString& value);
+	// returns / sets if the higher bands of the downmix and all channels are calculated with shorter FFTs
+	bool getMultiResolutionEnabled() const { return m_fft.getMultiResolution(); }
+	void setMultiResolutionEnabled(bool value);
+	// returns the engine that measures the levels of the bandpass triggers ("FFT", "Sliding DFT" or "Filter Bank")
+	QString getBandpassEngine() const;
+	// sets the engine that measures the levels of the bandpass triggers of the downmix and all channels
+	// (case insensitive, underscores instead of spaces are accepted, see BandpassEngine)
+	void setBandpassEngine(const QString& value);
 
 	// forward calls to OSCNetworkManager
 	// see OSCNetworkManager.h for documentation
@@ -377,14 +488,44 @@ public:  // to allow access from OSCMapping class without getters
 	TriggerGuiController* m_silenceController;  // GUI Controller for Silence TriggerGenerator
 
 protected:
+	// copies the parameters of the ScaledSpectrum of the downmix to the analyzers of the single channels
+	void syncChannelSpectrumParameters();
+
+	// selects the analyzers of the downmix and of the channels the triggers are bound to
+	// and enables the channel buffers of these channels
+	// - called in the GUI thread with m_analysisMutex locked
+	void updateActiveAnalyzers();
+
+	// calculates the next hop of all active analyzers that have one available
+	// (in parallel on the global thread pool), returns false if there was no new hop
+	// - called with m_analysisMutex locked
+	bool analyzeNextHops();
+
+	// checks the triggers of the analyzers of the last call to analyzeNextHops()
+	// and of the channels that only have level triggers
+	// - called in the GUI thread with m_analysisMutex locked
+	void checkTriggersOfHops();
+
+	// analyzes all new hops and lets the GUI thread check the triggers after each of them,
+	// returns the number of put samples of m_buffer at which the next hop is available
+	// - the analysis function of m_analysisThread
+	int64_t analyzeNewHops();
+
 	QQmlApplicationEngine*		m_qmlEngine;  // pointer to QmlEngine (created in main.cpp)
 	QVector<TriggerGeneratorInterface*> m_triggerContainer;  // list of all TriggerGenerators
 	MonoAudioBuffer				m_buffer;  // MonoAudioBuffer instance
 	AudioInputInterface*		m_audioInput;  // pointer to AudioInputInterface implementation
 	FFTAnalyzer					m_fft;  // FFTAnalyzer instance
+	QVector<FFTAnalyzer*>		m_channelFfts;  // FFTAnalyzer instances for the single channels of m_buffer
+	QVector<FFTAnalyzer*>		m_activeFfts;  // the analyzers calculated in the current update (reused to avoid allocations)
+	QVector<FFTAnalyzer*>		m_hopFfts;  // the analyzers with a hop available in the current round of an update
+	QVector<FFTAnalyzer*>		m_levelOnlyFfts;  // the analyzers of the channels that only have level triggers (no FFT is needed)
+	mutable QMutex				m_analysisMutex;  // locked while the analyzers are used or changed (recursive, the trigger checks may call back into the GUI)
+	QSemaphore					m_hopTriggersChecked;  // released by the GUI thread when the triggers of a hop have been checked
+	AnalysisThread				m_analysisThread;  // analyzes the hops as soon as the input has put them into the buffer
 	OSCNetworkManager			m_osc;  // OSCNetworkManager instance
 	QString						m_consoleType;  // console type as string
-	QTimer						m_fftUpdateTimer;  // Timer used to trigger FFT update
+	QTimer						m_bandTriggerTimer;  // Timer used to check the bandpass triggers with engines other than the FFT
 	QString						m_currentPresetFilename;  // file path and name of active preset
 	bool						m_presetChangedButNotSaved;  // true, if the preset has been changed but not saved yet
 	QMap<QString, QObject*>		m_dialogs;  // list of all open dialogs (QML-filename -> GUI element instance)
@@ -398,6 +539,10 @@ protected:
     QTimer                      m_bpmUpdatetimer; // Timer to trigger bpm update
     bool                        m_waveformVisible; // true if the waveform is visible
     bool                        m_autoBpm; // true if BPM should be set automatically
+    bool                        m_analysisDrivenByInput; // true if the input calls the analysis per hop instead of the analysis thread
+	QTimer						m_audioStatusTimer;  // Timer used to check the input for dropouts
+	int							m_reportedAudioOverruns;  // number of overruns of the input that were already reported
+	int							m_reportedAudioUnderruns;  // number of underruns of the input that were already reported
 
 	TriggerGenerator* m_bass;  // pointer to Bass TriggerGenerator instance
 	TriggerGenerator* m_loMid;  // pointer to LoMid TriggerGenerator instance
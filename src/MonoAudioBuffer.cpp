@@ -20,57 +20,459 @@
 
 #include "MonoAudioBuffer.h"
 
-#include "FFTAnalyzer.h"
+#include <QtMath>
 
-MonoAudioBuffer::MonoAudioBuffer(int capacity)
+#include <cstring>
+
+namespace {
+
+// multiplies two blocks element by element
+// (the restrict qualifiers allow the compiler to vectorize the loop)
+void multiplyBlock(const float* __restrict input, const float* __restrict window, float* __restrict output, int numSamples)
+{
+	for (int i=0; i<numSamples; ++i) {
+		output[i] = input[i] * window[i];
+	}
+}
+
+// returns the max absolute value of a block and adds the squares of its samples to sumOfSquares
+// (peak and sum are calculated in one pass over the samples)
+float measureBlock(const float* __restrict samples, int numSamples, float& sumOfSquares)
+{
+	float peak = 0.0f;
+	float sum = 0.0f;
+	for (int i=0; i<numSamples; ++i) {
+		const float value = samples[i];
+		peak = qMax(peak, qAbs(value));
+		sum += value * value;
+	}
+	sumOfSquares += sum;
+	return peak;
+}
+
+// sets target to value if value is greater
+void storeMax(std::atomic<float>& target, float value)
+{
+	float current = target.load(std::memory_order_relaxed);
+	while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+}  // namespace
+
+
+MonoAudioBuffer::MonoAudioBuffer(int capacity, int maxChannelBuffers)
 	: m_capacity(capacity)
-	, m_buffer(capacity)
-    , m_numPutSamples(0)
+	, m_data(capacity, 0.0f)
+	, m_numPutSamples(0)
+	, m_writeEnd(0)
+	, m_sampleRate(ANALYSIS_SAMPLE_RATE)
+	, m_resamplingEnabled(true)
+	, m_dcBlockerEnabled(true)
+	, m_highPassFrequency(0)
+	, m_highPassOrder(2)
+	, m_preFilterRevision(0)
+	, m_timestampSequence(0)
+	, m_timestampSampleNumber(0)
+	, m_timestampNanoseconds(HighResTime::toNanoseconds(HighResTime::monotonicNow()))
+	, m_numChannelBuffers(0)
+	, m_channelBuffers()
+	, m_heldPeak(0.0f)
+	, m_heldRms(0.0f)
+	, m_latestRms(0.0f)
+	, m_loudness(0.0f)
+	, m_hopListener(nullptr)
+	, m_hopNotificationSampleNumber(-1)
+	, m_blockListener(nullptr)
+	, m_inputSampleRate(ANALYSIS_SAMPLE_RATE)
+	, m_resamplingApplied(false)
+	, m_resampling(false)
+	, m_resampler()
+	, m_preFilterRevisionApplied(0)
+	, m_preFilter()
+	, m_decodeBuffer(RESAMPLING_DECODE_FRAMES)
+	, m_resampleBuffer(RESAMPLING_DECODE_FRAMES + 1)
+	, m_mixBuffer(RESAMPLING_DECODE_FRAMES)
+	, m_blockTime()
+	, m_blockPeak(0.0f)
+	, m_levelBlockSumOfSquares(0.0f)
+	, m_levelBlockNumSamples(0)
+	, m_loudnessMeanSquare(0.0f)
+	, m_captureClock()
+{
+	for (int i=0; i<maxChannelBuffers; ++i) {
+		m_channelBuffers.append(new MonoAudioBuffer(capacity));
+	}
+}
+
+MonoAudioBuffer::~MonoAudioBuffer()
+{
+	qDeleteAll(m_channelBuffers);
+}
+
+void MonoAudioBuffer::setInputSampleRate(int sampleRate, bool realtime)
+{
+	m_inputSampleRate = sampleRate;
+	updateResampler();
+	m_captureClock.start(sampleRate, realtime);
+
+	for (MonoAudioBuffer* channelBuffer: m_channelBuffers) {
+		channelBuffer->setInputSampleRate(sampleRate, realtime);
+	}
+}
+
+void MonoAudioBuffer::setResamplingEnabled(bool value)
+{
+	m_resamplingEnabled.store(value);
+	for (MonoAudioBuffer* channelBuffer: m_channelBuffers) {
+		channelBuffer->setResamplingEnabled(value);
+	}
+}
+
+void MonoAudioBuffer::setDcBlockerEnabled(bool value)
+{
+	m_dcBlockerEnabled.store(value);
+	m_preFilterRevision.fetch_add(1);
+	for (MonoAudioBuffer* channelBuffer: m_channelBuffers) {
+		channelBuffer->setDcBlockerEnabled(value);
+	}
+}
+
+void MonoAudioBuffer::setHighPass(int frequency, int order)
 {
-	for (int i=0; i < m_buffer.capacity(); ++i) {
-		m_buffer.push_back(0.0);
+	m_highPassFrequency.store(qMax(0, frequency));
+	m_highPassOrder.store(limit(1, order / 2, PRE_FILTER_MAX_SECTIONS) * 2);
+	m_preFilterRevision.fetch_add(1);
+	for (MonoAudioBuffer* channelBuffer: m_channelBuffers) {
+		channelBuffer->setHighPass(frequency, order);
 	}
 }
 
-void MonoAudioBuffer::putSamples(QVector<qreal>& data, const int& channelCount)
+void MonoAudioBuffer::putSamples(const char* data, int numFrames, const PcmDecoder& decoder)
 {
-	// convert incoming mulitchannel audio to mono:
-	convertToMonoInplace(data, channelCount);
+	const HighResTime::monotonic_time_point_t blockTime = HighResTime::monotonicNow();
+	beginBlock(numFrames, blockTime);
+	decodeAndWrite(data, numFrames, decoder, -1);
+	endBlock();
 
-	for (int i=0; i<data.size(); ++i) {
-		m_buffer.push_back(data[i]);
-    }
+	// extract the single channels (the last channel is repeated if the input has less channels):
+	const int numChannelBuffers = m_numChannelBuffers.load(std::memory_order_relaxed);
+	for (int i=0; i<numChannelBuffers; ++i) {
+		MonoAudioBuffer* channelBuffer = m_channelBuffers[i];
+		channelBuffer->beginBlock(numFrames, blockTime);
+		channelBuffer->decodeAndWrite(data, numFrames, decoder, qMin(i, decoder.getChannelCount() - 1));
+		channelBuffer->endBlock();
+	}
+	notifyHopListener();
+}
 
-    m_numPutSamples += data.size();
+void MonoAudioBuffer::putSamples(const float* samples, int numSamples)
+{
+	beginBlock(numSamples, HighResTime::monotonicNow());
+	writeOrResample(samples, numSamples);
+	endBlock();
+	notifyHopListener();
 }
 
-void MonoAudioBuffer::convertToMonoInplace(QVector<qreal>& data, const int& channelCount) const {
-	// - assumes that data for two channels A and B looks like ABABABABAB...
-	// - channels are average to get mono signal
-	// - result will be written inplace and data object will be decreased in size
-	switch (channelCount) {
-	case 1:
-		break;
-	case 2:
-		for (int i=0; i<data.size(); i+=2) {
-			// calculate average of both channels:
-			data[i/2] = (data[i] + data[i+1]) / 2.0;
+void MonoAudioBuffer::putSamples(const float* const* channels, int numChannels, int numSamples, float gain)
+{
+	const HighResTime::monotonic_time_point_t blockTime = HighResTime::monotonicNow();
+	beginBlock(numSamples, blockTime);
+
+	const int numChannelBuffers = m_numChannelBuffers.load(std::memory_order_relaxed);
+	for (int i=0; i<numChannelBuffers; ++i) {
+		m_channelBuffers[i]->beginBlock(numSamples, blockTime);
+	}
+
+	// mix and scale the channels block by block in the preallocated intermediate buffers:
+	float* const mix = m_mixBuffer.data();
+	const float mixGain = gain / qMax(1, numChannels);
+	for (int done = 0; done < numSamples; done += RESAMPLING_DECODE_FRAMES) {
+		const int count = qMin(numSamples - done, RESAMPLING_DECODE_FRAMES);
+
+		const float* first = channels[0] + done;
+		for (int i=0; i<count; ++i) {
+			mix[i] = first[i] * mixGain;
+		}
+		for (int ch=1; ch<numChannels; ++ch) {
+			const float* input = channels[ch] + done;
+			for (int i=0; i<count; ++i) {
+				mix[i] += input[i] * mixGain;
+			}
+		}
+		writeOrResample(mix, count);
+
+		for (int buffer=0; buffer<numChannelBuffers; ++buffer) {
+			MonoAudioBuffer* channelBuffer = m_channelBuffers[buffer];
+			const float* input = channels[qMin(buffer, numChannels - 1)] + done;
+			float* const output = channelBuffer->m_decodeBuffer.data();
+			for (int i=0; i<count; ++i) {
+				output[i] = input[i] * gain;
+			}
+			channelBuffer->writeOrResample(output, count);
 		}
-		data.resize(data.size() / 2);
-		break;
-	default:
-		for (int i=0; i<data.size(); i+=channelCount) {
-			qreal mono = 0.0;
-			for (int ch=0; ch<channelCount; ++ch) {
-				// sum up all channels:
-				mono += data[i+ch];
+	}
+
+	endBlock();
+	for (int i=0; i<numChannelBuffers; ++i) {
+		m_channelBuffers[i]->endBlock();
+	}
+	notifyHopListener();
+}
+
+HighResTime::monotonic_time_point_t MonoAudioBuffer::getCaptureTime(int64_t sampleNumber) const
+{
+	// read the timestamp of the latest block consistently:
+	unsigned sequence;
+	int64_t blockEnd;
+	int64_t blockTime;
+	do {
+		sequence = m_timestampSequence.load(std::memory_order_acquire);
+		blockEnd = m_timestampSampleNumber.load(std::memory_order_relaxed);
+		blockTime = m_timestampNanoseconds.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+	} while ((sequence & 1) || sequence != m_timestampSequence.load(std::memory_order_relaxed));
+
+	// the last sample of the block was captured (approximately) when the block arrived:
+	const int64_t samplesBefore = blockEnd - 1 - sampleNumber;
+	return HighResTime::fromNanoseconds(blockTime - samplesBefore * 1000000000 / qMax(1, getSampleRate()));
+}
+
+void MonoAudioBuffer::beginBlock(int numFrames, const HighResTime::monotonic_time_point_t& blockTime)
+{
+	if (m_resamplingEnabled.load(std::memory_order_relaxed) != m_resamplingApplied) updateResampler();
+	if (m_preFilterRevision.load(std::memory_order_acquire) != m_preFilterRevisionApplied) updatePreFilter();
+
+	m_blockTime = blockTime;
+	m_captureClock.addBlock(numFrames, m_blockTime);
+}
+
+void MonoAudioBuffer::notifyHopListener()
+{
+	int64_t requested = m_hopNotificationSampleNumber.load(std::memory_order_acquire);
+	if (requested < 0 || getNumPutSamples() < requested) return;
+
+	// the request is only cleared if the reader didn't replace it in the meantime:
+	if (!m_hopNotificationSampleNumber.compare_exchange_strong(requested, -1)) return;
+	HopListener* listener = m_hopListener.load(std::memory_order_acquire);
+	if (listener) listener->hopReady();
+}
+
+void MonoAudioBuffer::endBlock()
+{
+	// (the peak doesn't depend on the block size, so it is published with every block)
+	storeMax(m_heldPeak, m_blockPeak);
+	m_blockPeak = 0.0f;
+}
+
+void MonoAudioBuffer::measureLevels(const float* samples, int numSamples)
+{
+	// split the samples at the boundaries of the level blocks:
+	int done = 0;
+	while (done < numSamples) {
+		const int count = qMin(numSamples - done, LEVEL_BLOCK_SIZE - m_levelBlockNumSamples);
+		m_blockPeak = qMax(m_blockPeak, measureBlock(samples + done, count, m_levelBlockSumOfSquares));
+		m_levelBlockNumSamples += count;
+		done += count;
+		if (m_levelBlockNumSamples >= LEVEL_BLOCK_SIZE) finishLevelBlock();
+	}
+
+	BlockListener* listener = m_blockListener.load(std::memory_order_acquire);
+	if (listener) listener->samplesWritten(samples, numSamples, getSampleRate());
+}
+
+void MonoAudioBuffer::finishLevelBlock()
+{
+	const float meanSquare = m_levelBlockSumOfSquares / LEVEL_BLOCK_SIZE;
+	const float rms = qSqrt(meanSquare);
+	storeMax(m_heldRms, rms);
+	m_latestRms.store(rms, std::memory_order_relaxed);
+
+	// average the mean square exponentially with the duration of the block as weight:
+	const float blockDuration = float(LEVEL_BLOCK_SIZE) / qMax(1, getSampleRate());
+	const float weight = 1.0f - qExp(-blockDuration / SHORT_TERM_LOUDNESS_TIME);
+	m_loudnessMeanSquare += weight * (meanSquare - m_loudnessMeanSquare);
+	m_loudness.store(qSqrt(m_loudnessMeanSquare), std::memory_order_relaxed);
+
+	m_levelBlockSumOfSquares = 0.0f;
+	m_levelBlockNumSamples = 0;
+}
+
+void MonoAudioBuffer::decodeAndWrite(const char* data, int numFrames, const PcmDecoder& decoder, int channel)
+{
+	const int bytesPerFrame = decoder.getBytesPerFrame();
+
+	if (m_resampling) {
+		// decode into the intermediate buffer block by block and resample from there:
+		for (int framesDone = 0; framesDone < numFrames; framesDone += RESAMPLING_DECODE_FRAMES) {
+			const int count = qMin(numFrames - framesDone, RESAMPLING_DECODE_FRAMES);
+			const char* input = data + qint64(framesDone) * bytesPerFrame;
+			if (channel < 0) {
+				decoder.decode(input, m_decodeBuffer.data(), count);
+			} else {
+				decoder.decodeChannel(input, m_decodeBuffer.data(), count, channel);
 			}
-			// calculate average of all channels:
-			mono /= channelCount;
-			data[i/channelCount] = mono;
+			resampleAndWrite(m_decodeBuffer.constData(), count);
 		}
-		data.resize(data.size() / channelCount);
-		break;
+		return;
+	}
+
+	// (only this thread changes m_numPutSamples, so a relaxed load is sufficient)
+	const int64_t writePosition = m_numPutSamples.load(std::memory_order_relaxed);
+	float* const ring = m_data.data();
+	beginWrite(writePosition + numFrames);
+
+	// decode the samples directly behind the current write position,
+	// this results in at most two contiguous blocks because of the wraparound of the ring:
+	int framesDone = 0;
+	while (framesDone < numFrames) {
+		const int index = indexOfSampleNumber(writePosition + framesDone);
+		const int count = qMin(numFrames - framesDone, m_capacity - index);
+		const char* input = data + qint64(framesDone) * bytesPerFrame;
+		if (channel < 0) {
+			decoder.decode(input, ring + index, count);
+		} else {
+			decoder.decodeChannel(input, ring + index, count, channel);
+		}
+		// (the decoded samples are still in the cache)
+		m_preFilter.process(ring + index, count);
+		measureLevels(ring + index, count);
+		framesDone += count;
+	}
+
+	// publish the new samples to the readers:
+	publish(writePosition + numFrames);
+}
+
+void MonoAudioBuffer::writeOrResample(const float* samples, int numSamples)
+{
+	if (m_resampling) {
+		resampleAndWrite(samples, numSamples);
+	} else {
+		writeSamples(samples, numSamples);
+	}
+}
+
+void MonoAudioBuffer::writeSamples(const float* samples, int numSamples)
+{
+	// (only this thread changes m_numPutSamples, so a relaxed load is sufficient)
+	const int64_t writePosition = m_numPutSamples.load(std::memory_order_relaxed);
+	float* const ring = m_data.data();
+	beginWrite(writePosition + numSamples);
+
+	// copy the samples behind the current write position in at most two blocks:
+	int done = 0;
+	while (done < numSamples) {
+		const int index = indexOfSampleNumber(writePosition + done);
+		const int count = qMin(numSamples - done, m_capacity - index);
+		std::memcpy(ring + index, samples + done, sizeof(float) * count);
+		m_preFilter.process(ring + index, count);
+		measureLevels(ring + index, count);
+		done += count;
+	}
+
+	// publish the new samples to the readers:
+	publish(writePosition + numSamples);
+}
+
+void MonoAudioBuffer::resampleAndWrite(const float* samples, int numSamples)
+{
+	// resample block by block, so that the intermediate buffer has a fixed size:
+	for (int done = 0; done < numSamples; done += RESAMPLING_DECODE_FRAMES) {
+		const int count = qMin(numSamples - done, RESAMPLING_DECODE_FRAMES);
+		const int numOutputSamples = m_resampler.process(samples + done, count, m_resampleBuffer.data());
+		writeSamples(m_resampleBuffer.constData(), numOutputSamples);
 	}
+}
+
+void MonoAudioBuffer::beginWrite(int64_t writeEnd)
+{
+	// the readers have to see the new write end before any of the overwritten samples:
+	m_writeEnd.store(writeEnd, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+void MonoAudioBuffer::publish(int64_t numPutSamples)
+{
+	// update the timestamp (the sequence number is odd while it is changed):
+	const unsigned sequence = m_timestampSequence.load(std::memory_order_relaxed);
+	m_timestampSequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	m_timestampSampleNumber.store(numPutSamples, std::memory_order_relaxed);
+	m_timestampNanoseconds.store(HighResTime::toNanoseconds(m_blockTime), std::memory_order_relaxed);
+	m_timestampSequence.store(sequence + 2, std::memory_order_release);
+
+	// publish the new samples to the readers:
+	m_numPutSamples.store(numPutSamples, std::memory_order_release);
+}
+
+int64_t MonoAudioBuffer::getOldestIntactSampleNumber() const
+{
+	// the samples read before have to be loaded before the write end:
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return m_writeEnd.load(std::memory_order_relaxed) - m_capacity;
+}
+
+AudioSpans MonoAudioBuffer::getSpans(int64_t firstSampleNumber, int numSamples) const
+{
+	AudioSpans spans;
+	const int index = indexOfSampleNumber(firstSampleNumber);
+	spans.first = m_data.constData() + index;
+	spans.firstSize = qMin(numSamples, m_capacity - index);
+	spans.second = m_data.constData();
+	spans.secondSize = numSamples - spans.firstSize;
+	return spans;
+}
+
+AudioSpans MonoAudioBuffer::getLatestSpans(int numSamples, int64_t* firstSampleNumber) const
+{
+	const int64_t first = getNumPutSamples() - numSamples;
+	if (firstSampleNumber) *firstSampleNumber = first;
+	return getSpans(first, numSamples);
+}
 
+void MonoAudioBuffer::copySamples(int64_t firstSampleNumber, float* output, int numSamples) const
+{
+	const AudioSpans spans = getSpans(firstSampleNumber, numSamples);
+	std::memcpy(output, spans.first, sizeof(float) * spans.firstSize);
+	std::memcpy(output + spans.firstSize, spans.second, sizeof(float) * spans.secondSize);
+}
+
+void MonoAudioBuffer::copyWindowed(int64_t firstSampleNumber, const float* window, float* output, int numSamples) const
+{
+	const AudioSpans spans = getSpans(firstSampleNumber, numSamples);
+	multiplyBlock(spans.first, window, output, spans.firstSize);
+	multiplyBlock(spans.second, window + spans.firstSize, output + spans.firstSize, spans.secondSize);
+}
+
+AudioLevels MonoAudioBuffer::takeLevels()
+{
+	AudioLevels levels;
+	levels.peak = m_heldPeak.exchange(0.0f, std::memory_order_relaxed);
+	// (the latest RMS is returned if no level block was completed since the last call)
+	levels.rms = qMax(m_heldRms.exchange(0.0f, std::memory_order_relaxed), m_latestRms.load(std::memory_order_relaxed));
+	levels.loudness = m_loudness.load(std::memory_order_relaxed);
+	return levels;
+}
+
+void MonoAudioBuffer::updateResampler()
+{
+	m_resamplingApplied = m_resamplingEnabled.load(std::memory_order_relaxed);
+
+	// only higher rates are resampled, lower rates are analyzed at their own rate:
+	// (the resampler only reduces the rate, so the preallocated m_resampleBuffer is large enough)
+	m_resampling = m_resamplingApplied && m_inputSampleRate > ANALYSIS_SAMPLE_RATE
+			&& m_resampler.setRates(m_inputSampleRate, ANALYSIS_SAMPLE_RATE)
+			&& !m_resampler.isBypassed();
+
+	m_sampleRate.store(m_resampling ? ANALYSIS_SAMPLE_RATE : m_inputSampleRate, std::memory_order_release);
+
+	// the pre-filter runs at the rate of the buffer:
+	updatePreFilter();
+}
+
+void MonoAudioBuffer::updatePreFilter()
+{
+	m_preFilterRevisionApplied = m_preFilterRevision.load(std::memory_order_acquire);
+	m_preFilter.setup(getSampleRate(), m_dcBlockerEnabled.load(std::memory_order_relaxed),
+					  m_highPassFrequency.load(std::memory_order_relaxed), m_highPassOrder.load(std::memory_order_relaxed));
 }
@@ -21,37 +21,343 @@
 #ifndef MONOAUDIOBUFFER_H
 #define MONOAUDIOBUFFER_H
 
-#include "QCircularBuffer.h"
+#include "PcmDecoder.h"
+#include "Resampler.h"
+#include "PreFilter.h"
+#include "CaptureClock.h"
+#include "utils.h"
 
 #include <QVector>
 
+#include <atomic>
+#include <cstdint>
+
+
+// the sample rate the analysis is designed for,
+// inputs with a higher rate are resampled to this rate if resampling is enabled
+static const int ANALYSIS_SAMPLE_RATE = 44100;  // Hz
+
+// number of frames decoded at once before they are resampled
+static const int RESAMPLING_DECODE_FRAMES = 1024;
+
+// maximum number of input channels that can be analyzed separately
+static const int MAX_ANALYSIS_CHANNELS = 8;
+
+// number of samples the RMS of the level measurement is calculated of
+// (a fixed size, so that the levels don't depend on the block size of the audio backend)
+static const int LEVEL_BLOCK_SIZE = 1024;  // 23ms at 44.1kHz
+
+// time constant of the short-term loudness
+// (like the short-term window of EBU R128, but without K-weighting)
+static const float SHORT_TERM_LOUDNESS_TIME = 3.0f;  // s
+
+// number of samples a reader that skips the overwritten samples keeps away from the oldest sample of the ring
+// (at least one block of the producer, so that the next block doesn't overwrite the samples while they are read)
+static const int AUDIO_BUFFER_READ_MARGIN = 4096;
+
+// The samples of a range in the MonoAudioBuffer as at most two contiguous blocks
+// (second is empty if the range doesn't wrap around the end of the ring).
+struct AudioSpans
+{
+	const float*	first;  // pointer to the oldest samples of the range
+	int				firstSize;  // number of samples in first
+	const float*	second;  // pointer to the rest of the samples (start of the ring)
+	int				secondSize;  // number of samples in second
+};
+
+
+// Levels of the samples put into a MonoAudioBuffer (linear, 1.0 is full scale),
+// measured while the samples are written to the ring.
+struct AudioLevels
+{
+	float	peak;  // max absolute sample value of the blocks since the last takeLevels()
+	float	rms;  // max RMS of the level blocks completed since the last takeLevels() (at least of the latest one)
+	float	loudness;  // RMS exponentially averaged over SHORT_TERM_LOUDNESS_TIME
+};
+
 
 // A class that receives audio samples and buffers these with circular buffering.
+// The buffer is a lock-free single-producer / multi-reader ring:
+// - exactly one thread (usually the capture thread of an AudioInputInterface) calls putSamples()
+// - any number of analysis consumers read the samples without locks
+// The write position is published atomically after the samples are written,
+// so a reader that takes a snapshot with getNumPutSamples() and reads
+// the samples before that position always sees completely written data.
+// A reader has to stay within getCapacity() samples behind the writer.
+// The producer overwrites the oldest samples before the new ones are published,
+// so a reader close to the oldest sample checks with getOldestIntactSampleNumber()
+// after reading whether the samples were overwritten in the meantime (like a seqlock).
+// Each block is tagged with its monotonic arrival time and checked for dropouts (see CaptureClock).
+// The samples are pre-filtered (DC blocker and optional high-pass, see PreFilter)
+// while they are written, so all analyzers read the filtered signal.
+//
+// Besides the mono downmix the buffer can keep the single channels of the input
+// in separate channel buffers (see setNumChannelBuffers()), so that i.e. a kick mic
+// and a program mix on different channels can be analyzed independently.
+// The channel buffers are filled by the same producer with the same timestamps.
+//
+// The peak, the RMS of blocks of LEVEL_BLOCK_SIZE samples and the short-term loudness
+// are measured right after the samples are written (see takeLevels()), so that broadband level
+// decisions don't need to wait for a full FFT window.
+// Further measurements can be made on the written samples in the producer thread
+// by a BlockListener (i.e. the band-pass filters of the bandpass triggers, see BandFilterMeter).
 class MonoAudioBuffer
 {
 
 public:
-	explicit MonoAudioBuffer(int capacity);
+	// receives a notification from the producer when the samples requested with requestHopNotification()
+	// have been put into the buffer (i.e. to start the analysis of a hop without polling the buffer)
+	class HopListener
+	{
+	public:
+		virtual ~HopListener() {}
+
+		// called in the producer thread at the end of the putSamples() call that completed the hop
+		// (the channel buffers contain the samples of the hop, too)
+		// - must not block or allocate memory, i.e. only wake up the thread of the analysis
+		virtual void hopReady() = 0;
+	};
+
+	// receives the samples from the producer right after they have been written to the ring
+	// (i.e. to measure the levels of frequency bands without the latency of a FFT window)
+	class BlockListener
+	{
+	public:
+		virtual ~BlockListener() {}
+
+		// called in the producer thread with the pre-filtered samples that have just been written
+		// and the sample rate of the buffer (a block of the input can be passed in several calls)
+		// - must not block or allocate memory
+		virtual void samplesWritten(const float* samples, int numSamples, int sampleRate) = 0;
+	};
+
+	// maxChannelBuffers channel buffers of the same capacity are allocated in advance
+	// (so that they can be enabled and disabled without reallocating while the input is running)
+	explicit MonoAudioBuffer(int capacity, int maxChannelBuffers = 0);
+	~MonoAudioBuffer();
+
+	// sets the sample rate of the data that is put into the buffer
+	// and resamples it to ANALYSIS_SAMPLE_RATE if it is higher and resampling is enabled
+	// realtime is false if the input is not bound to the wall clock (disables the dropout detection)
+	// - has to be called by the AudioInputInterface object before putting the first samples
+	//   and whenever the format of the input changes (in the same thread as putSamples())
+	// - doesn't allocate memory, so it can be called in a realtime thread
+	void setInputSampleRate(int sampleRate, bool realtime = true);
 
-	// puts samples in the buffer
-	// - usually called by an AudioInputInterface object
-	void putSamples(QVector<qreal>& data, const int& channelCount);
+	// decodes numFrames frames of PCM data with the given decoder and puts the resulting
+	// mono samples in the buffer (without any intermediate copy or allocation if not resampling)
+	// - usually called by an AudioInputInterface object in its capture thread
+	// - must not be called from more than one thread (single producer)
+	void putSamples(const char* data, int numFrames, const PcmDecoder& decoder);
+
+	// puts numSamples mono samples in the buffer (resampled if necessary)
+	// - same threading rules as above
+	void putSamples(const float* samples, int numSamples);
+
+	// puts numSamples samples of numChannels separate (non-interleaved) channels in the buffer,
+	// the average of all channels is put in this buffer and the single channels in the channel buffers
+	// (all multiplied with gain)
+	// - same threading rules as above
+	void putSamples(const float* const* channels, int numChannels, int numSamples, float gain);
+
+	// returns the sample rate of the samples in the buffer
+	// (the rate of the input or ANALYSIS_SAMPLE_RATE when resampling)
+	// - can be called from any thread, the analyzers adapt to changes of this value
+	int getSampleRate() const { return m_sampleRate.load(std::memory_order_acquire); }
+
+	// returns if inputs with a higher rate than ANALYSIS_SAMPLE_RATE are resampled
+	bool getResamplingEnabled() const { return m_resamplingEnabled.load(); }
+	// enables or disables resampling (applied with the next samples put into the buffer)
+	// - can be called from any thread
+	void setResamplingEnabled(bool value);
+
+	// returns if the DC blocker of the pre-filter is enabled
+	bool getDcBlockerEnabled() const { return m_dcBlockerEnabled.load(); }
+	// enables or disables the DC blocker (applied with the next samples put into the buffer)
+	// - can be called from any thread
+	void setDcBlockerEnabled(bool value);
+
+	// returns the cutoff frequency of the high-pass of the pre-filter in Hz (0 if disabled)
+	int getHighPassFrequency() const { return m_highPassFrequency.load(); }
+	// returns the order of the high-pass of the pre-filter (2, 4, 6 or 8)
+	int getHighPassOrder() const { return m_highPassOrder.load(); }
+	// sets the cutoff frequency in Hz (0 to disable) and order of the high-pass
+	// (applied with the next samples put into the buffer)
+	// - can be called from any thread
+	void setHighPass(int frequency, int order);
 
 	// returns the value in the buffer at index i
-	const qreal& at(int i) const { return m_buffer[i]; }
+	// (0 is the oldest and getCapacity()-1 is the newest sample)
+	// - the position of the newest sample is read for each call,
+	//   use copySamples() or getSpans() to read a consistent block of samples
+	float at(int i) const { return atSampleNumber(getNumPutSamples() - m_capacity + i); }
+
+	// returns the sample with the absolute number sampleNumber
+	// (the first sample ever put into the buffer has the number 0)
+	// - only the last getCapacity() samples before getNumPutSamples() are valid
+	float atSampleNumber(int64_t sampleNumber) const { return m_data[indexOfSampleNumber(sampleNumber)]; }
 
-    // returns the number of samples that have ever been put in the buffer
-    int64_t getNumPutSamples() const { return m_numPutSamples; }
-    int getCapacity() const { return m_capacity; }
+	// returns numSamples samples beginning with the absolute number firstSampleNumber
+	// as pointers into the ring without copying them
+	// - numSamples must not be larger than getCapacity()
+	AudioSpans getSpans(int64_t firstSampleNumber, int numSamples) const;
+
+	// returns the latest numSamples samples as pointers into the ring
+	// - firstSampleNumber is set to the number of the first sample if not null
+	AudioSpans getLatestSpans(int numSamples, int64_t* firstSampleNumber = nullptr) const;
+
+	// copies numSamples samples beginning with the absolute number firstSampleNumber to output
+	void copySamples(int64_t firstSampleNumber, float* output, int numSamples) const;
+
+	// copies numSamples samples beginning with the absolute number firstSampleNumber to output
+	// and multiplies them with the window function (e.g. to prepare the data for a FFT)
+	void copyWindowed(int64_t firstSampleNumber, const float* window, float* output, int numSamples) const;
+
+	// returns the number of samples that have ever been put in the buffer
+	// - the samples up to this number are completely written and can be read by any thread
+	int64_t getNumPutSamples() const { return m_numPutSamples.load(std::memory_order_acquire); }
+	int getCapacity() const { return m_capacity; }
+
+	// returns the absolute number of the oldest sample that is not overwritten (or being overwritten) by the producer
+	// - call it after reading samples: they are only valid if they don't start before this number
+	// - skip to samples at least AUDIO_BUFFER_READ_MARGIN newer than this number if they start before it
+	int64_t getOldestIntactSampleNumber() const;
+
+	// returns the monotonic capture time of the sample with the absolute number sampleNumber
+	// (estimated from the arrival time of the latest block and the sample rate)
+	// - can be called from any thread
+	HighResTime::monotonic_time_point_t getCaptureTime(int64_t sampleNumber) const;
+
+	// returns the object that counts the dropouts of the input
+	const CaptureClock& getCaptureClock() const { return m_captureClock; }
+
+	// returns the max peak and RMS of the blocks put since the last call and the current short-term loudness
+	// - can be called from any thread, but only one reader should take the levels of a buffer
+	//   (the held maximum values are reset by this call)
+	AudioLevels takeLevels();
+
+	// sets the object that receives the written samples (nullptr to remove it)
+	// - the listener must not be deleted before it has been removed and the producer has stopped
+	void setBlockListener(BlockListener* listener) { m_blockListener.store(listener, std::memory_order_release); }
+
+	// sets the object that is notified by the producer (nullptr to disable the notifications)
+	// - the listener must not be deleted before it has been removed and the producer has stopped
+	void setHopListener(HopListener* listener) { m_hopListener.store(listener, std::memory_order_release); }
+
+	// lets the producer notify the HopListener once the sample with the absolute number sampleNumber - 1
+	// has been put into the buffer (only once per request, a new request replaces the previous one)
+	// - can be called from any thread
+	void requestHopNotification(int64_t sampleNumber) { m_hopNotificationSampleNumber.store(sampleNumber, std::memory_order_release); }
+
+	// returns the number of channel buffers that have been allocated
+	int getMaxChannelBuffers() const { return m_channelBuffers.size(); }
+
+	// returns the number of channel buffers that are filled with the single channels of the input
+	int getNumChannelBuffers() const { return m_numChannelBuffers.load(); }
+	// sets the number of channel buffers that are filled with the single channels of the input
+	// (0 to only keep the downmix, the channel buffer i contains the last channel of the input
+	// if i is greater than the number of input channels)
+	// - can be called from any thread, applied with the next samples put into the buffer
+	void setNumChannelBuffers(int value) { m_numChannelBuffers.store(limit(0, value, getMaxChannelBuffers())); }
+
+	// returns the channel buffer with the samples of the input channel channel
+	// - channel has to be in the range 0...getMaxChannelBuffers()-1
+	const MonoAudioBuffer& getChannelBuffer(int channel) const { return *m_channelBuffers[channel]; }
+	MonoAudioBuffer& getChannelBuffer(int channel) { return *m_channelBuffers[channel]; }
 
 protected:
-	// Converts PCM data with multiple channels to mono by averaging all channels.
-	// Result is saved inplace and data object will be resized.
-	void convertToMonoInplace(QVector<qreal>& data, const int& channelCount) const;
+	// returns the index in m_data where the sample with the absolute number sampleNumber is stored
+	int indexOfSampleNumber(int64_t sampleNumber) const {
+		int index = int(sampleNumber % m_capacity);
+		return index < 0 ? index + m_capacity : index;
+	}
+
+	// tags the next block with blockTime and checks it for dropouts
+	// - called by putSamples() with the number of input frames
+	void beginBlock(int numFrames, const HighResTime::monotonic_time_point_t& blockTime);
+
+	// notifies the HopListener if the requested samples have been put into the buffer
+	// - called at the end of each putSamples() call
+	void notifyHopListener();
+
+	// publishes the peak of the current block to the readers
+	// - called at the end of putSamples()
+	void endBlock();
+
+	// adds numSamples samples that have just been written to the level measurement
+	// and passes them to the BlockListener
+	// (in a second pass over the samples while they are still in the cache)
+	void measureLevels(const float* samples, int numSamples);
+
+	// publishes the RMS of the completed level block and updates the short-term loudness
+	void finishLevelBlock();
+
+	// decodes numFrames frames of PCM data (the downmix or the single channel channel if it is >= 0)
+	// and writes the samples to the ring (resampled if necessary)
+	void decodeAndWrite(const char* data, int numFrames, const PcmDecoder& decoder, int channel);
+
+	// writes numSamples samples to the ring, resampled if necessary
+	void writeOrResample(const float* samples, int numSamples);
+
+	// copies numSamples samples to the ring and publishes them to the readers
+	void writeSamples(const float* samples, int numSamples);
+
+	// resamples numSamples samples and writes them to the ring
+	void resampleAndWrite(const float* samples, int numSamples);
+
+	// announces that the samples up to writeEnd are written next (before their part of the ring is overwritten)
+	void beginWrite(int64_t writeEnd);
+
+	// stores the timestamp of the current block and publishes the samples up to numPutSamples
+	void publish(int64_t numPutSamples);
+
+	// configures the resampler for the input sample rate and the resampling setting
+	// - called in the producer thread (doesn't allocate, like the other update functions)
+	void updateResampler();
+
+	// configures the pre-filter for the sample rate of the buffer and the filter settings
+	// - called in the producer thread
+	void updatePreFilter();
+
+	const int				m_capacity;  // max capacity of the buffer, should be length of FFT
+	QVector<float>			m_data;  // the storage of the ring, the oldest elements are overwritten when inserting new ones
+	std::atomic<int64_t>	m_numPutSamples; // the number of samples that have ever been put into the buffer (write position)
+	std::atomic<int64_t>	m_writeEnd;  // the end of the samples that are being written (ahead of m_numPutSamples while writing)
+	std::atomic<int>		m_sampleRate;  // sample rate of the samples in the buffer
+	std::atomic<bool>		m_resamplingEnabled;  // true if inputs with a higher rate should be resampled
+	std::atomic<bool>		m_dcBlockerEnabled;  // true if the DC blocker of the pre-filter is enabled
+	std::atomic<int>		m_highPassFrequency;  // cutoff of the high-pass of the pre-filter in Hz (0 if disabled)
+	std::atomic<int>		m_highPassOrder;  // order of the high-pass of the pre-filter
+	std::atomic<unsigned>	m_preFilterRevision;  // incremented when a setting of the pre-filter changes
+	std::atomic<unsigned>	m_timestampSequence;  // odd while the timestamp of the latest block is changed (seqlock)
+	std::atomic<int64_t>	m_timestampSampleNumber;  // the number of put samples after the latest block
+	std::atomic<int64_t>	m_timestampNanoseconds;  // the monotonic arrival time of the latest block
+	std::atomic<int>		m_numChannelBuffers;  // number of channel buffers that are filled
+	QVector<MonoAudioBuffer*> m_channelBuffers;  // buffers for the single channels of the input (allocated in advance)
+	std::atomic<float>		m_heldPeak;  // max peak since the last takeLevels() (reset by the reader)
+	std::atomic<float>		m_heldRms;  // max level block RMS since the last takeLevels() (reset by the reader)
+	std::atomic<float>		m_latestRms;  // RMS of the latest completed level block
+	std::atomic<float>		m_loudness;  // the current short-term loudness
+	std::atomic<HopListener*> m_hopListener;  // notified when the requested samples have been put (or nullptr)
+	std::atomic<int64_t>	m_hopNotificationSampleNumber;  // the number of put samples the listener waits for (-1 if none)
+	std::atomic<BlockListener*> m_blockListener;  // receives the written samples (or nullptr)
 
-    const int    m_capacity;  // max capacity of the buffer, should be length of FFT
-	Qt3DCore::QCircularBuffer<qreal>	m_buffer;  // a circular buffer, removing the oldest elements when inserting new ones
-    int64_t      m_numPutSamples; // the number of samples that have ever been put into the buffer
+	// only used by the producer thread:
+	int						m_inputSampleRate;  // sample rate of the input
+	bool					m_resamplingApplied;  // the value of m_resamplingEnabled the resampler is configured for
+	bool					m_resampling;  // true if the resampler is active
+	Resampler				m_resampler;  // converts the input to ANALYSIS_SAMPLE_RATE
+	unsigned				m_preFilterRevisionApplied;  // the value of m_preFilterRevision the pre-filter is configured for
+	PreFilter				m_preFilter;  // removes DC and rumble before the samples are written to the ring
+	QVector<float>			m_decodeBuffer;  // decoded input samples before resampling
+	QVector<float>			m_resampleBuffer;  // resampled samples before they are written to the ring (allocated in advance)
+	QVector<float>			m_mixBuffer;  // downmix of separate channels before it is written to the ring
+	HighResTime::monotonic_time_point_t m_blockTime;  // the arrival time of the current block
+	float					m_blockPeak;  // max absolute value of the samples of the current block
+	float					m_levelBlockSumOfSquares;  // sum of the squared samples of the current level block
+	int						m_levelBlockNumSamples;  // number of measured samples of the current level block
+	float					m_loudnessMeanSquare;  // exponentially averaged mean square of the level blocks
+	CaptureClock			m_captureClock;  // detects dropouts of the input
 };
 
 #endif // MONOAUDIOBUFFER_H
@@ -0,0 +1,156 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "NetworkAudioInput.h"
+
+#include "utils.h"
+
+#include <QUdpSocket>
+#include <QDebug>
+
+#include <cstring>
+
+
+NetworkAudioInput::NetworkAudioInput(MonoAudioBuffer* buffer, const QString& sourceName, const QAudioFormat& format)
+	: QThread(0)
+	, AudioInputInterface(buffer)
+	, m_sourceName(sourceName)
+	, m_activeInputName("")
+	, m_decoder()
+	, m_receiveBuffer(NETWORK_MAX_PACKET_SIZE, 0)
+	, m_pendingBytes(0)
+	, m_jitterBuffer(this, NETWORK_JITTER_BUFFER_PACKETS, NETWORK_MAX_PACKET_SIZE)
+	, m_volume(1.0f)
+{
+	if (!m_decoder.setFormat(format)) {
+		qWarning() << "Unsupported sample format for network input, using s16le mono.";
+	}
+	m_jitterBuffer.setSilenceValue(m_decoder.getSilenceValue());
+	setObjectName("AudioNetwork");
+}
+
+NetworkAudioInput::~NetworkAudioInput()
+{
+	requestInterruption();
+	wait();
+}
+
+void NetworkAudioInput::setInputByName(const QString& name)
+{
+	// stop the receiving thread of the previous source:
+	requestInterruption();
+	wait();
+
+	m_activeInputName = name;
+	m_pendingBytes = 0;
+	m_jitterBuffer.reset();
+	m_buffer->setInputSampleRate(m_decoder.getFormat().sampleRate());
+
+	start(QThread::TimeCriticalPriority);
+}
+
+void NetworkAudioInput::setVolume(const qreal& value)
+{
+	m_volume.store(limit(0, value, 1));
+}
+
+bool NetworkAudioInput::parseSourceName(const QString& name, bool& isRtp, QHostAddress& address, quint16& port)
+{
+	QStringList parts = name.trimmed().toLower().split(":");
+	if (parts.size() < 2 || parts.size() > 3) return false;
+	if (parts[0] != "rtp" && parts[0] != "udp") return false;
+	isRtp = (parts[0] == "rtp");
+
+	address = QHostAddress();
+	if (parts.size() == 3 && !address.setAddress(parts[1])) return false;
+
+	bool portOk;
+	port = parts.last().toUShort(&portOk);
+	return portOk && port > 0;
+}
+
+void NetworkAudioInput::run()
+{
+	bool isRtp;
+	QHostAddress address;
+	quint16 port;
+	if (!parseSourceName(m_activeInputName, isRtp, address, port)) {
+		qWarning() << "Invalid network input" << m_activeInputName << "(expected rtp:[address:]port or udp:[address:]port)";
+		return;
+	}
+
+	// the socket is created in this thread, so its blocking functions can be used here:
+	QUdpSocket socket;
+	const bool multicast = address.isMulticast();
+	const QHostAddress bindAddress = (multicast || address.isNull()) ? QHostAddress(QHostAddress::AnyIPv4) : address;
+	if (!socket.bind(bindAddress, port, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint)) {
+		qWarning() << "Could not bind network input to port" << port << ":" << socket.errorString();
+		return;
+	}
+	if (multicast && !socket.joinMulticastGroup(address)) {
+		qWarning() << "Could not join multicast group" << address.toString() << ":" << socket.errorString();
+		return;
+	}
+
+	while (!isInterruptionRequested()) {
+		// wait for packets, but check regularly if the thread should stop:
+		if (!socket.waitForReadyRead(NETWORK_POLL_TIMEOUT)) {
+			// the stream stopped or paused, the last packets are not held back:
+			m_jitterBuffer.flush();
+			continue;
+		}
+
+		while (socket.hasPendingDatagrams()) {
+			// (a plain datagram is received behind the incomplete frame of the previous one, RTP packets at the beginning)
+			const qint64 size = socket.readDatagram(m_receiveBuffer.data() + m_pendingBytes, m_receiveBuffer.size() - m_pendingBytes);
+			if (size <= 0) continue;
+			if (isRtp) {
+				m_jitterBuffer.putPacket(m_receiveBuffer.constData(), int(size));
+			} else {
+				// plain datagrams are passed on in the order they arrive:
+				putDatagram(int(size));
+			}
+		}
+	}
+}
+
+void NetworkAudioInput::putDatagram(int size)
+{
+	// decode the complete frames, including the frame that was split by the previous datagram:
+	const int bytesPerFrame = m_decoder.getBytesPerFrame();
+	const int availableBytes = m_pendingBytes + size;
+	const int numFrames = availableBytes / bytesPerFrame;
+	putPayload(m_receiveBuffer.constData(), numFrames * bytesPerFrame);
+
+	// keep an incomplete frame for the next datagram:
+	m_pendingBytes = availableBytes - numFrames * bytesPerFrame;
+	if (m_pendingBytes > 0) {
+		std::memmove(m_receiveBuffer.data(), m_receiveBuffer.constData() + numFrames * bytesPerFrame, m_pendingBytes);
+	}
+}
+
+void NetworkAudioInput::putPayload(const char* data, int size)
+{
+	// Call MonoAudioBuffer as next element in processing chain:
+	const int numFrames = size / m_decoder.getBytesPerFrame();
+	if (numFrames <= 0) return;
+	m_decoder.setGain(m_volume.load(std::memory_order_relaxed));
+	m_buffer->putSamples(data, numFrames, m_decoder);
+}
@@ -0,0 +1,124 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef NETWORKAUDIOINPUT_H
+#define NETWORKAUDIOINPUT_H
+
+#include "AudioInputInterface.h"
+#include "MonoAudioBuffer.h"
+#include "PcmDecoder.h"
+#include "RtpJitterBuffer.h"
+
+#include <QThread>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHostAddress>
+#include <QtMultimedia/QAudioFormat>
+
+#include <atomic>
+
+
+// max size of a received datagram in bytes (larger datagrams are truncated)
+static const int NETWORK_MAX_PACKET_SIZE = 8192;
+
+// number of RTP packets in the jitter buffer, a missing packet is treated as lost
+// when the buffer is full (packets in order are passed on immediately, only reordered packets are delayed)
+static const int NETWORK_JITTER_BUFFER_PACKETS = 4;
+
+// time to wait for new packets before checking if the receiving thread should stop,
+// the packets waiting in the jitter buffer are released if none arrived within this time
+static const int NETWORK_POLL_TIMEOUT = 100;  // ms
+
+
+// An AudioInputInterface implementation that receives raw PCM data over UDP,
+// either as RTP packets (i.e. L16 / L24 of RFC 3190 or AES67) or as plain datagrams:
+//   s2l --input-network rtp:5004 --raw-format s16be:2:44100
+//   s2l --input-network rtp:239.69.1.1:5004 --raw-format s24be:2:48000
+//   ffmpeg -re -i song.wav -acodec pcm_s16be -f rtp rtp://127.0.0.1:5004
+//   ffmpeg -re -i song.wav -ac 2 -ar 48000 -f s16be udp://127.0.0.1:5005
+// see AudioInputInterface.h for documentation of overridden functions
+//
+// An input name is "rtp:[address:]port" or "udp:[address:]port", if address is a
+// multicast group, the group is joined. The format of the payload is given with the
+// same description as for raw PCM streams (see PcmDecoder::parseFormat()), L16 and L24
+// are big endian ("s16be" and "s24be").
+//
+// The packets are received in a dedicated thread (the single producer of the buffer).
+// RTP packets are reordered by their sequence number in a small jitter buffer (see RtpJitterBuffer):
+// packets in order are put into the MonoAudioBuffer immediately, a missing packet is
+// waited for until the following packets fill the jitter buffer and is then replaced
+// by silence, so that the timing of the following samples stays correct.
+// Plain datagrams don't have to contain complete frames (i.e. 1472 bytes of s24be:2 with 6 bytes per frame),
+// an incomplete frame at the end of a datagram is completed by the next one.
+// All packet buffers are allocated once per input.
+class NetworkAudioInput : public QThread, public AudioInputInterface, protected RtpJitterBuffer::Output
+{
+	Q_OBJECT
+
+public:
+	// Creates a network input for the source name (see above).
+	// format is the format of the PCM payload, see PcmDecoder::parseFormat().
+	explicit NetworkAudioInput(MonoAudioBuffer* buffer, const QString& sourceName, const QAudioFormat& format);
+	~NetworkAudioInput() override;
+
+	// returns a list with the source name as the only entry
+	QStringList getAvailableInputs() const override { return QStringList(m_sourceName); }
+
+	// returns the source name
+	QString getDefaultInputName() const override { return m_sourceName; }
+
+	QString getActiveInputName() const override { return m_activeInputName; }
+	// stops receiving from the active source and starts receiving from the given one
+	void setInputByName(const QString& name) override;
+
+	qreal getVolume() const override { return m_volume.load(); }
+	void setVolume(const qreal& value) override;
+
+	// returns the number of RTP packets that were lost or arrived too late
+	int getNumLostPackets() const { return m_jitterBuffer.getNumLostPackets(); }
+
+	// parses an input name (see above), returns false if it is invalid
+	static bool parseSourceName(const QString& name, bool& isRtp, QHostAddress& address, quint16& port);
+
+protected:
+	// receives packets until an interruption is requested
+	// - runs in the receiving thread
+	void run() override;
+
+	// decodes the complete frames of a payload and puts them into the MonoAudioBuffer
+	// (the frames of the plain datagrams and the payloads released by the jitter buffer,
+	// RTP payloads contain complete frames, an incomplete frame at the end is dropped)
+	void putPayload(const char* data, int size) override;
+
+	// decodes the complete frames of a plain datagram of size bytes that was received
+	// behind the pending bytes in m_receiveBuffer and keeps an incomplete frame for the next datagram
+	void putDatagram(int size);
+
+	const QString		m_sourceName;  // the name of the source given at construction
+	QString				m_activeInputName;  // name of the source that is received
+	PcmDecoder			m_decoder;  // converts the PCM data to mono float samples
+	QByteArray			m_receiveBuffer;  // preallocated buffer for one datagram
+	int					m_pendingBytes;  // number of bytes of an incomplete frame at the beginning of m_receiveBuffer
+	RtpJitterBuffer		m_jitterBuffer;  // reorders the RTP packets
+	std::atomic<float>	m_volume;  // gain applied to the samples [0...1]
+};
+
+#endif // NETWORKAUDIOINPUT_H
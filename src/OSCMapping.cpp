@@ -84,6 +84,43 @@ void OSCMapping::handleMessage(OSCMessage msg)
         }
     } else if (msg.pathStartsWith("/s2l/bpm/mute")) {
         m_controller->toggleBPMMute();
+    } else if (msg.pathStartsWith("/s2l/fft/profile")) {
+        // sets the FFT size by the name of a latency profile (i.e. "low_latency", "balanced" or "high_resolution")
+        if (msg.arguments().size() == 1) {
+            m_controller->setFftProfile(msg.arguments().at(0).toString());
+        }
+    } else if (msg.pathStartsWith("/s2l/fft/size")) {
+        // sets the FFT size by the number of samples (a power of 2 between 512 and 16384)
+        if (msg.arguments().size() == 1) {
+            const int numSamples = msg.arguments().at(0).toInt();
+            if (numSamples > 0) m_controller->setFftSizeExponent(qRound(qLn(numSamples) / qLn(2)));
+        }
+    } else if (msg.pathStartsWith("/s2l/fft/multi_resolution")) {
+        // enables or disables the shorter FFTs for the higher bands
+        m_controller->setMultiResolutionEnabled(msg.isTrue());
+    } else if (msg.pathStartsWith("/s2l/fft/bandpass_engine")) {
+        // sets the engine of the bandpass triggers by its name (i.e. "fft", "sliding_dft" or "filter_bank")
+        if (msg.arguments().size() == 1) {
+            m_controller->setBandpassEngine(msg.arguments().at(0).toString());
+        }
+    } else if (msg.pathStartsWith("/s2l/audio/status")) {
+        // answer with the state of the audio input
+        sendAudioStatus();
+    } else if (msg.pathStartsWith("/s2l/") && msg.path().size() == 3 && msg.path().at(2) == "channel") {
+        // binds a trigger to an input channel (1...8) or to the downmix of all channels (0),
+        // i.e. "/s2l/bass/channel 1" to analyze the kick mic on the first channel
+        TriggerGuiController* trigger = getTriggerController(msg.path().at(1));
+        if (trigger && msg.arguments().size() == 1) {
+            trigger->setChannel(msg.arguments().at(0).toInt() - 1);
+        }
+    } else if (msg.pathStartsWith("/s2l/") && msg.path().size() == 3 && msg.path().at(2) == "broadband") {
+        // selects the level of the "level" and "silence" triggers: broadband RMS of the input (1)
+        // or max level of the spectrum (0, presets saved before the RMS was available),
+        // i.e. "/s2l/level/broadband 1"
+        TriggerGuiController* trigger = getTriggerController(msg.path().at(1));
+        if (trigger && msg.arguments().size() == 1) {
+            trigger->setBroadbandLevel(msg.arguments().at(0).toInt() != 0);
+        }
     } else if (msg.pathStartsWith("/s2l/bass/mute")) {
         m_controller->m_bassController->toggleMute();
     } else if (msg.pathStartsWith("/s2l/lo_mid/mute")) {
@@ -99,6 +136,17 @@ void OSCMapping::handleMessage(OSCMessage msg)
     }
 }
 
+TriggerGuiController* OSCMapping::getTriggerController(const QString& name) const
+{
+	if (name == "bass") return m_controller->m_bassController;
+	if (name == "lo_mid") return m_controller->m_loMidController;
+	if (name == "hi_mid") return m_controller->m_hiMidController;
+	if (name == "high") return m_controller->m_highController;
+	if (name == "level") return m_controller->m_envelopeController;
+	if (name == "silence") return m_controller->m_silenceController;
+	return nullptr;
+}
+
 void OSCMapping::sendLevelFeedback()
 {
     // send the levels of the bandpasses and the bpm via OSC as feedback:
@@ -138,4 +186,15 @@ void OSCMapping::sendCurrentState()
 
     // BPM Range
     m_controller->sendOscMessage("/s2l/out/bpm/range", QString::number(m_controller->getMinBPM()), true);
+
+	// Audio Input Status:
+	sendAudioStatus();
+}
+
+void OSCMapping::sendAudioStatus()
+{
+	m_controller->sendOscMessage(QString("/s2l/out/audio/sample_rate=").append(QString::number(m_controller->getAnalysisSampleRate())), true);
+	m_controller->sendOscMessage(QString("/s2l/out/audio/overruns=").append(QString::number(m_controller->getNumAudioOverruns())), true);
+	m_controller->sendOscMessage(QString("/s2l/out/audio/underruns=").append(QString::number(m_controller->getNumAudioUnderruns())), true);
+	m_controller->sendOscMessage(QString("/s2l/out/audio/lost_samples=").append(QString::number(m_controller->getNumLostAudioSamples())), true);
 }
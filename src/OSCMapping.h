@@ -26,8 +26,9 @@
 #include <QObject>
 
 
-// Forward declaration
+// Forward declarations
 class MainController;
+class TriggerGuiController;
 
 
 // This class maps application specific OSC messages to function calls
@@ -49,6 +50,9 @@ public slots:
 	// sends the current state (Preset Name + Trigger Output) as OSC messages
 	void sendCurrentState();
 
+	// sends the sample rate and the dropout counters of the audio input as OSC messages
+	void sendAudioStatus();
+
 	// returns if OSC input is enabled and if incoming messages will be handled
 	bool getInputEnabled() const { return m_inputIsEnabled; }
 
@@ -56,6 +60,10 @@ public slots:
 	void setInputEnabled(bool value) { m_inputIsEnabled = value; }
 
 protected:
+	// returns the GUI controller of the trigger with the given name in OSC paths
+	// (i.e. "bass" or "lo_mid") or nullptr if there is no such trigger
+	TriggerGuiController* getTriggerController(const QString& name) const;
+
 	MainController* m_controller;  // pointer to MainController instance
 	bool			m_inputIsEnabled;  // true if input is enabled and incoming messages will be handled
 };
@@ -0,0 +1,304 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "PcmDecoder.h"
+
+#include <QtEndian>
+#include <QStringList>
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define S2L_PCM_SSE2
+#endif
+
+namespace {
+
+// ---------------------------- Sample Readers ------------------------------
+// Each reader converts the sample at the given position to a float in the range [-1...1].
+// The bytes are assembled explicitly, so there are no alignment requirements
+// and both byte orders work on every host (the compiler turns this into plain or swapped loads).
+
+struct UInt8Reader {
+	static const int BYTES = 1;
+	static float read(const char* p) {
+		return (int(uchar(p[0])) - 128) * (1.0f / 128);
+	}
+};
+
+template<bool IsBigEndian>
+struct Int16Reader {
+	static const int BYTES = 2;
+	static float read(const char* p) {
+		const uchar* b = reinterpret_cast<const uchar*>(p);
+		const qint16 value = IsBigEndian ? qint16((b[0] << 8) | b[1]) : qint16((b[1] << 8) | b[0]);
+		return value * (1.0f / 32768);
+	}
+};
+
+template<bool IsBigEndian>
+struct Int24Reader {
+	static const int BYTES = 3;
+	static float read(const char* p) {
+		const uchar* b = reinterpret_cast<const uchar*>(p);
+		// put the 24 bits in the upper bytes of a 32bit value to keep the sign:
+		const quint32 bits = IsBigEndian ? (quint32(b[0]) << 24) | (quint32(b[1]) << 16) | (quint32(b[2]) << 8)
+										 : (quint32(b[2]) << 24) | (quint32(b[1]) << 16) | (quint32(b[0]) << 8);
+		return qint32(bits) * (1.0f / 2147483648.0f);
+	}
+};
+
+template<bool IsBigEndian>
+struct Int32Reader {
+	static const int BYTES = 4;
+	static quint32 readBits(const char* p) {
+		const uchar* b = reinterpret_cast<const uchar*>(p);
+		return IsBigEndian ? (quint32(b[0]) << 24) | (quint32(b[1]) << 16) | (quint32(b[2]) << 8) | quint32(b[3])
+						   : (quint32(b[3]) << 24) | (quint32(b[2]) << 16) | (quint32(b[1]) << 8) | quint32(b[0]);
+	}
+	static float read(const char* p) {
+		return qint32(readBits(p)) * (1.0f / 2147483648.0f);
+	}
+};
+
+template<bool IsBigEndian>
+struct Float32Reader {
+	static const int BYTES = 4;
+	static float read(const char* p) {
+		const quint32 bits = Int32Reader<IsBigEndian>::readBits(p);
+		float value;
+		std::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+};
+
+
+// ---------------------------- Decode Kernels ------------------------------
+
+// Generic kernel for all formats.
+// CHANNELS is 1 or 2 for the specialized mono and stereo kernels
+// (the inner loop is unrolled by the compiler) and 0 for any channel count.
+template<typename Reader, int CHANNELS>
+void decodeKernel(const char* input, float* output, int numFrames, int channelCount, float gain)
+{
+	const int channels = CHANNELS > 0 ? CHANNELS : channelCount;
+	const int bytesPerFrame = channels * Reader::BYTES;
+	// the average of all channels is the sum divided by the channel count:
+	const float scale = gain / channels;
+	for (int i=0; i<numFrames; ++i) {
+		const char* frame = input + i * bytesPerFrame;
+		float sum = Reader::read(frame);
+		for (int ch=1; ch<channels; ++ch) {
+			sum += Reader::read(frame + ch * Reader::BYTES);
+		}
+		output[i] = sum * scale;
+	}
+}
+
+#if defined(S2L_PCM_SSE2) && Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+
+// SSE2 kernel for native 16bit mono data (the most common format):
+template<>
+void decodeKernel<Int16Reader<false>, 1>(const char* input, float* output, int numFrames, int, float gain)
+{
+	const float scale = gain * (1.0f / 32768);
+	const __m128 scale4 = _mm_set1_ps(scale);
+	int i = 0;
+	for (; i + 8 <= numFrames; i += 8) {
+		const __m128i pcm = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 2));
+		// sign extend the 16bit values to 32bit:
+		const __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(pcm, pcm), 16);
+		const __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(pcm, pcm), 16);
+		_mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scale4));
+		_mm_storeu_ps(output + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale4));
+	}
+	for (; i < numFrames; ++i) {
+		output[i] = Int16Reader<false>::read(input + i * 2) * gain;
+	}
+}
+
+// SSE2 kernel for native 16bit stereo data (the most common format):
+template<>
+void decodeKernel<Int16Reader<false>, 2>(const char* input, float* output, int numFrames, int, float gain)
+{
+	// the average of both channels is the sum multiplied by 0.5:
+	const float scale = gain * (1.0f / 32768) * 0.5f;
+	const __m128 scale4 = _mm_set1_ps(scale);
+	const __m128i ones = _mm_set1_epi16(1);
+	int i = 0;
+	for (; i + 8 <= numFrames; i += 8) {
+		const __m128i pcmLow = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 4));
+		const __m128i pcmHigh = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 4 + 16));
+		// multiply by 1 and add neighbours = sum of left and right channel as 32bit values:
+		const __m128i sumLow = _mm_madd_epi16(pcmLow, ones);
+		const __m128i sumHigh = _mm_madd_epi16(pcmHigh, ones);
+		_mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(sumLow), scale4));
+		_mm_storeu_ps(output + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(sumHigh), scale4));
+	}
+	for (; i < numFrames; ++i) {
+		output[i] = (Int16Reader<false>::read(input + i * 4) + Int16Reader<false>::read(input + i * 4 + 2)) * gain * 0.5f;
+	}
+}
+
+#endif
+
+// Kernel that extracts a single channel of interleaved data
+// (input points to the first sample of the channel, the frames are channelCount samples apart):
+template<typename Reader>
+void channelKernel(const char* input, float* output, int numFrames, int channelCount, float gain)
+{
+	const int bytesPerFrame = channelCount * Reader::BYTES;
+	for (int i=0; i<numFrames; ++i) {
+		output[i] = Reader::read(input + i * bytesPerFrame) * gain;
+	}
+}
+
+// returns the mono, stereo or multichannel kernel for a sample reader
+// or the kernel for a single channel if singleChannel is true:
+template<typename Reader>
+PcmDecoder::Kernel kernelForChannels(int channelCount, bool singleChannel)
+{
+	// a single channel of mono data is the same as the downmix:
+	if (singleChannel && channelCount > 1) return &channelKernel<Reader>;
+
+	switch (channelCount) {
+	case 1:
+		return &decodeKernel<Reader, 1>;
+	case 2:
+		return &decodeKernel<Reader, 2>;
+	default:
+		return &decodeKernel<Reader, 0>;
+	}
+}
+
+}  // namespace
+
+
+PcmDecoder::PcmDecoder()
+	: m_kernel(nullptr)
+	, m_channelKernel(nullptr)
+	, m_channelCount(1)
+	, m_bytesPerSample(2)
+	, m_bytesPerFrame(2)
+	, m_gain(1.0f)
+{
+	// default format is 16bit mono:
+	QAudioFormat format;
+	format.setCodec("audio/pcm");
+	format.setSampleType(QAudioFormat::SignedInt);
+	format.setSampleSize(16);
+	format.setByteOrder(QAudioFormat::LittleEndian);
+	format.setChannelCount(1);
+	format.setSampleRate(44100);
+	setFormat(format);
+}
+
+bool PcmDecoder::isSupported(const QAudioFormat& format)
+{
+	return kernelForFormat(format) != nullptr;
+}
+
+bool PcmDecoder::setFormat(const QAudioFormat& format)
+{
+	Kernel kernel = kernelForFormat(format);
+	if (!kernel) return false;
+
+	m_format = format;
+	m_kernel = kernel;
+	m_channelKernel = kernelForFormat(format, true);
+	m_channelCount = format.channelCount();
+	m_bytesPerSample = format.sampleSize() / 8;
+	m_bytesPerFrame = format.channelCount() * m_bytesPerSample;
+	return true;
+}
+
+bool PcmDecoder::parseFormat(const QString& description, QAudioFormat& format)
+{
+	QStringList parts = description.trimmed().toLower().split(":");
+	if (parts.size() != 3 || parts[0].size() < 2) return false;
+
+	QString sample = parts[0];
+	QAudioFormat::Endian byteOrder = QAudioFormat::LittleEndian;
+	if (sample.endsWith("be")) {
+		byteOrder = QAudioFormat::BigEndian;
+		sample.chop(2);
+	} else if (sample.endsWith("le")) {
+		sample.chop(2);
+	}
+
+	QAudioFormat::SampleType sampleType;
+	if (sample.startsWith("s")) {
+		sampleType = QAudioFormat::SignedInt;
+	} else if (sample.startsWith("u")) {
+		sampleType = QAudioFormat::UnSignedInt;
+	} else if (sample.startsWith("f")) {
+		sampleType = QAudioFormat::Float;
+	} else {
+		return false;
+	}
+
+	bool sizeOk, channelsOk, rateOk;
+	const int sampleSize = sample.mid(1).toInt(&sizeOk);
+	const int channelCount = parts[1].toInt(&channelsOk);
+	const int sampleRate = parts[2].toInt(&rateOk);
+	if (!sizeOk || !channelsOk || !rateOk || sampleSize % 8 != 0 || sampleSize <= 0
+			|| channelCount <= 0 || sampleRate <= 0) {
+		return false;
+	}
+
+	format.setCodec("audio/pcm");
+	format.setSampleType(sampleType);
+	format.setSampleSize(sampleSize);
+	format.setByteOrder(byteOrder);
+	format.setChannelCount(channelCount);
+	format.setSampleRate(sampleRate);
+	return true;
+}
+
+PcmDecoder::Kernel PcmDecoder::kernelForFormat(const QAudioFormat& format, bool singleChannel)
+{
+	if (format.codec() != "audio/pcm" || format.channelCount() < 1) return nullptr;
+
+	const int channels = format.channelCount();
+	const bool bigEndian = format.byteOrder() == QAudioFormat::BigEndian;
+
+	switch (format.sampleType()) {
+	case QAudioFormat::SignedInt:
+		switch (format.sampleSize()) {
+		case 16:
+			return bigEndian ? kernelForChannels<Int16Reader<true>>(channels, singleChannel) : kernelForChannels<Int16Reader<false>>(channels, singleChannel);
+		case 24:
+			return bigEndian ? kernelForChannels<Int24Reader<true>>(channels, singleChannel) : kernelForChannels<Int24Reader<false>>(channels, singleChannel);
+		case 32:
+			return bigEndian ? kernelForChannels<Int32Reader<true>>(channels, singleChannel) : kernelForChannels<Int32Reader<false>>(channels, singleChannel);
+		default:
+			return nullptr;
+		}
+	case QAudioFormat::UnSignedInt:
+		if (format.sampleSize() == 8) return kernelForChannels<UInt8Reader>(channels, singleChannel);
+		return nullptr;
+	case QAudioFormat::Float:
+		if (format.sampleSize() != 32) return nullptr;
+		return bigEndian ? kernelForChannels<Float32Reader<true>>(channels, singleChannel) : kernelForChannels<Float32Reader<false>>(channels, singleChannel);
+	default:
+		return nullptr;
+	}
+}
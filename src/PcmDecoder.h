@@ -0,0 +1,104 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef PCMDECODER_H
+#define PCMDECODER_H
+
+#include <QtGlobal>
+#include <QString>
+#include <QtMultimedia/QAudioFormat>
+
+
+// A class that converts interleaved PCM data to mono float samples.
+// Conversion, scaling to [-1...1] and the downmix of all channels
+// are done in a single (vectorized) pass, the result is written directly
+// to the given output, i.e. the storage of a MonoAudioBuffer.
+// Single channels can be extracted the same way with decodeChannel().
+//
+// There is a specialized decode kernel for every supported combination of
+// sample type, sample size, byte order and channel layout (mono, stereo, multichannel).
+// The kernel is chosen once in setFormat() and not per sample or per block.
+// Supported formats: 8bit unsigned, 16bit, 24bit (packed) and 32bit signed integer
+// and 32bit float, each in little and big endian byte order.
+class PcmDecoder
+{
+
+public:
+	// signature of a decode kernel:
+	// converts numFrames frames with channelCount channels from input to numFrames mono samples in output
+	typedef void (*Kernel)(const char* input, float* output, int numFrames, int channelCount, float gain);
+
+	explicit PcmDecoder();
+
+	// Parses a PCM format description of the form "<type><bits><endian>:<channels>:<sampleRate>",
+	// i.e. "s16le:2:44100" or "f32be:1:48000".
+	// type is s (signed int), u (unsigned int) or f (float), endian is le or be.
+	// returns false if the description is not valid
+	static bool parseFormat(const QString& description, QAudioFormat& format);
+
+	// returns if a format can be decoded
+	static bool isSupported(const QAudioFormat& format);
+
+	// sets the format of the PCM data and chooses the matching decode kernel
+	// returns false if the format is not supported (the previous format stays active then)
+	bool setFormat(const QAudioFormat& format);
+
+	// returns the format of the PCM data
+	const QAudioFormat& getFormat() const { return m_format; }
+
+	// returns the number of interleaved channels in the PCM data
+	int getChannelCount() const { return m_channelCount; }
+
+	// returns the size of one frame (one sample of every channel) in bytes
+	int getBytesPerFrame() const { return m_bytesPerFrame; }
+
+	// returns the byte value that silence consists of in the PCM data
+	// (0x80 for unsigned 8bit samples, 0 for the signed and float formats)
+	char getSilenceValue() const { return m_format.sampleType() == QAudioFormat::UnSignedInt ? char(0x80) : 0; }
+
+	// returns the factor the samples are multiplied with
+	float getGain() const { return m_gain; }
+	// sets the factor the samples are multiplied with
+	void setGain(float value) { m_gain = value; }
+
+	// converts numFrames frames of PCM data in input to numFrames mono samples in output
+	void decode(const char* input, float* output, int numFrames) const { m_kernel(input, output, numFrames, m_channelCount, m_gain); }
+
+	// converts the samples of a single channel of numFrames frames in input to numFrames samples in output
+	// - channel has to be in the range 0...getChannelCount()-1
+	void decodeChannel(const char* input, float* output, int numFrames, int channel) const {
+		m_channelKernel(input + channel * m_bytesPerSample, output, numFrames, m_channelCount, m_gain);
+	}
+
+protected:
+	// returns the downmix kernel (or the single channel kernel if singleChannel is true)
+	// for a format or nullptr if the format is not supported
+	static Kernel kernelForFormat(const QAudioFormat& format, bool singleChannel = false);
+
+	QAudioFormat	m_format;  // format of the PCM data
+	Kernel			m_kernel;  // the decode kernel for m_format
+	Kernel			m_channelKernel;  // the kernel that extracts a single channel of m_format
+	int				m_channelCount;  // number of interleaved channels in the PCM data
+	int				m_bytesPerSample;  // size of one sample of one channel in bytes
+	int				m_bytesPerFrame;  // size of one frame in bytes
+	float			m_gain;  // factor the samples are multiplied with
+};
+
+#endif // PCMDECODER_H
@@ -0,0 +1,145 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "PreFilter.h"
+
+#include "utils.h"
+
+#include <QtMath>
+
+
+namespace {
+
+// calculates the difference between each sample and its predecessor
+// (the non-recursive part of the DC blocker)
+void differentiate(const float* __restrict input, float* __restrict output, int numSamples, float previous)
+{
+	output[0] = input[0] - previous;
+	for (int i=1; i<numSamples; ++i) {
+		output[i] = input[i] - input[i-1];
+	}
+}
+
+// applies the feed-forward coefficients of a biquad section
+// (x1 and x2 are the input samples before the block)
+void feedForward(const float* __restrict input, float* __restrict output, int numSamples,
+				 float b0, float b1, float b2, float x1, float x2)
+{
+	output[0] = b0 * input[0] + b1 * x1 + b2 * x2;
+	if (numSamples > 1) output[1] = b0 * input[1] + b1 * input[0] + b2 * x1;
+	for (int i=2; i<numSamples; ++i) {
+		output[i] = b0 * input[i] + b1 * input[i-1] + b2 * input[i-2];
+	}
+}
+
+}  // namespace
+
+
+PreFilter::PreFilter()
+	: m_dcBlockerEnabled(false)
+	, m_dcBlockerPole(1.0f)
+	, m_dcBlockerX1(0.0f)
+	, m_dcBlockerY1(0.0f)
+	, m_numSections(0)
+{
+}
+
+void PreFilter::setup(int sampleRate, bool dcBlockerEnabled, int highPassFrequency, int highPassOrder)
+{
+	m_dcBlockerEnabled = dcBlockerEnabled && sampleRate > 0;
+	m_dcBlockerPole = sampleRate > 0 ? qExp(-2 * M_PI * PRE_FILTER_DC_BLOCKER_FREQ / sampleRate) : 1.0f;
+	m_numSections = 0;
+
+	// the high-pass is only possible below the nyquist frequency:
+	if (sampleRate > 0 && highPassFrequency > 0 && highPassFrequency < sampleRate / 2) {
+		const int numSections = limit(1, highPassOrder / 2, PRE_FILTER_MAX_SECTIONS);
+		const double w0 = 2 * M_PI * highPassFrequency / sampleRate;
+		const double cosW0 = qCos(w0);
+		for (int k=1; k<=numSections; ++k) {
+			// the Q of each section of a Butterworth filter of order 2 * numSections:
+			const double q = 1 / (2 * qCos((2 * k - 1) * M_PI / (4 * numSections)));
+			const double alpha = qSin(w0) / (2 * q);
+			const double a0 = 1 + alpha;
+			Section& section = m_sections[m_numSections++];
+			section.b0 = (1 + cosW0) / 2 / a0;
+			section.b1 = -(1 + cosW0) / a0;
+			section.b2 = (1 + cosW0) / 2 / a0;
+			section.a1 = -2 * cosW0 / a0;
+			section.a2 = (1 - alpha) / a0;
+		}
+	}
+	reset();
+}
+
+void PreFilter::reset()
+{
+	m_dcBlockerX1 = 0.0f;
+	m_dcBlockerY1 = 0.0f;
+	for (int i=0; i<m_numSections; ++i) {
+		Section& section = m_sections[i];
+		section.x1 = section.x2 = section.y1 = section.y2 = 0.0f;
+	}
+}
+
+void PreFilter::process(float* samples, int numSamples)
+{
+	if (isBypassed()) return;
+	for (int done = 0; done < numSamples; done += PRE_FILTER_BLOCK_SIZE) {
+		processBlock(samples + done, qMin(numSamples - done, PRE_FILTER_BLOCK_SIZE));
+	}
+}
+
+void PreFilter::processBlock(float* samples, int numSamples)
+{
+	float temp[PRE_FILTER_BLOCK_SIZE];
+
+	if (m_dcBlockerEnabled) {
+		// y[n] = x[n] - x[n-1] + R * y[n-1]
+		differentiate(samples, temp, numSamples, m_dcBlockerX1);
+		m_dcBlockerX1 = samples[numSamples - 1];
+		const float pole = m_dcBlockerPole;
+		float y1 = m_dcBlockerY1;
+		for (int i=0; i<numSamples; ++i) {
+			y1 = temp[i] + pole * y1;
+			samples[i] = y1;
+		}
+		m_dcBlockerY1 = y1;
+	}
+
+	for (int s=0; s<m_numSections; ++s) {
+		Section& section = m_sections[s];
+		// y[n] = b0 * x[n] + b1 * x[n-1] + b2 * x[n-2] - a1 * y[n-1] - a2 * y[n-2]
+		feedForward(samples, temp, numSamples, section.b0, section.b1, section.b2, section.x1, section.x2);
+		section.x2 = numSamples > 1 ? samples[numSamples - 2] : section.x1;
+		section.x1 = samples[numSamples - 1];
+		const float a1 = section.a1;
+		const float a2 = section.a2;
+		float y1 = section.y1;
+		float y2 = section.y2;
+		for (int i=0; i<numSamples; ++i) {
+			const float y = temp[i] - a1 * y1 - a2 * y2;
+			y2 = y1;
+			y1 = y;
+			samples[i] = y;
+		}
+		section.y1 = y1;
+		section.y2 = y2;
+	}
+}
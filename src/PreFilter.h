@@ -0,0 +1,85 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef PREFILTER_H
+#define PREFILTER_H
+
+
+// cutoff frequency of the DC blocker
+static const double PRE_FILTER_DC_BLOCKER_FREQ = 5.0;  // Hz
+
+// maximum number of biquad sections of the high-pass (the max order is twice this value)
+static const int PRE_FILTER_MAX_SECTIONS = 4;
+
+// number of samples processed at once (size of the intermediate buffer on the stack)
+static const int PRE_FILTER_BLOCK_SIZE = 256;
+
+
+// A time-domain filter for mono float samples that is applied before the samples
+// are analyzed: a DC blocker followed by an optional Butterworth high-pass
+// as a cascade of biquad sections (i.e. to remove DC offset and rumble of stage mics).
+//
+// The samples are filtered in place block by block. Each filter is split into
+// its non-recursive part, which is calculated for the whole block in a loop the compiler
+// can vectorize, and its recursive part, which only needs one multiply-add per feedback
+// coefficient and sample. The sections are applied one after another to the whole block,
+// so the state of a section stays in registers.
+class PreFilter
+{
+
+public:
+	explicit PreFilter();
+
+	// configures the filters for sampleRate and resets the filter history
+	// (doesn't allocate memory, so it can be called in a realtime thread)
+	// - highPassFrequency is the cutoff in Hz (0 to disable the high-pass)
+	// - highPassOrder is the order of the high-pass (2, 4, 6 or 8)
+	void setup(int sampleRate, bool dcBlockerEnabled, int highPassFrequency, int highPassOrder);
+
+	// returns true if the samples are not changed by process()
+	bool isBypassed() const { return !m_dcBlockerEnabled && m_numSections == 0; }
+
+	// clears the filter history, i.e. after a gap in the input
+	void reset();
+
+	// filters numSamples samples in place
+	void process(float* samples, int numSamples);
+
+protected:
+	// coefficients and state of a biquad section (normalized to a0 = 1)
+	struct Section
+	{
+		float b0, b1, b2, a1, a2;  // coefficients
+		float x1, x2;  // the last two input samples
+		float y1, y2;  // the last two output samples
+	};
+
+	// filters one block of at most PRE_FILTER_BLOCK_SIZE samples in place
+	void processBlock(float* samples, int numSamples);
+
+	bool				m_dcBlockerEnabled;  // true if the DC blocker is active
+	float				m_dcBlockerPole;  // pole of the DC blocker (close to 1)
+	float				m_dcBlockerX1;  // last input sample of the DC blocker
+	float				m_dcBlockerY1;  // last output sample of the DC blocker
+	Section				m_sections[PRE_FILTER_MAX_SECTIONS];  // the biquad sections of the high-pass
+	int					m_numSections;  // number of used sections (0 if the high-pass is disabled)
+};
+
+#endif // PREFILTER_H
@@ -27,33 +27,38 @@
 #include <QByteArray>
 #include <QDebug>
 
+#include <cstring>
 #include <iostream>
 
 QAudioInputWrapper::QAudioInputWrapper(MonoAudioBuffer *buffer)
     : AudioInputInterface(buffer)
     , m_audioInput(0)
 	, m_audioIODevice(0)
+	, m_volume(0.0f)
+	, m_pendingBytes(0)
 {
     // Set up the desired format:
     // If the input device doesn't support this the nearest format will be used.
-    m_desiredAudioFormat.setSampleRate(44100);
+    m_desiredAudioFormat.setSampleRate(ANALYSIS_SAMPLE_RATE);
     m_desiredAudioFormat.setChannelCount(2);
     m_desiredAudioFormat.setSampleSize(16);
     m_desiredAudioFormat.setCodec("audio/pcm");
     m_desiredAudioFormat.setByteOrder(QAudioFormat::LittleEndian);
     m_desiredAudioFormat.setSampleType(QAudioFormat::SignedInt);
+
+	// receive the audio data in a dedicated high priority thread,
+	// the QAudioInput will be created in this thread by setInputByName():
+	m_captureThread.setObjectName("AudioCapture");
+	m_captureThread.start(QThread::TimeCriticalPriority);
+	moveToThread(&m_captureThread);
 }
 
 QAudioInputWrapper::~QAudioInputWrapper()
 {
-	// Close and delete previous input device:
-	if (m_audioInput) {
-		m_audioInput->stop();
-	}
-	if (m_audioIODevice && m_audioIODevice->isOpen()) {
-		m_audioIODevice->close();
-	}
-	delete m_audioInput;
+	// Close and delete previous input device in the capture thread:
+	QMetaObject::invokeMethod(this, "closeInput", Qt::BlockingQueuedConnection);
+	m_captureThread.quit();
+	m_captureThread.wait();
 }
 
 QStringList QAudioInputWrapper::getAvailableInputs() const
@@ -78,16 +83,14 @@ QString QAudioInputWrapper::getDefaultInputName() const
 
 void QAudioInputWrapper::setInputByName(const QString &inputName)
 {
+	// the QAudioInput has to be created in the capture thread:
+	if (QThread::currentThread() != thread()) {
+		QMetaObject::invokeMethod(this, "setInputByName", Qt::BlockingQueuedConnection, Q_ARG(QString, inputName));
+		return;
+	}
+
     // Close and delete previous input device:
-    if (m_audioInput) {
-        m_audioInput->stop();
-    }
-    if (m_audioIODevice && m_audioIODevice->isOpen()) {
-        disconnect(m_audioIODevice, SIGNAL(readyRead()), this, SLOT(audioDataReady()));
-        m_audioIODevice->close();
-    }
-    delete m_audioInput;
-    m_audioInput = 0;
+    closeInput();
 
     // Get device info of new input:
     QList<QAudioDeviceInfo> devices = QAudioDeviceInfo::availableDevices(QAudio::AudioInput);
@@ -98,52 +101,84 @@ void QAudioInputWrapper::setInputByName(const QString &inputName)
         }
     }
 
-    // check if desired format is supported:
-    if (!info.isFormatSupported(m_desiredAudioFormat)) {
+    // Use the preferred format of the device if it can be decoded
+    // (i.e. float32, 24bit or 48kHz interfaces run in their native format),
+    // otherwise check if desired format is supported:
+    const QAudioFormat preferredFormat = info.preferredFormat();
+    if (preferredFormat.sampleRate() > 0 && PcmDecoder::isSupported(preferredFormat)) {
+        m_actualAudioFormat = preferredFormat;
+    } else if (!info.isFormatSupported(m_desiredAudioFormat)) {
         qWarning() << "Default audio format not supported, trying to use the nearest.";
         m_actualAudioFormat = info.nearestFormat(m_desiredAudioFormat);
     } else {
         m_actualAudioFormat = m_desiredAudioFormat;
     }
 
+    // prepare decoder and read buffer for the format:
+    if (!m_decoder.setFormat(m_actualAudioFormat)) {
+        qWarning() << "Audio format of" << inputName << "can not be decoded:" << m_actualAudioFormat;
+        return;
+    }
+    m_buffer->setInputSampleRate(m_actualAudioFormat.sampleRate());
+    m_readBuffer.resize(AUDIO_READ_BUFFER_FRAMES * m_decoder.getBytesPerFrame());
+    m_pendingBytes = 0;
+
     // create new input:
     m_activeInputName = inputName;
     m_audioInput = new QAudioInput(info, m_actualAudioFormat, this);
 	m_audioInput->setVolume(1.0);
+	m_volume.store(float(m_audioInput->volume()));
     m_audioIODevice = m_audioInput->start();
     connect(m_audioIODevice, SIGNAL(readyRead()), this, SLOT(audioDataReady()));
 }
 
-qreal QAudioInputWrapper::getVolume() const
-{
-	if (!m_audioInput) return 0.0;
-	return m_audioInput->volume();
-}
-
 void QAudioInputWrapper::setVolume(const qreal &value)
 {
+	// the QAudioInput has to be changed in the capture thread:
+	if (QThread::currentThread() != thread()) {
+		QMetaObject::invokeMethod(this, "setVolume", Qt::BlockingQueuedConnection, Q_ARG(qreal, value));
+		return;
+	}
+
 	if (!m_audioInput) return;
 	m_audioInput->setVolume(limit(0, value, 1));
+	m_volume.store(float(m_audioInput->volume()));
 }
 
-void QAudioInputWrapper::audioDataReady()
+void QAudioInputWrapper::closeInput()
 {
-	// read data from input as QByteArray:
-	QByteArray data = m_audioIODevice->readAll();
-    const int bytesPerSample = m_actualAudioFormat.sampleSize() / 8;
-    const std::size_t numSamples = data.size() / bytesPerSample;
-    QVector<qreal> realData(numSamples);
-    const char *ptr = data.constData();
-
-    for (std::size_t i=0; i<numSamples; ++i) {
-        // interpret byte in QByteArray as int16 (because 16bit is desired sample format):
-        const qint16 pcmSample = *reinterpret_cast<const qint16*>(ptr);
-        // convert to real and scale down to range [-1.0, 1.0]:
-        const qreal scaled = qreal(pcmSample) / 32768;
-        realData[i] = scaled;
-        ptr += bytesPerSample;
-    }
+	if (m_audioInput) {
+		m_audioInput->stop();
+	}
+	if (m_audioIODevice && m_audioIODevice->isOpen()) {
+		disconnect(m_audioIODevice, SIGNAL(readyRead()), this, SLOT(audioDataReady()));
+		m_audioIODevice->close();
+	}
+	delete m_audioInput;
+	m_audioInput = 0;
+	m_audioIODevice = 0;
+	m_volume.store(0.0f);
+}
 
-    // Call MonoAudioBuffer as next element in processing chain:
-	m_buffer->putSamples(realData, m_actualAudioFormat.channelCount());
+void QAudioInputWrapper::audioDataReady()
+{
+	const int bytesPerFrame = m_decoder.getBytesPerFrame();
+
+	// read all available data into the preallocated buffer:
+	for (;;) {
+		const qint64 bytesRead = m_audioIODevice->read(m_readBuffer.data() + m_pendingBytes, m_readBuffer.size() - m_pendingBytes);
+		if (bytesRead <= 0) break;
+
+		// Call MonoAudioBuffer as next element in processing chain:
+		// (the PcmDecoder converts the samples of the actual format to mono float)
+		const int availableBytes = m_pendingBytes + int(bytesRead);
+		const int numFrames = availableBytes / bytesPerFrame;
+		m_buffer->putSamples(m_readBuffer.constData(), numFrames, m_decoder);
+
+		// keep an incomplete frame for the next read:
+		m_pendingBytes = availableBytes - numFrames * bytesPerFrame;
+		if (m_pendingBytes > 0) {
+			std::memmove(m_readBuffer.data(), m_readBuffer.constData() + numFrames * bytesPerFrame, m_pendingBytes);
+		}
+	}
 }
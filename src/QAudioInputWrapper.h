@@ -23,17 +23,31 @@
 
 #include "AudioInputInterface.h"
 #include "MonoAudioBuffer.h"
+#include "PcmDecoder.h"
 
 #include <QObject>
 #include <QString>
 #include <QStringList>
+#include <QThread>
+#include <QByteArray>
 #include <QtMultimedia/QAudio>
 #include <QtMultimedia/QAudioInput>
 #include <QtMultimedia/QAudioFormat>
 
+#include <atomic>
+
+
+// number of frames that are read from the QAudioInput at once
+static const int AUDIO_READ_BUFFER_FRAMES = 4096;
+
 
 // An AudioInputInterface implementation with QAudioInput
 // see AudioInputInterface.h for documentation of overridden functions
+//
+// The object lives in its own capture thread, so that the audio data is put into
+// the MonoAudioBuffer independently of the GUI thread (QML repaints, open dialogs, ...).
+// The public functions can be called from any thread, calls that change
+// the QAudioInput are executed blocking in the capture thread.
 class QAudioInputWrapper : public QObject, public AudioInputInterface
 {
 	Q_OBJECT
@@ -47,24 +61,33 @@ public:
 	QString getDefaultInputName() const override;
 
 	QString getActiveInputName() const override { return m_activeInputName; }
-	void setInputByName(const QString& name) override;
+	Q_INVOKABLE void setInputByName(const QString& name) override;
 
-	qreal getVolume() const override;
-	void setVolume(const qreal& value) override;
+	qreal getVolume() const override { return m_volume.load(); }
+	Q_INVOKABLE void setVolume(const qreal& value) override;
 
 
 private slots:
-	// Converts the incoming QByteArray to QVector<qreal>
-	// and scales down the values to [-1...1]
-	// - called by Qt singal when audio data is ready
+	// Reads the incoming data into a preallocated buffer and
+	// puts it into the MonoAudioBuffer (which converts it to mono float samples)
+	// - called by Qt singal in the capture thread when audio data is ready
 	void audioDataReady();
 
+	// stops and deletes the active input
+	// - has to be called in the capture thread
+	void closeInput();
+
 protected:
 	QAudioFormat	m_desiredAudioFormat;  // the desired audio format, may not be available
 	QAudioFormat	m_actualAudioFormat;  // the actual audio format used for recording
 	QAudioInput*	m_audioInput;  // a pointer to the used audio input object
 	QIODevice*		m_audioIODevice;  // a pointer to the stream like "device" used while recording
 	QString			m_activeInputName;  // the name of the active audio input
+	std::atomic<float>	m_volume;  // the volume of the active input, cached to be read from other threads
+	PcmDecoder		m_decoder;  // converts the PCM data of the active input to mono float samples
+	QByteArray		m_readBuffer;  // preallocated buffer for the data read from the input
+	int				m_pendingBytes;  // number of bytes of an incomplete frame at the beginning of m_readBuffer
+	QThread			m_captureThread;  // the thread this object lives in and that receives the audio data
 };
 
 #endif // QAUDIOINPUTWRAPPER_H
@@ -0,0 +1,166 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "Resampler.h"
+
+#include <QtMath>
+#include <QDebug>
+
+#include <cstring>
+
+
+Resampler::Resampler()
+	: m_inputRate(0)
+	, m_outputRate(0)
+	, m_upFactor(1)
+	, m_downFactor(1)
+	, m_tapsPerPhase(1)
+	, m_coefficients()
+	, m_work()
+	, m_phase(0)
+	, m_inputIndex(0)
+{
+	// allocate the storage for the largest filter in advance:
+	m_coefficients.reserve(RESAMPLER_MAX_COEFFICIENTS);
+	m_work.reserve(RESAMPLER_MAX_COEFFICIENTS + RESAMPLER_BLOCK_SIZE);
+}
+
+bool Resampler::setRates(int inputRate, int outputRate)
+{
+	m_inputRate = inputRate;
+	m_outputRate = outputRate;
+	m_upFactor = 1;
+	m_downFactor = 1;
+	m_tapsPerPhase = 1;
+	m_coefficients.resize(0);
+	m_work.resize(0);
+	reset();
+
+	if (inputRate <= 0 || outputRate <= 0 || inputRate == outputRate) return true;
+
+	// reduce the ratio of the rates to L / M:
+	int a = inputRate;
+	int b = outputRate;
+	while (b != 0) {
+		const int rest = a % b;
+		a = b;
+		b = rest;
+	}
+	const int upFactor = outputRate / a;
+	const int downFactor = inputRate / a;
+
+	// the filter has to be longer (in input samples) when reducing the rate by a larger factor,
+	// the number of taps is rounded to a multiple of 4 to help the vectorizer:
+	const int taps = qCeil(RESAMPLER_FILTER_LENGTH * qMax(1.0, double(downFactor) / upFactor));
+	const int tapsPerPhase = (taps + 3) & ~3;
+	if (upFactor > RESAMPLER_MAX_PHASES || upFactor * tapsPerPhase > RESAMPLER_MAX_COEFFICIENTS) {
+		qWarning() << "Resampling from" << inputRate << "Hz to" << outputRate << "Hz is not supported.";
+		return false;
+	}
+	m_upFactor = upFactor;
+	m_downFactor = downFactor;
+	m_tapsPerPhase = tapsPerPhase;
+	calculateFilter();
+
+	// (within the reserved capacity, so this doesn't allocate)
+	m_work.resize(m_tapsPerPhase - 1 + RESAMPLER_BLOCK_SIZE);
+	reset();
+	return true;
+}
+
+int Resampler::maxOutputSamples(int numInputSamples) const
+{
+	if (isBypassed()) return numInputSamples;
+	return int((qint64(numInputSamples) * m_upFactor + m_downFactor - 1) / m_downFactor) + 1;
+}
+
+void Resampler::reset()
+{
+	m_phase = 0;
+	m_inputIndex = 0;
+	m_work.fill(0.0f);
+}
+
+int Resampler::process(const float* input, int numInputSamples, float* output)
+{
+	if (isBypassed()) {
+		std::memcpy(output, input, sizeof(float) * numInputSamples);
+		return numInputSamples;
+	}
+
+	const int history = m_tapsPerPhase - 1;
+	float* const work = m_work.data();
+	int numOutputSamples = 0;
+
+	while (numInputSamples > 0) {
+		// append the next block of input samples behind the history:
+		const int blockSize = qMin(numInputSamples, RESAMPLER_BLOCK_SIZE);
+		std::memcpy(work + history, input, sizeof(float) * blockSize);
+
+		// calculate all output samples whose newest input sample is in this block:
+		while (m_inputIndex < blockSize) {
+			const float* coefficients = m_coefficients.constData() + m_phase * m_tapsPerPhase;
+			const float* samples = work + m_inputIndex;
+			float sum = 0.0f;
+			for (int i=0; i<m_tapsPerPhase; ++i) {
+				sum += coefficients[i] * samples[i];
+			}
+			output[numOutputSamples++] = sum;
+
+			// go M steps forward in the upsampled signal:
+			m_phase += m_downFactor;
+			m_inputIndex += m_phase / m_upFactor;
+			m_phase %= m_upFactor;
+		}
+
+		// keep the last input samples as history for the next block:
+		std::memmove(work, work + blockSize, sizeof(float) * history);
+		m_inputIndex -= blockSize;
+		input += blockSize;
+		numInputSamples -= blockSize;
+	}
+	return numOutputSamples;
+}
+
+void Resampler::calculateFilter()
+{
+	// Windowed sinc lowpass at the rate of the upsampled signal
+	// with the cutoff below the lower of both nyquist frequencies:
+	const int length = m_upFactor * m_tapsPerPhase;
+	const double cutoff = RESAMPLER_CUTOFF * 0.5 / qMax(m_upFactor, m_downFactor);  // relative to upsampled rate
+	const double center = (length - 1) / 2.0;
+
+	m_coefficients.resize(length);
+	for (int n=0; n<length; ++n) {
+		const double x = n - center;
+		const double sinc = (x == 0.0) ? 2 * cutoff : qSin(2 * M_PI * cutoff * x) / (M_PI * x);
+		// Blackman window:
+		const double window = 0.42 - 0.5 * qCos(2 * M_PI * n / (length - 1)) + 0.08 * qCos(4 * M_PI * n / (length - 1));
+		// multiply by L to compensate the zeros inserted by the upsampling:
+		const float coefficient = float(sinc * window * m_upFactor);
+
+		// Coefficient n belongs to phase n % L and is multiplied with the input sample
+		// that is n / L samples older than the newest one.
+		// It is stored in the order of the input samples (oldest first):
+		const int phase = n % m_upFactor;
+		const int age = n / m_upFactor;
+		m_coefficients[phase * m_tapsPerPhase + (m_tapsPerPhase - 1 - age)] = coefficient;
+	}
+}
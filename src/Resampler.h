@@ -0,0 +1,96 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <QVector>
+
+
+// number of taps of the anti-aliasing filter in samples of the output rate
+// (the filter gets longer in input samples when the rate is reduced by a larger factor)
+static const int RESAMPLER_FILTER_LENGTH = 24;
+
+// cutoff frequency of the anti-aliasing filter relative to the lower nyquist frequency
+static const double RESAMPLER_CUTOFF = 0.9;
+
+// maximum number of polyphase filters, rate ratios that require more phases are not resampled
+static const int RESAMPLER_MAX_PHASES = 1024;
+
+// number of input samples processed at once (size of the internal work buffer)
+static const int RESAMPLER_BLOCK_SIZE = 4096;
+
+// maximum number of filter coefficients (all phases), the storage is allocated in advance,
+// so that setRates() can be called in a realtime thread
+// (enough for all rates up to 192kHz to 44.1kHz, i.e. 147 phases with 108 taps)
+static const int RESAMPLER_MAX_COEFFICIENTS = 16384;
+
+
+// A polyphase FIR resampler for mono float samples with a rational ratio of the sample rates.
+//
+// The ratio outputRate / inputRate is reduced to L / M (e.g. 147 / 160 for 48000 -> 44100 Hz).
+// Conceptually the input is upsampled by L, lowpass filtered and downsampled by M.
+// The polyphase implementation only calculates the output samples that are kept:
+// each output sample is the dot product of one of the L sub-filters with the last input samples.
+// The coefficients are precalculated per phase in the order of the input samples,
+// so the inner loop runs over two contiguous arrays.
+class Resampler
+{
+
+public:
+	explicit Resampler();
+
+	// configures the conversion from inputRate to outputRate and resets the filter history
+	// returns false if the ratio can't be resampled efficiently (the resampler is bypassed then)
+	// - doesn't allocate memory (the filter is calculated in the storage allocated by the constructor)
+	bool setRates(int inputRate, int outputRate);
+
+	int getInputRate() const { return m_inputRate; }
+	int getOutputRate() const { return m_outputRate; }
+
+	// returns true if the samples are not changed by process() (equal rates or an unsupported ratio)
+	bool isBypassed() const { return m_upFactor == m_downFactor; }
+
+	// returns the maximum number of samples that process() returns for numInputSamples input samples
+	int maxOutputSamples(int numInputSamples) const;
+
+	// clears the filter history, i.e. after a gap in the input
+	void reset();
+
+	// resamples numInputSamples samples from input and writes the result to output
+	// returns the number of samples written to output (at most maxOutputSamples(numInputSamples))
+	int process(const float* input, int numInputSamples, float* output);
+
+protected:
+	// calculates the windowed sinc lowpass and splits it into the polyphase filters
+	void calculateFilter();
+
+	int				m_inputRate;  // sample rate of the input
+	int				m_outputRate;  // sample rate of the output
+	int				m_upFactor;  // L, the output rate divided by the gcd of both rates
+	int				m_downFactor;  // M, the input rate divided by the gcd of both rates
+	int				m_tapsPerPhase;  // number of coefficients of each polyphase filter
+	QVector<float>	m_coefficients;  // m_upFactor filters with m_tapsPerPhase coefficients each
+	QVector<float>	m_work;  // the last m_tapsPerPhase-1 input samples followed by the current input block
+	int				m_phase;  // phase (0...L-1) of the next output sample
+	int				m_inputIndex;  // index of the newest input sample of the next output sample in the current block
+};
+
+#endif // RESAMPLER_H
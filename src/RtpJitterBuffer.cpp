@@ -0,0 +1,156 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "RtpJitterBuffer.h"
+
+#include <cstring>
+
+
+// a sequence number jump of more than this number of jitter buffer lengths restarts the jitter buffer
+// (i.e. when the sender was restarted) instead of inserting silence for the missing packets
+static const int RTP_RESYNC_BUFFER_LENGTHS = 4;
+
+// size of the fixed part of the RTP header in bytes
+static const int RTP_HEADER_SIZE = 12;
+
+
+RtpJitterBuffer::RtpJitterBuffer(Output* output, int numPackets, int maxPayloadSize)
+	: m_output(output)
+	, m_packets(qMax(1, numPackets))
+	, m_silence(maxPayloadSize, 0)
+	, m_sequenceValid(false)
+	, m_nextSequence(0)
+	, m_lastPayloadSize(0)
+	, m_numLostPackets(0)
+{
+	for (int i=0; i<m_packets.size(); ++i) {
+		m_packets[i].payload = QByteArray(maxPayloadSize, 0);
+	}
+	reset();
+}
+
+void RtpJitterBuffer::putPacket(const char* packetData, int size)
+{
+	const uchar* data = reinterpret_cast<const uchar*>(packetData);
+	if (size < RTP_HEADER_SIZE || (data[0] >> 6) != 2) return;
+
+	// skip the CSRC list and the header extension and remove the padding:
+	const bool hasPadding = data[0] & 0x20;
+	const bool hasExtension = data[0] & 0x10;
+	const int csrcCount = data[0] & 0x0F;
+	const quint16 sequence = (quint16(data[2]) << 8) | data[3];
+	int offset = RTP_HEADER_SIZE + 4 * csrcCount;
+	if (hasExtension) {
+		if (offset + 4 > size) return;
+		offset += 4 + 4 * ((int(data[offset + 2]) << 8) | data[offset + 3]);
+	}
+	const int end = hasPadding ? size - data[size - 1] : size;
+	if (offset >= end) return;
+	const int payloadSize = qMin(end - offset, m_silence.size());
+
+	if (!m_sequenceValid) {
+		m_nextSequence = sequence;
+		m_sequenceValid = true;
+	}
+
+	// the distance to the next expected packet (the sequence number wraps around at 2^16):
+	int distance = qint16(quint16(sequence - m_nextSequence));
+	if (distance < 0) {
+		// duplicate or too late (already replaced by silence):
+		return;
+	}
+	if (distance >= RTP_RESYNC_BUFFER_LENGTHS * m_packets.size()) {
+		// the sender was restarted or a lot of packets were lost,
+		// pass on the waiting packets and start again at this packet:
+		for (int i=0; i<m_packets.size(); ++i) {
+			Packet& packet = slot(m_nextSequence + i);
+			if (packet.valid) m_output->putPayload(packet.payload.constData(), packet.size);
+		}
+		reset();
+		m_nextSequence = sequence;
+		m_sequenceValid = true;
+		distance = 0;
+	}
+	// make room for the packet by releasing (or skipping) the oldest packets:
+	while (distance >= m_packets.size()) {
+		releaseFirstPacket();
+		--distance;
+	}
+
+	Packet& packet = slot(sequence);
+	packet.size = payloadSize;
+	std::memcpy(packet.payload.data(), data + offset, payloadSize);
+	packet.valid = true;
+
+	releasePackets();
+}
+
+void RtpJitterBuffer::flush()
+{
+	int numWaiting = getNumWaiting();
+	while (numWaiting > 0) {
+		if (slot(m_nextSequence).valid) --numWaiting;
+		releaseFirstPacket();
+	}
+}
+
+void RtpJitterBuffer::reset()
+{
+	for (int i=0; i<m_packets.size(); ++i) {
+		m_packets[i].size = 0;
+		m_packets[i].valid = false;
+	}
+	m_sequenceValid = false;
+	m_nextSequence = 0;
+}
+
+int RtpJitterBuffer::getNumWaiting() const
+{
+	int numWaiting = 0;
+	for (int i=0; i<m_packets.size(); ++i) {
+		if (m_packets[i].valid) ++numWaiting;
+	}
+	return numWaiting;
+}
+
+void RtpJitterBuffer::releasePackets()
+{
+	forever {
+		// wait for a missing packet until all other slots are filled:
+		if (!slot(m_nextSequence).valid && getNumWaiting() < m_packets.size() - 1) return;
+		if (getNumWaiting() == 0) return;
+		releaseFirstPacket();
+	}
+}
+
+void RtpJitterBuffer::releaseFirstPacket()
+{
+	Packet& first = slot(m_nextSequence);
+	if (first.valid) {
+		m_output->putPayload(first.payload.constData(), first.size);
+		m_lastPayloadSize = first.size;
+		first.valid = false;
+	} else {
+		// replace the lost packet by silence of the same duration as the last packet:
+		m_numLostPackets.fetch_add(1, std::memory_order_relaxed);
+		m_output->putPayload(m_silence.constData(), m_lastPayloadSize);
+	}
+	++m_nextSequence;
+}
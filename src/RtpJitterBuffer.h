@@ -0,0 +1,107 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef RTPJITTERBUFFER_H
+#define RTPJITTERBUFFER_H
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QVector>
+
+#include <atomic>
+
+
+// A jitter buffer that puts the payloads of RTP packets back into the order of their sequence numbers.
+//
+// Packets in order are passed on to the output immediately, only reordered packets are delayed:
+// a missing packet is waited for until the following packets fill the jitter buffer and
+// is then replaced by silence of the duration of the last payload, so that the timing of the
+// following samples stays correct. flush() releases the waiting packets when the stream stops.
+// All packet buffers are allocated at construction, so packets can be handled in a realtime thread.
+class RtpJitterBuffer
+{
+
+public:
+	// receives the payloads released by the jitter buffer in order
+	class Output
+	{
+	public:
+		virtual ~Output() {}
+
+		// handles the payload of a packet (or silence that replaces a lost packet) of size bytes
+		virtual void putPayload(const char* data, int size) = 0;
+	};
+
+	// Creates a jitter buffer with room for numPackets packets with payloads of up to maxPayloadSize bytes
+	// (numPackets has to be a power of two, so that the slots stay valid when the sequence number wraps around).
+	// The released payloads are passed on to output.
+	explicit RtpJitterBuffer(Output* output, int numPackets, int maxPayloadSize);
+
+	// sets the byte value a lost packet is replaced with
+	// (the silence of the payload format, i.e. 0x80 for unsigned 8bit samples)
+	void setSilenceValue(char value) { m_silence.fill(value); }
+
+	// handles a received RTP packet of size bytes (including the RTP header),
+	// invalid packets and packets that arrive too late are ignored
+	void putPacket(const char* data, int size);
+
+	// releases all waiting packets, missing packets between them are replaced by silence
+	// - i.e. if no packets arrived for a while, so that the last packets are not held back
+	void flush();
+
+	// clears the jitter buffer, the next packet starts a new sequence
+	void reset();
+
+	// returns the number of packets that were lost or arrived too late
+	int getNumLostPackets() const { return m_numLostPackets.load(); }
+
+protected:
+	// a received packet waiting in the jitter buffer
+	struct Packet
+	{
+		QByteArray	payload;  // preallocated storage of the payload
+		int			size;  // size of the payload in bytes
+		bool		valid;  // true if the slot contains a packet that has not been passed on yet
+	};
+
+	// returns the slot of the packet with the given sequence number
+	Packet& slot(quint16 sequence) { return m_packets[sequence % m_packets.size()]; }
+
+	// returns the number of packets waiting in the jitter buffer
+	int getNumWaiting() const;
+
+	// passes on the valid packets at the beginning of the jitter buffer
+	// and skips missing packets if the buffer is full
+	void releasePackets();
+
+	// passes on the first packet of the jitter buffer (or silence if it is missing)
+	// and moves the jitter buffer forward by one packet
+	void releaseFirstPacket();
+
+	Output* const		m_output;  // receives the released payloads
+	QVector<Packet>		m_packets;  // packets by sequence number modulo the number of packets
+	QByteArray			m_silence;  // samples used to replace a lost packet
+	bool				m_sequenceValid;  // true if m_nextSequence has been set by the first packet
+	quint16				m_nextSequence;  // the sequence number of the next packet to be passed on
+	int					m_lastPayloadSize;  // size of the last payload (used for the silence of a lost packet)
+	std::atomic<int>	m_numLostPackets;  // number of packets that were lost or arrived too late
+};
+
+#endif // RTPJITTERBUFFER_H
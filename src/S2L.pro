@@ -3,7 +3,7 @@ LANGUAGE = C++
 
 TEMPLATE = app
 
-QT += qml quick multimedia quickwidgets network widgets
+QT += qml quick multimedia quickwidgets network widgets concurrent
 
 CONFIG += c++11 thread
 
@@ -11,9 +11,28 @@ QMAKE_CXXFLAGS += -Wall
 
 SOURCES += main.cpp \
     FFTAnalyzer.cpp \
+    AnalysisThread.cpp \
+    STFT.cpp \
+    SlidingDFT.cpp \
+    SimdFFT.cpp \
+    FixedPointFFT.cpp \
+    SimdFFTSse2.cpp \
+    SimdFFTAvx2.cpp \
+    SimdFFTNeon.cpp \
+    FFTBenchmark.cpp \
     MainController.cpp \
     MonoAudioBuffer.cpp \
     QAudioInputWrapper.cpp \
+    AudioFileInput.cpp \
+    AudioStreamInput.cpp \
+    NetworkAudioInput.cpp \
+    RtpJitterBuffer.cpp \
+    PcmDecoder.cpp \
+    Resampler.cpp \
+    PreFilter.cpp \
+    BandFilterBank.cpp \
+    BandFilterMeter.cpp \
+    CaptureClock.cpp \
     ScaledSpectrum.cpp \
     TriggerFilter.cpp \
     OSCParser.cpp \
@@ -27,6 +46,15 @@ SOURCES += main.cpp \
     BPMOscControler.cpp \
     BPMTapDetector.cpp
 
+# JACK audio backend (Linux), build with: qmake CONFIG+=jack
+jack {
+    DEFINES += S2L_WITH_JACK
+    SOURCES += JackAudioInput.cpp
+    HEADERS += JackAudioInput.h
+    CONFIG += link_pkgconfig
+    PKGCONFIG += jack
+}
+
 RESOURCES += qml.qrc \
     images.qrc
 
@@ -60,10 +88,27 @@ HEADERS += \
     AudioInputInterface.h \
     BasicFFTInterface.h \
     FFTAnalyzer.h \
+    AnalysisThread.h \
     FFTRealWrapper.h \
+    FixedPointFFT.h \
+    STFT.h \
+    SlidingDFT.h \
+    SimdFFT.h \
+    SimdFFTKernel.h \
+    FFTBenchmark.h \
     MainController.h \
     MonoAudioBuffer.h \
     QAudioInputWrapper.h \
+    AudioFileInput.h \
+    AudioStreamInput.h \
+    NetworkAudioInput.h \
+    RtpJitterBuffer.h \
+    PcmDecoder.h \
+    Resampler.h \
+    PreFilter.h \
+    BandFilterBank.h \
+    BandFilterMeter.h \
+    CaptureClock.h \
     ScaledSpectrum.h \
     TriggerGeneratorInterface.h \
     TriggerFilter.h \
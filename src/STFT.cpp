@@ -0,0 +1,225 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "STFT.h"
+
+#include "FFTRealWrapper.h"
+#include "utils.h"
+
+#include <QtMath>
+
+// true if new STFTs calculate their frames with integer arithmetic (see STFT::setFixedPointEnabled())
+static bool s_fixedPointEnabled = false;
+
+// true if new STFTs use SimdFFT if the CPU supports it (see STFT::setSimdFftEnabled())
+static bool s_simdFftEnabled = true;
+
+// creates the FFT implementation for 2^sizeExponent samples
+// (the vectorized SimdFFT if it is enabled and the CPU supports one of its backends, FFTReal otherwise)
+static BasicFFTInterface* createFft(int sizeExponent)
+{
+	if (s_simdFftEnabled && SimdFFT::getBestBackend() != SimdFFT::NoBackend) {
+		return new SimdFFT(sizeExponent);
+	}
+
+	// FFTReal has a fixed length, so there is a template instance for each supported size:
+	switch (sizeExponent) {
+	case 9: return new FFTRealWrapper<9>();
+	case 10: return new FFTRealWrapper<10>();
+	case 11: return new FFTRealWrapper<11>();
+	case 12: return new FFTRealWrapper<12>();
+	case 13: return new FFTRealWrapper<13>();
+	default: return new FFTRealWrapper<STFT_MAX_SIZE_EXPONENT>();
+	}
+}
+
+STFT::STFT(int sizeExponent, double hopSize)
+	: m_size(0)
+	, m_hopSize(hopSize)
+	, m_hopRemainder(0)
+	, m_nextFrameEnd(0)
+	, m_lastFrameEnd(0)
+	, m_spectrumType(MagnitudeSpectrum)
+	, m_fft(nullptr)
+	, m_fixedPointFft(nullptr)
+	, m_window()
+	, m_buffer()
+	, m_fftOutput()
+	, m_fixedPointWindow()
+	, m_fixedPointBuffer()
+	, m_fixedPointOutput()
+	, m_spectrum()
+	, m_consumers()
+{
+	setSizeExponent(sizeExponent);
+}
+
+STFT::~STFT()
+{
+	delete m_fft;
+	delete m_fixedPointFft;
+}
+
+bool STFT::getFixedPointEnabled()
+{
+	return s_fixedPointEnabled;
+}
+
+void STFT::setFixedPointEnabled(bool value)
+{
+	s_fixedPointEnabled = value;
+}
+
+bool STFT::getSimdFftEnabled()
+{
+	return s_simdFftEnabled;
+}
+
+void STFT::setSimdFftEnabled(bool value)
+{
+	s_simdFftEnabled = value;
+}
+
+void STFT::setSizeExponent(int sizeExponent)
+{
+	sizeExponent = limit(STFT_MIN_SIZE_EXPONENT, sizeExponent, STFT_MAX_SIZE_EXPONENT);
+	const int size = 1 << sizeExponent;
+	if (size == m_size) return;
+
+	delete m_fft;
+	m_fft = nullptr;
+	delete m_fixedPointFft;
+	m_fixedPointFft = nullptr;
+	if (s_fixedPointEnabled) {
+		m_fixedPointFft = new FixedPointFFT(sizeExponent);
+		m_fixedPointWindow.resize(size);
+		m_fixedPointBuffer.resize(size);
+		m_fixedPointOutput.resize(size);
+	} else {
+		m_fft = createFft(sizeExponent);
+		m_buffer.resize(size);
+		m_fftOutput.resize(size);
+	}
+	m_size = size;
+	m_window.resize(size);
+	m_spectrum = QVector<float>(size / 2, 0.0f);
+	calculateWindow();
+}
+
+void STFT::calculateWindow()
+{
+	// Hann Window function
+	// used to prepare the PCM data for FFT
+	for (int i=0; i<m_size; ++i) {
+		m_window[i] = 0.5f * (1 - qCos((2 * M_PI * i) / (m_size - 1)));
+	}
+	for (int i=0; i<m_fixedPointWindow.size(); ++i) {
+		m_fixedPointWindow[i] = FixedPointFFT::toQ31(m_window[i]);
+	}
+}
+
+void STFT::addConsumer(STFTConsumer* consumer)
+{
+	if (!m_consumers.contains(consumer)) m_consumers.append(consumer);
+}
+
+void STFT::removeConsumer(STFTConsumer* consumer)
+{
+	m_consumers.removeAll(consumer);
+}
+
+void STFT::reset(int64_t firstSampleNumber)
+{
+	m_nextFrameEnd = firstSampleNumber + m_size;
+	m_hopRemainder = 0;
+}
+
+bool STFT::isFrameAvailable(const MonoAudioBuffer& buffer) const
+{
+	return buffer.getNumPutSamples() >= m_nextFrameEnd;
+}
+
+void STFT::processNextFrame(const MonoAudioBuffer& buffer)
+{
+	// get the position of the newest sample once, so that the frame stays consistent
+	// while the capture thread puts new samples into the buffer:
+	const int64_t numPutSamples = buffer.getNumPutSamples();
+	int64_t frameEnd = qMin(m_nextFrameEnd, numPutSamples);
+
+	// skip the frames that have already been overwritten (i.e. after the analysis was paused)
+	// or could be overwritten by the next block of the producer while they are read:
+	if (frameEnd - m_size < buffer.getOldestIntactSampleNumber() + AUDIO_BUFFER_READ_MARGIN) {
+		frameEnd = numPutSamples;
+	}
+
+	// go forward by the hop size, the fractional part is accumulated
+	// so that the frames have exactly the requested distance:
+	m_hopRemainder += m_hopSize;
+	const int hop = int(m_hopRemainder);
+	m_hopRemainder -= hop;
+	m_nextFrameEnd = frameEnd + hop;
+
+	processFrameAt(buffer, frameEnd);
+}
+
+bool STFT::processFrameAt(const MonoAudioBuffer& buffer, int64_t frameEnd)
+{
+	m_lastFrameEnd = frameEnd;
+	const int64_t frameStart = frameEnd - m_size;
+
+	if (m_fixedPointFft) {
+		if (!processFixedPointFrame(buffer, frameStart)) return false;
+	} else {
+		// copy the samples and apply window:
+		buffer.copyWindowed(frameStart, m_window.constData(), m_buffer.data(), m_size);
+
+		// drop the frame if the producer has overwritten some of its samples while they were copied:
+		if (frameStart < buffer.getOldestIntactSampleNumber()) return false;
+
+		// apply FFT:
+		m_fft->doFft(m_fftOutput.data(), m_buffer.constData());
+
+		// convert complex output of FFT to magnitudes or powers (vectorized if possible):
+		SimdFFT::calculateSpectrum(m_spectrumType, m_fftOutput.constData(), m_size, m_spectrum.data());
+	}
+
+	for (STFTConsumer* consumer: m_consumers) {
+		consumer->processFrame(m_spectrum, buffer.getSampleRate());
+	}
+	return true;
+}
+
+bool STFT::processFixedPointFrame(const MonoAudioBuffer& buffer, int64_t frameStart)
+{
+	// convert the samples to Q31 and apply window (in up to two parts if the frame wraps around the end of the ring):
+	const AudioSpans spans = buffer.getSpans(frameStart, m_size);
+	FixedPointFFT::applyWindow(spans.first, m_fixedPointWindow.constData(), m_fixedPointBuffer.data(), spans.firstSize);
+	FixedPointFFT::applyWindow(spans.second, m_fixedPointWindow.constData() + spans.firstSize,
+							   m_fixedPointBuffer.data() + spans.firstSize, spans.secondSize);
+	if (frameStart < buffer.getOldestIntactSampleNumber()) return false;
+
+	// apply FFT:
+	m_fixedPointFft->doFixedPointFft(m_fixedPointOutput.data(), m_fixedPointBuffer.constData());
+
+	// the output is the FFT of the halved samples divided by the size:
+	FixedPointFFT::calculateSpectrum(m_spectrumType, m_fixedPointOutput.constData(), m_size,
+									 2.0f * m_size / 2147483648.0f, m_spectrum.data());
+	return true;
+}
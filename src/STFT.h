@@ -0,0 +1,160 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef STFT_H
+#define STFT_H
+
+#include "BasicFFTInterface.h"
+#include "FixedPointFFT.h"
+#include "MonoAudioBuffer.h"
+#include "SimdFFT.h"
+
+#include <QVector>
+
+
+// smallest and largest supported frame size expressed as an exponent of 2
+static const int STFT_MIN_SIZE_EXPONENT = 9;
+static const int STFT_MAX_SIZE_EXPONENT = 14;
+
+
+// An interface for objects that process the spectrum frames of a STFT.
+class STFTConsumer
+{
+public:
+	virtual ~STFTConsumer() {}
+
+	// called for each new frame of a STFT the consumer has been added to
+	// - spectrum contains the values of the frequency bins 0...size/2-1
+	//   of the SpectrumType of the STFT (bin i is at i * sampleRate / size Hz)
+	virtual void processFrame(const QVector<float>& spectrum, int sampleRate) = 0;
+};
+
+
+// A short-time Fourier transform of the samples in a MonoAudioBuffer:
+// - cuts the samples into overlapping frames that are one hop apart
+// - applies a Hann window, calculates the FFT and the magnitudes (or powers) of the bins
+//   (with integer arithmetic from the window to the FFT output if enabled, see setFixedPointEnabled())
+// - publishes each spectrum frame to all consumers added with addConsumer()
+// Each frame is calculated once, no matter how many consumers use it.
+// The position of the frames is bookkept with absolute sample numbers,
+// so every hop of the buffer is processed exactly once.
+class STFT
+{
+
+public:
+	// sizeExponent is the number of samples of a frame expressed as an exponent of 2
+	// hopSize is the number of samples between the start of two frames (the fractional part is accumulated)
+	explicit STFT(int sizeExponent, double hopSize);
+	~STFT();
+
+	// returns the number of samples of a frame
+	int getSize() const { return m_size; }
+
+	// changes the number of samples of a frame (within STFT_MIN_SIZE_EXPONENT...STFT_MAX_SIZE_EXPONENT),
+	// the next frame ends at the same sample as before
+	void setSizeExponent(int sizeExponent);
+
+	// returns the number of samples between the start of two frames
+	double getHopSize() const { return m_hopSize; }
+
+	// sets the number of samples between the start of two frames (applied from the next hop on)
+	void setHopSize(double value) { m_hopSize = value; }
+
+	// returns the values calculated for the bins
+	SpectrumType getSpectrumType() const { return m_spectrumType; }
+
+	// sets the values calculated for the bins (MagnitudeSpectrum by default)
+	void setSpectrumType(SpectrumType value) { m_spectrumType = value; }
+
+	// adds a consumer that gets all following frames
+	void addConsumer(STFTConsumer* consumer);
+
+	// removes a consumer added with addConsumer()
+	void removeConsumer(STFTConsumer* consumer);
+
+	// lets the next frame start at the absolute sample number firstSampleNumber
+	void reset(int64_t firstSampleNumber);
+
+	// returns true if buffer contains all samples of the next frame
+	bool isFrameAvailable(const MonoAudioBuffer& buffer) const;
+
+	// returns the absolute sample number after the last sample of the next frame
+	int64_t getNextFrameEnd() const { return m_nextFrameEnd; }
+
+	// calculates the next frame from buffer and publishes it to the consumers
+	// (the newest samples if the next frame is not complete yet,
+	// frames that have already been overwritten in buffer or are close to it are skipped)
+	// - only uses members of this object, so different STFTs can run in parallel
+	void processNextFrame(const MonoAudioBuffer& buffer);
+
+	// calculates the frame that ends before the absolute sample number frameEnd and publishes it to the consumers
+	// (the position of the next frame is not changed, i.e. to align the frames with those of another STFT)
+	// - returns false and drops the frame if its samples were overwritten by the producer while they were read
+	bool processFrameAt(const MonoAudioBuffer& buffer, int64_t frameEnd);
+
+	// returns the absolute sample number after the last sample of the last frame
+	int64_t getLastFrameEnd() const { return m_lastFrameEnd; }
+
+	// returns the spectrum of the last frame
+	const QVector<float>& getSpectrum() const { return m_spectrum; }
+
+	// returns if the frames are calculated with integer arithmetic
+	static bool getFixedPointEnabled();
+
+	// sets if the frames of the STFTs created afterwards (or resized) are calculated with integer arithmetic
+	// instead of floats (see FixedPointFFT for the parts that still use floats)
+	// - has to be called before the analysis is created (i.e. from a command line option)
+	static void setFixedPointEnabled(bool value);
+
+	// returns if the float frames are calculated with SimdFFT if the CPU supports it
+	static bool getSimdFftEnabled();
+
+	// sets if the float frames of the STFTs created afterwards (or resized) are calculated with SimdFFT
+	// if the CPU supports it (the default), or with FFTReal (i.e. to compare them in the benchmark)
+	static void setSimdFftEnabled(bool value);
+
+protected:
+	// calculates a Hann Window for FFT and saves it to m_window (and m_fixedPointWindow if used)
+	void calculateWindow();
+
+	// windows the samples of buffer that start at the absolute sample number frameStart
+	// and calculates their FFT and spectrum with m_fixedPointFft
+	// - returns false if the samples were overwritten while they were read
+	bool processFixedPointFrame(const MonoAudioBuffer& buffer, int64_t frameStart);
+
+	int						m_size;  // number of samples of a frame
+	double					m_hopSize;  // number of samples between the start of two frames
+	double					m_hopRemainder;  // the fractional part of the hops that has not been used yet
+	int64_t					m_nextFrameEnd;  // the absolute sample number after the last sample of the next frame
+	int64_t					m_lastFrameEnd;  // the absolute sample number after the last sample of the last frame
+	SpectrumType			m_spectrumType;  // the values calculated for the bins
+	BasicFFTInterface*		m_fft;  // FFT implementation (for m_size samples, nullptr if m_fixedPointFft is used)
+	FixedPointFFT*			m_fixedPointFft;  // FFT with integer arithmetic (for m_size samples, nullptr if not enabled)
+	QVector<float>			m_window;  // array with window data
+	QVector<float>			m_buffer;  // buffer for the windowed samples (intermediate result)
+	QVector<float>			m_fftOutput;  // buffer containing the FFT output (intermediate result)
+	QVector<int32_t>		m_fixedPointWindow;  // the window data as Q31 values (only with m_fixedPointFft)
+	QVector<int32_t>		m_fixedPointBuffer;  // the windowed Q31 samples (intermediate result, only with m_fixedPointFft)
+	QVector<int32_t>		m_fixedPointOutput;  // the Q31 FFT output (intermediate result, only with m_fixedPointFft)
+	QVector<float>			m_spectrum;  // spectrum of the last frame
+	QVector<STFTConsumer*>	m_consumers;  // objects that process the frames
+};
+
+#endif // STFT_H
@@ -29,20 +29,30 @@ ScaledSpectrum::ScaledSpectrum(const int &baseFreq, const int &scaledLength)
     : m_baseFreq(baseFreq)
     , m_scaledLength(scaledLength)
     , m_freqScaleFactor(0)
+    , m_logOfFreqScaleFactor(0)
+    , m_nyquistFreq(SCALED_SPECTRUM_MAX_FREQ)
+	, m_maxFftValue(MAX_FFT_VALUE)
 	, m_gain(1)
 	, m_compression(1)
 	, m_convertToDecibel(false)
+	, m_powerDomain(false)
     , m_normSpectrum(scaledLength)
 	, m_agcEnabled(true)
+	, m_resolutions()
+	, m_filterLinearLength(0)
+	, m_filterFirstIndex(scaledLength)
+	, m_filterOffset(scaledLength + 1)
+	, m_filterWeights()
+	, m_filterPowerWeights()
 	, m_lastMaxValues(AGC_AVERAGING_LENGTH)
 {
     // freqScaleFactor is a constant that is used in for-loop in updateWithLinearSpectrum
     // to calculate the next frequency in logarithmic scale:
-    m_freqScaleFactor = qPow(22050.0 / baseFreq, 1./scaledLength);
+    m_freqScaleFactor = qPow(qreal(SCALED_SPECTRUM_MAX_FREQ) / baseFreq, 1./scaledLength);
 
     // logOfFreqScaleFactor is a constant used in getIndexForFreq
     // to convert a frequency back to the index in the logarithmic array:
-	m_logOfFreqScaleFactor = qLn(22050. / baseFreq) / scaledLength;
+	m_logOfFreqScaleFactor = qLn(qreal(SCALED_SPECTRUM_MAX_FREQ) / baseFreq) / scaledLength;
 
 	// initialize lastMaxValues with 0:
 	for (int i=0; i<m_lastMaxValues.size(); ++i) {
@@ -50,58 +60,169 @@ ScaledSpectrum::ScaledSpectrum(const int &baseFreq, const int &scaledLength)
 	}
 }
 
-void ScaledSpectrum::updateWithLinearSpectrum(const QVector<float> linearSpectrum)
+void ScaledSpectrum::setSampleRate(int value)
 {
-    const int linearLength = linearSpectrum.size();
-	double freq = m_baseFreq;
-	float maxValue = 0;
+	m_nyquistFreq = value / 2.0;
+	// the frequencies of the linear bins have changed:
+	m_filterLinearLength = 0;
+}
 
+void ScaledSpectrum::setResolutions(const QVector<int>& lengths)
+{
+	m_resolutions = lengths;
+	m_filterLinearLength = 0;
+}
+
+void ScaledSpectrum::copyParameters(const ScaledSpectrum& other)
+{
+	m_gain = other.m_gain;
+	m_compression = other.m_compression;
+	m_convertToDecibel = other.m_convertToDecibel;
+	m_powerDomain = other.m_powerDomain;
+	m_maxFftValue = other.m_maxFftValue;
+	// (the filterbank is only recalculated if the frequencies of the linear bins have changed)
+	if (other.m_nyquistFreq != m_nyquistFreq || other.m_resolutions != m_resolutions) {
+		m_nyquistFreq = other.m_nyquistFreq;
+		m_resolutions = other.m_resolutions;
+		m_filterLinearLength = 0;
+	}
+}
+
+void ScaledSpectrum::prepareFilterbank(int linearLength)
+{
+	if (linearLength != m_filterLinearLength) {
+		updateFilterbank(linearLength);
+	}
+}
+
+void ScaledSpectrum::getLinearBins(int index, int& firstIndex, int& numBins) const
+{
+	firstIndex = m_filterFirstIndex[index];
+	numBins = m_filterOffset[index+1] - m_filterOffset[index];
+}
+
+void ScaledSpectrum::updateWithLinearSpectrum(const QVector<float>& linearSpectrum)
+{
+	prepareFilterbank(linearSpectrum.size());
+	float maxValue = 0;
 
-    // This for-loop generates frequencies so that there are equally many steps between every octave of frequencies:
-    // (There are as many steps between 100Hz and 200Hz as between 400Hz and 800Hz.)
     for (int i = 0; i<m_scaledLength; ++i) {
-        // calculate begin and end frequency of this step:
-        double nextFreq = m_baseFreq * qPow(m_freqScaleFactor, i+1);
-        const std::size_t startIndex = freq / 22050 * (linearLength);
-        const std::size_t endIndex = nextFreq / 22050 * (linearLength);
-        const std::size_t valuesTillNext = endIndex - startIndex;
-        freq = nextFreq;
-
-        // Sum up the energies of all FFT elements betwen the two frequencies:
-        float energy = linearSpectrum[startIndex];
-        for (std::size_t j=1; j < valuesTillNext; ++j) {
-            energy += linearSpectrum[startIndex+j];
-        }
-
-        // Maximum of FFT is sqrt(NUM_SAMPLES)
-        // in this case: sqrt(2048) = 45.2548339959
-
-		//const float maxPossibleEnergy = (MAX_FFT_VALUE*qMax(std::size_t(1), valuesTillNext));
-		const float maxPossibleEnergy = MAX_FFT_VALUE;
-
-        if (m_convertToDecibel) {
-            // Convert energy to dB:
-			float dB = 20 * qLn(energy / maxPossibleEnergy) / qLn(10);
-			float valueBeforeGain = (dB + 60) / 60;
-			maxValue = qMax(maxValue, valueBeforeGain);
-
-            // Scale the value with factor and exponent:
-			m_normSpectrum[i] = qPow(qMax(0.0f, qMin(valueBeforeGain * m_gain, 1.0f)), (1 / m_compression));
-        } else {
-            // Apply reasonable scale:
-			energy /= maxPossibleEnergy;
-			maxValue = qMax(maxValue, energy);
-			energy *= m_gain;
-
-            // Scale the value with factor and exponent:
-			m_normSpectrum[i] = qPow(qMax(0.0f, qMin(energy, 1.0f)), (1 / m_compression));
-		}
+		maxValue = qMax(maxValue, updateBin(linearSpectrum.constData(), i));
     }
 	// add maximum value to circular buffer:
 	m_lastMaxValues.push_back(maxValue);
 	updateAGC();
 }
 
+void ScaledSpectrum::updateBins(const QVector<float>& linearSpectrum, int startIndex, int endIndex)
+{
+	prepareFilterbank(linearSpectrum.size());
+	for (int i=startIndex; i<=endIndex; ++i) {
+		updateBin(linearSpectrum.constData(), i);
+	}
+}
+
+float ScaledSpectrum::updateBin(const float* linear, int index)
+{
+	// Sum up the weighted energies of all FFT elements between the two frequencies of this step:
+	const float* values = linear + m_filterFirstIndex[index];
+	const int count = m_filterOffset[index+1] - m_filterOffset[index];
+	// (powers are weighted with the squared weights, so that a sine results in the same level as its magnitude)
+	const float* w = (m_powerDomain ? m_filterPowerWeights : m_filterWeights).constData() + m_filterOffset[index];
+	float energy = 0.0f;
+	for (int j=0; j < count; ++j) {
+		energy += w[j] * values[j];
+	}
+
+	// Maximum of FFT is sqrt(NUM_SAMPLES)
+	// in this case: sqrt(2048) = 45.2548339959
+
+	//const float maxPossibleEnergy = (MAX_FFT_VALUE*qMax(std::size_t(1), valuesTillNext));
+	const float maxPossibleEnergy = m_powerDomain ? m_maxFftValue * m_maxFftValue : m_maxFftValue;
+
+	if (m_convertToDecibel) {
+		// Convert energy to dB (powers don't have to be squared):
+		float dB = (m_powerDomain ? 10 : 20) * qLn(energy / maxPossibleEnergy) / qLn(10);
+		float valueBeforeGain = (dB + 60) / 60;
+
+		// Scale the value with factor and exponent:
+		m_normSpectrum[index] = qPow(qMax(0.0f, qMin(valueBeforeGain * m_gain, 1.0f)), (1 / m_compression));
+		return valueBeforeGain;
+	}
+	// Apply reasonable scale:
+	energy /= maxPossibleEnergy;
+	// (a power is converted back to a magnitude, so that the gain, the AGC and the thresholds
+	// work on the same values in both domains)
+	if (m_powerDomain) energy = qSqrt(energy);
+	const float valueBeforeGain = energy;
+	energy *= m_gain;
+
+	// Scale the value with factor and exponent:
+	m_normSpectrum[index] = qPow(qMax(0.0f, qMin(energy, 1.0f)), (1 / m_compression));
+	return valueBeforeGain;
+}
+
+void ScaledSpectrum::updateFilterbank(int linearLength)
+{
+	m_filterLinearLength = linearLength;
+	m_filterWeights.clear();
+	m_filterPowerWeights.clear();
+
+	// the linear spectrum is a single spectrum if it doesn't consist of the spectra set with setResolutions():
+	QVector<int> lengths = m_resolutions;
+	int totalLength = 0;
+	for (int length: lengths) totalLength += length;
+	if (totalLength != linearLength) lengths = QVector<int>(1, linearLength);
+
+	double freq = m_baseFreq;
+
+    // This for-loop generates frequencies so that there are equally many steps between every octave of frequencies:
+    // (There are as many steps between 100Hz and 200Hz as between 400Hz and 800Hz.)
+	for (int i = 0; i<m_scaledLength; ++i) {
+		const double nextFreq = m_baseFreq * qPow(m_freqScaleFactor, i+1);
+		m_filterOffset[i] = m_filterWeights.size();
+
+		// use the shortest FFT (the one with the lowest latency) in which this step spans at least one bin,
+		// the lowest steps use the longest FFT:
+		int part = lengths.size() - 1;
+		while (part > 0 && (nextFreq - freq) * lengths[part] / m_nyquistFreq < 1.0) --part;
+		int partOffset = 0;
+		for (int p=0; p < part; ++p) partOffset += lengths[p];
+		const int partLength = lengths[part];
+
+		// calculate begin and end of this step in units of linear bins
+		// (bin j of the linear spectrum covers the range [j, j+1)):
+		const double binsPerHz = partLength / m_nyquistFreq;
+		const double start = freq * binsPerHz;
+		const double end = nextFreq * binsPerHz;
+		freq = nextFreq;
+
+		// (the linear spectrum ends at the nyquist frequency of the actual sample rate,
+		// frequencies above the nyquist frequency of a low sample rate have no energy)
+		const int firstIndex = qMin(int(start), partLength);
+		const int endIndex = qMin(int(qCeil(end)), partLength);
+		m_filterFirstIndex[i] = partOffset + firstIndex;
+
+		// each linear bin is weighted with the fraction that overlaps with this step,
+		// steps narrower than one bin are interpolated instead of summed up
+		// (they would be empty or contain the same bin as their neighbours otherwise):
+		const double normalization = 1.0 / qMin(1.0, end - start);
+		for (int j=firstIndex; j < endIndex; ++j) {
+			const double overlap = qMin(end, j + 1.0) - qMax(start, double(j));
+			const double weight = qMax(0.0, overlap) * normalization;
+			m_filterWeights.append(weight);
+			m_filterPowerWeights.append(weight * weight);
+		}
+	}
+	m_filterOffset[m_scaledLength] = m_filterWeights.size();
+}
+
+void ScaledSpectrum::setFftSize(int numSamples)
+{
+	// the magnitude of a sine in the spectrum grows linearly with the number of samples:
+	m_maxFftValue = float(MAX_FFT_VALUE) * numSamples / NUM_SAMPLES;
+}
+
 int ScaledSpectrum::getIndexForFreq(const int &freq) const
 {
     // convert a frequency back to the index in the logarithmic array:
@@ -114,12 +235,19 @@ double ScaledSpectrum::getFreqAtPosition(const double &value) const
 	return freq;
 }
 
-float ScaledSpectrum::getMaxLevel(const int &midFreq, const qreal &width) const
+void ScaledSpectrum::getIndexRange(const int& midFreq, const qreal& width, int& startIndex, int& endIndex) const
 {
 	int midIndex = getIndexForFreq(midFreq);
-	int startIndex = qMax(0, qMin(int(midIndex - m_scaledLength*width/2), m_scaledLength - 1));
-	int endIndex = qMax(0, qMin(int(midIndex + m_scaledLength*width/2), m_scaledLength - 1));
-	if (endIndex == startIndex) ++endIndex;
+	startIndex = qMax(0, qMin(int(midIndex - m_scaledLength*width/2), m_scaledLength - 1));
+	endIndex = qMax(0, qMin(int(midIndex + m_scaledLength*width/2), m_scaledLength - 1));
+	if (endIndex == startIndex && endIndex < m_scaledLength - 1) ++endIndex;
+}
+
+float ScaledSpectrum::getMaxLevel(const int &midFreq, const qreal &width) const
+{
+	int startIndex;
+	int endIndex;
+	getIndexRange(midFreq, width, startIndex, endIndex);
     // get max level between both indexes:
     float max = 0.0;
     for (int i=startIndex; i<=endIndex; ++i) {
@@ -137,6 +265,17 @@ float ScaledSpectrum::getMaxLevel() const
 	return max;
 }
 
+float ScaledSpectrum::normalizeLevel(float level) const
+{
+	if (m_convertToDecibel) {
+		// (same range of 60dB as the spectrum)
+		const float dB = 20 * qLn(qMax(level, 1e-6f)) / qLn(10);
+		const float valueBeforeGain = (dB + 60) / 60;
+		return qPow(qMax(0.0f, qMin(valueBeforeGain * m_gain, 1.0f)), (1 / m_compression));
+	}
+	return qPow(qMax(0.0f, qMin(level * m_gain, 1.0f)), (1 / m_compression));
+}
+
 void ScaledSpectrum::updateAGC()
 {
 	if (!m_agcEnabled) return;
@@ -26,6 +26,14 @@
 
 #include <QVector>
 
+
+// lowest frequency of the scaled spectrum
+static const int SCALED_SPECTRUM_BASE_FREQ = 20;  // Hz
+
+// highest frequency of the scaled spectrum, independent of the sample rate
+static const int SCALED_SPECTRUM_MAX_FREQ = 22050;  // Hz
+
+
 // ----------------- AGC Constants -----------------
 
 // AGC = Automatic Gain Control
@@ -81,14 +89,57 @@ public:
 	// set if energy values should be converted to dB values
 	void setDecibelConversion(bool value) { m_convertToDecibel = value; }
 
+	// returns if the linear spectrum contains powers instead of magnitudes
+	bool getPowerDomain() const { return m_powerDomain; }
+	// sets if the linear spectrum contains powers (squared magnitudes) instead of magnitudes
+	// - the powers of a scaled bin are summed up with the squared weights and the square root of the sum
+	//   is normalized, so a sine has the same level as with magnitudes and the gain, the AGC and the
+	//   thresholds of the triggers keep their meaning (the dB values stay the same)
+	// - a scaled bin with the energy spread over several linear bins (i.e. noise) is lower than with
+	//   magnitudes, because the square root of the summed powers is less than the sum of the magnitudes
+	void setPowerDomain(bool value) { m_powerDomain = value; }
+
 	// returns if the AGC is enabled
 	bool getAgcEnabled() const { return m_agcEnabled; }
 	// sets if the AGC is enabled
 	void setAgcEnabled(bool value) { m_agcEnabled = value; }
 
+	// returns the sample rate of the signal the linear spectrum is calculated from
+	int getSampleRate() const { return qRound(m_nyquistFreq * 2); }
+	// sets the sample rate of the signal the linear spectrum is calculated from
+	// (the linear spectrum is expected to reach from 0Hz to half of the sample rate)
+	void setSampleRate(int value);
+
+	// sets the number of samples of the FFT the linear spectrum is calculated from
+	// (the energies are normalized with MAX_FFT_VALUE scaled to this size)
+	void setFftSize(int numSamples);
+
+	// sets the lengths of the linear spectra of FFTs with different sizes (from the longest to the shortest FFT)
+	// that are concatenated in the linear spectrum passed to updateWithLinearSpectrum()
+	// - each scaled bin takes its values from the shortest FFT in which it spans at least one linear bin
+	// - all spectra have to be scaled to the energies of the longest FFT
+	// - the linear spectrum is a single spectrum if its length doesn't match the sum of the lengths
+	void setResolutions(const QVector<int>& lengths);
+
+	// copies the gain, compression, dB conversion, power domain and the frequency mapping
+	// of another spectrum (i.e. for a spectrum that is only updated in some bands, see updateBins())
+	void copyParameters(const ScaledSpectrum& other);
+
+	// calculates the mapping of the linear spectrum if its length or the sample rate has changed
+	// (done by the update methods, needed before getLinearBins() is called)
+	void prepareFilterbank(int linearLength);
+
+	// returns the range of bins of the linear spectrum that is used for the scaled bin index
+	// - numBins is 0 if the scaled bin is above the nyquist frequency
+	void getLinearBins(int index, int& firstIndex, int& numBins) const;
+
 	// Scales the incoming linear spectrum to a logarithmic spectrum.
 	// Results will be written in dbSpectrum and normSpectrum.
-	void updateWithLinearSpectrum(const QVector<float> linearSpectrum);
+	void updateWithLinearSpectrum(const QVector<float>& linearSpectrum);
+
+	// updates only the scaled bins startIndex...endIndex with the incoming linear spectrum
+	// (i.e. when only the bins of some bands are calculated, the AGC is not updated)
+	void updateBins(const QVector<float>& linearSpectrum, int startIndex, int endIndex);
 
 	// returns a normalized spectrum (energy value from 0 to 1)
 	// This spectrum is scaled by both factor and exponent.
@@ -103,13 +154,28 @@ public:
 	// returns the energy level of a certain frequency
 	float getLevelAtFreq(const int& freq) const { return m_normSpectrum[getIndexForFreq(freq)]; }
 
+	// returns the range of scaled bins of a frequency band (as used by getMaxLevel())
+	void getIndexRange(const int& midFreq, const qreal& width, int& startIndex, int& endIndex) const;
+
 	// returns the max level within a frequency band
 	float getMaxLevel(const int& midFreq, const qreal& width) const;
 
 	// returns the overall max level
 	float getMaxLevel() const;
 
+	// scales a broadband level (i.e. of AudioLevels, 1.0 is full scale) with the same gain,
+	// compression and dB conversion as the spectrum, so that it can be compared with the spectrum levels
+	float normalizeLevel(float level) const;
+
 private:
+	// calculates the sparse matrix that maps a linear spectrum of the given length
+	// to the logarithmic frequency scale (called only if the length or the sample rate changes)
+	void updateFilterbank(int linearLength);
+
+	// calculates the normalized energy of the scaled bin index from the linear spectrum
+	// and returns its value before the gain is applied (used for the AGC)
+	float updateBin(const float* linear, int index);
+
 	// calculates the required gain and changes the actual gain in small steps
 	// based on the last maximum values of the FFT
 	void updateAGC();
@@ -119,11 +185,20 @@ protected:
 	const int		m_scaledLength;  // resulting number of frequency bins after scaling
 	qreal			m_freqScaleFactor;  // internal factor used to calculate the scaled frequencies
 	qreal			m_logOfFreqScaleFactor;  // log of m_freqScaleFactor (often used in calculations)
+	qreal			m_nyquistFreq;  // highest frequency of the linear spectrum (half of the sample rate)
+	float			m_maxFftValue;  // maximum value of the linear spectrum (used to normalize the energies)
 	float			m_gain;  // Gain factor
 	float			m_compression;  // Compression factor (the higher it is the more the energy values get compressed)
 	bool			m_convertToDecibel;  // true if the energy values should be converted to dB
+	bool			m_powerDomain;  // true if the linear spectrum contains powers instead of magnitudes
 	QVector<float>	m_normSpectrum;  // stores the spectrum with energy values between 0 and 1
 	bool			m_agcEnabled;  // true if AGC is enabled
+	QVector<int>	m_resolutions;  // lengths of the concatenated linear spectra (from the longest to the shortest FFT)
+	int				m_filterLinearLength;  // length of the linear spectrum the filterbank is calculated for (0 if outdated)
+	QVector<int>	m_filterFirstIndex;  // index of the first linear bin of each scaled bin (in the concatenated spectra)
+	QVector<int>	m_filterOffset;  // offset of the weights of each scaled bin in m_filterWeights (plus end offset)
+	QVector<float>	m_filterWeights;  // weights of the linear bins of all scaled bins, stored contiguously
+	QVector<float>	m_filterPowerWeights;  // squared weights (used in the power domain)
 	Qt3DCore::QCircularBuffer<float> m_lastMaxValues;  // list of last maximum energy values used for AGC
 };
 
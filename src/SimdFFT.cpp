@@ -0,0 +1,193 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "SimdFFT.h"
+
+#include <QtMath>
+#include <cmath>
+#include <algorithm>
+
+#if defined(SIMD_FFT_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// returns true if the CPU and the operating system support AVX2
+static bool cpuHasAvx2()
+{
+#if defined(SIMD_FFT_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) return false;
+	// OSXSAVE and AVX, the OS has to save the YMM registers:
+	__cpuid(info, 1);
+	if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) return false;
+	if ((_xgetbv(0) & 6) != 6) return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#elif defined(SIMD_FFT_X86) && (defined(__GNUC__) || defined(__clang__))
+	// (also checks the support of the OS)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#else
+	return false;
+#endif
+}
+
+SimdFFT::SimdFFT(int sizeExponent, Backend backend)
+	: m_backend(backend)
+	, m_size(1 << sizeExponent)
+	, m_kernel(nullptr)
+	, m_twiddles()
+	, m_work()
+	, m_tables()
+{
+	switch (backend) {
+#if defined(SIMD_FFT_X86)
+	case Sse2Backend: m_kernel = simdRealFftSse2; break;
+	case Avx2Backend: m_kernel = simdRealFftAvx2; break;
+#elif defined(SIMD_FFT_NEON)
+	case NeonBackend: m_kernel = simdRealFftNeon; break;
+#endif
+	default:
+		qWarning("SimdFFT: backend not available.");
+		break;
+	}
+
+	// the kernels need at least SIMD_FFT_MIN_SIZE_EXPONENT, the tables are still calculated
+	// so that the object stays valid:
+	Q_ASSERT(sizeExponent >= SIMD_FFT_MIN_SIZE_EXPONENT);
+	if (sizeExponent < SIMD_FFT_MIN_SIZE_EXPONENT) {
+		qWarning("SimdFFT: size below the minimum of the backends.");
+		m_kernel = nullptr;
+	}
+	const int size = 1 << qMax(sizeExponent, SIMD_FFT_MIN_SIZE_EXPONENT);
+	const int complexSize = size / 2;
+	const int half = complexSize / 2;
+	m_work.resize(4 * complexSize);
+
+	// twiddle factors of the complex FFT, the expanded tables and the post-processing:
+	m_twiddles.resize(2 * half + 2 * SIMD_FFT_NUM_EXPANDED_TWIDDLES * half + 2 * complexSize);
+	float* twiddleRe = m_twiddles.data();
+	float* twiddleIm = twiddleRe + half;
+	for (int k=0; k<half; ++k) {
+		twiddleRe[k] = float(qCos(2 * M_PI * k / complexSize));
+		twiddleIm[k] = float(-qSin(2 * M_PI * k / complexSize));
+	}
+	float* expanded = twiddleIm + half;
+	for (int i=0; i<SIMD_FFT_NUM_EXPANDED_TWIDDLES; ++i) {
+		const int stride = 1 << i;
+		float* expandedRe = expanded + 2 * i * half;
+		float* expandedIm = expandedRe + half;
+		for (int j=0; j<half; ++j) {
+			expandedRe[j] = twiddleRe[j & ~(stride - 1)];
+			expandedIm[j] = twiddleIm[j & ~(stride - 1)];
+		}
+		m_tables.expandedTwiddleRe[i] = expandedRe;
+		m_tables.expandedTwiddleIm[i] = expandedIm;
+	}
+	float* realCos = expanded + 2 * SIMD_FFT_NUM_EXPANDED_TWIDDLES * half;
+	float* realSin = realCos + complexSize;
+	for (int k=0; k<complexSize; ++k) {
+		realCos[k] = float(qCos(2 * M_PI * k / size));
+		realSin[k] = float(qSin(2 * M_PI * k / size));
+	}
+
+	m_tables.size = size;
+	m_tables.complexSize = complexSize;
+	m_tables.twiddleRe = twiddleRe;
+	m_tables.twiddleIm = twiddleIm;
+	m_tables.realTwiddleCos = realCos;
+	m_tables.realTwiddleSin = realSin;
+}
+
+void SimdFFT::doFft(float* output, const float* input)
+{
+	Q_ASSERT(m_kernel);
+	if (!m_kernel) {
+		// (no uninitialized output if the FFT can't be calculated)
+		std::fill(output, output + m_size, 0.0f);
+		return;
+	}
+	m_kernel(m_tables, m_work.data(), input, output);
+}
+
+SimdFFT::Backend SimdFFT::getBestBackend()
+{
+	static const Backend best = isBackendAvailable(Avx2Backend) ? Avx2Backend
+			: isBackendAvailable(Sse2Backend) ? Sse2Backend
+			: isBackendAvailable(NeonBackend) ? NeonBackend
+			: NoBackend;
+	return best;
+}
+
+bool SimdFFT::isBackendAvailable(Backend backend)
+{
+	switch (backend) {
+#if defined(SIMD_FFT_X86)
+	case Sse2Backend: return true;
+	case Avx2Backend: {
+		static const bool avx2 = cpuHasAvx2();
+		return avx2;
+	}
+#elif defined(SIMD_FFT_NEON)
+	case NeonBackend: return true;
+#endif
+	default: return false;
+	}
+}
+
+QString SimdFFT::getBackendName(Backend backend)
+{
+	switch (backend) {
+	case Sse2Backend: return "SSE2";
+	case Avx2Backend: return "AVX2";
+	case NeonBackend: return "NEON";
+	default: return "none";
+	}
+}
+
+void SimdFFT::calculateSpectrum(SpectrumType type, const float* fftOutput, int size, float* spectrum)
+{
+	switch (getBestBackend()) {
+#if defined(SIMD_FFT_X86)
+	case Avx2Backend: simdSpectrumAvx2(type, fftOutput, size, spectrum); return;
+	case Sse2Backend: simdSpectrumSse2(type, fftOutput, size, spectrum); return;
+#elif defined(SIMD_FFT_NEON)
+	case NeonBackend: simdSpectrumNeon(type, fftOutput, size, spectrum); return;
+#endif
+	default: break;
+	}
+
+	// scalar version:
+	const int half = size / 2;
+	for (int i=0; i<half; ++i) {
+		const float real = fftOutput[i];
+		// (bin 0 is real, the Nyquist bin is omitted)
+		const float img = i > 0 ? fftOutput[half + i] : 0.0f;
+		const float power = real*real + img*img;
+		if (type == MagnitudeSpectrum) {
+			spectrum[i] = qSqrt(power);
+		} else if (type == PowerSpectrum) {
+			spectrum[i] = power;
+		} else {
+			spectrum[i] = 10 * std::log10(qMax(power, SIMD_FFT_MIN_POWER));
+		}
+	}
+}
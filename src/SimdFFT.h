@@ -0,0 +1,140 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef SIMDFFT_H
+#define SIMDFFT_H
+
+#include "BasicFFTInterface.h"
+
+#include <QString>
+#include <QVector>
+
+// the instruction sets the SIMD backends can be compiled for:
+#if defined(__x86_64__) || defined(_M_X64) || ((defined(__i386__) || defined(_M_IX86)) && (defined(__SSE2__) || _M_IX86_FP >= 2))
+#define SIMD_FFT_X86
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SIMD_FFT_NEON
+#endif
+
+// smallest number of samples supported by SimdFFT expressed as an exponent of 2
+// (the complex FFT of half the samples has to fill the widest vectors in every pass)
+static const int SIMD_FFT_MIN_SIZE_EXPONENT = 6;
+
+// number of passes with a stride smaller than the widest vector (8 floats)
+static const int SIMD_FFT_NUM_EXPANDED_TWIDDLES = 3;
+
+// smallest power in a LogPowerSpectrum (-200dB, avoids the logarithm of 0)
+static const float SIMD_FFT_MIN_POWER = 1e-20f;
+
+
+// the values of a spectrum calculated by SimdFFT::calculateSpectrum()
+enum SpectrumType {
+	MagnitudeSpectrum,  // sqrt(re^2 + im^2)
+	PowerSpectrum,  // re^2 + im^2
+	LogPowerSpectrum  // 10 * log10(re^2 + im^2) in dB
+};
+
+
+// Precalculated tables of a SimdFFT (passed to the backends).
+struct SimdFFTTables
+{
+	int				size;  // number of real samples
+	int				complexSize;  // number of points of the complex FFT (size / 2)
+	const float*	twiddleRe;  // cos(2*pi*k / complexSize) for k < complexSize / 2
+	const float*	twiddleIm;  // -sin(2*pi*k / complexSize) for k < complexSize / 2
+	// the twiddle factors of the passes with a stride of 1, 2 and 4 for every butterfly
+	// (the factor of butterfly j is twiddle[j & ~(stride - 1)])
+	const float*	expandedTwiddleRe[SIMD_FFT_NUM_EXPANDED_TWIDDLES];
+	const float*	expandedTwiddleIm[SIMD_FFT_NUM_EXPANDED_TWIDDLES];
+	const float*	realTwiddleCos;  // cos(2*pi*k / size) for k < complexSize
+	const float*	realTwiddleSin;  // sin(2*pi*k / size) for k < complexSize
+
+	// returns the index of the expanded twiddle table of stride (1, 2 or 4)
+	static int expandedIndex(int stride) { return stride == 1 ? 0 : (stride == 2 ? 1 : 2); }
+};
+
+// the entry points of the backends (each compiled for its instruction set):
+#if defined(SIMD_FFT_X86)
+void simdRealFftSse2(const SimdFFTTables& tables, float* work, const float* input, float* output);
+void simdRealFftAvx2(const SimdFFTTables& tables, float* work, const float* input, float* output);
+void simdSpectrumSse2(SpectrumType type, const float* fftOutput, int size, float* spectrum);
+void simdSpectrumAvx2(SpectrumType type, const float* fftOutput, int size, float* spectrum);
+#elif defined(SIMD_FFT_NEON)
+void simdRealFftNeon(const SimdFFTTables& tables, float* work, const float* input, float* output);
+void simdSpectrumNeon(SpectrumType type, const float* fftOutput, int size, float* spectrum);
+#endif
+
+
+// An implementation of the BasicFFTInterface with vectorized code for SSE2, AVX2 or NEON.
+// The result has the same format as the one of FFTReal (see FFTRealWrapper):
+// - output[0...N/2] are the real parts of the bins 0...N/2
+// - output[N/2+1...N-1] are the negated imaginary parts of the bins 1...N/2-1
+// The backend is selected at runtime from the features of the CPU (see getBestBackend()).
+class SimdFFT : public BasicFFTInterface
+{
+
+public:
+	// the vectorized implementations
+	enum Backend {
+		NoBackend,  // no SIMD backend is available for the CPU
+		Sse2Backend,
+		Avx2Backend,
+		NeonBackend
+	};
+
+	// sizeExponent is the number of samples expressed as an exponent of 2, backend has to be available
+	// - sizeExponent has to be at least SIMD_FFT_MIN_SIZE_EXPONENT (asserted, smaller sizes are not calculated)
+	explicit SimdFFT(int sizeExponent, Backend backend = getBestBackend());
+
+	// calculates the FFT of 2^sizeExponent samples
+	// - the output is set to 0 if the backend is not available or the size is too small (asserted)
+	void doFft(float* output, const float* input) override;
+
+	// returns the backend used by this object
+	Backend getBackend() const { return m_backend; }
+
+	// returns the fastest backend supported by the CPU
+	// (detected once with CPUID on x86, NoBackend if there is none)
+	static Backend getBestBackend();
+
+	// returns true if backend has been compiled in and is supported by the CPU
+	static bool isBackendAvailable(Backend backend);
+
+	// returns the name of backend (i.e. to print it)
+	static QString getBackendName(Backend backend);
+
+	// calculates the spectrum of the given type from the output of a FFT of size samples
+	// in the format of FFTReal in one pass (with the best backend, scalar code if there is none)
+	// - spectrum has to have space for size / 2 values (bin 0 is the DC value, the Nyquist bin is omitted)
+	static void calculateSpectrum(SpectrumType type, const float* fftOutput, int size, float* spectrum);
+
+protected:
+	// the function type of the entry points of the backends
+	typedef void (*KernelFunction)(const SimdFFTTables&, float*, const float*, float*);
+
+	const Backend	m_backend;  // the used vectorized implementation
+	const int		m_size;  // number of samples of the FFT
+	KernelFunction	m_kernel;  // the entry point of m_backend (nullptr if the FFT can't be calculated)
+	QVector<float>	m_twiddles;  // storage of the twiddle tables
+	QVector<float>	m_work;  // the arrays of the complex FFT (intermediate result)
+	SimdFFTTables	m_tables;  // pointers to the twiddle tables in m_twiddles
+};
+
+#endif // SIMDFFT_H
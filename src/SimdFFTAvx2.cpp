@@ -0,0 +1,122 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "SimdFFT.h"
+
+#include <cmath>
+
+#if defined(SIMD_FFT_X86)
+
+// the functions of this file are compiled for AVX2,
+// they are only called if the CPU supports it (see SimdFFT::getBestBackend()):
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+#include <immintrin.h>
+
+#include "SimdFFTKernel.h"
+
+namespace {
+
+// 8 floats in an AVX register
+struct VecAvx2
+{
+	typedef __m256 T;
+	static const int WIDTH = 8;
+
+	static T load(const float* p) { return _mm256_loadu_ps(p); }
+	static void store(float* p, T v) { _mm256_storeu_ps(p, v); }
+	static T set1(float value) { return _mm256_set1_ps(value); }
+	static T add(T a, T b) { return _mm256_add_ps(a, b); }
+	static T sub(T a, T b) { return _mm256_sub_ps(a, b); }
+	static T mul(T a, T b) { return _mm256_mul_ps(a, b); }
+	static T div(T a, T b) { return _mm256_div_ps(a, b); }
+	static T max(T a, T b) { return _mm256_max_ps(a, b); }
+	static T sqrt(T v) { return _mm256_sqrt_ps(v); }
+
+	// the exponent of positive normal numbers as float
+	static T exponent(T v) {
+		const __m256i bits = _mm256_castps_si256(v);
+		return _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+	}
+
+	// the mantissa of positive normal numbers (1 <= mantissa < 2)
+	static T mantissa(T v) {
+		const __m256i bits = _mm256_castps_si256(v);
+		return _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f800000)));
+	}
+
+	// [7 6 5 4 3 2 1 0]
+	static T reverse(T v) { return _mm256_permutevar8x32_ps(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0)); }
+
+	// [p0 p2 ... p14], [p1 p3 ... p15]
+	static void deinterleave(const float* p, T& even, T& odd) {
+		const T a = _mm256_loadu_ps(p);
+		const T b = _mm256_loadu_ps(p + 8);
+		// the shuffles work within the 128 bit lanes: [a0 a2 b0 b2 | a4 a6 b4 b6]
+		const T e = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+		const T o = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+		even = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(e), _MM_SHUFFLE(3, 1, 2, 0)));
+		odd = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(o), _MM_SHUFFLE(3, 1, 2, 0)));
+	}
+
+	// alternating blocks of STRIDE values of u and v
+	template<int STRIDE>
+	static void interleave(T u, T v, T& lo, T& hi) {
+		T l, h;
+		if (STRIDE == 1) {
+			// [u0 v0 u1 v1 | u4 v4 u5 v5], [u2 v2 u3 v3 | u6 v6 u7 v7]
+			l = _mm256_unpacklo_ps(u, v);
+			h = _mm256_unpackhi_ps(u, v);
+		} else if (STRIDE == 2) {
+			l = _mm256_castpd_ps(_mm256_unpacklo_pd(_mm256_castps_pd(u), _mm256_castps_pd(v)));
+			h = _mm256_castpd_ps(_mm256_unpackhi_pd(_mm256_castps_pd(u), _mm256_castps_pd(v)));
+		} else {
+			l = u;
+			h = v;
+		}
+		lo = _mm256_permute2f128_ps(l, h, 0x20);
+		hi = _mm256_permute2f128_ps(l, h, 0x31);
+	}
+};
+
+}  // namespace
+
+void simdRealFftAvx2(const SimdFFTTables& tables, float* work, const float* input, float* output)
+{
+	simdRealFft<VecAvx2>(tables, work, input, output);
+}
+
+void simdSpectrumAvx2(SpectrumType type, const float* fftOutput, int size, float* spectrum)
+{
+	simdSpectrum<VecAvx2>(type, fftOutput, size, spectrum);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // SIMD_FFT_X86
@@ -0,0 +1,228 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef SIMDFFTKERNEL_H
+#define SIMDFFTKERNEL_H
+
+#include "SimdFFT.h"
+
+// The vectorized FFT kernel shared by the SIMD backends of SimdFFT.
+// This header is only included by the translation units of the backends (SimdFFTSse2.cpp etc.),
+// which define a vector type V with the operations used below and compile the kernel
+// with the matching instruction set. V has to be declared in an anonymous namespace,
+// so that the instantiations of the different backends are never merged by the linker.
+// For the same reason all other headers (i.e. <cmath>) have to be included before
+// the instruction set is selected.
+//
+// The real FFT of N samples is calculated as a complex FFT of N/2 points
+// z[k] = x[2k] + i * x[2k+1], followed by a post-processing step that separates
+// the spectra of the even and odd samples. The complex FFT is a radix-2 Stockham FFT
+// on split real / imaginary arrays: each pass reads both halves of the data contiguously
+// and writes the results in their final order, so no bit reversal is needed.
+
+// a complex FFT pass with a stride smaller than the vector width V::WIDTH:
+// the twiddle factors are read from the expanded table of the stride
+template<class V, int STRIDE>
+inline void simdFftSmallStridePass(const SimdFFTTables& tables, const float* twiddleRe, const float* twiddleIm,
+								   const float* xRe, const float* xIm, float* yRe, float* yIm)
+{
+	const int half = tables.complexSize / 2;
+	for (int j=0; j<half; j+=V::WIDTH) {
+		const typename V::T aRe = V::load(xRe + j);
+		const typename V::T aIm = V::load(xIm + j);
+		const typename V::T bRe = V::load(xRe + j + half);
+		const typename V::T bIm = V::load(xIm + j + half);
+		const typename V::T wRe = V::load(twiddleRe + j);
+		const typename V::T wIm = V::load(twiddleIm + j);
+		const typename V::T dRe = V::sub(aRe, bRe);
+		const typename V::T dIm = V::sub(aIm, bIm);
+		// the sums and the rotated differences are interleaved in blocks of STRIDE values:
+		typename V::T lo, hi;
+		V::template interleave<STRIDE>(V::add(aRe, bRe), V::sub(V::mul(dRe, wRe), V::mul(dIm, wIm)), lo, hi);
+		V::store(yRe + 2 * j, lo);
+		V::store(yRe + 2 * j + V::WIDTH, hi);
+		V::template interleave<STRIDE>(V::add(aIm, bIm), V::add(V::mul(dRe, wIm), V::mul(dIm, wRe)), lo, hi);
+		V::store(yIm + 2 * j, lo);
+		V::store(yIm + 2 * j + V::WIDTH, hi);
+	}
+}
+
+// a complex FFT pass with a stride of at least the vector width:
+// all values of a vector use the same twiddle factor
+template<class V>
+inline void simdFftLargeStridePass(const SimdFFTTables& tables, int stride,
+								   const float* xRe, const float* xIm, float* yRe, float* yIm)
+{
+	const int half = tables.complexSize / 2;
+	for (int p=0; p * stride < half; ++p) {
+		const typename V::T wRe = V::set1(tables.twiddleRe[p * stride]);
+		const typename V::T wIm = V::set1(tables.twiddleIm[p * stride]);
+		const int x0 = p * stride;
+		const int y0 = 2 * p * stride;
+		for (int q=0; q<stride; q+=V::WIDTH) {
+			const typename V::T aRe = V::load(xRe + x0 + q);
+			const typename V::T aIm = V::load(xIm + x0 + q);
+			const typename V::T bRe = V::load(xRe + x0 + q + half);
+			const typename V::T bIm = V::load(xIm + x0 + q + half);
+			const typename V::T dRe = V::sub(aRe, bRe);
+			const typename V::T dIm = V::sub(aIm, bIm);
+			V::store(yRe + y0 + q, V::add(aRe, bRe));
+			V::store(yIm + y0 + q, V::add(aIm, bIm));
+			V::store(yRe + y0 + stride + q, V::sub(V::mul(dRe, wRe), V::mul(dIm, wIm)));
+			V::store(yIm + y0 + stride + q, V::add(V::mul(dRe, wIm), V::mul(dIm, wRe)));
+		}
+	}
+}
+
+// swaps the input and the output arrays of a pass
+// (static and no std::swap, so that no function is shared with code compiled for another instruction set)
+static inline void simdFftSwap(float*& a, float*& b)
+{
+	float* const tmp = a;
+	a = b;
+	b = tmp;
+}
+
+// calculates the real FFT of tables.size samples in input
+// and writes it to output in the format of FFTReal (see SimdFFT)
+template<class V>
+void simdRealFft(const SimdFFTTables& tables, float* work, const float* input, float* output)
+{
+	const int n = tables.complexSize;
+	float* xRe = work;
+	float* xIm = work + n;
+	float* yRe = work + 2 * n;
+	float* yIm = work + 3 * n;
+
+	// split the even and odd samples into the real and imaginary parts of z:
+	for (int k=0; k<n; k+=V::WIDTH) {
+		typename V::T even, odd;
+		V::deinterleave(input + 2 * k, even, odd);
+		V::store(xRe + k, even);
+		V::store(xIm + k, odd);
+	}
+
+	// complex FFT of z:
+	int stride = 1;
+	for (; stride < V::WIDTH && stride < n; stride *= 2) {
+		const float* twiddleRe = tables.expandedTwiddleRe[tables.expandedIndex(stride)];
+		const float* twiddleIm = tables.expandedTwiddleIm[tables.expandedIndex(stride)];
+		switch (stride) {
+		case 1: simdFftSmallStridePass<V, 1>(tables, twiddleRe, twiddleIm, xRe, xIm, yRe, yIm); break;
+		case 2: simdFftSmallStridePass<V, 2>(tables, twiddleRe, twiddleIm, xRe, xIm, yRe, yIm); break;
+		default: simdFftSmallStridePass<V, 4>(tables, twiddleRe, twiddleIm, xRe, xIm, yRe, yIm); break;
+		}
+		simdFftSwap(xRe, yRe);
+		simdFftSwap(xIm, yIm);
+	}
+	for (; stride < n; stride *= 2) {
+		simdFftLargeStridePass<V>(tables, stride, xRe, xIm, yRe, yIm);
+		simdFftSwap(xRe, yRe);
+		simdFftSwap(xIm, yIm);
+	}
+
+	// separate the spectra of the even and odd samples:
+	// X[k] = E[k] + e^(-2*pi*i*k/N) * O[k]
+	// with E[k] = (Z[k] + conj(Z[n-k])) / 2 and O[k] = (Z[k] - conj(Z[n-k])) / 2i
+	output[0] = xRe[0] + xIm[0];
+	output[n] = xRe[0] - xIm[0];
+	const typename V::T h = V::set1(0.5f);
+	int k = 1;
+	for (; k + V::WIDTH <= n; k+=V::WIDTH) {
+		const typename V::T aRe = V::load(xRe + k);
+		const typename V::T aIm = V::load(xIm + k);
+		const typename V::T bRe = V::reverse(V::load(xRe + n - k - V::WIDTH + 1));
+		const typename V::T bIm = V::reverse(V::load(xIm + n - k - V::WIDTH + 1));
+		const typename V::T eRe = V::mul(h, V::add(aRe, bRe));
+		const typename V::T eIm = V::mul(h, V::sub(aIm, bIm));
+		const typename V::T oRe = V::mul(h, V::add(aIm, bIm));
+		const typename V::T oIm = V::mul(h, V::sub(bRe, aRe));
+		const typename V::T c = V::load(tables.realTwiddleCos + k);
+		const typename V::T s = V::load(tables.realTwiddleSin + k);
+		V::store(output + k, V::add(eRe, V::add(V::mul(oRe, c), V::mul(oIm, s))));
+		// FFTReal stores the negated imaginary parts:
+		V::store(output + n + k, V::sub(V::sub(V::mul(oRe, s), V::mul(oIm, c)), eIm));
+	}
+	for (; k<n; ++k) {
+		const float eRe = 0.5f * (xRe[k] + xRe[n - k]);
+		const float eIm = 0.5f * (xIm[k] - xIm[n - k]);
+		const float oRe = 0.5f * (xIm[k] + xIm[n - k]);
+		const float oIm = 0.5f * (xRe[n - k] - xRe[k]);
+		const float c = tables.realTwiddleCos[k];
+		const float s = tables.realTwiddleSin[k];
+		output[k] = eRe + oRe * c + oIm * s;
+		output[n + k] = oRe * s - oIm * c - eIm;
+	}
+}
+
+// calculates the power, magnitude or power in dB of the size / 2 bins
+// of the output of simdRealFft() in one pass (see SimdFFT::calculateSpectrum())
+template<class V>
+void simdSpectrum(SpectrumType type, const float* fftOutput, int size, float* spectrum)
+{
+	const int half = size / 2;
+	const float* re = fftOutput;
+	const float* im = fftOutput + half;
+
+	// the loops for each type are separate, so that there is no branch in them:
+	if (type == MagnitudeSpectrum) {
+		for (int i=0; i<half; i+=V::WIDTH) {
+			const typename V::T r = V::load(re + i);
+			const typename V::T m = V::load(im + i);
+			V::store(spectrum + i, V::sqrt(V::add(V::mul(r, r), V::mul(m, m))));
+		}
+		// bin 0 is real, the value at im[0] is the Nyquist bin:
+		spectrum[0] = re[0] < 0 ? -re[0] : re[0];
+	} else if (type == PowerSpectrum) {
+		for (int i=0; i<half; i+=V::WIDTH) {
+			const typename V::T r = V::load(re + i);
+			const typename V::T m = V::load(im + i);
+			V::store(spectrum + i, V::add(V::mul(r, r), V::mul(m, m)));
+		}
+		spectrum[0] = re[0] * re[0];
+	} else {
+		// the power is split into exponent and mantissa m (1 <= m < 2):
+		// ln(m) = 2 * atanh(s) = 2 * (s + s^3/3 + s^5/5 + s^7/7 + ...) with s = (m - 1) / (m + 1) < 1/3
+		const typename V::T minPower = V::set1(SIMD_FFT_MIN_POWER);
+		const typename V::T one = V::set1(1.0f);
+		const typename V::T c3 = V::set1(1.0f / 3);
+		const typename V::T c5 = V::set1(1.0f / 5);
+		const typename V::T c7 = V::set1(1.0f / 7);
+		const typename V::T ln2 = V::set1(0.693147181f);
+		const typename V::T dbPerNeper = V::set1(4.342944819f);  // 10 / ln(10)
+		const typename V::T twoDbPerNeper = V::set1(8.685889638f);
+		for (int i=0; i<half; i+=V::WIDTH) {
+			const typename V::T r = V::load(re + i);
+			const typename V::T m = V::load(im + i);
+			const typename V::T power = V::max(V::add(V::mul(r, r), V::mul(m, m)), minPower);
+			const typename V::T mantissa = V::mantissa(power);
+			const typename V::T s = V::div(V::sub(mantissa, one), V::add(mantissa, one));
+			const typename V::T s2 = V::mul(s, s);
+			const typename V::T series = V::add(one, V::mul(s2, V::add(c3, V::mul(s2, V::add(c5, V::mul(s2, c7))))));
+			// 10 * log10(power) = 10 / ln(10) * (exponent * ln(2) + 2 * s * series):
+			V::store(spectrum + i, V::add(V::mul(dbPerNeper, V::mul(V::exponent(power), ln2)),
+										  V::mul(twoDbPerNeper, V::mul(s, series))));
+		}
+		const float power = re[0] * re[0];
+		spectrum[0] = 10 * std::log10(power > SIMD_FFT_MIN_POWER ? power : SIMD_FFT_MIN_POWER);
+	}
+}
+
+#endif // SIMDFFTKERNEL_H
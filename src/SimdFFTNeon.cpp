@@ -0,0 +1,119 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "SimdFFT.h"
+
+#include <cmath>
+
+#if defined(SIMD_FFT_NEON)
+
+#include <arm_neon.h>
+
+#include "SimdFFTKernel.h"
+
+namespace {
+
+// 4 floats in a NEON register
+struct VecNeon
+{
+	typedef float32x4_t T;
+	static const int WIDTH = 4;
+
+	static T load(const float* p) { return vld1q_f32(p); }
+	static void store(float* p, T v) { vst1q_f32(p, v); }
+	static T set1(float value) { return vdupq_n_f32(value); }
+	static T add(T a, T b) { return vaddq_f32(a, b); }
+	static T sub(T a, T b) { return vsubq_f32(a, b); }
+	static T mul(T a, T b) { return vmulq_f32(a, b); }
+	static T max(T a, T b) { return vmaxq_f32(a, b); }
+
+#if defined(__aarch64__)
+	static T div(T a, T b) { return vdivq_f32(a, b); }
+	static T sqrt(T v) { return vsqrtq_f32(v); }
+#else
+	// ARMv7 has no vector division, the reciprocal estimate is refined with two Newton-Raphson steps:
+	static T div(T a, T b) {
+		T r = vrecpeq_f32(b);
+		r = vmulq_f32(vrecpsq_f32(b, r), r);
+		r = vmulq_f32(vrecpsq_f32(b, r), r);
+		return vmulq_f32(a, r);
+	}
+	// sqrt(v) = v * 1/sqrt(v) with a refined estimate (0 for v = 0):
+	static T sqrt(T v) {
+		T r = vrsqrteq_f32(v);
+		r = vmulq_f32(vrsqrtsq_f32(vmulq_f32(v, r), r), r);
+		r = vmulq_f32(vrsqrtsq_f32(vmulq_f32(v, r), r), r);
+		const uint32x4_t isZero = vceqq_f32(v, vdupq_n_f32(0.0f));
+		return vbslq_f32(isZero, v, vmulq_f32(v, r));
+	}
+#endif
+
+	// the exponent of positive normal numbers as float
+	static T exponent(T v) {
+		const uint32x4_t bits = vreinterpretq_u32_f32(v);
+		return vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(bits, 23)), vdupq_n_s32(127)));
+	}
+
+	// the mantissa of positive normal numbers (1 <= mantissa < 2)
+	static T mantissa(T v) {
+		const uint32x4_t bits = vreinterpretq_u32_f32(v);
+		return vreinterpretq_f32_u32(vorrq_u32(vandq_u32(bits, vdupq_n_u32(0x007fffff)), vdupq_n_u32(0x3f800000)));
+	}
+
+	// [3 2 1 0]
+	static T reverse(T v) {
+		const T r = vrev64q_f32(v);
+		return vcombine_f32(vget_high_f32(r), vget_low_f32(r));
+	}
+
+	// [p0 p2 p4 p6], [p1 p3 p5 p7]
+	static void deinterleave(const float* p, T& even, T& odd) {
+		const float32x4x2_t v = vld2q_f32(p);
+		even = v.val[0];
+		odd = v.val[1];
+	}
+
+	// alternating blocks of STRIDE values of u and v
+	template<int STRIDE>
+	static void interleave(T u, T v, T& lo, T& hi) {
+		if (STRIDE == 1) {
+			const float32x4x2_t z = vzipq_f32(u, v);
+			lo = z.val[0];
+			hi = z.val[1];
+		} else {
+			lo = vcombine_f32(vget_low_f32(u), vget_low_f32(v));
+			hi = vcombine_f32(vget_high_f32(u), vget_high_f32(v));
+		}
+	}
+};
+
+}  // namespace
+
+void simdRealFftNeon(const SimdFFTTables& tables, float* work, const float* input, float* output)
+{
+	simdRealFft<VecNeon>(tables, work, input, output);
+}
+
+void simdSpectrumNeon(SpectrumType type, const float* fftOutput, int size, float* spectrum)
+{
+	simdSpectrum<VecNeon>(type, fftOutput, size, spectrum);
+}
+
+#endif // SIMD_FFT_NEON
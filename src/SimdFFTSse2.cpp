@@ -0,0 +1,97 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "SimdFFT.h"
+
+#include <cmath>
+
+#if defined(SIMD_FFT_X86)
+
+#include <emmintrin.h>
+
+#include "SimdFFTKernel.h"
+
+namespace {
+
+// 4 floats in a SSE2 register
+struct VecSse2
+{
+	typedef __m128 T;
+	static const int WIDTH = 4;
+
+	static T load(const float* p) { return _mm_loadu_ps(p); }
+	static void store(float* p, T v) { _mm_storeu_ps(p, v); }
+	static T set1(float value) { return _mm_set1_ps(value); }
+	static T add(T a, T b) { return _mm_add_ps(a, b); }
+	static T sub(T a, T b) { return _mm_sub_ps(a, b); }
+	static T mul(T a, T b) { return _mm_mul_ps(a, b); }
+	static T div(T a, T b) { return _mm_div_ps(a, b); }
+	static T max(T a, T b) { return _mm_max_ps(a, b); }
+	static T sqrt(T v) { return _mm_sqrt_ps(v); }
+
+	// the exponent of positive normal numbers as float
+	static T exponent(T v) {
+		const __m128i bits = _mm_castps_si128(v);
+		return _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+	}
+
+	// the mantissa of positive normal numbers (1 <= mantissa < 2)
+	static T mantissa(T v) {
+		const __m128i bits = _mm_castps_si128(v);
+		return _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)));
+	}
+
+	// [3 2 1 0]
+	static T reverse(T v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3)); }
+
+	// [p0 p2 p4 p6], [p1 p3 p5 p7]
+	static void deinterleave(const float* p, T& even, T& odd) {
+		const T a = _mm_loadu_ps(p);
+		const T b = _mm_loadu_ps(p + 4);
+		even = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+		odd = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+	}
+
+	// alternating blocks of STRIDE values of u and v
+	template<int STRIDE>
+	static void interleave(T u, T v, T& lo, T& hi) {
+		if (STRIDE == 1) {
+			lo = _mm_unpacklo_ps(u, v);
+			hi = _mm_unpackhi_ps(u, v);
+		} else {
+			lo = _mm_movelh_ps(u, v);
+			hi = _mm_movehl_ps(v, u);
+		}
+	}
+};
+
+}  // namespace
+
+void simdRealFftSse2(const SimdFFTTables& tables, float* work, const float* input, float* output)
+{
+	simdRealFft<VecSse2>(tables, work, input, output);
+}
+
+void simdSpectrumSse2(SpectrumType type, const float* fftOutput, int size, float* spectrum)
+{
+	simdSpectrum<VecSse2>(type, fftOutput, size, spectrum);
+}
+
+#endif // SIMD_FFT_X86
@@ -0,0 +1,155 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "SlidingDFT.h"
+
+#include <QtMath>
+
+SlidingDFT::SlidingDFT(int windowSize)
+	: m_windowSize(windowSize)
+	, m_windowEnd(0)
+	, m_samplesSinceRefresh(0)
+	, m_bins()
+	, m_stateIndex(windowSize / 2 + 1, -1)
+	, m_stateBins()
+	, m_real()
+	, m_imag()
+	, m_rotationReal()
+	, m_rotationImag()
+	, m_samples(windowSize)
+	, m_oldSamples(windowSize)
+	, m_difference(windowSize)
+{
+}
+
+void SlidingDFT::setBins(const QVector<int>& bins)
+{
+	m_bins.clear();
+	m_stateBins.clear();
+	m_stateIndex.fill(-1);
+
+	// each Hann windowed bin needs the rectangular bin and its neighbours:
+	for (int bin: bins) {
+		if (bin < 1 || bin >= m_windowSize / 2) continue;
+		m_bins.append(bin);
+		for (int k=bin-1; k<=bin+1; ++k) {
+			if (m_stateIndex[k] >= 0) continue;
+			m_stateIndex[k] = m_stateBins.size();
+			m_stateBins.append(k);
+		}
+	}
+
+	const int numStates = m_stateBins.size();
+	m_real = QVector<double>(numStates, 0.0);
+	m_imag = QVector<double>(numStates, 0.0);
+	m_rotationReal.resize(numStates);
+	m_rotationImag.resize(numStates);
+	for (int i=0; i<numStates; ++i) {
+		const double angle = 2 * M_PI * m_stateBins[i] / m_windowSize;
+		m_rotationReal[i] = qCos(angle);
+		m_rotationImag[i] = qSin(angle);
+	}
+
+	// the new bins have to be calculated from the whole window:
+	m_windowEnd = 0;
+}
+
+void SlidingDFT::advance(const MonoAudioBuffer& buffer, int64_t windowEnd)
+{
+	const int64_t numSamples = windowEnd - m_windowEnd;
+	if (numSamples == 0) return;
+
+	if (m_windowEnd == 0 || numSamples < 0 || numSamples >= m_windowSize
+			|| m_samplesSinceRefresh + numSamples > int64_t(m_windowSize) * SLIDING_DFT_REFRESH_WINDOWS) {
+		recalculate(buffer, windowEnd);
+		return;
+	}
+
+	// the samples entering and leaving the window:
+	const int count = int(numSamples);
+	buffer.copySamples(m_windowEnd, m_samples.data(), count);
+	buffer.copySamples(m_windowEnd - m_windowSize, m_oldSamples.data(), count);
+	for (int i=0; i<count; ++i) {
+		m_difference[i] = double(m_samples[i]) - m_oldSamples[i];
+	}
+	const double* difference = m_difference.constData();
+
+	// X(n) = W * (X(n-1) + x(n) - x(n-N)) with W = e^(j*2*pi*k/N):
+	for (int s=0; s<m_stateBins.size(); ++s) {
+		double re = m_real[s];
+		double im = m_imag[s];
+		const double rotRe = m_rotationReal[s];
+		const double rotIm = m_rotationImag[s];
+		for (int i=0; i<count; ++i) {
+			const double sum = re + difference[i];
+			re = sum * rotRe - im * rotIm;
+			im = sum * rotIm + im * rotRe;
+		}
+		m_real[s] = re;
+		m_imag[s] = im;
+	}
+
+	m_windowEnd = windowEnd;
+	m_samplesSinceRefresh += numSamples;
+}
+
+void SlidingDFT::recalculate(const MonoAudioBuffer& buffer, int64_t windowEnd)
+{
+	buffer.copySamples(windowEnd - m_windowSize, m_samples.data(), m_windowSize);
+	const float* samples = m_samples.constData();
+
+	// X(k) = sum of x(m) * e^(-j*2*pi*k*m/N), the twiddle factor is rotated sample by sample:
+	for (int s=0; s<m_stateBins.size(); ++s) {
+		const double rotRe = m_rotationReal[s];
+		const double rotIm = -m_rotationImag[s];
+		double twiddleRe = 1.0;
+		double twiddleIm = 0.0;
+		double re = 0.0;
+		double im = 0.0;
+		for (int m=0; m<m_windowSize; ++m) {
+			re += samples[m] * twiddleRe;
+			im += samples[m] * twiddleIm;
+			const double nextRe = twiddleRe * rotRe - twiddleIm * rotIm;
+			twiddleIm = twiddleRe * rotIm + twiddleIm * rotRe;
+			twiddleRe = nextRe;
+		}
+		m_real[s] = re;
+		m_imag[s] = im;
+	}
+
+	m_windowEnd = windowEnd;
+	m_samplesSinceRefresh = 0;
+}
+
+float SlidingDFT::getPower(int bin) const
+{
+	const int center = m_stateIndex[bin];
+	const int lower = m_stateIndex[bin - 1];
+	const int upper = m_stateIndex[bin + 1];
+	// Hann window applied in the frequency domain:
+	const double re = 0.5 * m_real[center] - 0.25 * (m_real[lower] + m_real[upper]);
+	const double im = 0.5 * m_imag[center] - 0.25 * (m_imag[lower] + m_imag[upper]);
+	return float(re * re + im * im);
+}
+
+float SlidingDFT::getMagnitude(int bin) const
+{
+	return qSqrt(getPower(bin));
+}
@@ -0,0 +1,92 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef SLIDINGDFT_H
+#define SLIDINGDFT_H
+
+#include "MonoAudioBuffer.h"
+
+#include <QVector>
+
+
+// number of window lengths a SlidingDFT slides before its bins are recalculated directly
+// (to remove the rounding errors accumulated by the recursion)
+static const int SLIDING_DFT_REFRESH_WINDOWS = 16;
+
+
+// A sliding DFT that keeps a few bins of the Hann windowed DFT of the latest samples
+// of a MonoAudioBuffer up to date, sample by sample:
+// - each bin of the rectangular DFT is updated with X = W * (X + x(new) - x(old))
+// - the Hann window is applied in the frequency domain (0.5 X(k) - 0.25 X(k-1) - 0.25 X(k+1))
+// The cost per sample is proportional to the number of bins, not to the window size,
+// so single bands can be analyzed at a much higher rate than with a full FFT.
+class SlidingDFT
+{
+
+public:
+	// windowSize is the number of samples of the DFT (the bins have the same frequencies as a FFT of this size)
+	explicit SlidingDFT(int windowSize);
+
+	// returns the number of samples of the DFT
+	int getWindowSize() const { return m_windowSize; }
+
+	// sets the Hann windowed bins to be calculated [1...windowSize/2-1]
+	// (the bins are recalculated with the next call of advance())
+	void setBins(const QVector<int>& bins);
+
+	// returns the Hann windowed bins that are calculated
+	const QVector<int>& getBins() const { return m_bins; }
+
+	// slides the window forward so that it ends before the absolute sample number windowEnd
+	// (the bins are recalculated directly from the buffer if the window has jumped
+	// or after SLIDING_DFT_REFRESH_WINDOWS windows)
+	// - the samples from windowEnd - windowSize on have to be in buffer
+	void advance(const MonoAudioBuffer& buffer, int64_t windowEnd);
+
+	// recalculates the bins with the next call of advance()
+	// (i.e. if the samples were overwritten by the producer while they were read)
+	void invalidate() { m_windowEnd = 0; }
+
+	// returns the power (squared magnitude) of the Hann windowed bin, it has to be one of getBins()
+	float getPower(int bin) const;
+
+	// returns the magnitude of the Hann windowed bin, it has to be one of getBins()
+	float getMagnitude(int bin) const;
+
+protected:
+	// calculates all bins directly from the window that ends before windowEnd
+	void recalculate(const MonoAudioBuffer& buffer, int64_t windowEnd);
+
+	const int				m_windowSize;  // number of samples of the DFT
+	int64_t					m_windowEnd;  // the absolute sample number after the last sample of the window (0 if not calculated)
+	int64_t					m_samplesSinceRefresh;  // number of samples the window has slid since the last recalculation
+	QVector<int>			m_bins;  // the Hann windowed bins that are calculated
+	QVector<int>			m_stateIndex;  // index of each rectangular bin in the state arrays (-1 if not calculated)
+	QVector<int>			m_stateBins;  // the rectangular bins that are calculated (the bins and their neighbours)
+	QVector<double>			m_real;  // real parts of the rectangular bins
+	QVector<double>			m_imag;  // imaginary parts of the rectangular bins
+	QVector<double>			m_rotationReal;  // real parts of the rotation per sample of each rectangular bin
+	QVector<double>			m_rotationImag;  // imaginary parts of the rotation per sample of each rectangular bin
+	QVector<float>			m_samples;  // samples of the window (intermediate result)
+	QVector<float>			m_oldSamples;  // samples that leave the window (intermediate result)
+	QVector<double>			m_difference;  // difference of the new and the leaving samples (intermediate result)
+};
+
+#endif // SLIDINGDFT_H
@@ -35,6 +35,7 @@ TriggerGenerator::TriggerGenerator(QString name, OSCNetworkManager* osc, bool is
 	, m_defaultMidFreq(midFreq)
 	, m_width(0.1)
 	, m_threshold(0.5)
+	, m_broadbandLevel(true)
 	, m_isActive(false)
 	, m_oscParameters()
     , m_filter(osc, m_oscParameters, m_mute)
@@ -58,14 +59,24 @@ void TriggerGenerator::setMute(bool mute)
     m_osc->sendMessage("/s2l/out/" + m_name + "/mute", (m_mute ? "1" : "0"), true);
 }
 
-bool TriggerGenerator::checkForTrigger(ScaledSpectrum &spectrum, bool forceRelease)
+bool TriggerGenerator::checkForTrigger(ScaledSpectrum &spectrum, const AudioLevels& levels, bool forceRelease)
 {
 	qreal value;
 	if (m_isBandpass) {
 		value = spectrum.getMaxLevel(m_midFreq, m_width);
-	} else {
+	} else if (!m_broadbandLevel) {
+		// level of presets saved before the broadband level was introduced:
 		value = spectrum.getMaxLevel();
+	} else {
+		// the block RMS is scaled to the amplitude of a sine with the same RMS,
+		// this is the level of the strongest band in the spectrum for a single tone:
+		value = spectrum.normalizeLevel(levels.rms * M_SQRT2);
 	}
+	return checkLevel(value, forceRelease);
+}
+
+bool TriggerGenerator::checkLevel(qreal value, bool forceRelease)
+{
 	if (m_invert) value = 1 - value;
 
     // check for trigger:
@@ -101,6 +112,8 @@ void TriggerGenerator::save(QSettings& settings) const
     settings.setValue(m_name + "/threshold", m_threshold);
 	settings.setValue(m_name + "/midFreq", m_midFreq);
 	settings.setValue(m_name + "/width", m_width);
+	settings.setValue(m_name + "/channel", m_channel);
+	settings.setValue(m_name + "/broadbandLevel", m_broadbandLevel);
 	m_filter.save(m_name, settings);
 	m_oscParameters.save(m_name, settings);
 }
@@ -111,6 +124,10 @@ void TriggerGenerator::restore(QSettings& settings)
 	setThreshold(settings.value(m_name + "/threshold").toReal());
 	setMidFreq(settings.value(m_name + "/midFreq").toReal());
 	setWidth(settings.value(m_name + "/width").toReal());
+	setChannel(settings.value(m_name + "/channel", -1).toInt());
+	// presets without this key were saved with thresholds for the spectrum level,
+	// they keep it because the broadband RMS would shift these thresholds:
+	m_broadbandLevel = settings.value(m_name + "/broadbandLevel", !settings.contains(m_name + "/threshold")).toBool();
 	m_filter.restore(m_name, settings);
     m_oscParameters.restore(m_name, settings);
 }
@@ -119,6 +136,8 @@ void TriggerGenerator::resetParameters()
 {
     setMidFreq(m_defaultMidFreq);
 	setWidth(0.1);
+	setChannel(-1);
+	m_broadbandLevel = true;
     m_mute = false;
 	if (m_isBandpass) {
 		setThreshold(0.5);
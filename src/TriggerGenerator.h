@@ -61,14 +61,14 @@ public:
 
 
 	// returns the middle frequency of the frequency band [20...22050]
-	int getMidFreq() const { return m_midFreq; }
+	int getMidFreq() const override { return m_midFreq; }
 
 	// sets the middle frequency of the frequency band [20...22050]
 	void setMidFreq(const int& value) { m_midFreq = limit(10, value, 22050); }
 
 
 	// returns the width of the frequency band [0...1]
-	qreal getWidth() const { return m_width; }
+	qreal getWidth() const override { return m_width; }
 
 	// sets the width of the frequency band ]0...1]
 	void setWidth(const qreal& value) { m_width = limit(0.00001, value, 1); }
@@ -80,6 +80,16 @@ public:
 	// sets the threshold that is used to generate the trigger [0...1]
 	void setThreshold(const qreal& value) { m_threshold = limit(0, value, 1); }
 
+	// returns true if the "level" / "envelope" trigger uses the broadband RMS of the input,
+	// false if it uses the max level of the spectrum (presets saved before the RMS was available)
+	bool getBroadbandLevel() const { return m_broadbandLevel; }
+
+	// sets if the "level" / "envelope" trigger uses the broadband RMS of the input (no effect for bandpass triggers)
+	void setBroadbandLevel(bool value) { m_broadbandLevel = value; }
+
+	// returns true if checkForTrigger() needs the spectrum of the channel
+	bool usesSpectrum() const override { return m_isBandpass || !m_broadbandLevel; }
+
 	// returns a reference to the internal TriggerFilter
 	TriggerFilter& getTriggerFilter() override { return m_filter; }
 
@@ -93,7 +103,11 @@ public:
 	qreal getCurrentLevel() const { return m_lastValue; }
 
 	// checks if the max level within the frequency band is greater than the threshold
-    bool checkForTrigger(ScaledSpectrum& spectrum, bool forceRelease) override;
+	// (the "level" / "envelope" trigger uses the block levels of the input instead of the spectrum)
+    bool checkForTrigger(ScaledSpectrum& spectrum, const AudioLevels& levels, bool forceRelease) override;
+
+	// checks if the given level of the frequency band is greater than the threshold
+	bool checkLevel(qreal value, bool forceRelease) override;
 
 	// ---------------- Save and Restore ---------------
 
@@ -115,6 +129,7 @@ protected:
 	const int		m_defaultMidFreq;  // default midFreq in Hz, used for reset
 	qreal			m_width;  // width of bandpass [0...1]
 	qreal			m_threshold;  // threshold for Trigger generation [0...1]
+	bool			m_broadbandLevel;  // true if a non-bandpass trigger uses the RMS of the input instead of the spectrum
 	bool			m_isActive;  // true if value is above threshold
 	qreal			m_lastValue;  // last value (used to check if new level message should be sent)
 	TriggerOscParameters m_oscParameters;  // OSC parameter object (stores OSC messages)
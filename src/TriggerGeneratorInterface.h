@@ -23,6 +23,8 @@
 
 #include "ScaledSpectrum.h"
 #include "TriggerFilter.h"
+#include "MonoAudioBuffer.h"
+#include "utils.h"
 
 #include <QObject>
 
@@ -37,12 +39,18 @@ class TriggerGeneratorInterface
 
 public:
     explicit TriggerGeneratorInterface(bool isBandpass)
-        : m_isBandpass(isBandpass) {}
+        : m_isBandpass(isBandpass)
+        , m_channel(-1) {}
 	virtual ~TriggerGeneratorInterface() {}
 
 	// checks if a signal should be triggered by analyzing the given spectrum
+	// or the levels of the blocks since the last check
     // forceRelease is true when low solo mode is active and a lower trigger was activated
-    virtual bool checkForTrigger(ScaledSpectrum& spectrum, bool forceRelease) = 0;
+    virtual bool checkForTrigger(ScaledSpectrum& spectrum, const AudioLevels& levels, bool forceRelease) = 0;
+
+	// checks if a signal should be triggered by a level that has been measured elsewhere
+	// (i.e. by a band-pass filter, in the normalized scale of the spectrum [0...1])
+	virtual bool checkLevel(qreal value, bool forceRelease) = 0;
 
 	// returns a reference to the internal TriggerFilter
 	virtual TriggerFilter& getTriggerFilter() = 0;
@@ -56,8 +64,24 @@ public:
     // returns if this is a Bandpass trigger generator
     bool isBandpass() const { return m_isBandpass; }
 
+	// returns true if checkForTrigger() needs the spectrum of the channel
+	virtual bool usesSpectrum() const { return m_isBandpass; }
+
+	// returns the middle frequency of the frequency band in Hz (used by bandpass triggers)
+	virtual int getMidFreq() const = 0;
+
+	// returns the width of the frequency band [0...1] (used by bandpass triggers)
+	virtual qreal getWidth() const = 0;
+
+	// returns the input channel whose spectrum is analyzed (-1 for the downmix of all channels)
+	int getChannel() const { return m_channel; }
+
+	// sets the input channel whose spectrum is analyzed [-1...MAX_ANALYSIS_CHANNELS-1]
+	void setChannel(int value) { m_channel = limit(-1, value, MAX_ANALYSIS_CHANNELS - 1); }
+
 protected:
     const bool m_isBandpass;  // true if this is a bandpass (with frequency and width parameter)
+    int m_channel;  // the analyzed input channel (-1 for the downmix)
 };
 
 
@@ -37,6 +37,8 @@ class TriggerGuiController : public QObject
 	Q_PROPERTY(qreal midFreq READ getMidFreq WRITE setMidFreq NOTIFY parameterChanged)
 	Q_PROPERTY(qreal width READ getWidth WRITE setWidth NOTIFY parameterChanged)
 	Q_PROPERTY(qreal threshold READ getThreshold WRITE setThreshold NOTIFY parameterChanged)
+	Q_PROPERTY(int channel READ getChannel WRITE setChannel NOTIFY parameterChanged)
+	Q_PROPERTY(bool broadbandLevel READ getBroadbandLevel WRITE setBroadbandLevel NOTIFY parameterChanged)
 	Q_PROPERTY(qreal onDelay READ getOnDelay NOTIFY parameterChanged)
 	Q_PROPERTY(qreal offDelay READ getOffDelay NOTIFY parameterChanged)
 	Q_PROPERTY(qreal maxHold READ getMaxHold NOTIFY parameterChanged)
@@ -79,6 +81,12 @@ public slots:
 	qreal getThreshold() const { return m_trigger->getThreshold(); }
 	void setThreshold(const qreal& value) { m_trigger->setThreshold(value); emit parameterChanged(); emit presetChanged(); }
 
+	int getChannel() const { return m_trigger->getChannel(); }
+	void setChannel(int value) { m_trigger->setChannel(value); emit parameterChanged(); emit presetChanged(); }
+
+	bool getBroadbandLevel() const { return m_trigger->getBroadbandLevel(); }
+	void setBroadbandLevel(bool value) { m_trigger->setBroadbandLevel(value); emit parameterChanged(); emit presetChanged(); }
+
 	qreal getCurrentLevel() const { return m_trigger->getCurrentLevel(); }
 
 
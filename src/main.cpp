@@ -19,8 +19,12 @@
 // THE SOFTWARE.
 
 #include "MainController.h"
+#include "FFTBenchmark.h"
+#include "STFT.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QCommandLineOption>
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
 #include <QIcon>
@@ -39,6 +43,37 @@ int main(int argc, char *argv[]) {
 	QCoreApplication::setApplicationName("Sound2Light");
 	QSettings::setDefaultFormat(QSettings::IniFormat);
 
+	// ----------- Command Line Options ------
+	QCommandLineParser parser;
+	parser.addHelpOption();
+	QCommandLineOption inputFileOption("input-file", "Analyze a WAV or raw PCM <file> instead of a sound card input.", "file");
+	QCommandLineOption inputStreamOption("input-stream", "Analyze raw PCM data from the standard input (-) or a named pipe <source>.", "source");
+	QCommandLineOption inputNetworkOption("input-network", "Analyze RTP or UDP PCM packets received on <source>, i.e. rtp:5004 or udp:239.69.1.1:5004.", "source");
+	QCommandLineOption rawFormatOption("raw-format", "Sample <format> of a raw PCM input file, stream or network input, i.e. s16le:2:44100.", "format");
+	QCommandLineOption fastOption("fast", "Process the input file as fast as possible instead of in realtime.");
+	QCommandLineOption quitAtEndOption("quit-at-end", "Quit when the input file or the standard input has been processed completely.");
+	QCommandLineOption jackOption("jack", "Use a JACK client as input instead of a sound card (requires a running JACK server).");
+	QCommandLineOption fixedPointOption("fixed-point", "Calculate the FFTs with integer arithmetic instead of floats.");
+	QCommandLineOption benchmarkFftOption("benchmark-fft", "Compare the speed of the FFT implementations available on this CPU and the precision of the fixed-point analysis and quit.");
+	parser.addOption(inputFileOption);
+	parser.addOption(inputStreamOption);
+	parser.addOption(inputNetworkOption);
+	parser.addOption(rawFormatOption);
+	parser.addOption(fastOption);
+	parser.addOption(quitAtEndOption);
+	parser.addOption(jackOption);
+	parser.addOption(fixedPointOption);
+	parser.addOption(benchmarkFftOption);
+	parser.process(app);
+
+	if (parser.isSet(benchmarkFftOption)) {
+		// (fails if the fixed-point analysis exceeds its tolerance)
+		return runFFTBenchmark() ? 0 : 1;
+	}
+
+	// (has to be set before the analysis is created)
+	STFT::setFixedPointEnabled(parser.isSet(fixedPointOption));
+
 	// ----------- Show Splash Screen --------
 	QPixmap pixmap(":/images/icons/etclogo.png");
 	QSplashScreen splash(pixmap);
@@ -53,6 +88,21 @@ int main(int argc, char *argv[]) {
 	QQmlApplicationEngine engine;
     MainController* controller = new MainController(&engine);
 
+	// use JACK, an input stream, a network input or an input file instead of a sound card if requested:
+	if (parser.isSet(jackOption) && !controller->useJackInput()) {
+		qWarning() << "JACK input not available, using the sound card.";
+	}
+	if (parser.isSet(inputStreamOption)) {
+		controller->useAudioStreamInput(parser.value(inputStreamOption), parser.value(rawFormatOption));
+	} else if (parser.isSet(inputNetworkOption)) {
+		controller->useNetworkInput(parser.value(inputNetworkOption), parser.value(rawFormatOption));
+	} else if (parser.isSet(inputFileOption)) {
+		controller->useAudioFileInput(parser.value(inputFileOption), parser.value(rawFormatOption), !parser.isSet(fastOption));
+	}
+	if (parser.isSet(quitAtEndOption)) {
+		QObject::connect(controller, SIGNAL(inputFinished()), &app, SLOT(quit()));
+	}
+
 	// set global QML variable "controller" to a pointer to the MainController:
     engine.rootContext()->setContextProperty("controller", controller);
 
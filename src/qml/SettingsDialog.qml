@@ -42,7 +42,7 @@ Dialog {
 
 	contentItem: Item {
 		implicitWidth: 270
-		implicitHeight: 400
+		implicitHeight: 430
 
 		DarkBlueStripedBackground {}
 
@@ -214,6 +214,37 @@ Dialog {
 				}
 			}
 
+			// ----------------------- FFT Profile ----------------------
+			Row {
+				width: parent.width
+				height: 30
+
+				CenterLabel {
+					width: parent.width  * 0.5
+					height: parent.height
+					text: "FFT Profile:"
+				}
+
+				DarkComboBox {
+					id: fftProfileComboBox
+					property var fftProfiles: ["Low Latency", "Balanced", "High Resolution"]
+					width: parent.width  * 0.5
+					height: parent.height
+					model: fftProfiles
+					currentIndex: fftProfiles.indexOf(controller.fftProfile)
+					onCurrentTextChanged: {
+						if (currentText && currentText !== controller.fftProfile) {
+							controller.setFftProfile(currentText)
+						}
+					}
+
+					Connections {
+						target: controller
+						onFftSizeChanged: fftProfileComboBox.currentIndex = fftProfileComboBox.fftProfiles.indexOf(controller.fftProfile)
+					}
+				}
+			}
+
 			// ----------------------- Input Device List ----------------------
 			GreyText {
 				width: parent.width
@@ -226,7 +257,7 @@ Dialog {
 			ExclusiveGroup { id: inputListGroup }
 			ScrollView {
 				width: parent.width
-				height: parent.height - 40*2 - 30*5 - 20 - (udpTxPort.visible ? 30 : 0)
+				height: parent.height - 40*2 - 30*6 - 20 - (udpTxPort.visible ? 30 : 0)
 				ListView {
 					id: inputList
 					model: controller.getAvailableInputs()
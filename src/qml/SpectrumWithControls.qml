@@ -210,7 +210,7 @@ Row {
 		// ------------------------- Gain and Compressor Sliders ---------------------
 		Row {
 			width: parent.width
-            height: parent.height - 30*3
+            height: parent.height - 30*4
 			// -------------------------- Gain
 			Column {
 				width: 80
@@ -277,7 +277,7 @@ Row {
 			}
 		}  // Row Gain and Compressor Sliders end
 
-        // ----------------------------- dB + AGC + LowSolo Checkbox -----------------------
+        // ----------------------------- dB + AGC + Power + LowSolo Checkbox -----------------------
 		DarkCheckBox {
 			id: agcCheckbox
 			width: parent.width - 20
@@ -306,6 +306,20 @@ Row {
 				onDecibelConversionChanged: dbCheckbox.checked = controller.decibelConversion
 			}
 		}
+		DarkCheckBox {
+			id: powerCheckbox
+			width: parent.width - 20
+			height: 30
+			x: 20
+			checked: controller.powerDomain
+			onCheckedChanged: if (checked !== controller.powerDomain) controller.setPowerDomain(checked)
+			text: "Power Spectrum"
+
+			Connections {
+				target: controller
+				onPowerDomainChanged: powerCheckbox.checked = controller.powerDomain
+			}
+		}
         DarkCheckBox {
             id: lowSoloCheckbox
             width: parent.width - 20
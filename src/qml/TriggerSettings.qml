@@ -101,9 +101,10 @@ Item {
 			id: details
 			visible: detailsVisible
 			width: parent.width
-            height: detailsVisible ? 30*6 : 0
+            height: detailsVisible ? 30*7 : 0
 
 			Column {  // ------------------ Frequency and Width - only visible if this is a Bandpass ---------
+				// (level source instead for the other triggers)
 				width: parent.width
 				height: 60
 				// ---------------------------- Frequency ----------------------
@@ -130,9 +131,31 @@ Item {
 					onValueChanged: if (Math.abs(triggerController.width - value / 10) > 0.01) triggerController.width = value / 10
 					visible: isBandpass
 				}
+				// ---------------------------- Level Source ----------------------
+				DarkButton {
+					width: parent.width
+					height: 30
+					// broadband RMS of the input or max level of the spectrum (presets saved before the RMS was available):
+					text: triggerController.broadbandLevel ? "Level: RMS" : "Level: Spectrum"
+					onClicked: triggerController.broadbandLevel = !triggerController.broadbandLevel
+					visible: !isBandpass
+				}
 			}
 
 
+			// ---------------------------- Input Channel ----------------------
+			NumericInput {
+				width: parent.width
+				height: 30
+				minimumValue: 0
+				maximumValue: controller.getMaxAnalysisChannels()
+				stepSize: 1
+				prefix: "Ch "
+				textReplacement: (value <= 0) ? "Mix" : ""
+				// 0 is the downmix of all channels, the channels are numbered from 1:
+				value: triggerController.channel + 1
+				onValueChanged: if (triggerController.channel !== value - 1) triggerController.channel = value - 1
+			}
 			// ---------------------------- On Delay ----------------------
 			NumericInput {
 				width: parent.width
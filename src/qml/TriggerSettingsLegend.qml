@@ -95,13 +95,16 @@ Column {
 		id: details
 		visible: detailsVisible
 		width: parent.width
-        height: detailsVisible ? 30*6 : 0  // 6 labels with 30px height each
+        height: detailsVisible ? 30*7 : 0  // 7 labels with 30px height each
 		CenterLabel {
 			text: "Frequency"
 		}
 		CenterLabel {
 			text: "Width [Oct.]"
 		}
+		CenterLabel {
+			text: "Input Channel"
+		}
 		CenterLabel {
 			text: "On Delay"
 		}
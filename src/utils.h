@@ -23,6 +23,7 @@
 
 #include <QtMath>
 #include <chrono>
+#include <cstdint>
 
 // This file includes some often used utility functions.
 
@@ -61,6 +62,29 @@ inline double getElapsedSecAndUpdate(time_point_t& lastTime) {
     return elapsedSeconds;
 }
 
+// Monotonic clock for timestamps and intervals,
+// it is not affected by changes of the system time (i.e. NTP adjustments during a show):
+
+typedef std::chrono::steady_clock::time_point monotonic_time_point_t;
+
+inline monotonic_time_point_t monotonicNow() {
+    return std::chrono::steady_clock::now();
+}
+
+inline double diff(monotonic_time_point_t end, monotonic_time_point_t start) {
+    std::chrono::duration<double> elapsed_seconds_duration = end - start;
+    return elapsed_seconds_duration.count();
+}
+
+// returns the time point in nanoseconds since the epoch of the clock (i.e. to store it in an atomic)
+inline int64_t toNanoseconds(monotonic_time_point_t time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+inline monotonic_time_point_t fromNanoseconds(int64_t nanoseconds) {
+    return monotonic_time_point_t(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(nanoseconds)));
+}
+
 }  // end namespace HighResTime -----------------
 
 
@@ -0,0 +1,21 @@
+# common settings of the unit tests,
+# each test compiles the sources of the units it tests from SRC_DIR
+
+QT += testlib
+QT -= gui
+
+CONFIG += c++11 thread console testcase
+CONFIG -= app_bundle
+
+QMAKE_CXXFLAGS += -Wall
+
+SRC_DIR = $$PWD/../src
+INCLUDEPATH += $$SRC_DIR
+
+# sources of the MonoAudioBuffer and the stages it applies while writing the samples
+AUDIO_BUFFER_SOURCES = \
+    $$SRC_DIR/MonoAudioBuffer.cpp \
+    $$SRC_DIR/PcmDecoder.cpp \
+    $$SRC_DIR/Resampler.cpp \
+    $$SRC_DIR/PreFilter.cpp \
+    $$SRC_DIR/CaptureClock.cpp
@@ -0,0 +1,19 @@
+# Unit tests of the Sound2Light processing chain
+# build and run with: qmake tests.pro && make check
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    tst_audiofileinput \
+    tst_bandfilterbank \
+    tst_captureclock \
+    tst_fixedpointanalysis \
+    tst_fixedpointfft \
+    tst_monoaudiobuffer \
+    tst_networkaudioinput \
+    tst_pcmdecoder \
+    tst_prefilter \
+    tst_resampler \
+    tst_rtpjitterbuffer \
+    tst_scaledspectrum \
+    tst_simdfft \
+    tst_slidingdft
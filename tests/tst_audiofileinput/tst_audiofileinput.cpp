@@ -0,0 +1,208 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "AudioFileInput.h"
+#include "MonoAudioBuffer.h"
+
+#include <QtTest>
+#include <QTemporaryFile>
+#include <QSignalSpy>
+#include <QtEndian>
+
+#include <cstring>
+
+
+// Tests the WAV / raw PCM file input with files that are written to a temporary directory.
+class TestAudioFileInput : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void wav16BitStereo();
+	void wavExtensibleFloat();
+	void wavOddChunk();
+	void rawFormat();
+
+protected:
+	// returns a RIFF WAVE file with the given format and sample data
+	// (extraChunkSize > 0 inserts an unknown chunk of that size before the fmt chunk)
+	static QByteArray createWav(quint16 formatTag, int channels, int sampleRate, int bitsPerSample,
+								const QByteArray& data, int extraChunkSize = 0);
+
+	// writes data to file and streams it into buffer as fast as possible
+	// returns the number of hops that have been processed
+	static int streamFile(QTemporaryFile& file, const QByteArray& data, MonoAudioBuffer& buffer, const QString& rawFormat = QString());
+};
+
+namespace {
+
+// appends a little endian value to data
+template<typename T>
+void append(QByteArray& data, T value)
+{
+	char bytes[sizeof(T)];
+	qToLittleEndian<T>(value, reinterpret_cast<uchar*>(bytes));
+	data.append(bytes, sizeof(T));
+}
+
+// number of hops per second used by the tests
+const int TEST_HOPS_PER_SECOND = 44;
+
+}  // namespace
+
+QByteArray TestAudioFileInput::createWav(quint16 formatTag, int channels, int sampleRate, int bitsPerSample,
+										 const QByteArray& data, int extraChunkSize)
+{
+	QByteArray fmt;
+	append<quint16>(fmt, formatTag);
+	append<quint16>(fmt, channels);
+	append<quint32>(fmt, sampleRate);
+	append<quint32>(fmt, sampleRate * channels * bitsPerSample / 8);
+	append<quint16>(fmt, channels * bitsPerSample / 8);
+	append<quint16>(fmt, bitsPerSample);
+	if (formatTag == 0xFFFE) {
+		// WAVE_FORMAT_EXTENSIBLE with the IEEE float sub format:
+		append<quint16>(fmt, 22);
+		append<quint16>(fmt, bitsPerSample);
+		append<quint32>(fmt, 0);
+		append<quint16>(fmt, 3);
+		fmt.append(QByteArray::fromHex("000000001000800000aa00389b71"));
+	}
+
+	QByteArray body("WAVE");
+	if (extraChunkSize > 0) {
+		body.append("LIST");
+		append<quint32>(body, extraChunkSize);
+		body.append(QByteArray(extraChunkSize + (extraChunkSize & 1), 'x'));
+	}
+	body.append("fmt ");
+	append<quint32>(body, fmt.size());
+	body.append(fmt);
+	body.append("data");
+	append<quint32>(body, data.size());
+	body.append(data);
+
+	QByteArray wav("RIFF");
+	append<quint32>(wav, body.size());
+	wav.append(body);
+	return wav;
+}
+
+int TestAudioFileInput::streamFile(QTemporaryFile& file, const QByteArray& data, MonoAudioBuffer& buffer, const QString& rawFormat)
+{
+	if (!file.open()) return 0;
+	file.write(data);
+	file.close();
+
+	// compare the samples without pre-filter:
+	buffer.setDcBlockerEnabled(false);
+
+	AudioFileInput input(&buffer, file.fileName(), TEST_HOPS_PER_SECOND, false);
+	if (!rawFormat.isEmpty() && !input.setRawFormat(rawFormat)) return 0;
+	QSignalSpy hopSpy(&input, SIGNAL(hopReady()));
+	QSignalSpy finishedSpy(&input, SIGNAL(finished()));
+	input.setInputByName(file.fileName());
+	if (input.getActiveInputName().isEmpty()) return 0;
+	if (!finishedSpy.wait(5000)) return 0;
+	return hopSpy.count();
+}
+
+void TestAudioFileInput::wav16BitStereo()
+{
+	// 1.5 hops of a ramp on the left and silence on the right channel:
+	const int numFrames = 1500;
+	QByteArray data;
+	for (int i=0; i<numFrames; ++i) {
+		append<qint16>(data, qint16(i * 16));
+		append<qint16>(data, 0);
+	}
+
+	QTemporaryFile file;
+	MonoAudioBuffer buffer(4096);
+	QCOMPARE(streamFile(file, createWav(1, 2, 44100, 16, data), buffer), 2);
+	QCOMPARE(buffer.getNumPutSamples(), int64_t(numFrames));
+	QCOMPARE(buffer.getSampleRate(), 44100);
+
+	// the channels are averaged:
+	for (int i=0; i<numFrames; ++i) {
+		QVERIFY(qAbs(buffer.atSampleNumber(i) - (float(i * 16) / 32768.0f / 2.0f)) < 1e-6f);
+	}
+}
+
+void TestAudioFileInput::wavExtensibleFloat()
+{
+	const int numFrames = 2000;
+	QByteArray data;
+	for (int i=0; i<numFrames; ++i) {
+		const float value = (i % 100) / 100.0f - 0.5f;
+		quint32 bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		append<quint32>(data, bits);
+	}
+
+	QTemporaryFile file;
+	MonoAudioBuffer buffer(4096);
+	QVERIFY(streamFile(file, createWav(0xFFFE, 1, 44100, 32, data), buffer) > 0);
+	QCOMPARE(buffer.getNumPutSamples(), int64_t(numFrames));
+	for (int i=0; i<numFrames; ++i) {
+		QVERIFY(qAbs(buffer.atSampleNumber(i) - ((i % 100) / 100.0f - 0.5f)) < 1e-6f);
+	}
+}
+
+void TestAudioFileInput::wavOddChunk()
+{
+	// an unknown chunk of odd size is padded and has to be skipped including the pad byte:
+	const int numFrames = 300;
+	QByteArray data;
+	for (int i=0; i<numFrames; ++i) {
+		append<quint8>(data, quint8(128 + (i % 64)));
+	}
+
+	QTemporaryFile file;
+	MonoAudioBuffer buffer(4096);
+	QVERIFY(streamFile(file, createWav(1, 1, 22050, 8, data, 7), buffer) > 0);
+	QCOMPARE(buffer.getNumPutSamples(), int64_t(numFrames));
+	QCOMPARE(buffer.getSampleRate(), 22050);
+	for (int i=0; i<numFrames; ++i) {
+		QVERIFY(qAbs(buffer.atSampleNumber(i) - ((i % 64) / 128.0f)) < 1e-6f);
+	}
+}
+
+void TestAudioFileInput::rawFormat()
+{
+	// a file without header is interpreted with the raw format:
+	const int numFrames = 4800;
+	QByteArray data;
+	for (int i=0; i<numFrames; ++i) {
+		append<qint16>(data, qint16(-i));
+	}
+
+	QTemporaryFile file;
+	MonoAudioBuffer buffer(8192);
+	buffer.setResamplingEnabled(false);
+	QCOMPARE(streamFile(file, data, buffer, "s16le:1:48000"), (numFrames + 48000 / TEST_HOPS_PER_SECOND - 1) / (48000 / TEST_HOPS_PER_SECOND));
+	QCOMPARE(buffer.getSampleRate(), 48000);
+	QCOMPARE(buffer.getNumPutSamples(), int64_t(numFrames));
+	QVERIFY(qAbs(buffer.atSampleNumber(numFrames - 1) - float(1 - numFrames) / 32768.0f) < 1e-6f);
+}
+
+QTEST_GUILESS_MAIN(TestAudioFileInput)
+
+#include "tst_audiofileinput.moc"
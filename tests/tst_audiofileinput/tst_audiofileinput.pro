@@ -0,0 +1,11 @@
+include(../tests.pri)
+
+TARGET = tst_audiofileinput
+
+QT += multimedia
+
+SOURCES += tst_audiofileinput.cpp \
+    $$AUDIO_BUFFER_SOURCES \
+    $$SRC_DIR/AudioFileInput.cpp
+
+HEADERS += $$SRC_DIR/AudioFileInput.h
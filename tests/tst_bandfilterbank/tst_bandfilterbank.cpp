@@ -0,0 +1,266 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "BandFilterBank.h"
+#include "BandFilterMeter.h"
+#include "MonoAudioBuffer.h"
+
+#include <QtTest>
+#include <QtMath>
+#include <QVector>
+
+
+// Tests the band-pass filters and envelopes of BandFilterBank
+// and the BandFilterMeter that runs them as block listener of a MonoAudioBuffer.
+class TestBandFilterBank : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void midFrequencyGain();
+	void offBandAttenuation();
+	void envelopeRelease();
+	void blockSizeIndependence();
+	void unusedBands();
+	void meterListensToBuffer();
+	void meterHoldsMaxLevel();
+	void meterFollowsSampleRate();
+
+protected:
+	// returns numSamples samples of a sine with frequency and amplitude at sampleRate
+	QVector<float> createSine(double frequency, float amplitude, int numSamples, int sampleRate = 44100) const;
+};
+
+namespace {
+
+// sample rate of the test signals
+const int TEST_SAMPLE_RATE = 44100;
+
+// the bands of the tests (middle frequencies in Hz and widths like the bandpass triggers)
+const int TEST_MID_FREQS[] = { 100, 1000, 5000 };
+const float TEST_WIDTHS[] = { 0.1f, 0.05f, 0.2f };
+const int TEST_NUM_BANDS = 3;
+
+// amplitude of the test sines
+const float TEST_AMPLITUDE = 0.5f;
+
+// largest deviation of the envelope of a sine at the middle frequency from its amplitude
+const float TEST_MAX_DEVIATION = 0.01f;
+
+}
+
+void TestBandFilterBank::midFrequencyGain()
+{
+	// the peak gain of each band is 1, so the envelope of a sine at the middle frequency is its amplitude:
+	for (int band=0; band<TEST_NUM_BANDS; ++band) {
+		BandFilterBank filters;
+		filters.setup(TEST_SAMPLE_RATE, TEST_MID_FREQS, TEST_WIDTHS, TEST_NUM_BANDS);
+		const QVector<float> sine = createSine(TEST_MID_FREQS[band], TEST_AMPLITUDE, TEST_SAMPLE_RATE);
+		float maxEnvelopes[BAND_FILTER_MAX_BANDS];
+		// (after the settling time, the envelope ripples between the peaks)
+		filters.process(sine.constData(), sine.size() / 2, maxEnvelopes);
+		filters.process(sine.constData() + sine.size() / 2, sine.size() / 2, maxEnvelopes);
+		QVERIFY2(qAbs(maxEnvelopes[band] - TEST_AMPLITUDE) < TEST_AMPLITUDE * TEST_MAX_DEVIATION,
+				 qPrintable(QString::number(maxEnvelopes[band])));
+		QVERIFY(filters.getEnvelope(band) > TEST_AMPLITUDE * 0.8f);
+	}
+}
+
+void TestBandFilterBank::offBandAttenuation()
+{
+	BandFilterBank filters;
+	filters.setup(TEST_SAMPLE_RATE, TEST_MID_FREQS, TEST_WIDTHS, TEST_NUM_BANDS);
+	// two octaves above the narrowest band and far below the others:
+	const QVector<float> sine = createSine(4000, TEST_AMPLITUDE, TEST_SAMPLE_RATE);
+	float maxEnvelopes[BAND_FILTER_MAX_BANDS];
+	filters.process(sine.constData(), sine.size(), maxEnvelopes);
+	QVERIFY(filters.getEnvelope(0) < TEST_AMPLITUDE * 0.05f);
+	QVERIFY(filters.getEnvelope(1) < TEST_AMPLITUDE * 0.2f);
+	// (4000Hz is inside the widest band, about a third of an octave below its middle frequency)
+	QVERIFY(filters.getEnvelope(2) > TEST_AMPLITUDE * 0.5f);
+}
+
+void TestBandFilterBank::envelopeRelease()
+{
+	BandFilterBank filters;
+	filters.setup(TEST_SAMPLE_RATE, TEST_MID_FREQS, TEST_WIDTHS, TEST_NUM_BANDS);
+	const QVector<float> sine = createSine(1000, TEST_AMPLITUDE, TEST_SAMPLE_RATE / 2);
+	float maxEnvelopes[BAND_FILTER_MAX_BANDS];
+	filters.process(sine.constData(), sine.size(), maxEnvelopes);
+	const float level = filters.getEnvelope(1);
+
+	// the envelope decays by 1/e per release time (4 periods of 1000Hz, at least BAND_FILTER_MIN_RELEASE_TIME)
+	// after the ringing of the filter:
+	const float releaseTime = qMax(BAND_FILTER_MIN_RELEASE_TIME, BAND_FILTER_RELEASE_PERIODS / 1000);
+	const QVector<float> silence(int(releaseTime * 10 * TEST_SAMPLE_RATE), 0.0f);
+	filters.process(silence.constData(), silence.size(), maxEnvelopes);
+	QVERIFY(filters.getEnvelope(1) < level * 0.01f);
+	QVERIFY(filters.getEnvelope(1) > 0.0f);
+	// (the max of the block is the level at its start)
+	QVERIFY(qAbs(maxEnvelopes[1] - level) < level * TEST_MAX_DEVIATION);
+
+	filters.reset();
+	QCOMPARE(filters.getEnvelope(1), 0.0f);
+}
+
+void TestBandFilterBank::blockSizeIndependence()
+{
+	const QVector<float> sine = createSine(1234, TEST_AMPLITUDE, 4096);
+	BandFilterBank reference;
+	reference.setup(TEST_SAMPLE_RATE, TEST_MID_FREQS, TEST_WIDTHS, TEST_NUM_BANDS);
+	float referenceMax[BAND_FILTER_MAX_BANDS];
+	reference.process(sine.constData(), sine.size(), referenceMax);
+
+	// the state is kept between the calls, so the blocks give the same results as a single call:
+	const int blockSizes[] = { 1, 7, 64, 1000 };
+	for (int blockSize: blockSizes) {
+		BandFilterBank filters;
+		filters.setup(TEST_SAMPLE_RATE, TEST_MID_FREQS, TEST_WIDTHS, TEST_NUM_BANDS);
+		float totalMax[BAND_FILTER_MAX_BANDS] = { };
+		for (int start=0; start<sine.size(); start += blockSize) {
+			float maxEnvelopes[BAND_FILTER_MAX_BANDS];
+			filters.process(sine.constData() + start, qMin(blockSize, sine.size() - start), maxEnvelopes);
+			for (int band=0; band<TEST_NUM_BANDS; ++band) {
+				totalMax[band] = qMax(totalMax[band], maxEnvelopes[band]);
+			}
+		}
+		for (int band=0; band<TEST_NUM_BANDS; ++band) {
+			QCOMPARE(filters.getEnvelope(band), reference.getEnvelope(band));
+			QCOMPARE(totalMax[band], referenceMax[band]);
+		}
+	}
+}
+
+void TestBandFilterBank::unusedBands()
+{
+	BandFilterBank filters;
+	QCOMPARE(filters.getNumBands(), 0);
+	filters.setup(TEST_SAMPLE_RATE, TEST_MID_FREQS, TEST_WIDTHS, 2);
+	QCOMPARE(filters.getNumBands(), 2);
+
+	// only the configured bands are written:
+	const QVector<float> sine = createSine(5000, TEST_AMPLITUDE, 1024);
+	float maxEnvelopes[BAND_FILTER_MAX_BANDS];
+	for (int band=0; band<BAND_FILTER_MAX_BANDS; ++band) {
+		maxEnvelopes[band] = -1.0f;
+	}
+	filters.process(sine.constData(), sine.size(), maxEnvelopes);
+	QVERIFY(maxEnvelopes[1] >= 0.0f);
+	QCOMPARE(maxEnvelopes[2], -1.0f);
+	QCOMPARE(filters.getEnvelope(2), 0.0f);
+
+	// without a sample rate no band is configured:
+	filters.setup(0, TEST_MID_FREQS, TEST_WIDTHS, TEST_NUM_BANDS);
+	QCOMPARE(filters.getNumBands(), 0);
+}
+
+void TestBandFilterBank::meterListensToBuffer()
+{
+	MonoAudioBuffer buffer(TEST_SAMPLE_RATE);
+	buffer.setInputSampleRate(TEST_SAMPLE_RATE);
+	buffer.setDcBlockerEnabled(false);
+	BandFilterMeter meter;
+	meter.setBands(TEST_MID_FREQS, TEST_WIDTHS, TEST_NUM_BANDS);
+	float levels[BAND_FILTER_MAX_BANDS];
+
+	// without the listener the meter sees no samples:
+	const QVector<float> sine = createSine(1000, TEST_AMPLITUDE, TEST_SAMPLE_RATE / 2);
+	buffer.putSamples(sine.constData(), sine.size());
+	meter.takeLevels(levels, TEST_NUM_BANDS);
+	QCOMPARE(levels[1], 0.0f);
+
+	buffer.setBlockListener(&meter);
+	buffer.putSamples(sine.constData(), sine.size());
+	meter.takeLevels(levels, TEST_NUM_BANDS);
+	QVERIFY(qAbs(levels[1] - TEST_AMPLITUDE) < TEST_AMPLITUDE * 0.05f);
+	QVERIFY(levels[0] < TEST_AMPLITUDE * 0.2f);
+
+	// the same bands keep the filters running:
+	meter.setBands(TEST_MID_FREQS, TEST_WIDTHS, TEST_NUM_BANDS);
+	const float silence[] = { 0.0f };
+	buffer.putSamples(silence, 1);
+	meter.takeLevels(levels, TEST_NUM_BANDS);
+	QVERIFY(levels[1] > TEST_AMPLITUDE * 0.9f);
+
+	// other bands reset them:
+	const int otherMidFreqs[] = { 200 };
+	meter.setBands(otherMidFreqs, TEST_WIDTHS, 1);
+	buffer.putSamples(silence, 1);
+	meter.takeLevels(levels, 1);
+	QCOMPARE(levels[0], 0.0f);
+
+	buffer.setBlockListener(nullptr);
+}
+
+void TestBandFilterBank::meterHoldsMaxLevel()
+{
+	BandFilterMeter meter;
+	meter.setBands(TEST_MID_FREQS, TEST_WIDTHS, TEST_NUM_BANDS);
+	const QVector<float> sine = createSine(1000, TEST_AMPLITUDE, TEST_SAMPLE_RATE / 2);
+	meter.samplesWritten(sine.constData(), sine.size(), TEST_SAMPLE_RATE);
+	const QVector<float> silence(TEST_SAMPLE_RATE / 2, 0.0f);
+	meter.samplesWritten(silence.constData(), silence.size(), TEST_SAMPLE_RATE);
+
+	// a peak between two checks is not missed:
+	float levels[BAND_FILTER_MAX_BANDS];
+	meter.takeLevels(levels, TEST_NUM_BANDS);
+	QVERIFY(qAbs(levels[1] - TEST_AMPLITUDE) < TEST_AMPLITUDE * 0.05f);
+	// and only reported once:
+	meter.takeLevels(levels, TEST_NUM_BANDS);
+	QVERIFY(levels[1] < TEST_AMPLITUDE * 0.01f);
+}
+
+void TestBandFilterBank::meterFollowsSampleRate()
+{
+	BandFilterMeter meter;
+	meter.setBands(TEST_MID_FREQS, TEST_WIDTHS, TEST_NUM_BANDS);
+	float levels[BAND_FILTER_MAX_BANDS];
+
+	// the filters are designed again for a new sample rate, so the band keeps its frequency:
+	const int sampleRates[] = { TEST_SAMPLE_RATE, 96000, 22050 };
+	for (int sampleRate: sampleRates) {
+		const QVector<float> sine = createSine(1000, TEST_AMPLITUDE, sampleRate / 2, sampleRate);
+		meter.samplesWritten(sine.constData(), sine.size(), sampleRate);
+		meter.takeLevels(levels, TEST_NUM_BANDS);
+		meter.samplesWritten(sine.constData(), sine.size(), sampleRate);
+		meter.takeLevels(levels, TEST_NUM_BANDS);
+		QVERIFY2(qAbs(levels[1] - TEST_AMPLITUDE) < TEST_AMPLITUDE * 0.05f, qPrintable(QString::number(sampleRate)));
+	}
+
+	// no bands disable the filters:
+	meter.setBands(nullptr, nullptr, 0);
+	const QVector<float> sine = createSine(1000, TEST_AMPLITUDE, 1024);
+	meter.samplesWritten(sine.constData(), sine.size(), TEST_SAMPLE_RATE);
+	meter.takeLevels(levels, TEST_NUM_BANDS);
+	QCOMPARE(levels[1], 0.0f);
+}
+
+QVector<float> TestBandFilterBank::createSine(double frequency, float amplitude, int numSamples, int sampleRate) const
+{
+	QVector<float> samples(numSamples);
+	for (int i=0; i<numSamples; ++i) {
+		samples[i] = amplitude * float(qSin(2 * M_PI * frequency * i / sampleRate));
+	}
+	return samples;
+}
+
+QTEST_APPLESS_MAIN(TestBandFilterBank)
+
+#include "tst_bandfilterbank.moc"
@@ -0,0 +1,10 @@
+include(../tests.pri)
+
+QT += multimedia
+
+TARGET = tst_bandfilterbank
+
+SOURCES += tst_bandfilterbank.cpp \
+    $$SRC_DIR/BandFilterBank.cpp \
+    $$SRC_DIR/BandFilterMeter.cpp \
+    $$AUDIO_BUFFER_SOURCES
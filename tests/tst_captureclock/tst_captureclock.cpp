@@ -0,0 +1,188 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "CaptureClock.h"
+
+#include <QtTest>
+
+#include <random>
+
+
+// Tests the dropout detection of CaptureClock with simulated arrival times of the blocks.
+class TestCaptureClock : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void steadyStream();
+	void lostSamples();
+	void lateDelivery();
+	void stallWithLoss();
+	void notRealtime();
+};
+
+namespace {
+
+// sample rate of the simulated inputs
+const int TEST_SAMPLE_RATE = 44100;
+
+// Simulates an input that delivers blocks of blockSize frames.
+// The audio clock runs at 1 + drift times the speed of the system clock
+// and each block is delivered with a random delay of up to jitter blocks.
+class InputSimulation
+{
+public:
+	InputSimulation(CaptureClock& clock, int blockSize, double drift, double jitter)
+		: m_clock(clock)
+		, m_blockSize(blockSize)
+		, m_blockDuration(double(blockSize) / TEST_SAMPLE_RATE / (1 + drift))
+		, m_jitter(jitter)
+		, m_startTime(HighResTime::monotonicNow())
+		, m_captureTime(0)
+		, m_random(42)
+	{
+		m_clock.start(TEST_SAMPLE_RATE, true);
+	}
+
+	// captures and delivers the blocks of the next duration seconds
+	void run(double duration) {
+		const double end = m_captureTime + duration;
+		while (m_captureTime < end) {
+			m_captureTime += m_blockDuration;
+			deliver(m_captureTime + m_jitter * m_blockDuration * m_distribution(m_random));
+		}
+	}
+
+	// loses the blocks of the next duration seconds (captured, but never delivered)
+	void lose(double duration) {
+		m_captureTime += qRound(duration / m_blockDuration) * m_blockDuration;
+	}
+
+	// captures the blocks of the next duration seconds and delivers all of them at the end
+	void stall(double duration) {
+		const int numBlocks = qRound(duration / m_blockDuration);
+		const double deliveryTime = m_captureTime + numBlocks * m_blockDuration;
+		for (int i=0; i<numBlocks; ++i) {
+			m_captureTime += m_blockDuration;
+			deliver(deliveryTime + i * 0.00001);
+		}
+	}
+
+protected:
+	void deliver(double time) {
+		m_clock.addBlock(m_blockSize, m_startTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(time)));
+	}
+
+	CaptureClock&								m_clock;
+	const int									m_blockSize;
+	const double								m_blockDuration;
+	const double								m_jitter;
+	const HighResTime::monotonic_time_point_t	m_startTime;
+	double										m_captureTime;
+	std::mt19937								m_random;
+	std::uniform_real_distribution<double>		m_distribution;
+};
+
+}  // namespace
+
+void TestCaptureClock::steadyStream()
+{
+	// the drift of the clocks and a jitter of almost one block are no dropouts:
+	const double drifts[] = { -0.0005, 0.0, 0.0005 };
+	for (double drift: drifts) {
+		CaptureClock clock;
+		InputSimulation input(clock, 256, drift, 0.9);
+		input.run(600.0);
+		QCOMPARE(clock.getNumOverruns(), 0);
+		QCOMPARE(clock.getNumUnderruns(), 0);
+	}
+
+	// large blocks of a driver with a long buffer:
+	CaptureClock clock;
+	InputSimulation input(clock, 4096, 0.0002, 0.5);
+	input.run(60.0);
+	QCOMPARE(clock.getNumOverruns(), 0);
+	QCOMPARE(clock.getNumUnderruns(), 0);
+}
+
+void TestCaptureClock::lostSamples()
+{
+	// short dropouts are detected if they are longer than the tolerance (1.5 blocks + 2ms):
+	const int blockSizes[] = { 128, 256, 256, 256 };
+	const double durations[] = { 0.015, 0.02, 0.15, 1.0 };
+	for (int i=0; i<4; ++i) {
+		CaptureClock clock;
+		InputSimulation input(clock, blockSizes[i], 0.0002, 0.5);
+		input.run(10.0);
+		input.lose(durations[i]);
+		input.run(10.0);
+		QCOMPARE(clock.getNumOverruns(), 1);
+		QCOMPARE(clock.getNumUnderruns(), 0);
+		QVERIFY2(qAbs(clock.getNumLostSamples() - durations[i] * TEST_SAMPLE_RATE) <= blockSizes[i],
+				 qPrintable(QString("%1s: %2 samples").arg(durations[i]).arg(clock.getNumLostSamples())));
+	}
+}
+
+void TestCaptureClock::lateDelivery()
+{
+	// blocks that are delivered late, but completely, are an underrun only:
+	const double durations[] = { 0.02, 0.1, 0.5 };
+	for (double duration: durations) {
+		CaptureClock clock;
+		InputSimulation input(clock, 256, 0.0, 0.5);
+		input.run(10.0);
+		input.stall(duration);
+		input.run(10.0);
+		QCOMPARE(clock.getNumOverruns(), 0);
+		QCOMPARE(clock.getNumUnderruns(), 1);
+		QCOMPARE(clock.getNumLostSamples(), int64_t(0));
+	}
+}
+
+void TestCaptureClock::stallWithLoss()
+{
+	// a stall after which only a part of the samples is delivered is counted once as overrun:
+	CaptureClock clock;
+	InputSimulation input(clock, 256, 0.0, 0.5);
+	input.run(10.0);
+	input.lose(0.15);
+	input.stall(0.15);
+	input.run(10.0);
+	QCOMPARE(clock.getNumOverruns(), 1);
+	QCOMPARE(clock.getNumUnderruns(), 0);
+	QVERIFY(qAbs(clock.getNumLostSamples() - 0.15 * TEST_SAMPLE_RATE) <= 256);
+}
+
+void TestCaptureClock::notRealtime()
+{
+	// inputs that are not bound to the wall clock are not checked:
+	CaptureClock clock;
+	clock.start(TEST_SAMPLE_RATE, false);
+	const HighResTime::monotonic_time_point_t now = HighResTime::monotonicNow();
+	for (int i=0; i<100; ++i) {
+		clock.addBlock(4096, now);
+	}
+	QCOMPARE(clock.getNumOverruns(), 0);
+	QCOMPARE(clock.getNumUnderruns(), 0);
+}
+
+QTEST_APPLESS_MAIN(TestCaptureClock)
+
+#include "tst_captureclock.moc"
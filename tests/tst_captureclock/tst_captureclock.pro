@@ -0,0 +1,6 @@
+include(../tests.pri)
+
+TARGET = tst_captureclock
+
+SOURCES += tst_captureclock.cpp \
+    $$SRC_DIR/CaptureClock.cpp
@@ -0,0 +1,239 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "FFTAnalyzer.h"
+#include "MonoAudioBuffer.h"
+#include "STFT.h"
+#include "ScaledSpectrum.h"
+#include "TriggerGenerator.h"
+
+#include <QtTest>
+#include <QtMath>
+#include <QVector>
+
+
+// Compares the trigger decisions of the fixed-point analysis (see STFT::setFixedPointEnabled())
+// with those of the float analysis: both STFTs analyze the same synthetic material,
+// their spectra go through a ScaledSpectrum each and are checked by the same set of TriggerGenerators.
+class TestFixedPointAnalysis : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void triggerDecisions();
+
+protected:
+	// the settings of the ScaledSpectrum that change how the trigger levels are calculated
+	struct SpectrumMode
+	{
+		const char*	name;  // name of the mode for the messages
+		bool		powerDomain;  // see ScaledSpectrum::setPowerDomain()
+		bool		decibel;  // see ScaledSpectrum::setDecibelConversion()
+		float		gain;  // see ScaledSpectrum::setGain()
+		float		compression;  // see ScaledSpectrum::setCompression()
+		bool		agc;  // see ScaledSpectrum::setAgcEnabled()
+	};
+
+	// the result of the analysis of the material in one mode
+	struct Analysis
+	{
+		QVector<float>	thresholds;  // threshold of each trigger
+		QVector<float>	levels;  // level of each trigger in each frame
+		QVector<bool>	decisions;  // true if the trigger is active (for each trigger in each frame)
+	};
+
+	// returns the test material (kicks, chords, noise bursts, quiet passages, silence, a sweep, fades)
+	QVector<float> createMaterial() const;
+
+	// analyzes buffer with the float or the fixed-point STFT in mode and checks the triggers after each frame
+	Analysis analyze(const MonoAudioBuffer& buffer, bool fixedPoint, const SpectrumMode& mode) const;
+};
+
+namespace {
+
+// sample rate of the test material
+const int TEST_SAMPLE_RATE = 44100;
+
+// the bands of the tested triggers (middle frequency in Hz and width)
+const int TEST_MID_FREQS[] = { 60, 440, 2000, 8000 };
+const qreal TEST_WIDTHS[] = { 0.1, 0.1, 0.15, 0.2 };
+const int TEST_NUM_BANDS = 4;
+
+// the thresholds of the tested triggers (each band is tested with all of them)
+const qreal TEST_THRESHOLDS[] = { 0.1, 0.3, 0.5, 0.7, 0.9 };
+
+}
+
+void TestFixedPointAnalysis::triggerDecisions()
+{
+	const QVector<float> material = createMaterial();
+	MonoAudioBuffer buffer(material.size());
+	buffer.setInputSampleRate(TEST_SAMPLE_RATE);
+	buffer.setDcBlockerEnabled(false);
+	buffer.putSamples(material.constData(), material.size());
+
+	const SpectrumMode modes[] = {
+		{ "magnitude", false, false, 1.0f, 1.0f, false },
+		{ "magnitude dB", false, true, 1.0f, 1.0f, false },
+		{ "power", true, false, 1.0f, 1.0f, false },
+		{ "power dB", true, true, 1.0f, 1.0f, false },
+		{ "magnitude AGC", false, false, 1.0f, 1.0f, true },
+		{ "power dB AGC", true, true, 1.0f, 1.0f, true },
+		{ "magnitude gain 4", false, false, 4.0f, 1.0f, false },
+		{ "magnitude dB gain 2", false, true, 2.0f, 1.0f, false },
+		{ "magnitude compression 2", false, false, 1.0f, 2.0f, false },
+		{ "power compression 3", true, false, 1.0f, 3.0f, false },
+		{ "magnitude compression 10", false, false, 1.0f, 10.0f, false },
+		{ "power dB compression 0.5", true, true, 1.0f, 0.5f, false },
+	};
+	for (const SpectrumMode& mode: modes) {
+		const Analysis floatAnalysis = analyze(buffer, false, mode);
+		const Analysis fixedPointAnalysis = analyze(buffer, true, mode);
+		QCOMPARE(fixedPointAnalysis.levels.size(), floatAnalysis.levels.size());
+
+		// the documented tolerance of the levels (see FIXED_POINT_LEVEL_TOLERANCE),
+		// a compression above 1 raises the levels to the power of 1 / compression:
+		const float tolerance = mode.compression <= 1.0f ? mode.gain * FIXED_POINT_LEVEL_TOLERANCE
+				: qPow(mode.gain * FIXED_POINT_FFT_TOLERANCE, 1.0f / mode.compression);
+		int numActive = 0;
+		for (int i=0; i<floatAnalysis.levels.size(); ++i) {
+			const int trigger = i % floatAnalysis.thresholds.size();
+			const float level = floatAnalysis.levels[i];
+			const float deviation = qAbs(fixedPointAnalysis.levels[i] - level);
+			QVERIFY2(deviation <= tolerance,
+					 qPrintable(QString("%1: level %2 deviates by %3").arg(mode.name).arg(level).arg(deviation)));
+			// a decision can only differ if the level is within the tolerance of the threshold:
+			const float threshold = floatAnalysis.thresholds[trigger];
+			QVERIFY2(fixedPointAnalysis.decisions[i] == floatAnalysis.decisions[i] || qAbs(level - threshold) <= tolerance,
+					 qPrintable(QString("%1: different decision at level %2 (threshold %3)").arg(mode.name).arg(level).arg(threshold)));
+			if (floatAnalysis.decisions[i]) ++numActive;
+		}
+		// (the material switches the triggers on and off in all modes)
+		QVERIFY2(numActive > 0 && numActive < floatAnalysis.decisions.size(), mode.name);
+	}
+}
+
+QVector<float> TestFixedPointAnalysis::createMaterial() const
+{
+	const int second = TEST_SAMPLE_RATE;
+	QVector<float> material(8 * second, 0.0f);
+	quint32 random = 1;
+	for (int i=0; i<material.size(); ++i) {
+		random = random * 1664525u + 1013904223u;
+		const double noise = (random >> 8) / double(1 << 24) - 0.5;
+		const double t = double(i) / TEST_SAMPLE_RATE;
+		const int segment = i / second;
+		const double s = t - segment;  // time within the segment
+		double value = 0;
+		switch (segment) {
+		case 0: {
+			// kicks every 250ms:
+			const double hit = std::fmod(s, 0.25);
+			value = 0.8 * qExp(-hit * 20) * qSin(2 * M_PI * 55 * hit);
+			break;
+		}
+		case 1: {
+			// a chord fading in from -60dB to -6dB:
+			const double amplitude = 0.001 * qPow(500, s);
+			value = amplitude / 3 * (qSin(2 * M_PI * 220 * t) + qSin(2 * M_PI * 440 * t) + qSin(2 * M_PI * 660 * t));
+			break;
+		}
+		case 2:
+			// noise bursts of 30ms every 125ms:
+			value = std::fmod(s, 0.125) < 0.03 ? 0.6 * noise : 0.0;
+			break;
+		case 3:
+			// a quiet passage (a tone at -66dB and noise at -80dB):
+			value = 0.0005 * qSin(2 * M_PI * 2000 * t) + 0.0002 * noise;
+			break;
+		case 4:
+			// silence
+			break;
+		case 5:
+			// a sweep from 50Hz to 12800Hz:
+			value = 0.3 * qSin(2 * M_PI * 50 * (qPow(256, s) - 1) / qLn(256));
+			break;
+		case 6:
+			// almost full scale:
+			value = 0.6 * qSin(2 * M_PI * 100 * t) + 0.35 * qSin(2 * M_PI * 3000 * t);
+			break;
+		default:
+			// noise fading out from -6dB to -100dB:
+			value = noise * qPow(10, -5 * s);
+			break;
+		}
+		material[i] = float(value);
+	}
+	return material;
+}
+
+TestFixedPointAnalysis::Analysis TestFixedPointAnalysis::analyze(const MonoAudioBuffer& buffer, bool fixedPoint, const SpectrumMode& mode) const
+{
+	// (the arithmetic is chosen when the STFT is created)
+	STFT::setFixedPointEnabled(fixedPoint);
+	STFT stft(NUM_SAMPLES_EXPONENT, double(TEST_SAMPLE_RATE) / FFT_HOP_RATE);
+	STFT::setFixedPointEnabled(false);
+	stft.setSpectrumType(mode.powerDomain ? PowerSpectrum : MagnitudeSpectrum);
+
+	ScaledSpectrum spectrum(SCALED_SPECTRUM_BASE_FREQ, SCALED_SPECTRUM_LENGTH);
+	spectrum.setSampleRate(TEST_SAMPLE_RATE);
+	spectrum.setFftSize(stft.getSize());
+	spectrum.setPowerDomain(mode.powerDomain);
+	spectrum.setDecibelConversion(mode.decibel);
+	spectrum.setGain(mode.gain);
+	spectrum.setCompression(mode.compression);
+	spectrum.setAgcEnabled(mode.agc);
+
+	// (the triggers have no OSC messages, so they don't need an OSCNetworkManager)
+	Analysis analysis;
+	QVector<TriggerGenerator*> triggers;
+	for (int band=0; band<TEST_NUM_BANDS; ++band) {
+		for (qreal threshold: TEST_THRESHOLDS) {
+			TriggerGenerator* trigger = new TriggerGenerator("test", nullptr, true, false, TEST_MID_FREQS[band]);
+			trigger->setWidth(TEST_WIDTHS[band]);
+			trigger->setThreshold(threshold);
+			triggers.append(trigger);
+			analysis.thresholds.append(float(threshold));
+		}
+	}
+
+	// the linear spectrum is scaled like in FFTAnalyzer::processFrame():
+	const float scale = mode.powerDomain ? 0.01f : 0.1f;
+	QVector<float> linear(stft.getSize() / 2);
+	const AudioLevels levels = AudioLevels();
+	for (int64_t frameEnd=stft.getSize(); frameEnd<=buffer.getNumPutSamples(); frameEnd+=int64_t(stft.getHopSize())) {
+		stft.processFrameAt(buffer, frameEnd);
+		for (int i=0; i<linear.size(); ++i) {
+			linear[i] = stft.getSpectrum()[i] * scale;
+		}
+		linear[0] = 0.0f;
+		spectrum.updateWithLinearSpectrum(linear);
+		for (TriggerGenerator* trigger: triggers) {
+			analysis.decisions.append(trigger->checkForTrigger(spectrum, levels, false));
+			analysis.levels.append(float(trigger->getCurrentLevel()));
+		}
+	}
+	qDeleteAll(triggers);
+	return analysis;
+}
+
+QTEST_APPLESS_MAIN(TestFixedPointAnalysis)
+
+#include "tst_fixedpointanalysis.moc"
@@ -0,0 +1,24 @@
+include(../tests.pri)
+
+QT += multimedia network
+
+TARGET = tst_fixedpointanalysis
+
+SOURCES += tst_fixedpointanalysis.cpp \
+    $$SRC_DIR/STFT.cpp \
+    $$SRC_DIR/FixedPointFFT.cpp \
+    $$SRC_DIR/SimdFFT.cpp \
+    $$SRC_DIR/SimdFFTSse2.cpp \
+    $$SRC_DIR/SimdFFTAvx2.cpp \
+    $$SRC_DIR/SimdFFTNeon.cpp \
+    $$SRC_DIR/ScaledSpectrum.cpp \
+    $$SRC_DIR/TriggerGenerator.cpp \
+    $$SRC_DIR/TriggerFilter.cpp \
+    $$SRC_DIR/TriggerOscParameters.cpp \
+    $$SRC_DIR/OSCNetworkManager.cpp \
+    $$SRC_DIR/OSCParser.cpp \
+    $$SRC_DIR/OSCMessage.cpp \
+    $$AUDIO_BUFFER_SOURCES
+
+HEADERS += $$SRC_DIR/TriggerFilter.h \
+    $$SRC_DIR/OSCNetworkManager.h
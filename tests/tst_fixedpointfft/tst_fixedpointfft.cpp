@@ -0,0 +1,291 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "FixedPointFFT.h"
+
+#include <QtTest>
+#include <QtMath>
+#include <QVector>
+
+#include <cmath>
+
+
+// Tests the integer arithmetic of FixedPointFFT against a DFT in double precision.
+class TestFixedPointFFT : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void q31Conversion();
+	void squareRoot();
+	void fftMatchesDft();
+	void fullScaleInput();
+	void applyWindow();
+	void spectrum();
+
+protected:
+	// returns a test signal of size samples within -1...1 (noise and a few sines)
+	QVector<float> createSignal(int size) const;
+
+	// returns the DFT of input in the format of FFTReal (see FixedPointFFT)
+	QVector<double> calculateDft(const QVector<float>& input) const;
+
+	// returns the largest deviation of output from expected relative to the largest value of expected
+	double maxRelativeDeviation(const float* output, const QVector<double>& expected) const;
+};
+
+namespace {
+
+// range of the tested FFT sizes as exponents of 2
+const int TEST_MIN_SIZE_EXPONENT = FIXED_POINT_FFT_MIN_SIZE_EXPONENT;
+const int TEST_MAX_SIZE_EXPONENT = 12;
+
+// largest deviation of a FFT from the DFT relative to the largest value
+const double TEST_MAX_FFT_DEVIATION = 1e-6;
+
+// largest relative deviation of magnitudes and powers of the loud bins
+const double TEST_MAX_SPECTRUM_DEVIATION = 1e-5;
+
+// largest deviation of a power in dB of the loud bins
+const double TEST_MAX_DB_DEVIATION = 1e-3;
+
+// value of 1.0 in Q31
+const double TEST_Q31_ONE = 2147483648.0;
+
+}
+
+void TestFixedPointFFT::q31Conversion()
+{
+	QCOMPARE(FixedPointFFT::toQ31(0.5), int32_t(1 << 30));
+	QCOMPARE(FixedPointFFT::toQ31(-1.0), std::numeric_limits<int32_t>::min());
+	// (1 is saturated)
+	QCOMPARE(FixedPointFFT::toQ31(1.0), std::numeric_limits<int32_t>::max());
+
+	// samples are halved and limited to -1...1:
+	QCOMPARE(FixedPointFFT::halfToQ31(1.0f), int32_t(1 << 30));
+	QCOMPARE(FixedPointFFT::halfToQ31(-3.0f), int32_t(-(1 << 30)));
+	QCOMPARE(FixedPointFFT::halfToQ31(0.25f), int32_t(1 << 28));
+
+	// products are rounded:
+	QCOMPARE(FixedPointFFT::multiply(1 << 30, 1 << 30), int32_t(1 << 29));
+	QCOMPARE(FixedPointFFT::multiply(3, 1 << 30), int32_t(2));
+	QCOMPARE(FixedPointFFT::multiply(-(1 << 30), FixedPointFFT::toQ31(0.5)), int32_t(-(1 << 29)));
+}
+
+void TestFixedPointFFT::squareRoot()
+{
+	QCOMPARE(FixedPointFFT::squareRoot(0), uint32_t(0));
+	QCOMPARE(FixedPointFFT::squareRoot(1), uint32_t(1));
+	QCOMPARE(FixedPointFFT::squareRoot(2), uint32_t(1));
+	QCOMPARE(FixedPointFFT::squareRoot(3), uint32_t(2));
+	QCOMPARE(FixedPointFFT::squareRoot(16), uint32_t(4));
+	// the largest power of a bin (two squares of -2^31):
+	QCOMPARE(FixedPointFFT::squareRoot(uint64_t(1) << 63), uint32_t(3037000500u));
+
+	// all values up to beyond the first ones estimated with the table:
+	for (uint64_t value=0; value < 4096; ++value) {
+		const long double expected = std::floor(std::sqrt((long double)value) + 0.5L);
+		QVERIFY2(FixedPointFFT::squareRoot(value) == uint32_t(expected),
+				 qPrintable(QString("root of %1").arg(double(value))));
+	}
+
+	// the squares and the rounding limits next to them at the powers of 4:
+	for (int exponent=4; exponent<=31; ++exponent) {
+		const uint64_t roots[] = { (uint64_t(1) << exponent) - 1, uint64_t(1) << exponent, (uint64_t(1) << exponent) + 1 };
+		for (uint64_t root: roots) {
+			if (root * root > (uint64_t(1) << 63)) continue;
+			QCOMPARE(FixedPointFFT::squareRoot(root * root - 1), uint32_t(root));
+			QCOMPARE(FixedPointFFT::squareRoot(root * root), uint32_t(root));
+			QCOMPARE(FixedPointFFT::squareRoot(root * root + root), uint32_t(root));
+			if (root * root + root + 1 <= (uint64_t(1) << 63)) {
+				QCOMPARE(FixedPointFFT::squareRoot(root * root + root + 1), uint32_t(root + 1));
+			}
+		}
+	}
+
+	quint64 random = 1;
+	for (int i=0; i<10000; ++i) {
+		random = random * 6364136223846793005ull + 1442695040888963407ull;
+		const uint64_t value = random >> (1 + i % 60);
+		const long double expected = std::floor(std::sqrt((long double)value) + 0.5L);
+		QVERIFY2(FixedPointFFT::squareRoot(value) == uint32_t(expected),
+				 qPrintable(QString("root of %1").arg(double(value))));
+	}
+}
+
+void TestFixedPointFFT::fftMatchesDft()
+{
+	for (int exponent=TEST_MIN_SIZE_EXPONENT; exponent<=TEST_MAX_SIZE_EXPONENT; ++exponent) {
+		const QVector<float> input = createSignal(1 << exponent);
+		QVector<float> output(input.size());
+		FixedPointFFT fft(exponent);
+		QCOMPARE(fft.getSize(), input.size());
+		fft.doFft(output.data(), input.data());
+		const double deviation = maxRelativeDeviation(output.data(), calculateDft(input));
+		QVERIFY2(deviation < TEST_MAX_FFT_DEVIATION,
+				 qPrintable(QString("%1 samples: deviation %2").arg(input.size()).arg(deviation)));
+	}
+}
+
+void TestFixedPointFFT::fullScaleInput()
+{
+	// the halved passes can't overflow, even with the largest values in all samples:
+	const int exponent = TEST_MAX_SIZE_EXPONENT;
+	const int size = 1 << exponent;
+	FixedPointFFT fft(exponent);
+	QVector<float> output(size);
+
+	// DC (all energy in bin 0, samples beyond full scale are clipped):
+	QVector<float> input(size, 1.0f);
+	input[7] = 2.0f;
+	fft.doFft(output.data(), input.data());
+	QVERIFY(qAbs(output[0] - size) < size * TEST_MAX_FFT_DEVIATION);
+	for (int i=1; i<size; ++i) {
+		QVERIFY(qAbs(output[i]) < size * TEST_MAX_FFT_DEVIATION);
+	}
+
+	// a square wave at the Nyquist frequency (all energy in bin size/2):
+	for (int i=0; i<size; ++i) {
+		input[i] = i % 2 ? -1.0f : 1.0f;
+	}
+	fft.doFft(output.data(), input.data());
+	QVERIFY(qAbs(output[size / 2] - size) < size * TEST_MAX_FFT_DEVIATION);
+	QVERIFY(qAbs(output[0]) < size * TEST_MAX_FFT_DEVIATION);
+
+	// other full scale signals match the DFT:
+	for (int i=0; i<size; ++i) {
+		input[i] = i % 3 ? -1.0f : 1.0f;
+	}
+	fft.doFft(output.data(), input.data());
+	QVERIFY(maxRelativeDeviation(output.data(), calculateDft(input)) < TEST_MAX_FFT_DEVIATION);
+}
+
+void TestFixedPointFFT::applyWindow()
+{
+	const int size = 256;
+	const QVector<float> input = createSignal(size);
+	QVector<int32_t> window(size);
+	for (int i=0; i<size; ++i) {
+		window[i] = FixedPointFFT::toQ31(0.5 - 0.5 * qCos(2 * M_PI * i / (size - 1)));
+	}
+	QVector<int32_t> output(size);
+	FixedPointFFT::applyWindow(input.constData(), window.constData(), output.data(), size);
+	for (int i=0; i<size; ++i) {
+		// (the samples are halved)
+		const double expected = 0.5 * input[i] * window[i] / TEST_Q31_ONE;
+		QVERIFY(qAbs(output[i] / TEST_Q31_ONE - expected) < 2 / TEST_Q31_ONE);
+	}
+}
+
+void TestFixedPointFFT::spectrum()
+{
+	const int exponent = 10;
+	const int size = 1 << exponent;
+	const int half = size / 2;
+	FixedPointFFT fft(exponent);
+	QVector<int32_t> input(size);
+	const QVector<float> signal = createSignal(size);
+	for (int i=0; i<size; ++i) {
+		input[i] = FixedPointFFT::halfToQ31(signal[i]);
+	}
+	QVector<int32_t> fftOutput(size);
+	fft.doFixedPointFft(fftOutput.data(), input.constData());
+	// a bin with a power of 0:
+	fftOutput[5] = 0;
+	fftOutput[half + 5] = 0;
+
+	// the scale of doFft(), so that the spectrum has the scale of the float FFTs:
+	const float scale = 2.0f * size / float(TEST_Q31_ONE);
+	QVector<float> magnitudes(half);
+	QVector<float> powers(half);
+	QVector<float> decibels(half);
+	FixedPointFFT::calculateSpectrum(MagnitudeSpectrum, fftOutput.constData(), size, scale, magnitudes.data());
+	FixedPointFFT::calculateSpectrum(PowerSpectrum, fftOutput.constData(), size, scale, powers.data());
+	FixedPointFFT::calculateSpectrum(LogPowerSpectrum, fftOutput.constData(), size, scale, decibels.data());
+
+	// the integer powers and roots are exact up to the rounding of the last step:
+	for (int i=0; i<half; ++i) {
+		const double re = fftOutput[i] * double(scale);
+		// (bin 0 is real, the value at half is the Nyquist bin)
+		const double im = i > 0 ? fftOutput[half + i] * double(scale) : 0.0;
+		const double power = re * re + im * im;
+		const double expectedDb = 10 * std::log10(qMax(power, double(SIMD_FFT_MIN_POWER)));
+		QVERIFY2(qAbs(magnitudes[i] - qSqrt(power)) <= TEST_MAX_SPECTRUM_DEVIATION * qSqrt(power) + scale,
+				 qPrintable(QString("magnitude of bin %1: %2 instead of %3").arg(i).arg(magnitudes[i]).arg(qSqrt(power))));
+		QVERIFY2(qAbs(powers[i] - power) <= TEST_MAX_SPECTRUM_DEVIATION * power,
+				 qPrintable(QString("power of bin %1: %2 instead of %3").arg(i).arg(powers[i]).arg(power)));
+		if (power > 1e-6) {
+			QVERIFY2(qAbs(decibels[i] - expectedDb) < TEST_MAX_DB_DEVIATION,
+					 qPrintable(QString("dB of bin %1: %2 instead of %3").arg(i).arg(decibels[i]).arg(expectedDb)));
+		}
+	}
+	QCOMPARE(magnitudes[5], 0.0f);
+	QCOMPARE(decibels[5], float(10 * std::log10(SIMD_FFT_MIN_POWER)));
+}
+
+QVector<float> TestFixedPointFFT::createSignal(int size) const
+{
+	QVector<float> signal(size);
+	quint32 random = 12345;
+	for (int i=0; i<size; ++i) {
+		random = random * 1664525u + 1013904223u;
+		const double noise = (random >> 8) / double(1 << 24) - 0.5;
+		signal[i] = float(0.1 * noise + 0.5 * qSin(2 * M_PI * 3 * i / size)
+						  + 0.25 * qCos(2 * M_PI * 0.37 * i) + 0.1);
+	}
+	return signal;
+}
+
+QVector<double> TestFixedPointFFT::calculateDft(const QVector<float>& input) const
+{
+	const int size = input.size();
+	const int half = size / 2;
+	QVector<double> output(size);
+	for (int k=0; k<=half; ++k) {
+		double re = 0;
+		double im = 0;
+		for (int n=0; n<size; ++n) {
+			// (the product is reduced modulo size to keep the precision of the angle)
+			const double angle = 2 * M_PI * ((qint64(k) * n) % size) / size;
+			const double sample = qBound(-1.0f, input[n], 1.0f);
+			re += sample * qCos(angle);
+			im -= sample * qSin(angle);
+		}
+		output[k] = re;
+		// FFTReal stores the negated imaginary parts of the bins 1...N/2-1:
+		if (k > 0 && k < half) output[half + k] = -im;
+	}
+	return output;
+}
+
+double TestFixedPointFFT::maxRelativeDeviation(const float* output, const QVector<double>& expected) const
+{
+	double maxValue = 0;
+	double maxDeviation = 0;
+	for (int i=0; i<expected.size(); ++i) {
+		maxValue = qMax(maxValue, qAbs(expected[i]));
+		maxDeviation = qMax(maxDeviation, qAbs(output[i] - expected[i]));
+	}
+	return maxDeviation / maxValue;
+}
+
+QTEST_APPLESS_MAIN(TestFixedPointFFT)
+
+#include "tst_fixedpointfft.moc"
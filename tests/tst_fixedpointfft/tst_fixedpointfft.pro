@@ -0,0 +1,6 @@
+include(../tests.pri)
+
+TARGET = tst_fixedpointfft
+
+SOURCES += tst_fixedpointfft.cpp \
+    $$SRC_DIR/FixedPointFFT.cpp
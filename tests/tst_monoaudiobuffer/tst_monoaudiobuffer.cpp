@@ -0,0 +1,225 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "MonoAudioBuffer.h"
+
+#include <QtTest>
+#include <QtMath>
+#include <QVector>
+
+
+// Tests the level measurement of MonoAudioBuffer while the samples are written,
+// the notifications of the producer and the detection of overwritten samples.
+class TestMonoAudioBuffer : public QObject, protected MonoAudioBuffer::HopListener, protected MonoAudioBuffer::BlockListener
+{
+	Q_OBJECT
+
+private slots:
+	void rmsOfLevelBlocks();
+	void rmsIndependentOfBlockSize();
+	void rmsHeldBetweenLevelBlocks();
+	void peak();
+	void hopNotification();
+	void oldestIntactSample();
+
+protected:
+	// counts the notifications
+	void hopReady() override { ++m_numNotifications; }
+
+	// stores the positions of m_buffer while the samples are written
+	void samplesWritten(const float*, int, int) override {
+		m_oldestIntactWhileWriting = m_buffer->getOldestIntactSampleNumber();
+		m_numPutWhileWriting = m_buffer->getNumPutSamples();
+	}
+
+	// writes numSamples samples of a sine with the given amplitude in blocks of blockSize samples
+	// and takes the levels after each block, returns the max RMS that was taken
+	float writeSine(MonoAudioBuffer& buffer, float amplitude, int numSamples, int blockSize);
+
+	int m_numNotifications;  // number of calls of hopReady()
+	MonoAudioBuffer* m_buffer;  // the buffer of samplesWritten()
+	int64_t m_oldestIntactWhileWriting;  // getOldestIntactSampleNumber() in the last call of samplesWritten()
+	int64_t m_numPutWhileWriting;  // getNumPutSamples() in the last call of samplesWritten()
+};
+
+namespace {
+
+// sample rate of the test signals
+const int TEST_SAMPLE_RATE = 44100;
+
+// frequency of the test sine (a full number of periods fits into a level block)
+const double TEST_FREQUENCY = TEST_SAMPLE_RATE * 8.0 / LEVEL_BLOCK_SIZE;
+
+}
+
+void TestMonoAudioBuffer::rmsOfLevelBlocks()
+{
+	MonoAudioBuffer buffer(TEST_SAMPLE_RATE);
+	buffer.setInputSampleRate(TEST_SAMPLE_RATE);
+	buffer.setDcBlockerEnabled(false);
+
+	const float rms = writeSine(buffer, 0.5f, LEVEL_BLOCK_SIZE * 4, LEVEL_BLOCK_SIZE);
+	QVERIFY(qAbs(rms - 0.5f * M_SQRT1_2) < 1e-3f);
+}
+
+void TestMonoAudioBuffer::rmsIndependentOfBlockSize()
+{
+	// a signal whose level changes every 300 samples,
+	// the RMS must not depend on how the backend splits it into blocks:
+	QVector<float> signal(LEVEL_BLOCK_SIZE * 8);
+	for (int i=0; i<signal.size(); ++i) {
+		signal[i] = ((i / 300) % 2) ? 0.8f : 0.1f;
+	}
+
+	const int blockSizes[] = { 64, 100, 441, 512, LEVEL_BLOCK_SIZE, 4096 };
+	float reference = -1.0f;
+	for (int blockSize: blockSizes) {
+		MonoAudioBuffer buffer(TEST_SAMPLE_RATE);
+		buffer.setInputSampleRate(TEST_SAMPLE_RATE);
+		buffer.setDcBlockerEnabled(false);
+
+		float maxRms = 0.0f;
+		for (int i=0; i<signal.size(); i+=blockSize) {
+			buffer.putSamples(signal.constData() + i, qMin(blockSize, signal.size() - i));
+			maxRms = qMax(maxRms, buffer.takeLevels().rms);
+		}
+		if (reference < 0) reference = maxRms;
+		QVERIFY2(qAbs(maxRms - reference) < 1e-4f, qPrintable(QString("block size %1").arg(blockSize)));
+	}
+}
+
+void TestMonoAudioBuffer::rmsHeldBetweenLevelBlocks()
+{
+	MonoAudioBuffer buffer(TEST_SAMPLE_RATE);
+	buffer.setInputSampleRate(TEST_SAMPLE_RATE);
+	buffer.setDcBlockerEnabled(false);
+
+	// no level block completed yet:
+	writeSine(buffer, 0.5f, LEVEL_BLOCK_SIZE / 2, LEVEL_BLOCK_SIZE / 2);
+	QVERIFY(buffer.takeLevels().rms < 1e-6f);
+
+	// polls faster than the level blocks still return the latest RMS:
+	writeSine(buffer, 0.5f, LEVEL_BLOCK_SIZE / 2, LEVEL_BLOCK_SIZE / 2);
+	const float rms = buffer.takeLevels().rms;
+	QVERIFY(rms > 0.3f);
+	const float held = writeSine(buffer, 0.5f, 64, 64);
+	QVERIFY(qAbs(held - rms) < 1e-6f);
+}
+
+void TestMonoAudioBuffer::peak()
+{
+	MonoAudioBuffer buffer(TEST_SAMPLE_RATE);
+	buffer.setInputSampleRate(TEST_SAMPLE_RATE);
+	buffer.setDcBlockerEnabled(false);
+
+	QVector<float> block(100, 0.0f);
+	block[42] = -0.75f;
+	buffer.putSamples(block.constData(), block.size());
+	QVERIFY(qAbs(buffer.takeLevels().peak - 0.75f) < 1e-6f);
+
+	// the peak is reset by takeLevels():
+	block[42] = 0.0f;
+	buffer.putSamples(block.constData(), block.size());
+	QVERIFY(buffer.takeLevels().peak < 1e-6f);
+}
+
+void TestMonoAudioBuffer::hopNotification()
+{
+	MonoAudioBuffer buffer(TEST_SAMPLE_RATE, 2);
+	buffer.setInputSampleRate(TEST_SAMPLE_RATE);
+	buffer.setNumChannelBuffers(2);
+	m_numNotifications = 0;
+	QVector<float> block(500, 0.0f);
+
+	// no notification without a listener and a request:
+	buffer.putSamples(block.constData(), block.size());
+	buffer.requestHopNotification(1000);
+	buffer.putSamples(block.constData(), block.size());
+	QCOMPARE(m_numNotifications, 0);
+
+	buffer.setHopListener(this);
+	buffer.requestHopNotification(1600);
+	buffer.putSamples(block.constData(), block.size());
+	QCOMPARE(m_numNotifications, 0);
+	buffer.putSamples(block.constData(), block.size());
+	QCOMPARE(m_numNotifications, 1);
+
+	// only once per request:
+	buffer.putSamples(block.constData(), block.size());
+	QCOMPARE(m_numNotifications, 1);
+
+	// a request that is already complete is notified with the next block:
+	buffer.requestHopNotification(1000);
+	const float* channels[] = { block.constData(), block.constData() };
+	buffer.putSamples(channels, 2, block.size(), 1.0f);
+	QCOMPARE(m_numNotifications, 2);
+	QCOMPARE(buffer.getChannelBuffer(1).getNumPutSamples(), int64_t(block.size()));
+
+	buffer.setHopListener(nullptr);
+	buffer.requestHopNotification(0);
+	buffer.putSamples(block.constData(), block.size());
+	QCOMPARE(m_numNotifications, 2);
+}
+
+void TestMonoAudioBuffer::oldestIntactSample()
+{
+	MonoAudioBuffer buffer(1000);
+	buffer.setInputSampleRate(TEST_SAMPLE_RATE);
+	QVector<float> block(300, 0.0f);
+
+	// all samples are intact while the ring is filled:
+	buffer.putSamples(block.constData(), block.size());
+	QVERIFY(buffer.getOldestIntactSampleNumber() <= 0);
+
+	for (int i=0; i<4; ++i) {
+		buffer.putSamples(block.constData(), block.size());
+	}
+	QCOMPARE(buffer.getNumPutSamples(), int64_t(1500));
+	QCOMPARE(buffer.getOldestIntactSampleNumber(), int64_t(500));
+
+	// the samples that are overwritten by a block are not intact anymore before the block is published:
+	m_buffer = &buffer;
+	buffer.setBlockListener(this);
+	buffer.putSamples(block.constData(), block.size());
+	buffer.setBlockListener(nullptr);
+	QCOMPARE(m_numPutWhileWriting, int64_t(1500));
+	QCOMPARE(m_oldestIntactWhileWriting, int64_t(800));
+	QCOMPARE(buffer.getOldestIntactSampleNumber(), int64_t(800));
+}
+
+float TestMonoAudioBuffer::writeSine(MonoAudioBuffer& buffer, float amplitude, int numSamples, int blockSize)
+{
+	QVector<float> block(blockSize);
+	float maxRms = 0.0f;
+	for (int done=0; done<numSamples; done+=blockSize) {
+		const int count = qMin(blockSize, numSamples - done);
+		for (int i=0; i<count; ++i) {
+			block[i] = amplitude * qSin(2 * M_PI * TEST_FREQUENCY * (done + i) / TEST_SAMPLE_RATE);
+		}
+		buffer.putSamples(block.constData(), count);
+		maxRms = qMax(maxRms, buffer.takeLevels().rms);
+	}
+	return maxRms;
+}
+
+QTEST_APPLESS_MAIN(TestMonoAudioBuffer)
+
+#include "tst_monoaudiobuffer.moc"
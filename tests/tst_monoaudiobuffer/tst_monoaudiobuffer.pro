@@ -0,0 +1,8 @@
+include(../tests.pri)
+
+QT += multimedia
+
+TARGET = tst_monoaudiobuffer
+
+SOURCES += tst_monoaudiobuffer.cpp \
+    $$AUDIO_BUFFER_SOURCES
@@ -0,0 +1,128 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "NetworkAudioInput.h"
+#include "MonoAudioBuffer.h"
+#include "PcmDecoder.h"
+
+#include <QtTest>
+#include <QByteArray>
+#include <QVector>
+
+#include <cstring>
+
+
+// Exposes the handling of the plain datagrams without receiving them from a socket.
+class TestableNetworkAudioInput : public NetworkAudioInput
+{
+public:
+	TestableNetworkAudioInput(MonoAudioBuffer* buffer, const QAudioFormat& format)
+		: NetworkAudioInput(buffer, "udp:5005", format)
+	{}
+
+	// handles the datagram as if it was received by the socket
+	void receive(const char* data, int size) {
+		std::memcpy(m_receiveBuffer.data() + m_pendingBytes, data, size);
+		putDatagram(size);
+	}
+};
+
+
+// Tests that plain datagrams which are not aligned to frames are decoded like a continuous stream.
+class TestNetworkAudioInput : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void unalignedDatagrams();
+	void datagramsShorterThanAFrame();
+
+protected:
+	// sends the PCM data in datagrams of datagramSize bytes to a NetworkAudioInput
+	// and compares the samples with those of the data decoded at once
+	void compareWithStream(const QByteArray& data, int datagramSize);
+};
+
+namespace {
+
+// format of plain datagrams as sent by ffmpeg -f s24be (6 bytes per frame)
+const char* const TEST_FORMAT = "s24be:2:44100";
+
+// payload size of ffmpeg's default UDP packets (not a multiple of the frame size)
+const int TEST_DATAGRAM_SIZE = 1472;
+
+// creates numFrames frames of s24be:2 with a different ramp in each channel
+QByteArray createFrames(int numFrames)
+{
+	QByteArray data;
+	for (int i=0; i<numFrames; ++i) {
+		const int values[] = { i * 997, -i * 541 };
+		for (int value: values) {
+			data.append(char((value >> 16) & 0xFF));
+			data.append(char((value >> 8) & 0xFF));
+			data.append(char(value & 0xFF));
+		}
+	}
+	return data;
+}
+
+}
+
+void TestNetworkAudioInput::unalignedDatagrams()
+{
+	compareWithStream(createFrames(2000), TEST_DATAGRAM_SIZE);
+}
+
+void TestNetworkAudioInput::datagramsShorterThanAFrame()
+{
+	compareWithStream(createFrames(100), 4);
+	compareWithStream(createFrames(100), 1);
+}
+
+void TestNetworkAudioInput::compareWithStream(const QByteArray& data, int datagramSize)
+{
+	QAudioFormat format;
+	QVERIFY(PcmDecoder::parseFormat(TEST_FORMAT, format));
+	PcmDecoder decoder;
+	QVERIFY(decoder.setFormat(format));
+	const int bytesPerFrame = decoder.getBytesPerFrame();
+	const int numFrames = data.size() / bytesPerFrame;
+
+	// the reference decodes all frames at once:
+	MonoAudioBuffer expected(numFrames);
+	expected.setInputSampleRate(format.sampleRate());
+	expected.putSamples(data.constData(), numFrames, decoder);
+
+	MonoAudioBuffer buffer(numFrames);
+	buffer.setInputSampleRate(format.sampleRate());
+	TestableNetworkAudioInput input(&buffer, format);
+	for (int i=0; i<data.size(); i+=datagramSize) {
+		input.receive(data.constData() + i, qMin(datagramSize, data.size() - i));
+	}
+
+	QCOMPARE(buffer.getNumPutSamples(), int64_t(numFrames));
+	for (int i=0; i<numFrames; ++i) {
+		QCOMPARE(buffer.atSampleNumber(i), expected.atSampleNumber(i));
+	}
+}
+
+QTEST_APPLESS_MAIN(TestNetworkAudioInput)
+
+#include "tst_networkaudioinput.moc"
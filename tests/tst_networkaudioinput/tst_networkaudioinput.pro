@@ -0,0 +1,12 @@
+include(../tests.pri)
+
+QT += multimedia network
+
+TARGET = tst_networkaudioinput
+
+SOURCES += tst_networkaudioinput.cpp \
+    $$SRC_DIR/NetworkAudioInput.cpp \
+    $$SRC_DIR/RtpJitterBuffer.cpp \
+    $$AUDIO_BUFFER_SOURCES
+
+HEADERS += $$SRC_DIR/NetworkAudioInput.h
@@ -0,0 +1,210 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "PcmDecoder.h"
+
+#include <QtTest>
+#include <QVector>
+#include <QByteArray>
+
+#include <cstring>
+
+
+// Tests the decode kernels of PcmDecoder against a scalar reference for every supported format.
+class TestPcmDecoder : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void parseFormat();
+	void unsupportedFormats();
+	void decodeAllFormats();
+	void decodeChannels();
+	void gain();
+
+protected:
+	// returns interleaved PCM data of the format with the given description,
+	// the sample of channel ch in frame i is the value of testValue(i, ch)
+	static QByteArray encode(const QString& description, int numFrames);
+
+	// returns the value of a test sample, exactly representable in every supported format
+	static float testValue(int frame, int channel) { return ((frame * 37 + channel * 91) % 256 - 128) / 128.0f; }
+};
+
+namespace {
+
+// the formats that have a decode kernel, the channel count and sample rate are appended
+const char* const TEST_FORMATS[] = { "u8", "s16le", "s16be", "s24le", "s24be", "s32le", "s32be", "f32le", "f32be" };
+
+// number of frames per test, not a multiple of the vector width to test the remainder loops
+const int TEST_NUM_FRAMES = 101;
+
+// max deviation of a decoded sample from the reference
+const float DECODE_TOLERANCE = 1e-6f;
+
+}  // namespace
+
+QByteArray TestPcmDecoder::encode(const QString& description, int numFrames)
+{
+	QAudioFormat format;
+	if (!PcmDecoder::parseFormat(description, format)) return QByteArray();
+	const int bytes = format.sampleSize() / 8;
+	const bool bigEndian = format.byteOrder() == QAudioFormat::BigEndian;
+
+	QByteArray data;
+	for (int i=0; i<numFrames; ++i) {
+		for (int ch=0; ch<format.channelCount(); ++ch) {
+			const float value = testValue(i, ch);
+			quint32 bits;
+			if (format.sampleType() == QAudioFormat::Float) {
+				std::memcpy(&bits, &value, sizeof(bits));
+			} else if (format.sampleType() == QAudioFormat::UnSignedInt) {
+				bits = quint32(qRound(value * 128) + 128);
+			} else {
+				bits = quint32(qint32(qRound(value * 128)) << (format.sampleSize() - 8));
+			}
+			for (int b=0; b<bytes; ++b) {
+				const int shift = bigEndian ? (bytes - 1 - b) * 8 : b * 8;
+				data.append(char((bits >> shift) & 0xFF));
+			}
+		}
+	}
+	return data;
+}
+
+void TestPcmDecoder::parseFormat()
+{
+	QAudioFormat format;
+	QVERIFY(PcmDecoder::parseFormat("s16le:2:44100", format));
+	QCOMPARE(format.sampleType(), QAudioFormat::SignedInt);
+	QCOMPARE(format.sampleSize(), 16);
+	QCOMPARE(format.byteOrder(), QAudioFormat::LittleEndian);
+	QCOMPARE(format.channelCount(), 2);
+	QCOMPARE(format.sampleRate(), 44100);
+
+	QVERIFY(PcmDecoder::parseFormat(" F32BE:1:48000 ", format));
+	QCOMPARE(format.sampleType(), QAudioFormat::Float);
+	QCOMPARE(format.sampleSize(), 32);
+	QCOMPARE(format.byteOrder(), QAudioFormat::BigEndian);
+	QCOMPARE(format.channelCount(), 1);
+	QCOMPARE(format.sampleRate(), 48000);
+
+	// the byte order is optional:
+	QVERIFY(PcmDecoder::parseFormat("u8:1:8000", format));
+	QCOMPARE(format.sampleType(), QAudioFormat::UnSignedInt);
+	QCOMPARE(format.sampleSize(), 8);
+
+	QVERIFY(!PcmDecoder::parseFormat("s16le:2", format));
+	QVERIFY(!PcmDecoder::parseFormat("x16le:2:44100", format));
+	QVERIFY(!PcmDecoder::parseFormat("s12le:2:44100", format));
+	QVERIFY(!PcmDecoder::parseFormat("s16le:0:44100", format));
+	QVERIFY(!PcmDecoder::parseFormat("s16le:2:-1", format));
+	QVERIFY(!PcmDecoder::parseFormat("s16le:two:44100", format));
+}
+
+void TestPcmDecoder::unsupportedFormats()
+{
+	PcmDecoder decoder;
+	QAudioFormat format;
+	QVERIFY(PcmDecoder::parseFormat("u16le:1:44100", format));
+	QVERIFY(!PcmDecoder::isSupported(format));
+	QVERIFY(PcmDecoder::parseFormat("f64le:1:44100", format));
+	QVERIFY(!PcmDecoder::isSupported(format));
+	QVERIFY(PcmDecoder::parseFormat("s8:1:44100", format));
+	QVERIFY(!PcmDecoder::isSupported(format));
+
+	// the previous format stays active:
+	QVERIFY(!decoder.setFormat(format));
+	QCOMPARE(decoder.getBytesPerFrame(), 2);
+	QCOMPARE(decoder.getChannelCount(), 1);
+}
+
+void TestPcmDecoder::decodeAllFormats()
+{
+	QVector<float> output(TEST_NUM_FRAMES);
+	for (const char* sample: TEST_FORMATS) {
+		// mono, stereo and multichannel kernels:
+		for (int channels=1; channels<=3; ++channels) {
+			const QString description = QString("%1:%2:44100").arg(sample).arg(channels);
+			QAudioFormat format;
+			QVERIFY(PcmDecoder::parseFormat(description, format));
+			PcmDecoder decoder;
+			QVERIFY2(decoder.setFormat(format), qPrintable(description));
+			QCOMPARE(decoder.getBytesPerFrame(), channels * format.sampleSize() / 8);
+
+			const QByteArray data = encode(description, TEST_NUM_FRAMES);
+			decoder.decode(data.constData(), output.data(), TEST_NUM_FRAMES);
+			for (int i=0; i<TEST_NUM_FRAMES; ++i) {
+				float expected = 0.0f;
+				for (int ch=0; ch<channels; ++ch) expected += testValue(i, ch);
+				expected /= channels;
+				QVERIFY2(qAbs(output[i] - expected) <= DECODE_TOLERANCE, qPrintable(description));
+			}
+		}
+	}
+}
+
+void TestPcmDecoder::decodeChannels()
+{
+	QVector<float> output(TEST_NUM_FRAMES);
+	for (const char* sample: TEST_FORMATS) {
+		const int channels = 3;
+		const QString description = QString("%1:%2:44100").arg(sample).arg(channels);
+		QAudioFormat format;
+		QVERIFY(PcmDecoder::parseFormat(description, format));
+		PcmDecoder decoder;
+		QVERIFY(decoder.setFormat(format));
+
+		const QByteArray data = encode(description, TEST_NUM_FRAMES);
+		for (int ch=0; ch<channels; ++ch) {
+			decoder.decodeChannel(data.constData(), output.data(), TEST_NUM_FRAMES, ch);
+			for (int i=0; i<TEST_NUM_FRAMES; ++i) {
+				QVERIFY2(qAbs(output[i] - testValue(i, ch)) <= DECODE_TOLERANCE, qPrintable(description));
+			}
+		}
+	}
+}
+
+void TestPcmDecoder::gain()
+{
+	QVector<float> output(TEST_NUM_FRAMES);
+	for (int channels=1; channels<=2; ++channels) {
+		// the SSE2 kernels for 16bit mono and stereo have to apply the gain like the generic ones:
+		const QString description = QString("s16le:%1:44100").arg(channels);
+		QAudioFormat format;
+		QVERIFY(PcmDecoder::parseFormat(description, format));
+		PcmDecoder decoder;
+		QVERIFY(decoder.setFormat(format));
+		decoder.setGain(0.25f);
+
+		const QByteArray data = encode(description, TEST_NUM_FRAMES);
+		decoder.decode(data.constData(), output.data(), TEST_NUM_FRAMES);
+		for (int i=0; i<TEST_NUM_FRAMES; ++i) {
+			float expected = 0.0f;
+			for (int ch=0; ch<channels; ++ch) expected += testValue(i, ch);
+			expected *= 0.25f / channels;
+			QVERIFY(qAbs(output[i] - expected) <= DECODE_TOLERANCE);
+		}
+	}
+}
+
+QTEST_APPLESS_MAIN(TestPcmDecoder)
+
+#include "tst_pcmdecoder.moc"
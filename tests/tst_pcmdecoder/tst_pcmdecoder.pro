@@ -0,0 +1,8 @@
+include(../tests.pri)
+
+TARGET = tst_pcmdecoder
+
+QT += multimedia
+
+SOURCES += tst_pcmdecoder.cpp \
+    $$SRC_DIR/PcmDecoder.cpp
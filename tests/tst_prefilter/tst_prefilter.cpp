@@ -0,0 +1,176 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "PreFilter.h"
+
+#include <QtTest>
+#include <QtMath>
+#include <QVector>
+
+
+// Tests the DC blocker and the Butterworth high-pass of PreFilter.
+class TestPreFilter : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void bypass();
+	void dcRemoval();
+	void highPassResponse();
+	void blockIndependence();
+	void reset();
+
+protected:
+	// returns the gain of filter for a sine of the given frequency (after the filter has settled)
+	double measureGain(PreFilter& filter, double frequency);
+};
+
+namespace {
+
+// sample rate of the test signals
+const int TEST_SAMPLE_RATE = 48000;
+
+// cutoff frequency of the tested high-pass
+const int TEST_CUTOFF = 100;  // Hz
+
+}
+
+void TestPreFilter::bypass()
+{
+	PreFilter filter;
+	filter.setup(TEST_SAMPLE_RATE, false, 0, 2);
+	QVERIFY(filter.isBypassed());
+
+	float samples[] = { 0.5f, -0.25f, 1.0f };
+	filter.process(samples, 3);
+	QCOMPARE(samples[0], 0.5f);
+	QCOMPARE(samples[1], -0.25f);
+	QCOMPARE(samples[2], 1.0f);
+
+	// a high-pass at or above the nyquist frequency is disabled:
+	filter.setup(TEST_SAMPLE_RATE, false, TEST_SAMPLE_RATE / 2, 2);
+	QVERIFY(filter.isBypassed());
+
+	filter.setup(TEST_SAMPLE_RATE, true, 0, 2);
+	QVERIFY(!filter.isBypassed());
+}
+
+void TestPreFilter::dcRemoval()
+{
+	PreFilter filter;
+	filter.setup(TEST_SAMPLE_RATE, true, 0, 2);
+
+	// a constant offset decays with the time constant of the DC blocker:
+	QVector<float> samples(TEST_SAMPLE_RATE, 0.5f);
+	filter.process(samples.data(), samples.size());
+	QVERIFY(qAbs(samples.last()) < 1e-3f);
+
+	// frequencies well above the cutoff pass:
+	QVERIFY(qAbs(measureGain(filter, 1000) - 1) < 0.01);
+}
+
+void TestPreFilter::highPassResponse()
+{
+	const int orders[] = { 2, 4, 6, 8 };
+	for (int order: orders) {
+		PreFilter filter;
+		filter.setup(TEST_SAMPLE_RATE, false, TEST_CUTOFF, order);
+		QVERIFY(!filter.isBypassed());
+
+		// Butterworth response: |H(f)| = 1 / sqrt(1 + (fc / f)^(2 * order))
+		const double frequencies[] = { TEST_CUTOFF / 2.0, double(TEST_CUTOFF), TEST_CUTOFF * 2.0, TEST_CUTOFF * 10.0 };
+		for (double frequency: frequencies) {
+			const double expected = 1 / qSqrt(1 + qPow(TEST_CUTOFF / frequency, 2 * order));
+			const double gain = measureGain(filter, frequency);
+			QVERIFY2(qAbs(gain - expected) < 0.01,
+					 qPrintable(QString("order %1 at %2 Hz: %3 instead of %4").arg(order).arg(frequency).arg(gain).arg(expected)));
+		}
+	}
+}
+
+void TestPreFilter::blockIndependence()
+{
+	QVector<float> input(5000);
+	for (int i=0; i<input.size(); ++i) {
+		input[i] = 0.3f + 0.5f * qSin(i * 0.01) + 0.2f * qSin(i * 0.7);
+	}
+
+	PreFilter reference;
+	reference.setup(TEST_SAMPLE_RATE, true, TEST_CUTOFF, 8);
+	QVector<float> expected = input;
+	reference.process(expected.data(), expected.size());
+
+	// the result must not depend on the block size (including blocks of 1 and 2 samples):
+	const int blockSizes[] = { 1, 2, 3, 100, PRE_FILTER_BLOCK_SIZE, PRE_FILTER_BLOCK_SIZE + 1 };
+	for (int blockSize: blockSizes) {
+		PreFilter filter;
+		filter.setup(TEST_SAMPLE_RATE, true, TEST_CUTOFF, 8);
+		QVector<float> output = input;
+		for (int i=0; i<output.size(); i+=blockSize) {
+			filter.process(output.data() + i, qMin(blockSize, output.size() - i));
+		}
+		for (int i=0; i<output.size(); ++i) {
+			QVERIFY2(qAbs(output[i] - expected[i]) < 1e-5f, qPrintable(QString("block size %1, sample %2").arg(blockSize).arg(i)));
+		}
+	}
+}
+
+void TestPreFilter::reset()
+{
+	PreFilter filter;
+	filter.setup(TEST_SAMPLE_RATE, true, TEST_CUTOFF, 4);
+
+	QVector<float> first(300, 1.0f);
+	filter.process(first.data(), first.size());
+
+	// after reset() the filter responds like a new one:
+	filter.reset();
+	QVector<float> second(300, 1.0f);
+	filter.process(second.data(), second.size());
+
+	PreFilter fresh;
+	fresh.setup(TEST_SAMPLE_RATE, true, TEST_CUTOFF, 4);
+	QVector<float> expected(300, 1.0f);
+	fresh.process(expected.data(), expected.size());
+	for (int i=0; i<expected.size(); ++i) {
+		QCOMPARE(second[i], expected[i]);
+	}
+}
+
+double TestPreFilter::measureGain(PreFilter& filter, double frequency)
+{
+	// one second to settle, then the amplitude of the next second:
+	QVector<float> samples(TEST_SAMPLE_RATE * 2);
+	for (int i=0; i<samples.size(); ++i) {
+		samples[i] = qSin(2 * M_PI * frequency * i / TEST_SAMPLE_RATE);
+	}
+	filter.process(samples.data(), samples.size());
+
+	double sumOfSquares = 0;
+	for (int i=TEST_SAMPLE_RATE; i<samples.size(); ++i) {
+		sumOfSquares += samples[i] * samples[i];
+	}
+	return qSqrt(2 * sumOfSquares / TEST_SAMPLE_RATE);
+}
+
+QTEST_APPLESS_MAIN(TestPreFilter)
+
+#include "tst_prefilter.moc"
@@ -0,0 +1,6 @@
+include(../tests.pri)
+
+TARGET = tst_prefilter
+
+SOURCES += tst_prefilter.cpp \
+    $$SRC_DIR/PreFilter.cpp
@@ -0,0 +1,175 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "Resampler.h"
+
+#include <QtTest>
+#include <QtMath>
+#include <QVector>
+
+
+// Tests the polyphase resampler with sines of known frequency.
+class TestResampler : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void ratios();
+	void passband();
+	void aliasRejection();
+	void blockIndependence();
+	void reset();
+
+protected:
+	// returns numSamples samples of a sine with the given frequency and amplitude
+	static QVector<float> sine(double frequency, int sampleRate, int numSamples, float amplitude = 1.0f);
+
+	// returns the amplitude of the component with the given frequency in samples
+	// (from the sample firstSample to the end, the filter delay at the start is skipped)
+	static double amplitudeAt(const QVector<float>& samples, int firstSample, double frequency, int sampleRate);
+
+	// resamples the whole input in one call
+	static QVector<float> resample(Resampler& resampler, const QVector<float>& input);
+};
+
+QVector<float> TestResampler::sine(double frequency, int sampleRate, int numSamples, float amplitude)
+{
+	QVector<float> samples(numSamples);
+	for (int i=0; i<numSamples; ++i) {
+		samples[i] = amplitude * qSin(2 * M_PI * frequency * i / sampleRate);
+	}
+	return samples;
+}
+
+double TestResampler::amplitudeAt(const QVector<float>& samples, int firstSample, double frequency, int sampleRate)
+{
+	// correlation with a Hann windowed complex exponential:
+	const int n = samples.size() - firstSample;
+	double re = 0.0;
+	double im = 0.0;
+	double windowSum = 0.0;
+	for (int i=0; i<n; ++i) {
+		const double window = 0.5 - 0.5 * qCos(2 * M_PI * i / n);
+		const double phase = 2 * M_PI * frequency * i / sampleRate;
+		re += samples[firstSample + i] * window * qCos(phase);
+		im += samples[firstSample + i] * window * qSin(phase);
+		windowSum += window;
+	}
+	return 2 * qSqrt(re * re + im * im) / windowSum;
+}
+
+QVector<float> TestResampler::resample(Resampler& resampler, const QVector<float>& input)
+{
+	QVector<float> output(resampler.maxOutputSamples(input.size()));
+	output.resize(resampler.process(input.constData(), input.size(), output.data()));
+	return output;
+}
+
+void TestResampler::ratios()
+{
+	Resampler resampler;
+	QVERIFY(resampler.setRates(44100, 44100));
+	QVERIFY(resampler.isBypassed());
+
+	QVERIFY(resampler.setRates(48000, 44100));
+	QVERIFY(!resampler.isBypassed());
+	QCOMPARE(resampler.getInputRate(), 48000);
+	QCOMPARE(resampler.getOutputRate(), 44100);
+
+	// the number of output samples follows the ratio 147 / 160:
+	const QVector<float> output = resample(resampler, QVector<float>(48000, 0.0f));
+	QVERIFY(qAbs(output.size() - 44100) <= 1);
+	QVERIFY(output.size() <= resampler.maxOutputSamples(48000));
+
+	// a ratio with more than RESAMPLER_MAX_PHASES phases is bypassed:
+	QVERIFY(!resampler.setRates(44100, 44111));
+	QVERIFY(resampler.isBypassed());
+
+	// the filters of all rates up to 192kHz fit into the preallocated storage:
+	QVERIFY(resampler.setRates(192000, 44100));
+	QVERIFY(!resampler.isBypassed());
+	QVERIFY(!resampler.setRates(384000, 44100));
+	QVERIFY(resampler.isBypassed());
+}
+
+void TestResampler::passband()
+{
+	const int rates[][2] = { {48000, 44100}, {96000, 44100}, {192000, 44100}, {22050, 44100}, {44100, 11025} };
+	for (const auto& rate: rates) {
+		Resampler resampler;
+		QVERIFY(resampler.setRates(rate[0], rate[1]));
+		const QVector<float> output = resample(resampler, sine(1000.0, rate[0], rate[0], 0.5f));
+		const double amplitude = amplitudeAt(output, 1000, 1000.0, rate[1]);
+		QVERIFY2(qAbs(amplitude - 0.5) < 0.005, qPrintable(QString("%1 -> %2 Hz: %3").arg(rate[0]).arg(rate[1]).arg(amplitude)));
+	}
+}
+
+void TestResampler::aliasRejection()
+{
+	// 30kHz at 96kHz would alias to 14.1kHz at 44.1kHz:
+	Resampler resampler;
+	QVERIFY(resampler.setRates(96000, 44100));
+	const QVector<float> output = resample(resampler, sine(30000.0, 96000, 96000));
+	const double alias = amplitudeAt(output, 1000, 44100 - 30000.0, 44100);
+	QVERIFY2(alias < 0.01, qPrintable(QString::number(alias)));
+}
+
+void TestResampler::blockIndependence()
+{
+	// the output must not depend on how the input is split into blocks:
+	const QVector<float> input = sine(440.0, 48000, 20000);
+	Resampler whole;
+	QVERIFY(whole.setRates(48000, 44100));
+	const QVector<float> expected = resample(whole, input);
+
+	Resampler blocks;
+	QVERIFY(blocks.setRates(48000, 44100));
+	QVector<float> output(blocks.maxOutputSamples(input.size()) + 64);
+	int numOutputSamples = 0;
+	int position = 0;
+	for (int block=1; position < input.size(); block = block * 7 % (RESAMPLER_BLOCK_SIZE + 501)) {
+		const int count = qMin(block, input.size() - position);
+		numOutputSamples += blocks.process(input.constData() + position, count, output.data() + numOutputSamples);
+		position += count;
+	}
+	QCOMPARE(numOutputSamples, expected.size());
+	for (int i=0; i<numOutputSamples; ++i) {
+		QVERIFY(qAbs(output[i] - expected[i]) < 1e-6f);
+	}
+}
+
+void TestResampler::reset()
+{
+	// after a reset the output is the same as from a new resampler:
+	const QVector<float> input = sine(440.0, 96000, 5000);
+	Resampler resampler;
+	QVERIFY(resampler.setRates(96000, 44100));
+	const QVector<float> first = resample(resampler, input);
+	resampler.reset();
+	const QVector<float> second = resample(resampler, input);
+	QCOMPARE(second.size(), first.size());
+	for (int i=0; i<first.size(); ++i) {
+		QVERIFY(qAbs(first[i] - second[i]) < 1e-6f);
+	}
+}
+
+QTEST_APPLESS_MAIN(TestResampler)
+
+#include "tst_resampler.moc"
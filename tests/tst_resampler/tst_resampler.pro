@@ -0,0 +1,6 @@
+include(../tests.pri)
+
+TARGET = tst_resampler
+
+SOURCES += tst_resampler.cpp \
+    $$SRC_DIR/Resampler.cpp
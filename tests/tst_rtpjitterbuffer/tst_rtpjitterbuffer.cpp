@@ -0,0 +1,241 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "RtpJitterBuffer.h"
+
+#include <QtTest>
+#include <QByteArray>
+#include <QVector>
+
+
+// Tests the reordering, loss concealment and flushing of RtpJitterBuffer.
+class TestRtpJitterBuffer : public QObject, protected RtpJitterBuffer::Output
+{
+	Q_OBJECT
+
+private slots:
+	void init();
+	void inOrder();
+	void reordered();
+	void lostPacket();
+	void silenceValue();
+	void lateAndDuplicate();
+	void flush();
+	void sequenceWrap();
+	void resync();
+	void headerParsing();
+
+protected:
+	// collects the released payloads
+	void putPayload(const char* data, int size) override { m_payloads.append(QByteArray(data, size)); }
+
+	// creates an RTP packet with the given sequence number and a payload of TEST_PAYLOAD_SIZE bytes of value
+	static QByteArray createPacket(quint16 sequence, char value);
+
+	// puts the packet with the given sequence number and value into the jitter buffer
+	void put(RtpJitterBuffer& buffer, quint16 sequence, char value);
+
+	// returns the first byte of each released payload
+	QVector<char> releasedValues() const;
+
+	QVector<QByteArray> m_payloads;  // the payloads released by the jitter buffer
+};
+
+namespace {
+
+// number of packets in the tested jitter buffer
+const int TEST_PACKETS = 4;
+
+// max payload size of the tested jitter buffer
+const int TEST_MAX_PAYLOAD = 64;
+
+// size of the payloads of the test packets
+const int TEST_PAYLOAD_SIZE = 8;
+
+}
+
+void TestRtpJitterBuffer::init()
+{
+	m_payloads.clear();
+}
+
+void TestRtpJitterBuffer::inOrder()
+{
+	RtpJitterBuffer buffer(this, TEST_PACKETS, TEST_MAX_PAYLOAD);
+	for (int i=0; i<10; ++i) {
+		put(buffer, 100 + i, char(i + 1));
+		// packets in order are passed on immediately:
+		QCOMPARE(m_payloads.size(), i + 1);
+	}
+	QCOMPARE(m_payloads.last(), QByteArray(TEST_PAYLOAD_SIZE, char(10)));
+	QCOMPARE(buffer.getNumLostPackets(), 0);
+}
+
+void TestRtpJitterBuffer::reordered()
+{
+	RtpJitterBuffer buffer(this, TEST_PACKETS, TEST_MAX_PAYLOAD);
+	put(buffer, 0, 1);
+	put(buffer, 2, 3);
+	put(buffer, 3, 4);
+	// packet 1 is waited for:
+	QCOMPARE(m_payloads.size(), 1);
+	put(buffer, 1, 2);
+	QCOMPARE(releasedValues(), QVector<char>({ 1, 2, 3, 4 }));
+	QCOMPARE(buffer.getNumLostPackets(), 0);
+}
+
+void TestRtpJitterBuffer::lostPacket()
+{
+	RtpJitterBuffer buffer(this, TEST_PACKETS, TEST_MAX_PAYLOAD);
+	put(buffer, 0, 1);
+	put(buffer, 2, 3);
+	put(buffer, 3, 4);
+	QCOMPARE(m_payloads.size(), 1);
+	// the jitter buffer is full, packet 1 is replaced by silence of the same size:
+	put(buffer, 4, 5);
+	QCOMPARE(releasedValues(), QVector<char>({ 1, 0, 3, 4, 5 }));
+	QCOMPARE(m_payloads[1].size(), TEST_PAYLOAD_SIZE);
+	QCOMPARE(buffer.getNumLostPackets(), 1);
+}
+
+void TestRtpJitterBuffer::silenceValue()
+{
+	// i.e. unsigned 8bit samples:
+	RtpJitterBuffer buffer(this, TEST_PACKETS, TEST_MAX_PAYLOAD);
+	buffer.setSilenceValue(char(0x80));
+	put(buffer, 0, 1);
+	put(buffer, 2, 3);
+	buffer.flush();
+	QCOMPARE(m_payloads.size(), 3);
+	QCOMPARE(m_payloads[1], QByteArray(TEST_PAYLOAD_SIZE, char(0x80)));
+}
+
+void TestRtpJitterBuffer::lateAndDuplicate()
+{
+	RtpJitterBuffer buffer(this, TEST_PACKETS, TEST_MAX_PAYLOAD);
+	put(buffer, 0, 1);
+	put(buffer, 1, 2);
+	// duplicate:
+	put(buffer, 1, 2);
+	put(buffer, 3, 4);
+	put(buffer, 4, 5);
+	put(buffer, 5, 6);
+	// packet 2 arrives after it was replaced by silence:
+	put(buffer, 2, 3);
+	QCOMPARE(releasedValues(), QVector<char>({ 1, 2, 0, 4, 5, 6 }));
+	QCOMPARE(buffer.getNumLostPackets(), 1);
+}
+
+void TestRtpJitterBuffer::flush()
+{
+	RtpJitterBuffer buffer(this, TEST_PACKETS, TEST_MAX_PAYLOAD);
+	put(buffer, 0, 1);
+	put(buffer, 2, 3);
+	QCOMPARE(m_payloads.size(), 1);
+
+	// the stream stopped, the waiting packet must not be held back:
+	buffer.flush();
+	QCOMPARE(releasedValues(), QVector<char>({ 1, 0, 3 }));
+	QCOMPARE(buffer.getNumLostPackets(), 1);
+
+	// flushing an empty buffer doesn't insert silence:
+	buffer.flush();
+	QCOMPARE(m_payloads.size(), 3);
+
+	// the sequence continues after the flushed packets:
+	put(buffer, 3, 4);
+	QCOMPARE(releasedValues(), QVector<char>({ 1, 0, 3, 4 }));
+}
+
+void TestRtpJitterBuffer::sequenceWrap()
+{
+	RtpJitterBuffer buffer(this, TEST_PACKETS, TEST_MAX_PAYLOAD);
+	put(buffer, 65534, 1);
+	put(buffer, 0, 3);
+	put(buffer, 65535, 2);
+	put(buffer, 1, 4);
+	QCOMPARE(releasedValues(), QVector<char>({ 1, 2, 3, 4 }));
+	QCOMPARE(buffer.getNumLostPackets(), 0);
+}
+
+void TestRtpJitterBuffer::resync()
+{
+	RtpJitterBuffer buffer(this, TEST_PACKETS, TEST_MAX_PAYLOAD);
+	put(buffer, 10, 1);
+	put(buffer, 12, 3);
+	// the sender was restarted, no silence is inserted for the jump:
+	put(buffer, 30000, 5);
+	put(buffer, 30001, 6);
+	QCOMPARE(releasedValues(), QVector<char>({ 1, 3, 5, 6 }));
+	QCOMPARE(buffer.getNumLostPackets(), 0);
+}
+
+void TestRtpJitterBuffer::headerParsing()
+{
+	RtpJitterBuffer buffer(this, TEST_PACKETS, TEST_MAX_PAYLOAD);
+
+	// CSRC list with one entry, a header extension with one word and 3 bytes of padding:
+	QByteArray packet = createPacket(0, 7);
+	packet[0] = char(0x80 | 0x20 | 0x10 | 0x01);
+	const QByteArray csrcAndExtension("\x00\x00\x00\x01" "\xBE\xDE\x00\x01" "\x00\x00\x00\x00", 12);
+	packet.insert(12, csrcAndExtension);
+	packet.append(QByteArray("\x00\x00\x03", 3));
+	buffer.putPacket(packet.constData(), packet.size());
+	QCOMPARE(m_payloads.size(), 1);
+	QCOMPARE(m_payloads[0], QByteArray(TEST_PAYLOAD_SIZE, 7));
+
+	// wrong version and too short packets are ignored:
+	QByteArray wrongVersion = createPacket(1, 8);
+	wrongVersion[0] = char(0x40);
+	buffer.putPacket(wrongVersion.constData(), wrongVersion.size());
+	buffer.putPacket(packet.constData(), 11);
+	QCOMPARE(m_payloads.size(), 1);
+}
+
+QByteArray TestRtpJitterBuffer::createPacket(quint16 sequence, char value)
+{
+	QByteArray packet(12, 0);
+	packet[0] = char(0x80);  // version 2
+	packet[1] = char(96);  // dynamic payload type
+	packet[2] = char(sequence >> 8);
+	packet[3] = char(sequence & 0xFF);
+	packet.append(QByteArray(TEST_PAYLOAD_SIZE, value));
+	return packet;
+}
+
+void TestRtpJitterBuffer::put(RtpJitterBuffer& buffer, quint16 sequence, char value)
+{
+	const QByteArray packet = createPacket(sequence, value);
+	buffer.putPacket(packet.constData(), packet.size());
+}
+
+QVector<char> TestRtpJitterBuffer::releasedValues() const
+{
+	QVector<char> values;
+	for (const QByteArray& payload: m_payloads) {
+		values.append(payload.isEmpty() ? char(-1) : payload[0]);
+	}
+	return values;
+}
+
+QTEST_APPLESS_MAIN(TestRtpJitterBuffer)
+
+#include "tst_rtpjitterbuffer.moc"
@@ -0,0 +1,6 @@
+include(../tests.pri)
+
+TARGET = tst_rtpjitterbuffer
+
+SOURCES += tst_rtpjitterbuffer.cpp \
+    $$SRC_DIR/RtpJitterBuffer.cpp
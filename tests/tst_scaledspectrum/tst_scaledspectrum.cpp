@@ -0,0 +1,185 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "ScaledSpectrum.h"
+#include "FFTAnalyzer.h"
+
+#include <QtTest>
+#include <QtMath>
+#include <QVector>
+
+
+// Tests that the power domain of ScaledSpectrum results in the same levels as the magnitudes.
+class TestScaledSpectrum : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void sineLevels();
+	void decibelLevels();
+	void agc();
+	void normalizeLevel();
+	void broadbandLevels();
+
+protected:
+	// returns a ScaledSpectrum with the given settings and the AGC disabled
+	void setup(ScaledSpectrum& spectrum, bool powerDomain, bool decibel) const;
+
+	// returns a linear spectrum with a single bin of the given magnitude (a sine)
+	// scaled like FFTAnalyzer does (magnitudes by 1/10, powers by 1/100)
+	QVector<float> createSineSpectrum(float magnitude, bool powerDomain) const;
+
+	// returns the largest difference between the normalized spectra
+	float maxDifference(const ScaledSpectrum& a, const ScaledSpectrum& b) const;
+};
+
+namespace {
+
+// sample rate and size of the FFT of the linear spectra
+const int TEST_SAMPLE_RATE = 44100;
+const int TEST_FFT_SIZE = 4096;
+
+// bin of the sine in the linear spectra
+const int TEST_SINE_BIN = 100;
+
+// largest allowed difference of the normalized levels
+const float TEST_MAX_DIFFERENCE = 1e-5f;
+
+}
+
+void TestScaledSpectrum::sineLevels()
+{
+	const float magnitudes[] = { 1.0f, 50.0f, 300.0f, 1500.0f };
+	for (float magnitude: magnitudes) {
+		ScaledSpectrum magnitudeSpectrum(SCALED_SPECTRUM_BASE_FREQ, SCALED_SPECTRUM_LENGTH);
+		ScaledSpectrum powerSpectrum(SCALED_SPECTRUM_BASE_FREQ, SCALED_SPECTRUM_LENGTH);
+		setup(magnitudeSpectrum, false, false);
+		setup(powerSpectrum, true, false);
+		// (the gain is applied to the magnitudes in both domains)
+		magnitudeSpectrum.setGain(2.0f);
+		powerSpectrum.setGain(2.0f);
+		magnitudeSpectrum.updateWithLinearSpectrum(createSineSpectrum(magnitude, false));
+		powerSpectrum.updateWithLinearSpectrum(createSineSpectrum(magnitude, true));
+		QVERIFY(magnitudeSpectrum.getMaxLevel() > 0);
+		QVERIFY2(maxDifference(magnitudeSpectrum, powerSpectrum) < TEST_MAX_DIFFERENCE,
+				 qPrintable(QString("magnitude %1: %2 instead of %3").arg(magnitude)
+							.arg(powerSpectrum.getMaxLevel()).arg(magnitudeSpectrum.getMaxLevel())));
+	}
+}
+
+void TestScaledSpectrum::decibelLevels()
+{
+	ScaledSpectrum magnitudeSpectrum(SCALED_SPECTRUM_BASE_FREQ, SCALED_SPECTRUM_LENGTH);
+	ScaledSpectrum powerSpectrum(SCALED_SPECTRUM_BASE_FREQ, SCALED_SPECTRUM_LENGTH);
+	setup(magnitudeSpectrum, false, true);
+	setup(powerSpectrum, true, true);
+	magnitudeSpectrum.updateWithLinearSpectrum(createSineSpectrum(100.0f, false));
+	powerSpectrum.updateWithLinearSpectrum(createSineSpectrum(100.0f, true));
+	QVERIFY(magnitudeSpectrum.getMaxLevel() > 0);
+	QVERIFY(maxDifference(magnitudeSpectrum, powerSpectrum) < TEST_MAX_DIFFERENCE);
+}
+
+void TestScaledSpectrum::agc()
+{
+	// the noise threshold and the headroom of the AGC apply to the magnitudes in both domains:
+	const float magnitudes[] = { 150.0f, 500.0f, 1300.0f };
+	for (float magnitude: magnitudes) {
+		ScaledSpectrum magnitudeSpectrum(SCALED_SPECTRUM_BASE_FREQ, SCALED_SPECTRUM_LENGTH);
+		ScaledSpectrum powerSpectrum(SCALED_SPECTRUM_BASE_FREQ, SCALED_SPECTRUM_LENGTH);
+		setup(magnitudeSpectrum, false, false);
+		setup(powerSpectrum, true, false);
+		magnitudeSpectrum.setAgcEnabled(true);
+		powerSpectrum.setAgcEnabled(true);
+		for (int i=0; i<AGC_AVERAGING_LENGTH; ++i) {
+			magnitudeSpectrum.updateWithLinearSpectrum(createSineSpectrum(magnitude, false));
+			powerSpectrum.updateWithLinearSpectrum(createSineSpectrum(magnitude, true));
+		}
+		QVERIFY(magnitudeSpectrum.getGain() != 1.0f);
+		QVERIFY2(qAbs(powerSpectrum.getGain() - magnitudeSpectrum.getGain()) < TEST_MAX_DIFFERENCE,
+				 qPrintable(QString("magnitude %1: gain %2 instead of %3").arg(magnitude)
+							.arg(powerSpectrum.getGain()).arg(magnitudeSpectrum.getGain())));
+	}
+}
+
+void TestScaledSpectrum::normalizeLevel()
+{
+	const bool decibelModes[] = { false, true };
+	for (bool decibel: decibelModes) {
+		ScaledSpectrum magnitudeSpectrum(SCALED_SPECTRUM_BASE_FREQ, SCALED_SPECTRUM_LENGTH);
+		ScaledSpectrum powerSpectrum(SCALED_SPECTRUM_BASE_FREQ, SCALED_SPECTRUM_LENGTH);
+		setup(magnitudeSpectrum, false, decibel);
+		setup(powerSpectrum, true, decibel);
+		const float levels[] = { 0.01f, 0.3f, 0.9f };
+		for (float level: levels) {
+			QCOMPARE(powerSpectrum.normalizeLevel(level), magnitudeSpectrum.normalizeLevel(level));
+		}
+	}
+}
+
+void TestScaledSpectrum::broadbandLevels()
+{
+	// with the energy spread over all bins the square root of the summed powers
+	// is less than the sum of the magnitudes (see ScaledSpectrum::setPowerDomain()):
+	ScaledSpectrum magnitudeSpectrum(SCALED_SPECTRUM_BASE_FREQ, SCALED_SPECTRUM_LENGTH);
+	ScaledSpectrum powerSpectrum(SCALED_SPECTRUM_BASE_FREQ, SCALED_SPECTRUM_LENGTH);
+	setup(magnitudeSpectrum, false, false);
+	setup(powerSpectrum, true, false);
+	magnitudeSpectrum.updateWithLinearSpectrum(QVector<float>(TEST_FFT_SIZE / 2, 0.1f * 10.0f));
+	powerSpectrum.updateWithLinearSpectrum(QVector<float>(TEST_FFT_SIZE / 2, 0.01f * 10.0f * 10.0f));
+
+	const QVector<float>& magnitudeLevels = magnitudeSpectrum.getNormalizedSpectrum();
+	const QVector<float>& powerLevels = powerSpectrum.getNormalizedSpectrum();
+	// the highest scaled bins span many linear bins:
+	const int index = magnitudeLevels.size() - 2;
+	QVERIFY(powerLevels[index] < magnitudeLevels[index]);
+	for (int i=0; i<magnitudeLevels.size(); ++i) {
+		QVERIFY(powerLevels[i] <= magnitudeLevels[i] + TEST_MAX_DIFFERENCE);
+	}
+}
+
+void TestScaledSpectrum::setup(ScaledSpectrum& spectrum, bool powerDomain, bool decibel) const
+{
+	spectrum.setSampleRate(TEST_SAMPLE_RATE);
+	spectrum.setFftSize(TEST_FFT_SIZE);
+	spectrum.setPowerDomain(powerDomain);
+	spectrum.setDecibelConversion(decibel);
+	spectrum.setAgcEnabled(false);
+}
+
+QVector<float> TestScaledSpectrum::createSineSpectrum(float magnitude, bool powerDomain) const
+{
+	QVector<float> linear(TEST_FFT_SIZE / 2, 0.0f);
+	linear[TEST_SINE_BIN] = powerDomain ? 0.01f * magnitude * magnitude : 0.1f * magnitude;
+	return linear;
+}
+
+float TestScaledSpectrum::maxDifference(const ScaledSpectrum& a, const ScaledSpectrum& b) const
+{
+	float difference = 0;
+	for (int i=0; i<a.getNormalizedSpectrum().size(); ++i) {
+		difference = qMax(difference, qAbs(a.getNormalizedSpectrum()[i] - b.getNormalizedSpectrum()[i]));
+	}
+	return difference;
+}
+
+QTEST_APPLESS_MAIN(TestScaledSpectrum)
+
+#include "tst_scaledspectrum.moc"
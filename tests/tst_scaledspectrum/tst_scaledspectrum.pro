@@ -0,0 +1,6 @@
+include(../tests.pri)
+
+TARGET = tst_scaledspectrum
+
+SOURCES += tst_scaledspectrum.cpp \
+    $$SRC_DIR/ScaledSpectrum.cpp
@@ -0,0 +1,121 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef TST_SIMDFFT_ARM_NEON_H
+#define TST_SIMDFFT_ARM_NEON_H
+
+// A scalar emulation of the NEON intrinsics used by SimdFFTNeon.cpp.
+// It is only used by tst_simdfft on CPUs without NEON to run the NEON backend
+// through the shared kernel. It does not replace a test on ARM hardware:
+// the estimates vrecpeq_f32() and vrsqrteq_f32() are emulated with the documented
+// precision of 8 bits, but not bit exact, and the code generation of the compiler
+// for ARM is not covered.
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+struct float32x2_t { float v[2]; };
+struct float32x4_t { float v[4]; };
+struct uint32x4_t { uint32_t v[4]; };
+struct int32x4_t { int32_t v[4]; };
+struct float32x4x2_t { float32x4_t val[2]; };
+
+namespace NeonEmulation {
+
+// returns the value with the mantissa truncated to 8 bits (the precision of the estimates)
+inline float truncateToEstimate(float value)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	bits &= 0xffff8000u;
+	std::memcpy(&value, &bits, sizeof(bits));
+	return value;
+}
+
+}  // namespace NeonEmulation
+
+// the element wise operations:
+#define NEON_EMULATION_MAP(RESULT, EXPRESSION) \
+	RESULT r; for (int i=0; i<4; ++i) r.v[i] = (EXPRESSION); return r
+
+inline float32x4_t vld1q_f32(const float* p) { NEON_EMULATION_MAP(float32x4_t, p[i]); }
+inline void vst1q_f32(float* p, float32x4_t a) { for (int i=0; i<4; ++i) p[i] = a.v[i]; }
+inline float32x4_t vdupq_n_f32(float value) { NEON_EMULATION_MAP(float32x4_t, value); }
+inline uint32x4_t vdupq_n_u32(uint32_t value) { NEON_EMULATION_MAP(uint32x4_t, value); }
+inline int32x4_t vdupq_n_s32(int32_t value) { NEON_EMULATION_MAP(int32x4_t, value); }
+
+inline float32x4_t vaddq_f32(float32x4_t a, float32x4_t b) { NEON_EMULATION_MAP(float32x4_t, a.v[i] + b.v[i]); }
+inline float32x4_t vsubq_f32(float32x4_t a, float32x4_t b) { NEON_EMULATION_MAP(float32x4_t, a.v[i] - b.v[i]); }
+inline float32x4_t vmulq_f32(float32x4_t a, float32x4_t b) { NEON_EMULATION_MAP(float32x4_t, a.v[i] * b.v[i]); }
+inline float32x4_t vmaxq_f32(float32x4_t a, float32x4_t b) { NEON_EMULATION_MAP(float32x4_t, a.v[i] > b.v[i] ? a.v[i] : b.v[i]); }
+inline float32x4_t vdivq_f32(float32x4_t a, float32x4_t b) { NEON_EMULATION_MAP(float32x4_t, a.v[i] / b.v[i]); }
+inline float32x4_t vsqrtq_f32(float32x4_t a) { NEON_EMULATION_MAP(float32x4_t, std::sqrt(a.v[i])); }
+
+// estimates and Newton-Raphson steps:
+inline float32x4_t vrecpeq_f32(float32x4_t a) { NEON_EMULATION_MAP(float32x4_t, NeonEmulation::truncateToEstimate(1.0f / a.v[i])); }
+inline float32x4_t vrecpsq_f32(float32x4_t a, float32x4_t b) { NEON_EMULATION_MAP(float32x4_t, 2.0f - a.v[i] * b.v[i]); }
+inline float32x4_t vrsqrteq_f32(float32x4_t a) { NEON_EMULATION_MAP(float32x4_t, NeonEmulation::truncateToEstimate(1.0f / std::sqrt(a.v[i]))); }
+inline float32x4_t vrsqrtsq_f32(float32x4_t a, float32x4_t b) { NEON_EMULATION_MAP(float32x4_t, (3.0f - a.v[i] * b.v[i]) / 2.0f); }
+
+// comparison and bit operations:
+inline uint32x4_t vceqq_f32(float32x4_t a, float32x4_t b) { NEON_EMULATION_MAP(uint32x4_t, a.v[i] == b.v[i] ? 0xffffffffu : 0u); }
+inline float32x4_t vbslq_f32(uint32x4_t mask, float32x4_t a, float32x4_t b)
+{
+	float32x4_t r;
+	for (int i=0; i<4; ++i) {
+		uint32_t x, y;
+		std::memcpy(&x, &a.v[i], sizeof(x));
+		std::memcpy(&y, &b.v[i], sizeof(y));
+		const uint32_t bits = (x & mask.v[i]) | (y & ~mask.v[i]);
+		std::memcpy(&r.v[i], &bits, sizeof(bits));
+	}
+	return r;
+}
+inline uint32x4_t vandq_u32(uint32x4_t a, uint32x4_t b) { NEON_EMULATION_MAP(uint32x4_t, a.v[i] & b.v[i]); }
+inline uint32x4_t vorrq_u32(uint32x4_t a, uint32x4_t b) { NEON_EMULATION_MAP(uint32x4_t, a.v[i] | b.v[i]); }
+inline uint32x4_t vshrq_n_u32(uint32x4_t a, int n) { NEON_EMULATION_MAP(uint32x4_t, a.v[i] >> n); }
+inline int32x4_t vsubq_s32(int32x4_t a, int32x4_t b) { NEON_EMULATION_MAP(int32x4_t, a.v[i] - b.v[i]); }
+inline float32x4_t vcvtq_f32_s32(int32x4_t a) { NEON_EMULATION_MAP(float32x4_t, float(a.v[i])); }
+
+// reinterpretation of the bits:
+inline uint32x4_t vreinterpretq_u32_f32(float32x4_t a) { uint32x4_t r; std::memcpy(&r, &a, sizeof(r)); return r; }
+inline float32x4_t vreinterpretq_f32_u32(uint32x4_t a) { float32x4_t r; std::memcpy(&r, &a, sizeof(r)); return r; }
+inline int32x4_t vreinterpretq_s32_u32(uint32x4_t a) { int32x4_t r; std::memcpy(&r, &a, sizeof(r)); return r; }
+
+// permutations:
+inline float32x2_t vget_low_f32(float32x4_t a) { float32x2_t r = {{ a.v[0], a.v[1] }}; return r; }
+inline float32x2_t vget_high_f32(float32x4_t a) { float32x2_t r = {{ a.v[2], a.v[3] }}; return r; }
+inline float32x4_t vcombine_f32(float32x2_t lo, float32x2_t hi) { float32x4_t r = {{ lo.v[0], lo.v[1], hi.v[0], hi.v[1] }}; return r; }
+inline float32x4_t vrev64q_f32(float32x4_t a) { float32x4_t r = {{ a.v[1], a.v[0], a.v[3], a.v[2] }}; return r; }
+inline float32x4x2_t vzipq_f32(float32x4_t a, float32x4_t b)
+{
+	float32x4x2_t r = {{ {{ a.v[0], b.v[0], a.v[1], b.v[1] }}, {{ a.v[2], b.v[2], a.v[3], b.v[3] }} }};
+	return r;
+}
+inline float32x4x2_t vld2q_f32(const float* p)
+{
+	float32x4x2_t r = {{ {{ p[0], p[2], p[4], p[6] }}, {{ p[1], p[3], p[5], p[7] }} }};
+	return r;
+}
+
+#undef NEON_EMULATION_MAP
+
+#endif // TST_SIMDFFT_ARM_NEON_H
@@ -0,0 +1,236 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "SimdFFT.h"
+
+#include <QtTest>
+#include <QtMath>
+#include <QVector>
+
+#if defined(SIMD_FFT_NEON_EMULATION)
+// the NEON backend compiled with the emulated intrinsics (see neon_emulated.cpp)
+void simdRealFftNeon(const SimdFFTTables& tables, float* work, const float* input, float* output);
+void simdSpectrumNeon(SpectrumType type, const float* fftOutput, int size, float* spectrum);
+
+// a SimdFFT that uses its tables with the emulated NEON kernel
+class EmulatedNeonFFT : public SimdFFT
+{
+public:
+	explicit EmulatedNeonFFT(int sizeExponent) : SimdFFT(sizeExponent) { m_kernel = simdRealFftNeon; }
+};
+#endif
+
+
+// Tests the SIMD backends of SimdFFT against a DFT in double precision.
+class TestSimdFFT : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void backends();
+	void fftMatchesDft();
+	void emulatedNeonFftMatchesDft();
+	void spectrum();
+	void emulatedNeonSpectrum();
+
+protected:
+	// returns a test signal of size samples (noise and a few sines)
+	QVector<float> createSignal(int size) const;
+
+	// returns the DFT of input in the format of FFTReal (see SimdFFT)
+	QVector<double> calculateDft(const QVector<float>& input) const;
+
+	// returns the largest deviation of output from expected relative to the largest value of expected
+	double maxRelativeDeviation(const float* output, const QVector<double>& expected) const;
+
+	// compares the spectra of all types calculated by calculate from the output of a FFT
+	// with the ones calculated in double precision
+	void checkSpectrum(void (*calculate)(SpectrumType, const float*, int, float*));
+};
+
+namespace {
+
+// range of the tested FFT sizes as exponents of 2
+const int TEST_MIN_SIZE_EXPONENT = SIMD_FFT_MIN_SIZE_EXPONENT;
+const int TEST_MAX_SIZE_EXPONENT = 12;
+
+// largest deviation of a FFT from the DFT relative to the largest value
+const double TEST_MAX_FFT_DEVIATION = 1e-5;
+
+// largest relative deviation of magnitudes and powers
+const double TEST_MAX_SPECTRUM_DEVIATION = 1e-4;
+
+// largest deviation of a power in dB
+const double TEST_MAX_DB_DEVIATION = 1e-3;
+
+}
+
+void TestSimdFFT::backends()
+{
+	// the best backend is available and used by default:
+	const SimdFFT::Backend best = SimdFFT::getBestBackend();
+	QVERIFY(best == SimdFFT::NoBackend || SimdFFT::isBackendAvailable(best));
+	QVERIFY(!SimdFFT::isBackendAvailable(SimdFFT::NoBackend));
+	if (best != SimdFFT::NoBackend) {
+		SimdFFT fft(TEST_MIN_SIZE_EXPONENT);
+		QCOMPARE(fft.getBackend(), best);
+	}
+#if defined(SIMD_FFT_X86)
+	QVERIFY(SimdFFT::isBackendAvailable(SimdFFT::Sse2Backend));
+	QVERIFY(!SimdFFT::isBackendAvailable(SimdFFT::NeonBackend));
+#elif defined(SIMD_FFT_NEON)
+	QVERIFY(SimdFFT::isBackendAvailable(SimdFFT::NeonBackend));
+#endif
+}
+
+void TestSimdFFT::fftMatchesDft()
+{
+	const SimdFFT::Backend backends[] = { SimdFFT::Sse2Backend, SimdFFT::Avx2Backend, SimdFFT::NeonBackend };
+	int numTested = 0;
+	for (SimdFFT::Backend backend: backends) {
+		if (!SimdFFT::isBackendAvailable(backend)) continue;
+		++numTested;
+		for (int exponent=TEST_MIN_SIZE_EXPONENT; exponent<=TEST_MAX_SIZE_EXPONENT; ++exponent) {
+			const QVector<float> input = createSignal(1 << exponent);
+			QVector<float> output(input.size());
+			SimdFFT fft(exponent, backend);
+			fft.doFft(output.data(), input.data());
+			const double deviation = maxRelativeDeviation(output.data(), calculateDft(input));
+			QVERIFY2(deviation < TEST_MAX_FFT_DEVIATION,
+					 qPrintable(QString("%1 with %2 samples: deviation %3")
+								.arg(SimdFFT::getBackendName(backend)).arg(input.size()).arg(deviation)));
+		}
+	}
+	if (numTested == 0) QSKIP("no SIMD backend available");
+}
+
+void TestSimdFFT::emulatedNeonFftMatchesDft()
+{
+#if defined(SIMD_FFT_NEON_EMULATION)
+	for (int exponent=TEST_MIN_SIZE_EXPONENT; exponent<=TEST_MAX_SIZE_EXPONENT; ++exponent) {
+		const QVector<float> input = createSignal(1 << exponent);
+		QVector<float> output(input.size());
+		EmulatedNeonFFT fft(exponent);
+		fft.doFft(output.data(), input.data());
+		const double deviation = maxRelativeDeviation(output.data(), calculateDft(input));
+		QVERIFY2(deviation < TEST_MAX_FFT_DEVIATION,
+				 qPrintable(QString("emulated NEON with %1 samples: deviation %2").arg(input.size()).arg(deviation)));
+	}
+#else
+	QSKIP("the NEON backend is tested on the hardware");
+#endif
+}
+
+void TestSimdFFT::spectrum()
+{
+	checkSpectrum(SimdFFT::calculateSpectrum);
+}
+
+void TestSimdFFT::emulatedNeonSpectrum()
+{
+#if defined(SIMD_FFT_NEON_EMULATION)
+	checkSpectrum(simdSpectrumNeon);
+#else
+	QSKIP("the NEON backend is tested on the hardware");
+#endif
+}
+
+QVector<float> TestSimdFFT::createSignal(int size) const
+{
+	QVector<float> signal(size);
+	quint32 random = 12345;
+	for (int i=0; i<size; ++i) {
+		random = random * 1664525u + 1013904223u;
+		const double noise = (random >> 8) / double(1 << 24) - 0.5;
+		signal[i] = float(0.1 * noise + 0.5 * qSin(2 * M_PI * 3 * i / size)
+						  + 0.25 * qCos(2 * M_PI * 0.37 * i) + 0.1);
+	}
+	return signal;
+}
+
+QVector<double> TestSimdFFT::calculateDft(const QVector<float>& input) const
+{
+	const int size = input.size();
+	const int half = size / 2;
+	QVector<double> output(size);
+	for (int k=0; k<=half; ++k) {
+		double re = 0;
+		double im = 0;
+		for (int n=0; n<size; ++n) {
+			// (the product is reduced modulo size to keep the precision of the angle)
+			const double angle = 2 * M_PI * ((qint64(k) * n) % size) / size;
+			re += input[n] * qCos(angle);
+			im -= input[n] * qSin(angle);
+		}
+		output[k] = re;
+		// FFTReal stores the negated imaginary parts of the bins 1...N/2-1:
+		if (k > 0 && k < half) output[half + k] = -im;
+	}
+	return output;
+}
+
+double TestSimdFFT::maxRelativeDeviation(const float* output, const QVector<double>& expected) const
+{
+	double maxValue = 0;
+	double maxDeviation = 0;
+	for (int i=0; i<expected.size(); ++i) {
+		maxValue = qMax(maxValue, qAbs(expected[i]));
+		maxDeviation = qMax(maxDeviation, qAbs(output[i] - expected[i]));
+	}
+	return maxDeviation / maxValue;
+}
+
+void TestSimdFFT::checkSpectrum(void (*calculate)(SpectrumType, const float*, int, float*))
+{
+	const int size = 1 << 10;
+	const int half = size / 2;
+	QVector<float> fftOutput = createSignal(size);
+	// a few bins with a power of 0 and below the smallest power of the dB spectrum:
+	fftOutput[5] = 0;
+	fftOutput[half + 5] = 0;
+	fftOutput[6] = 1e-12f;
+	fftOutput[half + 6] = 0;
+
+	QVector<float> magnitudes(half);
+	QVector<float> powers(half);
+	QVector<float> decibels(half);
+	calculate(MagnitudeSpectrum, fftOutput.data(), size, magnitudes.data());
+	calculate(PowerSpectrum, fftOutput.data(), size, powers.data());
+	calculate(LogPowerSpectrum, fftOutput.data(), size, decibels.data());
+
+	for (int i=0; i<half; ++i) {
+		const double re = fftOutput[i];
+		// (bin 0 is real, the value at half is the Nyquist bin)
+		const double im = i > 0 ? fftOutput[half + i] : 0.0;
+		const double power = re * re + im * im;
+		const double expectedDb = 10 * std::log10(qMax(power, double(SIMD_FFT_MIN_POWER)));
+		QVERIFY2(qAbs(magnitudes[i] - qSqrt(power)) <= TEST_MAX_SPECTRUM_DEVIATION * qSqrt(power),
+				 qPrintable(QString("magnitude of bin %1: %2 instead of %3").arg(i).arg(magnitudes[i]).arg(qSqrt(power))));
+		QVERIFY2(qAbs(powers[i] - power) <= TEST_MAX_SPECTRUM_DEVIATION * power,
+				 qPrintable(QString("power of bin %1: %2 instead of %3").arg(i).arg(powers[i]).arg(power)));
+		QVERIFY2(qAbs(decibels[i] - expectedDb) < TEST_MAX_DB_DEVIATION,
+				 qPrintable(QString("dB of bin %1: %2 instead of %3").arg(i).arg(decibels[i]).arg(expectedDb)));
+	}
+}
+
+QTEST_APPLESS_MAIN(TestSimdFFT)
+
+#include "tst_simdfft.moc"
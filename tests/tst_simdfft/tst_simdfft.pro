@@ -0,0 +1,16 @@
+include(../tests.pri)
+
+TARGET = tst_simdfft
+
+SOURCES += tst_simdfft.cpp \
+    $$SRC_DIR/SimdFFT.cpp \
+    $$SRC_DIR/SimdFFTSse2.cpp \
+    $$SRC_DIR/SimdFFTAvx2.cpp \
+    $$SRC_DIR/SimdFFTNeon.cpp
+
+# without NEON hardware the NEON backend is compiled with an emulation of the intrinsics
+!contains(QT_ARCH, arm.*) {
+    DEFINES += SIMD_FFT_NEON_EMULATION
+    INCLUDEPATH += $$PWD/neon_emulation
+    SOURCES += neon_emulated.cpp
+}
@@ -0,0 +1,247 @@
+// Copyright (c) 2016 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "SlidingDFT.h"
+#include "MonoAudioBuffer.h"
+
+#include <QtTest>
+#include <QtMath>
+#include <QVector>
+
+
+// a SlidingDFT that tells when its bins have been recalculated
+class InspectedSlidingDFT : public SlidingDFT
+{
+public:
+	explicit InspectedSlidingDFT(int windowSize) : SlidingDFT(windowSize) { }
+
+	// returns the number of samples the window has slid since the last recalculation
+	int64_t getSamplesSinceRefresh() const { return m_samplesSinceRefresh; }
+};
+
+
+// Tests the bins of SlidingDFT against a Hann windowed DFT calculated directly.
+class TestSlidingDFT : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void invalidBins();
+	void sineMagnitude();
+	void slidingMatchesDft();
+	void jumpMatchesDft();
+	void refreshAfterManyWindows();
+
+protected:
+	// writes numSamples samples of the test signal (a sine, a second sine and noise) to buffer
+	void writeSignal(MonoAudioBuffer& buffer, int numSamples);
+
+	// returns the power of the Hann windowed bin of the window that ends before windowEnd
+	double calculatePower(const MonoAudioBuffer& buffer, int64_t windowEnd, int bin) const;
+
+	// compares all bins of dft with the directly calculated ones
+	void compareWithDft(const SlidingDFT& dft, const MonoAudioBuffer& buffer, int64_t windowEnd);
+
+	quint32		m_random;  // state of the noise generator
+	int64_t		m_signalPosition;  // number of samples of the test signal written
+};
+
+namespace {
+
+// sample rate of the test signals
+const int TEST_SAMPLE_RATE = 44100;
+
+// number of samples of the tested DFT
+const int TEST_WINDOW_SIZE = 1024;
+
+// number of samples the window slides per step (like the blocks of the band triggers)
+const int TEST_STEP_SIZE = 64;
+
+// the tested bins
+const QVector<int> TEST_BINS = { 3, 4, 20, 100, 101, 511 };
+
+// largest deviation of a power relative to the largest power of the bins
+const double TEST_MAX_DEVIATION = 1e-5;
+
+}
+
+void TestSlidingDFT::invalidBins()
+{
+	SlidingDFT dft(TEST_WINDOW_SIZE);
+	// bin 0 and the nyquist bin have no neighbours on both sides:
+	dft.setBins({ 0, 5, TEST_WINDOW_SIZE / 2, -1, TEST_WINDOW_SIZE });
+	QCOMPARE(dft.getBins(), QVector<int>({ 5 }));
+	QCOMPARE(dft.getWindowSize(), TEST_WINDOW_SIZE);
+}
+
+void TestSlidingDFT::sineMagnitude()
+{
+	// a sine at the frequency of a bin with amplitude a has the magnitude a * N / 4 with the Hann window:
+	const int bin = 32;
+	const float amplitude = 0.5f;
+	MonoAudioBuffer buffer(TEST_SAMPLE_RATE);
+	buffer.setInputSampleRate(TEST_SAMPLE_RATE);
+	buffer.setDcBlockerEnabled(false);
+	QVector<float> sine(TEST_WINDOW_SIZE * 2);
+	for (int i=0; i<sine.size(); ++i) {
+		sine[i] = amplitude * float(qSin(2 * M_PI * bin * i / TEST_WINDOW_SIZE));
+	}
+	buffer.putSamples(sine.constData(), sine.size());
+
+	SlidingDFT dft(TEST_WINDOW_SIZE);
+	dft.setBins({ bin, bin + 2 });
+	dft.advance(buffer, buffer.getNumPutSamples() - TEST_STEP_SIZE);
+	dft.advance(buffer, buffer.getNumPutSamples());
+	const float expected = amplitude * TEST_WINDOW_SIZE / 4;
+	QVERIFY(qAbs(dft.getMagnitude(bin) - expected) < expected * 1e-4f);
+	QVERIFY(qAbs(dft.getPower(bin) - expected * expected) < expected * expected * 1e-4f);
+	// (the Hann window leaks only into the direct neighbours)
+	QVERIFY(dft.getMagnitude(bin + 2) < expected * 1e-4f);
+}
+
+void TestSlidingDFT::slidingMatchesDft()
+{
+	m_random = 1;
+	m_signalPosition = 0;
+	MonoAudioBuffer buffer(TEST_SAMPLE_RATE);
+	buffer.setInputSampleRate(TEST_SAMPLE_RATE);
+	buffer.setDcBlockerEnabled(false);
+	writeSignal(buffer, TEST_WINDOW_SIZE);
+
+	InspectedSlidingDFT dft(TEST_WINDOW_SIZE);
+	dft.setBins(TEST_BINS);
+	dft.advance(buffer, buffer.getNumPutSamples());
+	compareWithDft(dft, buffer, buffer.getNumPutSamples());
+
+	// steps of different sizes are calculated with the recursion:
+	const int steps[] = { TEST_STEP_SIZE, 1, 7, TEST_STEP_SIZE, TEST_WINDOW_SIZE - 1 };
+	for (int step: steps) {
+		writeSignal(buffer, step);
+		dft.advance(buffer, buffer.getNumPutSamples());
+		QVERIFY(dft.getSamplesSinceRefresh() > 0);
+		compareWithDft(dft, buffer, buffer.getNumPutSamples());
+	}
+	// advancing to the same end changes nothing:
+	dft.advance(buffer, buffer.getNumPutSamples());
+	compareWithDft(dft, buffer, buffer.getNumPutSamples());
+}
+
+void TestSlidingDFT::jumpMatchesDft()
+{
+	m_random = 2;
+	m_signalPosition = 0;
+	MonoAudioBuffer buffer(TEST_SAMPLE_RATE);
+	buffer.setInputSampleRate(TEST_SAMPLE_RATE);
+	buffer.setDcBlockerEnabled(false);
+	writeSignal(buffer, TEST_WINDOW_SIZE * 4);
+
+	InspectedSlidingDFT dft(TEST_WINDOW_SIZE);
+	dft.setBins(TEST_BINS);
+	dft.advance(buffer, TEST_WINDOW_SIZE);
+
+	// a jump of a whole window and a jump backwards are calculated directly:
+	dft.advance(buffer, TEST_WINDOW_SIZE * 3);
+	QCOMPARE(dft.getSamplesSinceRefresh(), int64_t(0));
+	compareWithDft(dft, buffer, TEST_WINDOW_SIZE * 3);
+	dft.advance(buffer, TEST_WINDOW_SIZE * 2);
+	QCOMPARE(dft.getSamplesSinceRefresh(), int64_t(0));
+	compareWithDft(dft, buffer, TEST_WINDOW_SIZE * 2);
+
+	// new bins are calculated from the whole window:
+	dft.setBins({ 10, 11 });
+	dft.advance(buffer, TEST_WINDOW_SIZE * 2 + TEST_STEP_SIZE);
+	compareWithDft(dft, buffer, TEST_WINDOW_SIZE * 2 + TEST_STEP_SIZE);
+}
+
+void TestSlidingDFT::refreshAfterManyWindows()
+{
+	m_random = 3;
+	m_signalPosition = 0;
+	MonoAudioBuffer buffer(TEST_SAMPLE_RATE);
+	buffer.setInputSampleRate(TEST_SAMPLE_RATE);
+	buffer.setDcBlockerEnabled(false);
+	writeSignal(buffer, TEST_WINDOW_SIZE);
+
+	InspectedSlidingDFT dft(TEST_WINDOW_SIZE);
+	dft.setBins(TEST_BINS);
+	dft.advance(buffer, buffer.getNumPutSamples());
+
+	// the rounding errors of the recursion stay small until the bins are recalculated:
+	bool refreshed = false;
+	for (int i=0; i < SLIDING_DFT_REFRESH_WINDOWS * 2 * TEST_WINDOW_SIZE / TEST_STEP_SIZE; ++i) {
+		writeSignal(buffer, TEST_STEP_SIZE);
+		dft.advance(buffer, buffer.getNumPutSamples());
+		QVERIFY(dft.getSamplesSinceRefresh() <= int64_t(TEST_WINDOW_SIZE) * SLIDING_DFT_REFRESH_WINDOWS);
+		if (dft.getSamplesSinceRefresh() == 0) refreshed = true;
+		if (i % 100 == 0) compareWithDft(dft, buffer, buffer.getNumPutSamples());
+	}
+	QVERIFY(refreshed);
+	compareWithDft(dft, buffer, buffer.getNumPutSamples());
+}
+
+void TestSlidingDFT::writeSignal(MonoAudioBuffer& buffer, int numSamples)
+{
+	QVector<float> samples(numSamples);
+	for (int i=0; i<numSamples; ++i) {
+		m_random = m_random * 1664525u + 1013904223u;
+		const double noise = (m_random >> 8) / double(1 << 24) - 0.5;
+		const int64_t n = m_signalPosition++;
+		samples[i] = float(0.4 * qSin(2 * M_PI * 1000.0 * n / TEST_SAMPLE_RATE)
+						   + 0.2 * qSin(2 * M_PI * 4321.0 * n / TEST_SAMPLE_RATE) + 0.1 * noise);
+	}
+	buffer.putSamples(samples.constData(), numSamples);
+}
+
+double TestSlidingDFT::calculatePower(const MonoAudioBuffer& buffer, int64_t windowEnd, int bin) const
+{
+	QVector<float> samples(TEST_WINDOW_SIZE);
+	buffer.copySamples(windowEnd - TEST_WINDOW_SIZE, samples.data(), TEST_WINDOW_SIZE);
+	double re = 0;
+	double im = 0;
+	for (int m=0; m<TEST_WINDOW_SIZE; ++m) {
+		// periodic Hann window (its DFT is 0.5, -0.25, -0.25 at the bin and its neighbours):
+		const double window = 0.5 - 0.5 * qCos(2 * M_PI * m / TEST_WINDOW_SIZE);
+		const double angle = 2 * M_PI * ((int64_t(bin) * m) % TEST_WINDOW_SIZE) / TEST_WINDOW_SIZE;
+		re += window * samples[m] * qCos(angle);
+		im -= window * samples[m] * qSin(angle);
+	}
+	return re * re + im * im;
+}
+
+void TestSlidingDFT::compareWithDft(const SlidingDFT& dft, const MonoAudioBuffer& buffer, int64_t windowEnd)
+{
+	QVector<double> expected;
+	double maxPower = 0;
+	for (int bin: dft.getBins()) {
+		expected.append(calculatePower(buffer, windowEnd, bin));
+		maxPower = qMax(maxPower, expected.last());
+	}
+	for (int i=0; i<dft.getBins().size(); ++i) {
+		const int bin = dft.getBins()[i];
+		QVERIFY2(qAbs(dft.getPower(bin) - expected[i]) < TEST_MAX_DEVIATION * maxPower,
+				 qPrintable(QString("bin %1 at %2: %3 instead of %4").arg(bin).arg(windowEnd)
+							.arg(dft.getPower(bin)).arg(expected[i])));
+	}
+}
+
+QTEST_APPLESS_MAIN(TestSlidingDFT)
+
+#include "tst_slidingdft.moc"
@@ -0,0 +1,9 @@
+include(../tests.pri)
+
+QT += multimedia
+
+TARGET = tst_slidingdft
+
+SOURCES += tst_slidingdft.cpp \
+    $$SRC_DIR/SlidingDFT.cpp \
+    $$AUDIO_BUFFER_SOURCES